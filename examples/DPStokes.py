@@ -19,7 +19,7 @@ Lx = 2 * 71.273569727781705; Ly = 2 * 71.273569727781705; Lz = 16.89035120481798
 # precompute wave nums, fourier deriv ops, cheb integral mats and linops+bcs for each k
 Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, uvints, BCs_k0, \
   BCs_k, LU, Ainv_B, C, PIV, C_k0, Ginv, Ginv_k0, _, _, _, _, \
-    = DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H)
+    = DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H, real = True)
 
 # number of particles
 nP = 100000
@@ -115,7 +115,8 @@ for j in range(0,nits):
     gridGen.WriteCoords('coords.txt')  
   
   # instantiate forward transform wrapper with spread forces (C lib)
-  fTransformer = Transformer(fG, None, Nx, Ny, Nz, dof)
+  # (the coefficients are stored wavenumber-major, the layout of the solver)
+  fTransformer = Transformer(fG, None, Nx, Ny, Nz, dof, _real = True, _kmajor = True)
   fTransformer.Ftransform_cheb()
   # get the Fourier coefficients
   fG_hat_r = fTransformer.out_real
@@ -124,9 +125,10 @@ for j in range(0,nits):
   U_hat_r, U_hat_i, _, _ = DoublyPeriodicStokes_no_wall(fG_hat_r, fG_hat_i, eta, Nx, Ny, Nz, H, \
                                                         Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, \
                                                         uvints, BCs_k0, BCs_k, LU, Ainv_B, C, \
-                                                        PIV, C_k0, Ginv, Ginv_k0, k0)
+                                                        PIV, C_k0, Ginv, Ginv_k0, k0, real = True, \
+                                                        kmajor = True)
   # instantiate back transform wrapper with velocities on grid (C lib)
-  bTransformer = Transformer(U_hat_r, U_hat_i, Nx, Ny, Nz, dof)
+  bTransformer = Transformer(U_hat_r, U_hat_i, Nx, Ny, Nz, dof, _real = True, _kmajor = True)
   bTransformer.Btransform_cheb()
   # get real part of back transform
   uG_r = bTransformer.out_real
@@ -40,6 +40,8 @@ timeSpread = np.zeros(Ns.size)
 timeTransform = np.zeros(Ns.size)
 timeSolve = np.zeros(Ns.size)
 timeInterp = np.zeros(Ns.size)
+# the grid is made once and resized for each resolution, reusing its buffers
+gridGen = None
 for iN in range(Ns.size):
   Nx = Ny = int(Ns[iN]); 
   hx = hy = Lx / Nx
@@ -76,31 +78,46 @@ for iN in range(Ns.size):
   xP[0::3] += Lx / 2.0
   xP[1::3] += Lx / 2.0
 
-  for nIt in range(0,maxit): 
-    t0 = timer()
-    # precompute wave nums, fourier deriv ops, cheb integral mats and linops+bcs for each k
-    Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, uvints, BCs_k0, \
-      BCs_k, LU, Ainv_B, C, PIV, C_k0, Ginv, Ginv_k0, _, _, _, _, \
-        = DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H)
+  if gridGen is None:
     # instantiate the python grid wrapper
     gridGen = GridGen(Lx, Ly, Lz, hx, hy, 0, Nx, Ny, Nz, dof, periodic_x, periodic_y, periodic_z, BCs, zpts, zwts)
     # instantiate and define the grid with C lib call
     # this sets the GridGen.grid member to a pointer to a C++ Grid struct
     gridGen.Make()
+  else:
+    # resize the grid (C lib), only reallocating if it grows
+    gridGen.Resize(Lx, Ly, Lz, hx, hy, 0, Nx, Ny, Nz, zpts, zwts)
+  # instantiate the python particles wrapper
+  particlesGen = ParticlesGen(nP, dof, xP, fP, radP, wfP, cwfP, betafP)
+  # instantiate and define the particles with C lib call
+  # this sets the ParticlesGen.particles member to a pointer to a C++ ParticlesList struct
+  particlesGen.Make()
+  # plan the forward and backward Chebyshev transforms once for this resolution (C lib),
+  # and execute them on the spread forces and solution of each iteration
+  fTransformer = Transformer(None, None, Nx, Ny, Nz, dof, _real = True)
+  fTransformer.Plan(True, cheb = True)
+  bTransformer = Transformer(None, None, Nx, Ny, Nz, dof, _real = True)
+  bTransformer.Plan(False, cheb = True)
+
+  for nIt in range(0,maxit): 
+    t0 = timer()
+    # precompute wave nums, fourier deriv ops, cheb integral mats and linops+bcs for each k
+    Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, uvints, BCs_k0, \
+      BCs_k, LU, Ainv_B, C, PIV, C_k0, Ginv, Ginv_k0, _, _, _, _, \
+        = DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H, real = True)
     # if no wall, choose whether to 0 the k=0 mode of the RHS
     # k0 = 0 - the k=0 mode of the RHS for pressure and velocity will be 0
     # k0 = 1 - the k=0 mode of the RHS for pressure and velocity will not be 0
     #        - there will be a correction to the k=0 mode after each solve
     k0 = 0;
-    # instantiate the python particles wrapper
-    particlesGen = ParticlesGen(nP, dof, xP, fP, radP, wfP, cwfP, betafP)
-    # instantiate and define the particles with C lib call
-    # this sets the ParticlesGen.particles member to a pointer to a C++ ParticlesList struct
-    particlesGen.Make()
     # setup the particles on the grid with C lib call
     # this builds the particles-grid locator and defines other
     # interal data used to spread and interpolate
-    particlesGen.Setup(gridGen.grid)
+    # on later iterations, the locator is rebuilt in the buffers of the first
+    if nIt == 0:
+      particlesGen.Setup(gridGen.grid)
+    else:
+      particlesGen.Reset(gridGen.grid)
     timeInit[iN] += timer() - t0
  
     t0 = timer() 
@@ -114,8 +131,8 @@ for iN in range(Ns.size):
     timeSpread[iN] += timer() - t0
 
     tFtransform = timer()
-    # instantiate forward transform wrapper with spread forces (C lib)
-    fTransformer = Transformer(fG, None, Nx, Ny, Nz, dof)
+    # forward transform the spread forces (C lib)
+    fTransformer.SetInput(fG)
     fTransformer.Ftransform_cheb()
     # get the Fourier coefficients
     fG_hat_r = fTransformer.out_real
@@ -127,12 +144,12 @@ for iN in range(Ns.size):
     U_hat_r, U_hat_i, _, _ = DoublyPeriodicStokes_no_wall(fG_hat_r, fG_hat_i, eta, Nx, Ny, Nz, H, \
                                                           Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, \
                                                           uvints, BCs_k0, BCs_k, LU, Ainv_B, C, \
-                                                          PIV, C_k0, Ginv, Ginv_k0, k0)
+                                                          PIV, C_k0, Ginv, Ginv_k0, k0, real = True)
     timeSolve[iN] += timer() - t0
     
     tBtransform = timer()
-    # instantiate back transform wrapper with velocities on grid (C lib)
-    bTransformer = Transformer(U_hat_r, U_hat_i, Nx, Ny, Nz, dof)
+    # back transform the velocities on the grid (C lib)
+    bTransformer.SetInput(U_hat_r, U_hat_i)
     bTransformer.Btransform_cheb()
     # get real part of back transform
     uG_r = bTransformer.out_real
@@ -154,12 +171,12 @@ for iN in range(Ns.size):
 
     # reset the forces on the particles
     particlesGen.SetForces(fP)
-    # free memory persisting b/w C and python (C lib)
-    fTransformer.Clean()
-    bTransformer.Clean()
-    gridGen.Clean()
-    particlesGen.Clean()
     #print(timeInterp)
+  # free memory persisting b/w C and python (C lib)
+  fTransformer.Clean()
+  bTransformer.Clean()
+  particlesGen.Clean()
+gridGen.Clean()
 
 timeInit /= maxit; timeSpread /= maxit; timeTransform /= maxit; timeSolve /= maxit; timeInterp /= maxit
 fig, ax = plt.subplots()
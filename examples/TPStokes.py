@@ -8,7 +8,7 @@ from Particles import *
 from SpreadInterp import *
 from Transform import *
 from Ghost import *
-from Solvers import TriplyPeriodicStokes
+from Solvers import TriplyPeriodicStokesSolver
 
 # grid info 
 Nx = 64; Ny = 64; Nz = 64; dof = 3 
@@ -57,6 +57,9 @@ for iP in np.arange(0,nP):
     fP[j + dof * iP] = 10
 
 
+# precompute the multipliers of the Stokes operator on the half spectrum of the grid
+solver = TriplyPeriodicStokesSolver(Lx, Ly, Lz, Nx, Ny, Nz, eta, real = True)
+
 # instantiate the python grid wrapper
 gridGen = GridGen(Lx, Ly, Lz, hx, hy, hz, Nx, Ny, Nz, dof, periodic_x, periodic_y, periodic_z, BCs)
 # instantiate and define the grid with C lib call
@@ -67,6 +70,14 @@ particlesGen = ParticlesGen(nP, dof, xP, fP, radP, wfP, cwfP, betafP)
 # instantiate and define the particles with C lib call
 # this sets the ParticlesGen.particles member to a pointer to a C++ ParticlesList struct
 particlesGen.Make()
+# allocate the spectrum of the grid data, and bind the transforms to the grid,
+# so they run on its buffers without copies (this is before spreading, as
+# planning overwrites the buffers). The spectrum is the half spectrum in x
+gridGen.SetupSpectral(real = True)
+fTransformer = Transformer(None, None, Nx, Ny, Nz, dof, _real = True)
+fTransformer.Bind(gridGen, forward = True)
+bTransformer = Transformer(None, None, Nx, Ny, Nz, dof, _real = True)
+bTransformer.Bind(gridGen, forward = False)
 # setup the particles on the grid with C lib call
 # this builds the particles-grid locator and defines other
 # interal data used to spread and interpolate
@@ -83,24 +94,18 @@ fG = gridGen.GetSpread()
 gridGen.WriteGrid('spread.txt')
 gridGen.WriteCoords('coords.txt')  
 
-# instantiate transform wrapper with spread forces (C lib)
-fTransformer = Transformer(fG, None, Nx, Ny, Nz, dof)
-fTransformer.Ftransform()
-# get the Fourier coefficients
+# transform the spread forces to the spectrum of the grid (C lib)
+fTransformer.Execute()
+# get the Fourier coefficients (views of the spectrum of the grid)
 fG_hat_r = fTransformer.out_real
 fG_hat_i = fTransformer.out_complex
 
-# solve Stokes eq 
-U_hat_r, U_hat_i = TriplyPeriodicStokes(fG_hat_r, fG_hat_i, eta, Lx, Ly, Lz, Nx, Ny, Nz)
+# solve Stokes eq, writing the velocities over the forces in the spectrum
+solver.Solve(fG_hat_r, fG_hat_i, out = (fG_hat_r, fG_hat_i))
 
-# instantiate back transform wrapper with velocities on grid (C lib)
-bTransformer = Transformer(U_hat_r, U_hat_i, Nx, Ny, Nz, dof)
-bTransformer.Btransform()
-# get real part of back transform
-uG_r = bTransformer.out_real
+# back transform the velocities to the grid data (C lib), normalized
+bTransformer.Execute()
 
-# set velocity as new grid spread (C lib)
-gridGen.SetSpread(uG_r)
 # reinitialize forces on particles before interp
 particlesGen.ZeroForces()
 # populate ghost points according to triply periodic BCs
@@ -117,5 +122,6 @@ gridGen.WriteGrid('velocities.txt')
 # free memory persisting b/w C and python (C lib)
 fTransformer.Clean()
 bTransformer.Clean()
+solver.Clean()
 gridGen.Clean()
 particlesGen.Clean()
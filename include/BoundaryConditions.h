@@ -1,693 +1,445 @@
 #ifndef _BOUNDARY_CONDITION_H
 #define _BOUNDARY_CONDITION_H
 #include<omp.h>
+#include<climits>
+#include<vector>
 #include"SpreadInterp.h"
 
 /* this file contains the variable BC enumeration, fold and copy operations */
 
-/* Enumeration for boundary condition types 
+/* Enumeration for boundary condition types
    These must be specified at the ends of
    each axis. Note, if periodic is applied
    at the end of one axis, it must be applied
    at the other end as well. */
 enum BC {mirror, mirror_inv, none};
 
-/* implements fold operation to de-ghostify spread data according to BCs
-   Specifically, this function
-    - copies data in the ghost region of the extended grid Fe to correct region of 
-      the interior grid Fe_wrap
-    - if periodic[i] = true for axis i = 0,1 or 2, a periodic folding convention
-      where data adjacent to a ghost region are copied to the interior region 
-      adjacent to the ghost region at the other end of the axis.
-    - if periodic[i] = false, then the fold op copies according to convention 
-      dispatched by boundary condition on a given data component (dof). data in 
-      the ghost region will be copied to the adjacent interior region. 
-    - supported conventions are mirror, mirror_inv or none. mirror will copy
-      the data with no modification. mirror_inv will copy the negative of the
-      ghost data, and none will perform no copy
+/* GhostExchange implements the fold and copy operations (see fold() and copy() below)
+   from a plan of the ghost transfers, which is built once for a configuration of the
+   extended grid (sizes, ghost widths, periodicity, BCs and layout) by plan().
+
+ * fold_axes, copy_axes - plan of the transfers along x, y and z for fold and copy.
+                          For each axis, the plan holds the (source, destination) pairs
+                          of coordinates along the axis, and the sign of each dof at each
+                          end (1 for periodic and mirror, -1 for mirror_inv and 0 for none).
+                          The pairs are split in stages of independent transfers. There is one
+                          stage per axis, unless the interior is narrower than the ghost regions.
+ * fold_time, copy_time - seconds spent in the transfers along x, y and z and in the copy
+                          between the extended and the interior grid (in that order), summed
+                          over all calls since the plan was built (see resetTimes())
+
+ The transfers of all the axes and dof run in a single parallel region, with an
+ inner loop along the contiguous axis of the extended grid (x, or z if pencil = true)
+ over all the dof, using the sign of each dof repeated along a row. The transfers
+ along the contiguous axis itself loop over the pairs of a row and the dof.
 */
-inline void fold(double* Fe, double* Fe_wrap, const unsigned short wx, 
-                 const unsigned short wy, const unsigned short ext_up, 
-                 const unsigned short ext_down, const unsigned int Nx, 
-                 const unsigned int Ny, const unsigned int Nz, 
-                 const unsigned int dof, bool* periodic, const BC* BCs)
+struct GhostExchange
 {
-  unsigned int lend = wx, Nx_wrap = Nx - 2 * wx;
-  unsigned int rbeg = Nx - lend;
-  unsigned int bend = wy, Ny_wrap = Ny - 2 * wy;
-  unsigned int tbeg = Ny - bend;
-  unsigned int dend = ext_up, Nz_wrap = Nz - ext_up - ext_down; 
-  unsigned int ubeg = Nz - ext_down;
-  // periodic fold in x 
-  if (periodic[0])
+  // ghost transfers along one axis
+  struct Axis
   {
-    #pragma omp parallel
-    {
-      // fold eulerian data in y-z plane in ghost region to periodic index
-      #pragma omp for collapse(3)
-      for (unsigned int k = 0; k < Nz; ++k)
-      {
-        for (unsigned int j = 0; j < Ny; ++j)
-        {
-          // first do left
-          for (unsigned int i = 0; i < lend; ++i)
-          {
-            unsigned int ipb = i + Nx_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
-            { 
-              Fe[d + dof * at(ipb, j, k, Nx, Ny)] += Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }
-        }
-      }
-      #pragma omp for collapse(3)
-      for (unsigned int k = 0; k < Nz; ++k)
-      {
-        for (unsigned int j = 0; j < Ny; ++j)
-        {
-          // now do right
-          for (unsigned int i = rbeg; i < Nx; ++i)
-          {
-            unsigned int ipb = i - Nx_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
-            { 
-              Fe[d + dof * at(ipb, j, k, Nx, Ny)] += Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }  
-        }
-      }
-    }
-  }
-  // handle BC for each end of x as specified
-  else
-  {
-    // get bc for left end of x 
-    const BC* bc_xl = &(BCs[0]);
-    // multiplier to enforce bc
-    double s;
-    for (unsigned int d = 0; d < dof; ++d)
-    {
-      // we only do something if bc is not none
-      if (bc_xl[d] != none)
-      { 
+    // coordinates along the axis of the source and destination of each pair, and its end (0 or 1)
+    std::vector<unsigned int> src, dst, end;
+    // pairs of stage s are stage[s] to stage[s + 1] - 1
+    std::vector<unsigned int> stage;
+    // sign of dof d at end e is sign[d + dof * e], and row[e] repeats it
+    // for each point of a row along the contiguous axis
+    std::vector<double> sign, row[2];
+    // range of the coordinates along x, y and z of the rows transferred
+    unsigned int lo[3], hi[3];
+  };
+  Axis fold_axes[3], copy_axes[3];
+  // configuration the plan is built for
+  unsigned int Nx, Ny, Nz, dof;
+  unsigned short wx, wy, ext_up, ext_down;
+  bool periodic[3], pencil, planar;
+  std::vector<BC> BCs;
+  double fold_time[4], copy_time[4];
 
-        if (bc_xl[d] == mirror) s = 1.0;
-        if (bc_xl[d] == mirror_inv) s = -1.0;
-        // fold eulerian data in y-z plane in ghost region to adjacent interior region
-        // at left end of x axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = 0; k < Nz; ++k)
-        {
-          for (unsigned int j = 0; j < Ny; ++j)
-          {
-            for (unsigned int i = 0; i <= lend; ++i)
-            {
-              unsigned int ipb = 2 * lend - i;
-              Fe[d + dof * at(ipb, j, k, Nx, Ny)] += s * Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }
-        }
-      }
-    }
-    // get bc for right end of x
-    const BC* bc_xr = &(BCs[dof]); 
-    // no slip wall on x right
-    for (unsigned int d = 0; d < dof; ++d)
-    {
-      // we only do something if bc is not none
-      if (bc_xr[d] != none)
-      { 
-        if (bc_xr[d] == mirror) s = 1.0;
-        if (bc_xr[d] == mirror_inv) s = -1.0;
-        // fold eulerian data in y-z plane in ghost region to adjacent interior region
-        // at right end of x axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = 0; k < Nz; ++k)
-        {
-          for (unsigned int j = 0; j < Ny; ++j)
-          {
-            for (unsigned int i = rbeg - 1; i < Nx; ++i)
-            {
-              unsigned int ipb = 2 * rbeg - i - 2;
-              Fe[d + dof * at(ipb, j, k, Nx, Ny)] += s * Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }
-        }
-      }
-    }
+  /* empty/null ctor */
+  GhostExchange() : Nx(0), Ny(0), Nz(0), dof(0), wx(0), wy(0), ext_up(0), ext_down(0),
+                    periodic{false, false, false}, pencil(false), planar(false)
+  {
+    resetTimes();
   }
-  // periodic fold in y
-  if (periodic[1])
+
+  /* build the plan for an extended grid of Nx x Ny x Nz points with dof components,
+     unless it is already built for this configuration. The arguments are those of
+     fold() and copy(). Returns true if the plan was (re)built */
+  bool plan(const unsigned short wx, const unsigned short wy, const unsigned short ext_up,
+            const unsigned short ext_down, const unsigned int Nx, const unsigned int Ny,
+            const unsigned int Nz, const unsigned int dof, const bool* periodic,
+            const BC* BCs, const bool pencil = false, const bool planar = false)
   {
-    #pragma omp parallel
+    const std::vector<BC> bcs(BCs, BCs + 6 * dof);
+    if (Nx == this->Nx && Ny == this->Ny && Nz == this->Nz && dof == this->dof &&
+        wx == this->wx && wy == this->wy && ext_up == this->ext_up &&
+        ext_down == this->ext_down && periodic[0] == this->periodic[0] &&
+        periodic[1] == this->periodic[1] && periodic[2] == this->periodic[2] &&
+        pencil == this->pencil && planar == this->planar && bcs == this->BCs) return false;
+    this->Nx = Nx; this->Ny = Ny; this->Nz = Nz; this->dof = dof;
+    this->wx = wx; this->wy = wy; this->ext_up = ext_up; this->ext_down = ext_down;
+    for (unsigned int a = 0; a < 3; ++a) {this->periodic[a] = periodic[a];}
+    this->pencil = pencil; this->planar = planar; this->BCs = bcs;
+    const unsigned int N[3] = {Nx, Ny, Nz}, lo[3] = {wx, wy, ext_up};
+    const unsigned int hi[3] = {wx, wy, ext_down};
+    for (unsigned int a = 0; a < 3; ++a)
     {
-      // fold eulerian data in x-z plane in ghost region to periodic index
-      #pragma omp for collapse(3)
-      for (unsigned int k = 0; k < Nz; ++k)
-      {
-        // first do bottom
-        for (unsigned int j = 0; j < bend; ++j)
-        {
-          for (unsigned int i = 0; i < Nx; ++i)
-          {
-            unsigned int jpb = j + Ny_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
-            { 
-              Fe[d + dof * at(i, jpb, k, Nx, Ny)] += Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }
-        } 
-      } 
-      #pragma omp for collapse(3)
-      for (unsigned int k = 0; k < Nz; ++k)
+      planAxis(fold_axes[a], a, N[a], lo[a], hi[a], true);
+      planAxis(copy_axes[a], a, N[a], lo[a], hi[a], false);
+      for (unsigned int b = 0; b < 3; ++b)
       {
-        // now do top
-        for (unsigned int j = tbeg; j < Ny; ++j)
-        {
-          for (unsigned int i = 0; i < Nx; ++i)
-          {
-            unsigned int jpb = j - Ny_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
-            { 
-              Fe[d + dof * at(i, jpb, k, Nx, Ny)] += Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }
-        }
+        fold_axes[a].lo[b] = 0; fold_axes[a].hi[b] = N[b];
+        copy_axes[a].lo[b] = 0; copy_axes[a].hi[b] = N[b];
       }
     }
+    // the copy along x only fills the ghost regions of the interior in y and z, and
+    // the copy along y those of the interior in z. The later axes fill the corners.
+    copy_axes[0].lo[1] = wy; copy_axes[0].hi[1] = Ny - wy;
+    copy_axes[0].lo[2] = copy_axes[1].lo[2] = ext_up;
+    copy_axes[0].hi[2] = copy_axes[1].hi[2] = Nz - ext_down;
+    resetTimes();
+    return true;
   }
-  // handle BC for each end of y as specified
-  else
+
+  /* fold the ghost region of Fe into Fe_wrap (see fold()) */
+  template<typename Real>
+  void fold(Real* Fe, double* Fe_wrap)
   {
-    // get bc for left end of y 
-    const BC* bc_yl = &(BCs[2 * dof]);
-    // multiplier to enforce bc
-    double s;
-    for (unsigned int d = 0; d < dof; ++d)
-    {
-      // we only do something if bc is not none
-      if (bc_yl[d] != none)
-      { 
-        if (bc_yl[d] == mirror) s = 1.0;
-        if (bc_yl[d] == mirror_inv) s = -1.0;
-        // fold eulerian data in x-z plane in ghost region to adjacent interior region
-        // at bottom end of y axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = 0; k < Nz; ++k)
-        {
-          for (unsigned int j = 0; j <= bend; ++j)
-          {
-            for (unsigned int i = 0; i < Nx; ++i)
-            {
-              unsigned int jpb = 2 * bend - j;
-              Fe[d + dof * at(i, jpb, k, Nx, Ny)] += s * Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }
-        }
-      }
-    }
-    // get bc for right end of y 
-    const BC* bc_yr = &(BCs[3 * dof]);
-    for (unsigned int d = 0; d < dof; ++d)
-    {
-      // we only do something if bc is not none
-      if (bc_yr[d] != none)
-      { 
-        if (bc_yr[d] == mirror) s = 1.0;
-        if (bc_yr[d] == mirror_inv) s = -1.0;
-        // fold eulerian data in x-z plane in ghost region to adjacent interior region
-        // at top end of y axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = 0; k < Nz; ++k)
-        {
-          for (unsigned int j = tbeg - 1; j < Ny; ++j)
-          {
-            for (unsigned int i = 0; i < Nx; ++i)
-            {
-              unsigned int jpb = 2 * tbeg - i - 2;
-              Fe[d + dof * at(i, jpb, k, Nx, Ny)] += s * Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }
-        }
-      }
-    }
+    dispatch<Real, true>(Fe, Fe_wrap);
   }
-  // periodic fold in z
-  if (periodic[2])
+
+  /* copy Fe_wrap to Fe and its ghost region (see copy()) */
+  template<typename Real>
+  void copy(Real* Fe, const double* Fe_wrap)
   {
-    #pragma omp parallel
-    {
-      // fold eulerian data in x-y plane in ghost region to periodic index
-      // first do down
-      #pragma omp for collapse(3)
-      for (unsigned int k = 0; k < dend; ++k)
-      {
-        for (unsigned int j = 0; j < Ny; ++j)
-        {
-          for (unsigned int i = 0; i < Nx; ++i)
-          {
-            unsigned int kpb = k + Nz_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
-            { 
-              Fe[d + dof * at(i, j, kpb, Nx, Ny)] += Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }
-        } 
-      } 
-  
-      // now do up
-      #pragma omp for collapse(3)
-      for (unsigned int k = ubeg; k < Nz; ++k)
-      {
-        for (unsigned int j = 0; j < Ny; ++j)
-        {
-          for (unsigned int i = 0; i < Nx; ++i)
-          {
-            unsigned int kpb = k - Nz_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
-            { 
-              Fe[d + dof * at(i, j, kpb, Nx, Ny)] += Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          }
-        }
-      }
-    }
+    dispatch<Real, false>(Fe, const_cast<double*>(Fe_wrap));
   }
-  // handle BC for each end of z as specified
-  else
+
+  /* zero fold_time and copy_time */
+  void resetTimes()
   {
-    // get bc for left end of z 
-    const BC* bc_zl = &(BCs[4 * dof]);
-    // multiplier to enforce bc
-    double s;
-    for (unsigned int d = 0; d < dof; ++d)
+    for (unsigned int a = 0; a < 4; ++a) {fold_time[a] = copy_time[a] = 0;}
+  }
+
+  private:
+    // sign applied to dof d by bc
+    static double bcSign(const BC bc)
     {
-      // we only do something if bc is not none
-      if (bc_zl[d] != none)
-      { 
-        if (bc_zl[d] == mirror) s = 1.0;
-        if (bc_zl[d] == mirror_inv) s = -1.0;
-        // fold eulerian data in x-y plane in ghost region to adjacent interior region
-        // at lower end of z axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = 0; k <= dend; ++k)
-        {
-          for (unsigned int j = 0; j < Ny; ++j)
-          {
-            for (unsigned int i = 0; i < Nx; ++i)
-            {
-              unsigned int kpb = 2 * dend - k;
-              Fe[d + dof * at(i, j, kpb, Nx, Ny)] += s * Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
-          } 
-        }
-      }
+      return bc == mirror ? 1.0 : (bc == mirror_inv ? -1.0 : 0.0);
     }
-    // get bc for right end of z
-    const BC* bc_zr = &(BCs[5 * dof]);  
-    for (unsigned int d = 0; d < dof; ++d)
+
+    // number of the 3 coordinates that varies fastest in the extended grid
+    unsigned int contiguous() const {return pencil ? 2 : 0;}
+
+    /* pairs and signs of the transfers along axis a, with N extended points,
+       lo and hi of which are ghost points at the left and right ends */
+    void planAxis(Axis& ax, const unsigned int a, const unsigned int N,
+                  const unsigned int lo, const unsigned int hi, const bool fold)
     {
-      // we only do something if bc is not none
-      if (bc_zr[d] != none)
-      { 
-        if (bc_zr[d] == mirror) s = 1.0;
-        if (bc_zr[d] == mirror_inv) s = -1.0;
-        // fold eulerian data in x-y plane in ghost region to adjacent interior region
-        // at upper end of z axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = ubeg - 1; k < Nz; ++k)
+      const unsigned int Nw = N - lo - hi, rbeg = N - hi;
+      ax.src.clear(); ax.dst.clear(); ax.end.clear(); ax.stage.assign(1, 0);
+      ax.sign.assign(2 * dof, 1.0);
+      bool active[2] = {true, true};
+      if (not periodic[a])
+      {
+        active[0] = active[1] = false;
+        for (unsigned int e = 0; e < 2; ++e)
         {
-          for (unsigned int j = 0; j < Ny; ++j)
+          for (unsigned int d = 0; d < dof; ++d)
           {
-            for (unsigned int i = 0; i < Nx; ++i)
-            {
-              unsigned int kpb = 2 * ubeg - k - 2;
-              Fe[d + dof * at(i, j, kpb, Nx, Ny)] += s * Fe[d + dof * at(i, j, k, Nx, Ny)]; 
-            }
+            ax.sign[d + dof * e] = bcSign(BCs[d + dof * (2 * a + e)]);
+            active[e] = active[e] || ax.sign[d + dof * e] != 0;
           }
         }
       }
-    }
-  }
-  // copy data on extended grid to wrapped grid
-  #pragma omp parallel for collapse(3)
-  for (unsigned int k = dend; k < ubeg; ++k) 
-  {
-    for (unsigned int j = bend; j < tbeg; ++j)
-    {
-      for (unsigned int i = lend; i < rbeg; ++i)
+      // ghost points and the points they are folded to/copied from
+      auto add = [&ax, fold](const unsigned int ghost, const unsigned int other,
+                             const unsigned int e)
       {
-        unsigned int ii = i - lend, jj = j - bend, kk = k - dend;
-        #pragma omp simd aligned(Fe, Fe_wrap: MEM_ALIGN)
-        for (unsigned int d = 0; d < dof; ++d)
-        { 
-          Fe_wrap[d + dof * at(ii, jj, kk, Nx_wrap, Ny_wrap)] 
-            = Fe[d + dof * at(i, j, k, Nx, Ny)];
-        }
+        ax.src.push_back(fold ? ghost : other);
+        ax.dst.push_back(fold ? other : ghost);
+        ax.end.push_back(e);
+      };
+      if (periodic[a])
+      {
+        for (unsigned int i = 0; i < lo; ++i) {add(i, i + Nw, 0);}
+        for (unsigned int i = rbeg; i < N; ++i) {add(i, i - Nw, 1);}
       }
-    }
-  }
-}
-
-/* implements copy opertion to enforce periodicity of eulerian data before interpolation
-   Specifically, this function
-    - copies data on the interior grid Fe_wrap to the ghost region of the
-      extended grid Fe
-    - if periodic[i] = true for axis i = 0,1 or 2, a periodic folding convention
-      where interior data adjacent to a ghost region are copied to the ghost 
-      region at the other end of the axis.
-    - if periodic[i] = false, then the fold op copies according to convention 
-      dispatched by boundary condition on a given data component (dof) 
-    - supported conventions are mirror, mirror_inv or none. mirror will copy
-      the adjacent data to the ghost region. mirror_inv will copy the negative of the
-      adjacent data to the ghost region, and none will perform no copy
-*/
-inline void copy(double* Fe, const double* Fe_wrap, const unsigned short wx, 
-                 const unsigned short wy, const unsigned short ext_up,
-                 const unsigned short ext_down, const unsigned int Nx, 
-                 const unsigned int Ny, const unsigned int Nz, 
-                 const unsigned int dof, bool* periodic, const BC* BCs)
-{
-  unsigned int lend = wx, Nx_wrap = Nx - 2 * wx;
-  unsigned int rbeg = Nx - lend;
-  unsigned int bend = wy, Ny_wrap = Ny - 2 * wy;
-  unsigned int tbeg = Ny - bend;
-  unsigned int dend = ext_up, Nz_wrap = Nz - ext_up - ext_down; 
-  unsigned int ubeg = Nz - ext_down;
-  // copy data on wrapped grid to extended periodic grid
-  #pragma omp parallel for collapse(3)
-  for (unsigned int k = 0; k < Nz_wrap; ++k)
-  {
-    for (unsigned int j = 0; j < Ny_wrap; ++j)
-    {
-      for (unsigned int i = 0; i < Nx_wrap; ++i)
+      else
       {
-        unsigned int ii = i + lend, jj = j + bend, kk = k + dend;
-        for (unsigned int d = 0; d < dof; ++d)
-        {
-          Fe[d + dof * at(ii, jj, kk, Nx, Ny)] = Fe_wrap[d + dof * at(i, j, k, Nx_wrap, Ny_wrap)];
-        }
+        // the fold also reflects the boundary points onto themselves
+        if (active[0]) {for (unsigned int i = 0; i < lo + fold; ++i) {add(i, 2 * lo - i, 0);}}
+        if (active[1]) {for (unsigned int i = rbeg - fold; i < N; ++i) {add(i, 2 * rbeg - i - 2, 1);}}
       }
-    }
-  }
-  // periodic copy in x
-  if (periodic[0])
-  {
-    #pragma omp parallel
-    {  
-      // copy eulerian data in y-z plane in periodic region to ghost
-      #pragma omp for collapse(3)
-      for (unsigned int k = dend; k < ubeg; ++k)
+      // start a new stage at a pair that writes a point read or written by the stage,
+      // or reads a point written by it (pairs of a stage run in any order)
+      std::vector<bool> read(N, false), written(N, false);
+      for (unsigned int p = 0; p < ax.src.size(); ++p)
       {
-        for (unsigned int j = bend; j < tbeg; ++j)
+        if (written[ax.dst[p]] || read[ax.dst[p]] || written[ax.src[p]])
         {
-          // first copy right to left
-          for (unsigned int i = 0; i < lend; ++i)
-          {
-            unsigned int ipb = i + Nx_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
-            {
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = Fe[d + dof * at(ipb, j, k, Nx, Ny)]; 
-            }
-          }  
+          ax.stage.push_back(p);
+          read.assign(N, false); written.assign(N, false);
         }
+        read[ax.src[p]] = written[ax.dst[p]] = true;
       }
-      #pragma omp for collapse(3)
-      for (unsigned int k = dend; k < ubeg; ++k)
+      if (not ax.src.empty()) {ax.stage.push_back(ax.src.size());}
+      const unsigned int Nc[3] = {Nx, Ny, Nz};
+      for (unsigned int e = 0; e < 2; ++e)
       {
-        for (unsigned int j = bend; j < tbeg; ++j)
-        {
-          // now copy left to right
-          for (unsigned int i = rbeg; i < Nx; ++i)
-          {
-            unsigned int ipb = i - Nx_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0 ; d < dof; ++d)
-            {
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = Fe[d + dof * at(ipb, j, k, Nx, Ny)]; 
-            }
-          }
-        }
+        ax.row[e].resize((size_t) Nc[contiguous()] * dof);
+        for (size_t t = 0; t < ax.row[e].size(); ++t) {ax.row[e][t] = ax.sign[t % dof + dof * e];}
       }
     }
-  }
-  else
-  {
-    // get bc for left end of x 
-    const BC* bc_xl = &(BCs[0]);
-    // multiplier to enforce bc
-    double s;
-    for (unsigned int d = 0; d < dof; ++d)
-    {
-      // we only do something if bc is not none
-      if (bc_xl[d] != none)
-      { 
 
-        if (bc_xl[d] == mirror) s = 1.0;
-        if (bc_xl[d] == mirror_inv) s = -1.0;
-        // copy eulerian data in y-z plane in interior region to 
-        // adjacent ghost region at left end of x axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = dend; k < ubeg; ++k)
-        {
-          for (unsigned int j = bend; j < tbeg; ++j)
-          {
-            for (unsigned int i = 0; i < lend; ++i)
-            {
-              unsigned int ipb = 2 * lend - i;
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = s * Fe[d + dof * at(ipb, j, k, Nx, Ny)]; 
-            }
-          }
-        }
-      }
-    }
-    // get bc for right end of x
-    const BC* bc_xr = &(BCs[dof]); 
-    // no slip wall on x right
-    for (unsigned int d = 0; d < dof; ++d)
+    // dispatch run() on the type of the offsets and the layout of the dof
+    template<typename Real, bool Fold>
+    void dispatch(Real* Fe, double* Fe_wrap)
     {
-      // we only do something if bc is not none
-      if (bc_xr[d] != none)
-      { 
-        if (bc_xr[d] == mirror) s = 1.0;
-        if (bc_xr[d] == mirror_inv) s = -1.0;
-        // copy eulerian data in y-z plane in interior region to 
-        // adjacent ghost region at right end of x axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = dend; k < ubeg; ++k)
-        {
-          for (unsigned int j = bend; j < tbeg; ++j)
-          {
-            for (unsigned int i = rbeg; i < Nx; ++i)
-            {
-              unsigned int ipb = Nx_wrap - 2 - i + rbeg;
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = s * Fe[d + dof * at(ipb, j, k, Nx, Ny)]; 
-            }
-          }
-        }
-      }
+      const bool large = (size_t) Nx * Ny * Nz * dof > UINT_MAX;
+      if (large && planar) {run<Real, size_t, true, Fold>(Fe, Fe_wrap);}
+      else if (large) {run<Real, size_t, false, Fold>(Fe, Fe_wrap);}
+      else if (planar) {run<Real, unsigned int, true, Fold>(Fe, Fe_wrap);}
+      else {run<Real, unsigned int, false, Fold>(Fe, Fe_wrap);}
     }
-  }
-  // periodic copy in y
-  if (periodic[1])
-  {
-    #pragma omp parallel
-    { 
-      // copy eulerian data in x-z plane in periodic region to ghost
-      #pragma omp for collapse(3)
-      for (unsigned int k = dend; k < ubeg; ++k)
+
+    /* all the transfers of fold (Fold = true) or copy, in a single parallel region. Each
+       axis and stage ends with the barrier of its loop, so they run in order */
+    template<typename Real, typename Index, bool Planar, bool Fold>
+    void run(Real* Fe, double* Fe_wrap)
+    {
+      double* times = Fold ? fold_time : copy_time;
+      const Axis* axes = Fold ? fold_axes : copy_axes;
+      #pragma omp parallel
       {
-        for (unsigned int j = tbeg; j < Ny; ++j)
+        double t0 = omp_get_wtime();
+        if (not Fold)
         {
-          // first copy bottom to top
-          for (unsigned int i = 0; i < Nx; ++i)
+          interior<Real, Index, Planar, Fold>(Fe, Fe_wrap);
+          #pragma omp master
           {
-            unsigned int jpb = j - Ny_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
-            {
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = Fe[d + dof * at(i, jpb, k, Nx, Ny)]; 
-            }
+            const double t1 = omp_get_wtime(); times[3] += t1 - t0; t0 = t1;
           }
         }
-      }
-      #pragma omp for collapse(3)
-      for (unsigned int k = dend; k < ubeg; ++k)
-      {
-        for (unsigned int j = 0; j < bend; ++j)
-        {
-          // now copy top to bottom
-          for (unsigned int i = 0; i < Nx; ++i)
-          {
-            unsigned int jpb = j + Ny_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
-            {
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = Fe[d + dof * at(i, jpb, k, Nx, Ny)]; 
-            }
-          }  
-        }
-      }
-    }
-  }
-  else
-  {
-    // get bc for left end of y 
-    const BC* bc_yl = &(BCs[2 * dof]);
-    // multiplier to enforce bc
-    double s;
-    for (unsigned int d = 0; d < dof; ++d)
-    {
-      // we only do something if bc is not none
-      if (bc_yl[d] != none)
-      { 
-        if (bc_yl[d] == mirror) s = 1.0;
-        if (bc_yl[d] == mirror_inv) s = -1.0;
-        // copy eulerian data in x-z plane in interior region to 
-        // adjacent ghost region at bottom end of y axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = dend; k < ubeg; ++k)
+        for (unsigned int a = 0; a < 3; ++a)
         {
-          for (unsigned int j = 0; j < bend; ++j)
+          transfer<Real, Index, Planar, Fold>(axes[a], a, Fe);
+          #pragma omp master
           {
-            for (unsigned int i = 0; i < Nx; ++i)
-            {
-              unsigned int jpb = 2 * bend - j;
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = s * Fe[d + dof * at(i, jpb, k, Nx, Ny)]; 
-            }
+            const double t1 = omp_get_wtime(); times[a] += t1 - t0; t0 = t1;
           }
         }
-      }
-    }
-    // get bc for right end of y 
-    const BC* bc_yr = &(BCs[3 * dof]);
-    for (unsigned int d = 0; d < dof; ++d)
-    {
-      // we only do something if bc is not none
-      if (bc_yr[d] != none)
-      { 
-        if (bc_yr[d] == mirror) s = 1.0;
-        if (bc_yr[d] == mirror_inv) s = -1.0;
-        // copy of eulerian data in x-z plane in interior region to 
-        // adjacent ghost region at top end of y axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = dend; k < ubeg; ++k)
+        if (Fold)
         {
-          for (unsigned int j = tbeg; j < Ny; ++j)
+          interior<Real, Index, Planar, Fold>(Fe, Fe_wrap);
+          #pragma omp master
           {
-            for (unsigned int i = 0; i < Nx; ++i)
-            {
-              unsigned int jpb = Ny_wrap - 2 - j + tbeg;
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = s * Fe[d + dof * at(i, jpb, k, Nx, Ny)]; 
-            }
+            times[3] += omp_get_wtime() - t0;
           }
         }
       }
     }
-  }
-  // periodic copy in z
-  if (periodic[2])
-  {
-    #pragma omp parallel
+
+    // transfers along axis a, called by each thread of the parallel region
+    template<typename Real, typename Index, bool Planar, bool Fold>
+    void transfer(const Axis& ax, const unsigned int a, Real* Fe) const
     {
-      // copy eulerian data in x-y plane in periodic region to ghost
-      #pragma omp for collapse(3)
-      for (unsigned int k = ubeg; k < Nz; ++k)
+      // offsets of a step along x, y and z in the extended grid
+      const Index stride[3] = {pencil ? (Index) Nz : 1, pencil ? (Index) Nz * Nx : (Index) Nx,
+                               pencil ? 1 : (Index) Nx * Ny};
+      const Index Ne = (Index) Nx * Ny * Nz;
+      const unsigned int c = contiguous();
+      for (unsigned int s = 0; s + 1 < ax.stage.size(); ++s)
       {
-        for (unsigned int j = 0; j < Ny; ++j)
+        const unsigned int p0 = ax.stage[s], p1 = ax.stage[s + 1];
+        if (a != c)
         {
-          // first copy down to up
-          for (unsigned int i = 0; i < Nx; ++i)
+          // rows along the contiguous axis c, for each pair and coordinate along the other axis b
+          const unsigned int b = 3 - a - c;
+          const unsigned int nc = ax.hi[c] - ax.lo[c];
+          #pragma omp for collapse(2)
+          for (unsigned int ib = ax.lo[b]; ib < ax.hi[b]; ++ib)
           {
-            unsigned int kpb = k - Nz_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
+            for (unsigned int p = p0; p < p1; ++p)
             {
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = Fe[d + dof * at(i, j, kpb, Nx, Ny)]; 
+              const Index base = ib * stride[b] + ax.lo[c];
+              const Index src = base + ax.src[p] * stride[a], dst = base + ax.dst[p] * stride[a];
+              if (Planar)
+              {
+                for (unsigned int d = 0; d < dof; ++d)
+                {
+                  const double sign = ax.sign[d + dof * ax.end[p]];
+                  if (sign == 0) continue;
+                  const Real* in = Fe + src + Ne * d; Real* out = Fe + dst + Ne * d;
+                  #pragma omp simd
+                  for (unsigned int t = 0; t < nc; ++t)
+                  {
+                    if (Fold) {out[t] += sign * in[t];}
+                    else {out[t] = sign * in[t];}
+                  }
+                }
+              }
+              else
+              {
+                const double* sign = ax.row[ax.end[p]].data();
+                const Real* in = Fe + src * dof; Real* out = Fe + dst * dof;
+                #pragma omp simd
+                for (unsigned int t = 0; t < nc * dof; ++t)
+                {
+                  if (Fold) {out[t] += sign[t] * in[t];}
+                  else {out[t] = sign[t] != 0 ? sign[t] * in[t] : out[t];}
+                }
+              }
             }
           }
         }
-      }
-      #pragma omp for collapse(3)
-      for (unsigned int k = 0; k < dend; ++k)
-      {
-        for (unsigned int j = 0; j < Ny; ++j)
+        else
         {
-          // now copy up to down
-          for (unsigned int i = 0; i < Nx; ++i)
+          // pairs of each row along the transfer axis, for each point of the other two axes
+          const unsigned int b = c == 0 ? 1 : 0, e = c == 2 ? 1 : 2;
+          #pragma omp for collapse(2)
+          for (unsigned int ie = ax.lo[e]; ie < ax.hi[e]; ++ie)
           {
-            unsigned int kpb = k + Nz_wrap;
-            #pragma omp simd aligned(Fe: MEM_ALIGN)
-            for (unsigned int d = 0; d < dof; ++d)
+            for (unsigned int ib = ax.lo[b]; ib < ax.hi[b]; ++ib)
             {
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = Fe[d + dof * at(i, j, kpb, Nx, Ny)]; 
+              const Index base = ie * stride[e] + ib * stride[b];
+              for (unsigned int p = p0; p < p1; ++p)
+              {
+                const Index src = base + ax.src[p], dst = base + ax.dst[p];
+                const double* sign = &ax.sign[dof * ax.end[p]];
+                #pragma omp simd
+                for (unsigned int d = 0; d < dof; ++d)
+                {
+                  const Index in = atDof<Index, Planar>(d, src, dof, Ne);
+                  const Index out = atDof<Index, Planar>(d, dst, dof, Ne);
+                  if (Fold) {Fe[out] += sign[d] * Fe[in];}
+                  else {Fe[out] = sign[d] != 0 ? sign[d] * Fe[in] : Fe[out];}
+                }
+              }
             }
           }
         }
       }
     }
-  }
-  else
-  {
-    // get bc for left end of z 
-    const BC* bc_zl = &(BCs[4 * dof]);
-    // multiplier to enforce bc
-    double s;
-    for (unsigned int d = 0; d < dof; ++d)
+
+    /* copy the interior of Fe to Fe_wrap (Fold = true) or the reverse, with the
+       z-slabs of Fe_wrap split as in Grid::touchGrid() */
+    template<typename Real, typename Index, bool Planar, bool Fold>
+    void interior(Real* Fe, double* Fe_wrap) const
     {
-      // we only do something if bc is not none
-      if (bc_zl[d] != none)
-      { 
-        if (bc_zl[d] == mirror) s = 1.0;
-        if (bc_zl[d] == mirror_inv) s = -1.0;
-        // copy eulerian data in x-y plane in interior region to 
-        // adjacent ghost region at down end of z axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = 0; k < dend; ++k)
+      const unsigned int Nx_wrap = Nx - 2 * wx, Ny_wrap = Ny - 2 * wy;
+      const unsigned int Nz_wrap = Nz - ext_up - ext_down;
+      const Index stride[3] = {pencil ? (Index) Nz : 1, pencil ? (Index) Nz * Nx : (Index) Nx,
+                               pencil ? 1 : (Index) Nx * Ny};
+      const Index Ne = (Index) Nx * Ny * Nz, Ne_wrap = (Index) Nx_wrap * Ny_wrap * Nz_wrap;
+      #pragma omp for collapse(2)
+      for (unsigned int k = 0; k < Nz_wrap; ++k)
+      {
+        for (unsigned int j = 0; j < Ny_wrap; ++j)
         {
-          for (unsigned int j = 0; j < Ny; ++j)
+          const Index e = wx * stride[0] + (j + wy) * stride[1] + (k + ext_up) * stride[2];
+          const Index w = at<Index>(0, j, k, Nx_wrap, Ny_wrap);
+          if (not pencil)
           {
-            for (unsigned int i = 0; i < Nx; ++i)
+            // the rows are contiguous in both grids
+            const Index nt = Planar ? Nx_wrap : (Index) Nx_wrap * dof;
+            for (unsigned int d = 0; d < (Planar ? dof : 1); ++d)
             {
-              unsigned int kpb = 2 * dend - k;
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = s * Fe[d + dof * at(i, j, kpb, Nx, Ny)]; 
+              Real* fe = Fe + (Planar ? e + Ne * d : e * dof);
+              double* fw = Fe_wrap + (Planar ? w + Ne_wrap * d : w * dof);
+              #pragma omp simd
+              for (Index t = 0; t < nt; ++t)
+              {
+                if (Fold) {fw[t] = fe[t];}
+                else {fe[t] = fw[t];}
+              }
             }
           }
-        }
-      }
-    }
-    // get bc for right end of z
-    const BC* bc_zr = &(BCs[5 * dof]);  
-    for (unsigned int d = 0; d < dof; ++d)
-    {
-      // we only do something if bc is not none
-      if (bc_zr[d] != none)
-      { 
-        if (bc_zr[d] == mirror) s = 1.0;
-        if (bc_zr[d] == mirror_inv) s = -1.0;
-        // copy eulerian data in x-y plane in interior region to 
-        // adjacent ghost region at up end of z axis according to mirror or mirror_inv
-        #pragma omp parallel for collapse(3)
-        for (unsigned int k = ubeg; k < Nz; ++k)
-        {
-          for (unsigned int j = 0; j < Ny; ++j)
+          else
           {
-            for (unsigned int i = 0; i < Nx; ++i)
+            for (unsigned int i = 0; i < Nx_wrap; ++i)
             {
-              unsigned int kpb = 2 * ubeg - k - 2;
-              Fe[d + dof * at(i, j, k, Nx, Ny)] = s * Fe[d + dof * at(i, j, kpb, Nx, Ny)]; 
+              #pragma omp simd
+              for (unsigned int d = 0; d < dof; ++d)
+              {
+                const Index in = atDof<Index, Planar>(d, e + i * stride[0], dof, Ne);
+                const Index out = atDof<Index, Planar>(d, w + i, dof, Ne_wrap);
+                if (Fold) {Fe_wrap[out] = Fe[in];}
+                else {Fe[in] = Fe_wrap[out];}
+              }
             }
           }
         }
       }
     }
-  }
+};
+
+/* implements fold operation to de-ghostify spread data according to BCs
+   Specifically, this function
+    - copies data in the ghost region of the extended grid Fe to correct region of
+      the interior grid Fe_wrap
+    - if periodic[i] = true for axis i = 0,1 or 2, a periodic folding convention
+      where data adjacent to a ghost region are copied to the interior region
+      adjacent to the ghost region at the other end of the axis.
+    - if periodic[i] = false, then the fold op copies according to convention
+      dispatched by boundary condition on a given data component (dof). data in
+      the ghost region will be copied to the adjacent interior region.
+    - supported conventions are mirror, mirror_inv or none. mirror will copy
+      the data with no modification. mirror_inv will copy the negative of the
+      ghost data, and none will perform no copy
+    - the extended grid Fe may be single precision (Real = float), in which case
+      the data is converted to double on the copy to Fe_wrap
+    - the extended grid Fe may be stored z fastest (pencil = true), in which case
+      the transpose to the x fastest layout of Fe_wrap is done on the copy to Fe_wrap
+    - the components of Fe and Fe_wrap may be stored in contiguous planes (planar = true),
+      rather than interleaved (see Grid::setPlanarLayout())
+   The plan of the transfers is built on each call. To reuse it across calls,
+   use a GhostExchange (eg. Grid::ghost).
+*/
+template<typename Real>
+inline void fold(Real* Fe, double* Fe_wrap, const unsigned short wx,
+                 const unsigned short wy, const unsigned short ext_up,
+                 const unsigned short ext_down, const unsigned int Nx,
+                 const unsigned int Ny, const unsigned int Nz,
+                 const unsigned int dof, bool* periodic, const BC* BCs,
+                 const bool pencil = false, const bool planar = false)
+{
+  GhostExchange ghost;
+  ghost.plan(wx, wy, ext_up, ext_down, Nx, Ny, Nz, dof, periodic, BCs, pencil, planar);
+  ghost.fold(Fe, Fe_wrap);
+}
+
+/* implements copy opertion to enforce periodicity of eulerian data before interpolation
+   Specifically, this function
+    - copies data on the interior grid Fe_wrap to the ghost region of the
+      extended grid Fe
+    - if periodic[i] = true for axis i = 0,1 or 2, a periodic folding convention
+      where interior data adjacent to a ghost region are copied to the ghost
+      region at the other end of the axis.
+    - if periodic[i] = false, then the fold op copies according to convention
+      dispatched by boundary condition on a given data component (dof)
+    - supported conventions are mirror, mirror_inv or none. mirror will copy
+      the adjacent data to the ghost region. mirror_inv will copy the negative of the
+      adjacent data to the ghost region, and none will perform no copy
+    - the extended grid Fe may be single precision (Real = float), in which case
+      the data is converted to/from double on the copy to/from Fe_wrap
+    - the extended grid Fe may be stored z fastest (pencil = true), in which case
+      the transpose from the x fastest layout of Fe_wrap is done on the copy from Fe_wrap
+    - the components of Fe and Fe_wrap may be stored in contiguous planes (planar = true)
+   The plan of the transfers is built on each call, as for fold().
+*/
+template<typename Real>
+inline void copy(Real* Fe, const double* Fe_wrap, const unsigned short wx,
+                 const unsigned short wy, const unsigned short ext_up,
+                 const unsigned short ext_down, const unsigned int Nx,
+                 const unsigned int Ny, const unsigned int Nz,
+                 const unsigned int dof, bool* periodic, const BC* BCs,
+                 const bool pencil = false, const bool planar = false)
+{
+  GhostExchange ghost;
+  ghost.plan(wx, wy, ext_up, ext_down, Nx, Ny, Nz, dof, periodic, BCs, pencil, planar);
+  ghost.copy(Fe, Fe_wrap);
 }
+
 #endif
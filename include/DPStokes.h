@@ -0,0 +1,110 @@
+#ifndef DPSTOKES_H
+#define DPSTOKES_H
+#include "Memory.h"
+#include "FFTWTraits.h"
+
+/* Geometries of the doubly periodic Stokes solver, ie. the no wall, bottom wall
+   and slit channel solvers of Solvers.py */
+enum DPGeometry {no_wall, bottom_wall, slit_channel};
+
+/* DPStokes is an SoA holding the precomputed operators of the doubly periodic
+   Stokes solvers (DoublyPeriodicStokes_init() in Solvers.py) on a grid with a
+   Chebyshev z axis, so that a solve is a single threaded call on the Fourier-Chebyshev
+   coefficients of the forces (eg. the output of a forward Transform with cheb = true),
+   which overwrites them with those of the velocity.
+
+   For each wave number (kx, ky), the Nz coefficients in z of the pressure and of the
+   velocity are solved for as in DoublyPeriodicStokes_no_wall() (two banded Schur
+   complement solves, for the pressure and for u, v, w, see LinearSolvers.h), and for
+   a wall, the analytical correction of DoublyPeriodicStokes_bottom_wall() or
+   _slit_channel() is added (see DPTools.h). The wave numbers are independent, so a
+   thread gathers the columns of a group of W wave numbers into its workspace, solves
+   and scatters the velocity back, with no temporaries the size of the grid. The
+   pentadiagonal solves with A run across the group in SIMD lanes (see pentaSolveT() in
+   LinearSolvers.h), and the rest one wave number at a time.
+
+ * kx, ky        - wave numbers of each axis (2 pi k / L, for k = 0,..,N/2-1,-N/2,..,-1
+                   as in DoublyPeriodicStokes_init()). If real, kx holds the first Nx/2 + 1
+ * z             - Chebyshev points in z on [0, 2H] (z[0] = 2H is the top wall)
+ * SIMat, FIMat  - second and first Chebyshev integral matrices (Nz x Nz + 2, column major,
+                   scaled by H^2 and H, see Chebyshev.py)
+ * pints, uvints - integrals of the Chebyshev polynomials for the k = 0 mode (see precomputeInts())
+ * LU, PIV       - LU factors of the banded block A of the solve of each wave number
+                   ((2 * kl + ku + 1) x Nz x Nyx, with kl = ku = 2, and Nz x Nyx)
+ * PLU, PLUmask - factors of A with no pivoting, interleaved across each group of W =
+                   PentaLanes<Real>::W consecutive wave numbers (5 x W x Nz per group, see
+                   pentaFactorT()), and the bit mask of the lanes of each group that are
+                   solved with LU, PIV instead
+ * Ainv_B, C     - A^{-1} B (Nz x 2 x Nyx) and the BC block C (2 x Nz x Nyx) of each wave number
+ * Ginv          - inverse of the 2 x 2 Schur complement C A^{-1} B - D of each wave number
+ * C_k0, Ginv_k0 - C (2 x Nz) and G^{-1} (2 x 2) of the k = 0 mode, for each DPGeometry
+                   (the no wall BCs, and those of the bottom and top wall corrections)
+ * work          - per thread workspace of the solves (workSize() elements per thread)
+ * plan          - forward fftw plan of the Chebyshev transforms of the corrections
+ * Nx, Ny, Nz    - number of points of the grid in each axis
+ * Nxs, Nyx      - number of points in x of the spectrum (Nx / 2 + 1 if real, Nx otherwise),
+                   and Ny * Nxs
+ * H, eta        - half the extent of the z axis, and viscosity
+ * planar        - whether the 3 components of the spectrum are stored in planes
+                   (see Grid::setPlanarLayout()), or interleaved
+ * real          - whether the spectrum is the half spectrum of a real transform
+ * kmajor        - whether the spectrum is stored wavenumber-major (see Transform.h),
+                   so that the columns in z are contiguous
+
+ NOTES: - the spectrum is in the layout of Transform, so a solve can run in place on the
+          output of the forward transform, and the backward transform on its output.
+          Any of the layouts can be used, but kmajor is the one that streams.
+        - the k = 0 mode of the no wall solve is 0 unless k0 = 1, as in Solvers.py. The
+          wall solves always handle it.
+        - as in Solvers.py, the force is taken to be 0 outside of [0, 2H], so its z component
+          should vanish at both ends of the z axis (as a spread force does when the grid
+          extends past the particles), or the velocity is not divergence free.
+        - the operators are computed in double precision, and stored in the precision
+          of the solver, so DPStokesF solves in single precision as the single = True
+          operators of DoublyPeriodicStokes_init() do.
+*/
+
+template<typename Real>
+struct DPStokesT
+{
+  Real *kx, *ky, *z, *SIMat, *FIMat, *pints, *uvints;
+  Real *LU, *PLU, *Ainv_B, *C, *Ginv, *C_k0, *Ginv_k0, *work;
+  int* PIV;
+  unsigned int* PLUmask;
+  typename FFTW<Real>::plan plan;
+  unsigned int Nx, Ny, Nz, Nxs, Nyx, nthreads;
+  Real H, eta;
+  bool planar, real, kmajor;
+
+  /* empty/null ctor */
+  DPStokesT();
+  /* precompute the operators for an Nx x Ny x Nz grid spanning Lx x Ly x 2H */
+  DPStokesT(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+            const double Lx, const double Ly, const double H, const double eta,
+            const bool planar = false, const bool real = false, const bool kmajor = false);
+  void setup(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+             const double Lx, const double Ly, const double H, const double eta,
+             const bool planar, const bool real, const bool kmajor);
+  /* solve in geometry geom for the Fourier-Chebyshev coefficients of the velocity,
+     given those of the force in fhat_r, fhat_i (Nz * Ny * Nxs * 3 each), which are
+     overwritten with the velocity. The coefficients of the pressure are written
+     to phat_r, phat_i (Nz * Ny * Nxs, ordered as a component of the spectrum),
+     unless they are 0. k0 is the switch of DoublyPeriodicStokes_no_wall().
+     The solve runs in the workspace of the solver, so it is not reentrant: 
+     concurrent solves need a solver each */
+  void solve(Real* fhat_r, Real* fhat_i, const DPGeometry geom, const int k0 = 0,
+             Real* phat_r = 0, Real* phat_i = 0);
+  /* number of elements of the spectrum */
+  size_t spectralSize() const {return (size_t) Nz * Nyx * 3;}
+  /* number of elements of the workspace of each thread */
+  size_t workSize() const;
+  // bytes held by each allocated buffer (see Memory.h)
+  MemoryReport memoryReport() const;
+  void cleanup();
+};
+
+// double and single precision solvers (for the spectra of Transform and TransformF)
+typedef DPStokesT<double> DPStokes;
+typedef DPStokesT<float> DPStokesF;
+
+#endif
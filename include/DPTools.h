@@ -1,5 +1,7 @@
 #ifndef _DPTOOLS_H
 #define _DPTOOLS_H
+#include<stddef.h>
+#include"FFTWTraits.h"
 
 extern "C"
 {
@@ -83,5 +85,51 @@ extern "C"
                                      const double* Kx, const double* Ky, const double* z, double Lz, 
                                      double eta, unsigned int Nyx, unsigned int Nz, unsigned int dof);
 
+  /* single precision versions of the corrections above (fftwf and LAPACK's cgesv), 
+     for the single precision pipeline (see TransformF in Transform.h) */
+  void evalCorrectionSol_bottomWallF(float* Cpcorr_r, float* Cpcorr_i, float* Cucorr_r, 
+                                     float* Cucorr_i, float* Cvcorr_r, float* Cvcorr_i,
+                                     float* Cwcorr_r, float* Cwcorr_i, const float* fhat_r,
+                                     const float* fhat_i, const float* Kx, const float* Ky, 
+                                     const float* z, float eta, unsigned int Nyx, 
+                                     unsigned int Nz, unsigned int dof);
+  void evalCorrectionSol_slitChannelF(float* Cpcorr_r, float* Cpcorr_i, float* Cucorr_r, 
+                                      float* Cucorr_i, float* Cvcorr_r, float* Cvcorr_i,
+                                      float* Cwcorr_r, float* Cwcorr_i, const float* fbhat_r, 
+                                      const float* fbhat_i, const float* fthat_r, const float* fthat_i, 
+                                      const float* Kx, const float* Ky, const float* z, float Lz, 
+                                      float eta, unsigned int Nyx, unsigned int Nz, unsigned int dof);
 }
+
+/* The per wave number kernels of the functions above, for C++ callers that run the
+   DP solves one wave number at a time (see DPStokes.h). Each is instantiated for 
+   double and float, with the fftw plan of that precision.
+
+     chebTransformT - chebTransform() of N values, with work (see below) as the buffer 
+                      of the transform instead of a new allocation
+     bottomWallCorrectionK, slitChannelCorrectionK - the correction at one wave number
+                      (kx, ky) != 0 of evalCorrectionSol_bottomWall() and _slitChannel(),
+                      for the velocities fhat (or fbhat, fthat) of the 3 components at 
+                      the walls, into the Nz coefficients of each C(p,u,v,w)corr_(r,i)
+
+   work must hold correctionWorkSize(Nz) elements, aligned as from alignedMalloc(),
+   and plan must be a forward in place plan of 2 * Nz - 2 points (as in the functions above) */
+inline size_t correctionWorkSize(unsigned int Nz) {return 16 * (size_t) Nz;}
+
+template<typename Real>
+void chebTransformT(const Real* in_re, const Real* in_im, Real* out_re, Real* out_im, 
+                    const typename FFTW<Real>::plan plan, unsigned int N, Real* work);
+template<typename Real>
+void bottomWallCorrectionK(Real* Cpcorr_r, Real* Cpcorr_i, Real* Cucorr_r, Real* Cucorr_i, 
+                           Real* Cvcorr_r, Real* Cvcorr_i, Real* Cwcorr_r, Real* Cwcorr_i, 
+                           const Real* fhat_r, const Real* fhat_i, Real kx, Real ky, 
+                           const Real* z, Real eta, unsigned int Nz, 
+                           const typename FFTW<Real>::plan plan, Real* work);
+template<typename Real>
+void slitChannelCorrectionK(Real* Cpcorr_r, Real* Cpcorr_i, Real* Cucorr_r, Real* Cucorr_i, 
+                            Real* Cvcorr_r, Real* Cvcorr_i, Real* Cwcorr_r, Real* Cwcorr_i, 
+                            const Real* fbhat_r, const Real* fbhat_i, const Real* fthat_r, 
+                            const Real* fthat_i, Real kx, Real ky, const Real* z, Real H, 
+                            Real eta, unsigned int Nz, const typename FFTW<Real>::plan plan, 
+                            Real* work);
 #endif
@@ -0,0 +1,84 @@
+#ifndef FFTW_TRAITS_H
+#define FFTW_TRAITS_H
+#include<fftw3.h>
+
+/* The parts of the fftw interface used by Transform and the DP tools, for each
+   precision: FFTW<double> calls fftw_* (libfftw3) and FFTW<float> calls fftwf_*
+   (libfftw3f). The iodims and r2r kinds are the same types in both.
+
+ NOTES: - the two precisions keep separate wisdom and thread setup, so
+          init_threads() must be called for each precision that is used.
+*/
+
+template<typename Real> struct FFTW;
+
+#define FFTW_TRAITS(R, X)                                                              \
+template<> struct FFTW<R>                                                              \
+{                                                                                      \
+  typedef X##_plan plan;                                                               \
+  typedef X##_complex complex;                                                         \
+  static int init_threads() {return X##_init_threads();}                               \
+  static void plan_with_nthreads(int n) {X##_plan_with_nthreads(n);}                   \
+  static plan plan_split_dft(int rank, const fftw_iodim64* dims, int hrank,            \
+                             const fftw_iodim64* hdims, R* ri, R* ii, R* ro, R* io,    \
+                             unsigned flags)                                           \
+  {                                                                                    \
+    return X##_plan_guru64_split_dft(rank, dims, hrank, hdims, ri, ii, ro, io, flags); \
+  }                                                                                    \
+  static plan plan_split_dft_r2c(int rank, const fftw_iodim64* dims, int hrank,        \
+                                 const fftw_iodim64* hdims, R* in, R* ro, R* io,       \
+                                 unsigned flags)                                       \
+  {                                                                                    \
+    return X##_plan_guru64_split_dft_r2c(rank, dims, hrank, hdims, in, ro, io, flags); \
+  }                                                                                    \
+  static plan plan_split_dft_c2r(int rank, const fftw_iodim64* dims, int hrank,        \
+                                 const fftw_iodim64* hdims, R* ri, R* ii, R* out,      \
+                                 unsigned flags)                                       \
+  {                                                                                    \
+    return X##_plan_guru64_split_dft_c2r(rank, dims, hrank, hdims, ri, ii, out, flags);\
+  }                                                                                    \
+  static plan plan_r2r(int rank, const fftw_iodim64* dims, int hrank,                  \
+                       const fftw_iodim64* hdims, R* in, R* out,                       \
+                       const fftw_r2r_kind* kind, unsigned flags)                      \
+  {                                                                                    \
+    return X##_plan_guru64_r2r(rank, dims, hrank, hdims, in, out, kind, flags);        \
+  }                                                                                    \
+  static plan plan_dft_1d(int n, complex* in, complex* out, int sign, unsigned flags)  \
+  {                                                                                    \
+    return X##_plan_dft_1d(n, in, out, sign, flags);                                   \
+  }                                                                                    \
+  static void execute_split_dft(const plan p, R* ri, R* ii, R* ro, R* io)              \
+  {                                                                                    \
+    X##_execute_split_dft(p, ri, ii, ro, io);                                          \
+  }                                                                                    \
+  static void execute_split_dft_r2c(const plan p, R* in, R* ro, R* io)                 \
+  {                                                                                    \
+    X##_execute_split_dft_r2c(p, in, ro, io);                                          \
+  }                                                                                    \
+  static void execute_split_dft_c2r(const plan p, R* ri, R* ii, R* out)                \
+  {                                                                                    \
+    X##_execute_split_dft_c2r(p, ri, ii, out);                                         \
+  }                                                                                    \
+  static void execute_r2r(const plan p, R* in, R* out) {X##_execute_r2r(p, in, out);}  \
+  static void execute_dft(const plan p, complex* in, complex* out)                     \
+  {                                                                                    \
+    X##_execute_dft(p, in, out);                                                       \
+  }                                                                                    \
+  static void destroy_plan(plan p) {X##_destroy_plan(p);}                              \
+  static int alignment_of(R* p) {return X##_alignment_of(p);}                          \
+  static int import_wisdom(const char* fname)                                          \
+  {                                                                                    \
+    return X##_import_wisdom_from_filename(fname);                                     \
+  }                                                                                    \
+  static int export_wisdom(const char* fname)                                          \
+  {                                                                                    \
+    return X##_export_wisdom_to_filename(fname);                                       \
+  }                                                                                    \
+};
+
+FFTW_TRAITS(double, fftw)
+FFTW_TRAITS(float, fftwf)
+
+#undef FFTW_TRAITS
+
+#endif
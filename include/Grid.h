@@ -2,19 +2,32 @@
 #define GRID_H
 #include<ostream>
 #include"BoundaryConditions.h"
+#include"Memory.h"
 
 /* Grid is an SoA describing the domain and its data
 
  * fG                     - forces on the grid
  * fG_unwrap              - forces on extended grid (used internally for BCs)
+ * fG_unwrap_f            - single precision extended grid (used instead of fG_unwrap if single = true)
+ * fG_hat_r, fG_hat_i     - real and imaginary parts of the spectrum of fG, for transforms bound to 
+                            the grid (only allocated by setupSpectral(), see Transform.h)
+ * single                 - bool indicating whether spreading/interpolation use a single precision extended grid
+ * pencil                 - bool indicating whether the extended grid is stored z fastest (see setPencilLayout())
+ * planar                 - bool indicating whether the dof components are stored in planes (see setPlanarLayout())
+ * nrhs                   - number of data vectors (right-hand sides) interleaved on the grid. The
+                            components of each grid point are ordered as d + dof1 * r, for component d 
+                            of vector r, where dof1 = dof / nrhs. So, dof is the total for all vectors.
  * xG, yG, zG             - grids for each axis (sorted in inc or dec order) (see below)
  * Lx, Ly, Lz, hx, hy, hz - length and grid spacing in each dimension 
  *                        - if hx > 0, xG should be Null (same for y,z)
  *                        - if hx = 0, xG must be allocated (same for y,z)
  * Nxeff, Nyeff, Nzeff    - num points in each dimension for EXTENDED grid
+ * zG_ext, zG_ext_wts     - z grid and weights on the EXTENDED grid (only populated if unifZ = false)
  * has_locator            - bool indicating whether a grid locator has been constructed
  * isperiodic             - bool array indicating whether periodicity is on or off for each axis
  * has_bc                 - bool array indicating whether BCs for each dof are specified
+ * ghost                  - plan of the fold/copy of the extended grid (see BoundaryConditions.h), 
+                            built on the first fold/copy for the current sizes, ghost widths and BCs
  * firstn, nextn          - enables the lookup of particles in terms of columns of the grid 
                             for column ind, grid.firstn[ind] = i1 is the index of the first particle in the column
                             grid.nextn[i1] = i2 is the index of the next particle in the column, and so on.
@@ -24,31 +37,80 @@
 struct Grid
 {
   double *fG, *fG_unwrap, *xG, *yG, *zG, *zG_wts; 
+  double *zG_ext, *zG_ext_wts;
+  double *fG_hat_r, *fG_hat_i;
+  float* fG_unwrap_f;
   int *firstn, *nextn;
   unsigned int* number;
-  unsigned int Nx, Ny, Nz, dof;
+  unsigned int Nx, Ny, Nz, dof, nrhs;
   double Lx, Ly, Lz;
   double hx, hy, hz;
   unsigned int Nxeff, Nyeff, Nzeff;
-  bool has_locator, has_bc, unifZ;
+  bool has_locator, has_bc, unifZ, single, pencil, planar;
   // bool array specifying if grid is periodic in direction i
   // and another bool to make sure this array is populated
   bool isperiodic[3], has_periodicity;
   // enum for boundary conditions for each dof at the ends of each axis (dof x 6)
   BC* BCs;
+  // plan and timings of the fold/copy
+  GhostExchange ghost;
   
   /* empty/null ctor */
   Grid();
-  /* set up Grid based on what caller has provided */
+  /* set up Grid based on what caller has provided. This can be called again
+     after changing the sizes (eg. with setN(), seth()), in which case fG is 
+     reused if it is large enough, and the particles must be located again
+     (see ParticleList::reset()) */
   void setup();
+  /* Drop the particle locator and the extension of the grid, keeping all buffers.
+     The next ParticleList::locateOnGrid() then reuses the extended grid and locator
+     buffers if they are large enough (see alignedReserve() in Memory.h) */
+  void reset();
   void setL(const double Lx, const double Ly, const double Lz);
   void setN(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz);
   void seth(const double hx, const double hy, const double hz);
   void setZ(const double* zpts, const double* zwts);  
   void setPeriodicity(bool x, bool y, bool z);
   void setBCs(const BC* BCs);
+  /* Use a single precision extended grid for spreading and interpolation.
+     This must be called before the particles are located on the grid */
+  void setSinglePrecision(bool single);
+  /* Store the extended grid z fastest, as dof x Nzeff x Nxeff x Nyeff, so that
+     each (x,y) pair of a column is a contiguous run of Nzeff points. The fold/copy
+     (see BoundaryConditions.h) then transposes to/from the x fastest layout of fG.
+     This must be called before the particles are located on the grid */
+  void setPencilLayout(bool pencil);
+  /* Store the dof components of fG and the extended grid in contiguous planes,
+     so component d of point p is at p + N * d (N = Nx * Ny * Nz, or the extended
+     size), rather than interleaved at d + dof * p. fold/copy, Transform (with 
+     planar = true) and the solvers then work on unit-stride data for each component.
+     This must be called before the particles are located on the grid */
+  void setPlanarLayout(bool planar);
+  /* Set the number of data vectors (right-hand sides) on the grid. This
+     multiplies dof by nrhs, replicates the BCs of one vector for each of 
+     them and reallocates the interior and extended grids. Spreading and
+     interpolation then evaluate the kernel weights once for all vectors.
+     The ParticleList must be given the same nrhs (see ParticleList::setNumRHS()).
+     dof and the BCs (of one vector) must be set before this is called. */
+  void setNumRHS(const unsigned int nrhs);
+  /* whether the extended grid data (Nxeff * Nyeff * Nzeff * dof) has too many 
+     elements to be indexed with unsigned int, in which case spreading, 
+     interpolation and the BC fold/copy use 64-bit offsets */
+  bool largeIndex() const;
+  /* Allocate the spectrum of fG for transforms bound to the grid (see Transform.h).
+     If real, fG_hat_r and fG_hat_i hold the half spectrum (Nz x Ny x (Nx/2+1) x dof).
+     Otherwise, the complex transforms run in place, so fG_hat_r is fG and only
+     fG_hat_i (the size of fG) is allocated. This must be called after setup() */
+  void setupSpectral(const bool real);
   /* zero the extended grid */
   void zeroExtGrid();
+  /* zero fG according to the placement policy (see Memory.h). With first_touch,
+     threads zero z-slabs, the partition of fold/copy (see BoundaryConditions.h) */
+  void touchGrid();
+  /* zero the extended grid according to the placement policy (see Memory.h). With
+     first_touch, threads zero blocks of (x,y) columns, the partition of spreading and
+     interpolation (see SpreadInterp.h) */
+  void touchExtGrid();
   /* Create a valid triply periodic grid. The caller only provides these params */
   void makeTP(const double Lx, const double Ly, const double Lz, 
               const double hx, const double hy, const double hz,
@@ -62,6 +124,8 @@ struct Grid
               const unsigned int Nz, const unsigned int dof);
   /* clean memory */
   void cleanup();
+  /* bytes held by each allocated buffer (see Memory.h) */
+  MemoryReport memoryReport() const;
   /* check validity of current state */
   bool validState() const;
   
@@ -1,5 +1,6 @@
 #ifndef _LINEAR_SOLVERS_H
 #define _LINEAR_SOLVERS_H
+#include <stddef.h>
 extern "C"
 {
   /* compute LU of banded matrix A as well as X in AX = B
@@ -15,6 +16,68 @@ extern "C"
                         double* FIMat, double* SIMat, double* Cp, double* Dp, int kl, int ku, int Nyx, int Nz);
   void bandedSchurSolve_noD(double* LU, double* RHS, double* bc_RHS, int* PIV, double* C, double* GINV, double* AINVB,
                            double* SIMat, double* Cp, int kl, int ku, int Nyx, int Nz);
+  /* batched form of the above, for the nrhs right-hand sides of each wave number that
+     share its LU factors (eg. the real and imaginary parts of the pressure, or of u, v
+     and w), which are solved with one dgbtrs call and one Schur correction. RHS, Cp and 
+     Dp are Nz x nrhs x Nyx, and bc_RHS is 2 x nrhs x Nyx. With bc_RHS = 0 it is 
+     bandedSchurSolve(), and with FIMat = Dp = 0 it is bandedSchurSolve_noD() */
+  void bandedSchurSolveBatched(double* LU, double* RHS, double* bc_RHS, int* PIV, double* C,
+                               double* GINV, double* AINVB, double* FIMat, double* SIMat,
+                               double* Cp, double* Dp, int kl, int ku, int Nyx, int Nz, int nrhs);
+
+  /* single precision versions of the above (LAPACK's sgbsv/sgbtrs instead of 
+     dgbsv/dgbtrs), for the single precision pipeline (see TransformF in Transform.h). 
+     All the operators must then be precomputed in single precision */
+  void precomputeBandedLinOpsF(float* A, float* B, float* C, 
+                               float* D, float* G, float* G_inv, int* PIV, int kl, 
+                               int ku, int Nyx, int Nz);
+  void bandedSchurSolveF(float* LU, float* RHS, int* PIV, float* C, float* GINV, float* AINVB,
+                         float* FIMat, float* SIMat, float* Cp, float* Dp, int kl, int ku, int Nyx, int Nz);
+  void bandedSchurSolve_noDF(float* LU, float* RHS, float* bc_RHS, int* PIV, float* C, float* GINV, 
+                             float* AINVB, float* SIMat, float* Cp, int kl, int ku, int Nyx, int Nz);
+  void bandedSchurSolveBatchedF(float* LU, float* RHS, float* bc_RHS, int* PIV, float* C,
+                                float* GINV, float* AINVB, float* FIMat, float* SIMat,
+                                float* Cp, float* Dp, int kl, int ku, int Nyx, int Nz, int nrhs);
 }
 
+/* The templates behind the functions above, for C++ callers that hold the operators
+   in either precision (see DPStokes.h). precomputeBandedLinOpsT is precomputeBandedLinOps(F), 
+   and bandedSchurSolveK is the solve at one wave number of bandedSchurSolve(F) (with
+   bc_rhs = 0) and bandedSchurSolve_noD(F) (with FIMat = dp = 0), where lu, piv, c, ginv 
+   and ainvb are the operators of that wave number, rhs (Nz x nrhs) is overwritten and 
+   x ((Nz + 2) x nrhs) is scratch. Both are instantiated for double and float. */
+template<typename Real>
+void precomputeBandedLinOpsT(Real* A, Real* B, Real* C, Real* D, Real* G, Real* G_inv,
+                             int* PIV, int kl, int ku, int Nyx, int Nz);
+template<typename Real>
+void bandedSchurSolveK(const Real* lu, Real* rhs, const Real* bc_rhs, const int* piv, 
+                       const Real* c, const Real* ginv, const Real* ainvb, const Real* SIMat,
+                       const Real* FIMat, Real* x, Real* cp, Real* dp, int kl, int ku, int Nz,
+                       int nrhs = 1);
+
+/* schurCorrectK is bandedSchurSolveK for a rhs that already holds lu^{-1}*rhs (eg. from 
+   pentaSolveT below), ie. the Schur complement correction and the integral matrices only */
+template<typename Real>
+void schurCorrectK(Real* rhs, const Real* bc_rhs, const Real* c, const Real* ginv,
+                   const Real* ainvb, const Real* SIMat, const Real* FIMat, Real* x, Real* cp,
+                   Real* dp, int Nz, int nrhs = 1);
+
+/* Pentadiagonal (kl = ku = 2) solves of the A blocks, vectorized across wave numbers.
+   Groups of W = PentaLanes<Real>::W wave numbers (4 in double, 8 in single precision,
+   ie. one 256 bit register) are factored without pivoting, with the factors of each row
+   stored interleaved across the group (the two subdiagonals of L, the reciprocal pivot
+   and the two superdiagonals of U, 5 x W per row), so that the substitutions run one
+   wave number per SIMD lane instead of one dgbtrs call per wave number.
+ * pentaFactorT factors the nlanes <= W blocks at ab, ab + stride,... (LAPACK band format 
+   with kl = ku = 2, as A before precomputeBandedLinOpsT) into F (5 x W x Nz), with the
+   identity in the unused lanes. It returns the bit mask of the lanes with a pivot below
+   sqrt(eps) times its row of A, which should be solved with the pivoted LU instead.
+ * pentaSolveT overwrites X with A^{-1} X, for the nrhs right-hand sides of each lane
+   stored as X[(r * Nz + j) * W + lane] */
+template<typename Real> struct PentaLanes {static const int W = 32 / sizeof(Real);};
+template<typename Real>
+unsigned int pentaFactorT(const Real* ab, size_t stride, int nlanes, Real* F, int Nz);
+template<typename Real>
+void pentaSolveT(const Real* F, Real* X, int Nz, int nrhs);
+
 #endif
@@ -0,0 +1,144 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+#include<stddef.h>
+#include<vector>
+#include<ostream>
+
+/* Allocator policy for the buffers of Grid, ParticleList, Transform,
+   SpreadOperator, spreading/interpolation and the solver tools.
+
+ * every buffer is aligned to MEM_ALIGN bytes (64 by default, the width of
+   an AVX-512 register). This is the alignment assumed by the
+   omp simd aligned(...: MEM_ALIGN) clauses, so it must not be lowered below
+   what any buffer in those clauses gets.
+ * buffers of at least the huge page threshold (HUGEPAGE_MIN bytes by default,
+   see setHugePageThreshold()) are allocated from a huge page boundary and marked with
+   madvise(MADV_HUGEPAGE), so the kernel backs them with transparent huge pages. The
+   pointer returned is MEM_ALIGN bytes past that boundary (the bookkeeping header sits 
+   in between), so it is MEM_ALIGN aligned but not huge page aligned.
+ * the bytes currently allocated and the peak are tracked, and every allocation
+   and free is reported to the accounting hook, if one is set (see setAllocHook()).
+   The hot loops do not allocate: their scratch (eg. the column buffers of
+   spreading/interpolation) is allocated once per thread per call, so the counters,
+   the hook and the huge page path only see buffers that outlive a loop iteration.
+ * pages are placed on NUMA nodes by first touch. With the default placement
+   policy (first_touch), the large buffers are zeroed right after allocation with
+   the same OpenMP static partition as the hot loops that use them, so each page
+   lands on the node of the thread that works on it (see Grid::touchGrid(),
+   Grid::touchExtGrid() and firstTouch()). This only pays off if the threads do not
+   migrate, so run with eg. OMP_PROC_BIND=close OMP_PLACES=cores. With serial_touch,
+   the buffers are zeroed by the calling thread (all pages on one node), and with
+   no_touch they are left to be placed by whichever loop touches them first.
+
+ * memory reports list the bytes of each buffer held by an object (see 
+   Grid::memoryReport(), ParticleList::memoryReport(), Transform::memoryReport()),
+   and estimateMemory() predicts them for a problem size before anything is allocated.
+
+ NOTES: - buffers from alignedMalloc() must be released with alignedFree()
+          (not free() or fftw_free()), and vice versa.
+        - alignedMalloc() returns 0 if the allocation fails, like malloc().
+*/
+
+#ifndef MEM_ALIGN
+  #define MEM_ALIGN 64
+#endif
+
+#ifndef HUGEPAGE_MIN
+  #define HUGEPAGE_MIN (4UL << 20)
+#endif
+
+// size (and alignment) of a transparent huge page
+#define HUGEPAGE_SIZE (2UL << 20)
+
+// placement policy of the pages of large buffers (see above)
+enum Placement {no_touch, serial_touch, first_touch};
+
+// accounting hook, called with allocated = true after each allocation
+// and allocated = false before each free
+typedef void (*AllocHook)(const void* ptr, size_t bytes, bool allocated);
+
+// allocate and free a buffer of bytes bytes according to the policy above
+void* alignedMalloc(size_t bytes);
+void alignedFree(void* ptr);
+/* return a buffer of at least bytes bytes, reusing ptr (from alignedMalloc() or 0)
+   if its capacity suffices. Otherwise, ptr is freed and a buffer of the larger of
+   bytes and 3/2 the old capacity is allocated, so buffers that keep growing are 
+   reallocated a logarithmic number of times. The contents are not preserved */
+void* alignedReserve(void* ptr, size_t bytes);
+// capacity in bytes of a buffer from alignedMalloc() (0 if ptr is 0)
+size_t alignedCapacity(const void* ptr);
+// set the accounting hook (0 to remove it)
+void setAllocHook(AllocHook hook);
+// set the size in bytes above which buffers are backed by huge pages
+void setHugePageThreshold(size_t bytes);
+// bytes currently allocated, and the maximum since the start of the program
+size_t allocatedBytes();
+size_t peakAllocatedBytes();
+// set and get the placement policy (first_touch by default)
+void setPlacement(Placement placement);
+Placement getPlacement();
+
+/* zero the n elements of buf according to the placement policy. This is
+   for buffers used in loops with a static partition over the elements,
+   like the particle arrays, and must be called before the buffer is filled */
+template<typename T>
+inline void firstTouch(T* buf, const size_t n)
+{
+  const Placement placement = getPlacement();
+  if (placement == first_touch)
+  {
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i) {buf[i] = T(0);}
+  }
+  else if (placement == serial_touch)
+  {
+    for (size_t i = 0; i < n; ++i) {buf[i] = T(0);}
+  }
+}
+
+// a named buffer and its size (capacity) in bytes
+struct BufferBytes
+{
+  const char* name;
+  size_t bytes;
+};
+typedef std::vector<BufferBytes> MemoryReport;
+
+// add buffer ptr (from alignedMalloc()) to report, if it is allocated
+inline void addBuffer(MemoryReport& report, const char* name, const void* ptr)
+{
+  if (ptr) {report.push_back({name, alignedCapacity(ptr)});}
+}
+/* copy the first n entries of report to names and bytes (for the C wrappers), 
+   returning the number of entries in the report */
+inline unsigned int copyReport(const MemoryReport& report, const char** names, 
+                               size_t* bytes, const unsigned int n)
+{
+  for (unsigned int i = 0; i < n && i < report.size(); ++i) 
+  {
+    names[i] = report[i].name; bytes[i] = report[i].bytes;
+  }
+  return report.size();
+}
+// total bytes of a report
+size_t totalBytes(const MemoryReport& report);
+// write a report as a table of buffers, bytes and MiB, followed by the total
+void writeMemoryReport(const MemoryReport& report, std::ostream& outputStream);
+
+/* Dry-run estimate of the buffers allocated to spread, transform and interpolate 
+   on an Nx x Ny x Nz grid with dof components and nP particles, whose kernels span at
+   most wx, wy and wz grid points along each axis (for dp = true, wz is the max number 
+   of Chebyshev points in the support of a kernel, which bounds the ghost layers in z). 
+   The entries are those of the memory reports of Grid, ParticleList and Transform, and 
+   of the Python Transformer, plus the column workspaces of spreading for nthreads threads. Summing them (see totalBytes())
+   bounds the peak, since it assumes the forward and backward transforms are alive 
+   at once, as in the examples.
+
+   single and cache_weights are as in Grid::setSinglePrecision() and ParticleList::setWeightCache() */
+MemoryReport estimateMemory(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+                            const unsigned int dof, const unsigned int nP, 
+                            const unsigned short wx, const unsigned short wy, const unsigned short wz, 
+                            const bool dp, const bool single = false, 
+                            const bool cache_weights = false, const unsigned int nthreads = 1);
+
+#endif
@@ -4,6 +4,7 @@
 #include<unordered_set>
 #include<tuple>
 #include<functional>
+#include"Memory.h"
 
 /*
  *  ParticleList is an SoA describing the particle set.
@@ -20,7 +21,27 @@
  *  wfxP, wfyP, wfzP - actual width we use for each direction
  *  unique_monopoles - unique ES kernels, automatically freed when ParticleList exits scope
  *  zoffset - offset index in the z direction for each particle
- *  pt_wts - the kernel weights for each particle (only populated if grid.unifZ = false)
+ *  nodeP - index of the first grid node of the stencil of each particle along x, y and z
+ *          (nodeP[3 * i + d]). For z, this is an index into grid.zG_ext if grid.unifZ = false.
+ *          The offsets of the stencil nodes from the particle and the z quadrature weights
+ *          are regenerated from these when needed (see stencils())
+ *  nrhs - number of data vectors (right-hand sides) on the particles, ordered 
+ *         as fP[d + dof1 * r + dof * i] for component d of vector r on particle i, 
+ *         where dof1 = dof / nrhs 
+ *  cache_weights - if true, the separable kernel weights are cached on the first spread/interp 
+ *                  and reused until the particles are moved or relocated (see setWeightCache())
+ *  kxP, kyP, kzP - cached normalized 1D kernel weights for each particle (nP x wf(x,y,z)P_max)
+ *  nlayers - number of distinct z-layers (0 if the layered path is disabled, see findLayers())
+ *  max_layers - the layered path is used only if nlayers <= max_layers
+ *  layerP - z-layer index of each particle
+ *  zkern_layer - normalized z kernel weights for each layer (nlayers x wfzP_max)
+ *  zwts_layer - z quadrature weights for each layer (only populated if grid.unifZ = false)
+ *  reorder - if true, the particles are stored internally in Morton order of their
+ *            (x column, y column, z) cell on the grid, rather than the caller's order (see setReordering())
+ *  reorder_tol - fraction of out-of-order neighbors above which update() reorders again
+ *  perm - internal index -> caller index of each particle (null if the order is the caller's)
+ *  iperm - caller index -> internal index of each particle (null if the order is the caller's)
+ *  fP_out - buffer for data on the particles in the caller's order (see getForces())
 */
 
 /* first  define some types to minimize work during initialization. eg. for es, we need to compute
@@ -56,8 +77,17 @@ struct Grid;
 struct ParticleList
 {
   double *xP, *fP;
-  double *xunwrap, *yunwrap, *zunwrap, *pt_wts;
+  int *nodeP;
   unsigned int *zoffset;
+  unsigned short *layerP;
+  double *zkern_layer, *zwts_layer;
+  unsigned int nlayers, max_layers, nrhs;
+  double *kxP, *kyP, *kzP;
+  bool cache_weights;
+  unsigned int *perm, *iperm;
+  double *fP_out;
+  bool reorder;
+  double reorder_tol;
   double *radP, *betafP, *normfP, *alphafP, *cwfP; 
   unsigned short *wfP, *wfxP, *wfyP, *wfzP;
   unsigned short wfxP_max, wfyP_max, wfzP_max;
@@ -74,16 +104,29 @@ struct ParticleList
               const unsigned int nP, const unsigned int dof);
   /* setup ParticleList based on what caller has provided */
   void setup(Grid& grid);
+  /* Locate the particles on the grid again from scratch, eg. after the grid was 
+     resized (see Grid::setup()). Unlike cleanup() followed by setup(grid), the
+     extended grid and the locator buffers are kept and reused if they are large 
+     enough, so parameter sweeps do not reallocate them (see Grid::reset()) */
+  void reset(Grid& grid);
   /* finds unique kernels and computes normalization using clenshaw-curtis quadrature */
   void setup();
   /* clean memory */ 
   void cleanup();
+  /* bytes held by each allocated buffer (see Memory.h) */
+  MemoryReport memoryReport() const;
   /* normalize ES kernels using clenshaw-curtis quadrature*/
   void normalizeKernels();
   /* find unique ES kernels */
   void findUniqueKernels();
   /* set data on particles */
   void setForces(const double* _fP, unsigned int dof); 
+  /* set the number of data vectors (right-hand sides) on the particles.
+     This multiplies dof by nrhs and reallocates fP (zeroed). It must match 
+     the nrhs of the grid (see Grid::setNumRHS()) */
+  void setNumRHS(const unsigned int nrhs);
+  /* get data on the particles in the caller's order */
+  const double* getForces();
   /* set forces to 0 */
   void zeroForces();
   /* Locate the particles in terms of the columns of the grid,
@@ -94,12 +137,11 @@ struct ParticleList
       - wf(x,y,z)P the widths given the grids on each axis
       - wf(x,y,z)P_max the max widths, used for extending the grid
       - grid.N(x,y,z)eff - the number of points on extended grid axes
-      - allocates grid.fG_unwrap based on above extended size
-      - (x,y,z)unwrap - the grid points in x,y,z for each particle
-                        given the width of their kernels, in unwrapped
-                        coordinates.
+      - allocates grid.fG_unwrap (or grid.fG_unwrap_f if grid.single) based on above extended size
+      - nodeP - the first grid point of the stencil in x,y,z for each particle
+                given the width of their kernels, in unwrapped coordinates.
       - zoffset, the offset in the z direction for each particle
-      - for NonUnifZ, the weights (pt_wts) for each particle given its width
+      - for NonUnifZ, the extended z grid and weights (grid.zG_ext, grid.zG_ext_wts)
   
       - MOST IMPORTANTLY, grid.firstn and grid.nextn are computed. These
         partition the particles on the grid into columns. 
@@ -110,6 +152,50 @@ struct ParticleList
   void locateOnGrid(Grid& grid);
   void locateOnGridUnifZ(Grid& grid);
   void locateOnGridNonUnifZ(Grid& grid);
+  /* Detect whether the particles lie on a small number of z-layers,
+     i.e. groups of particles sharing the same height and kernel. 
+     If there are at most max_layers of them, the z kernel weights 
+     are evaluated once per layer and stored in zkern_layer, and 
+     spreading/interpolation switches to a separable path where the
+     x-y weights are applied as a 2D operation followed by an outer
+     product with the layer weights in z. Otherwise, nlayers = 0 
+     and the general path is used. */
+  void findLayers(const Grid& grid);
+  /* set the max number of z-layers for which the layered path is used */
+  void setMaxLayers(const unsigned int max_layers);
+  /* Turn on or off caching of kernel weights. If on, the ES kernel is 
+     separated into normalized 1D weights for each particle, which are
+     evaluated on the first call to spread() or interpolate() and reused
+     by subsequent calls. The cache is invalidated by update() and locateOnGrid(),
+     so repeated spread/interp at fixed positions skip kernel evaluation */
+  void setWeightCache(bool cache_weights);
+  /* Regenerate the stencils of the particles indx[0:npts] from nodeP. 
+     For particle indx[ipt], this writes the offsets of its stencil nodes from 
+     the particle along each axis to (x,y,z)unwrap[j + ipt * wf(x,y,z)P_max] and, 
+     if grid.unifZ = false, the quadrature weights of its z stencil nodes 
+     (times hx * hy) to pt_wts[k + ipt * wfzP_max]. The entries beyond the width 
+     of a particle's kernel are 0. Any of the outputs may be null, in which case it is skipped */
+  void stencils(const Grid& grid, const unsigned int* indx, const unsigned int npts,
+                double* xunwrap, double* yunwrap, double* zunwrap, double* pt_wts) const;
+  /* evaluate the 1D kernel weights in kxP, kyP, kzP */
+  void evalWeights(const Grid& grid);
+  /* free the cached kernel weights */
+  void clearWeights();
+  /* Turn on or off reordering of the particles along a space-filling curve.
+     If on, setup(grid) sorts all per-particle arrays in Morton order of
+     the (x column, y column, z) cell of each particle, so particles that are close
+     on the grid are close in memory. The permutation is applied to data entering
+     through setForces() and update(), and inverted for data leaving through 
+     getForces() and writeParticles(), so callers never see it. Other accessors 
+     (xP, radP, etc.) are in the internal order. After update(), the particles are 
+     reordered again if more than a fraction tol of them are out of order with 
+     respect to their predecessor. This must be called before setup(grid). */
+  void setReordering(bool reorder, double tol = 0.25);
+  /* sort the particles in Morton order of the cells of the positions x (in internal order),
+     permuting all per-particle arrays and the grid locator, if there is one */
+  void reorderParticles(Grid& grid, const double* x);
+  /* fraction of particles whose Morton key is smaller than that of their predecessor */
+  double disorder(const Grid& grid, const double* x) const;
   /* 
      Update the particle positions and search data structure 
      
@@ -6,9 +6,7 @@
   #include<iostream> 
 #endif
 
-#ifndef MEM_ALIGN
-  #define MEM_ALIGN 16 
-#endif
+#include"Memory.h"
 
 /* Main routines and helpers for spreading and interpolation, with
    the appropriate routines dispatched based on
@@ -28,6 +26,28 @@
           - the member grid.fG is overwritten with the spread data
           - the member particle.fP is overwritten with interp data
           - the member grid.fG_unwrap is modified during both spread and interp
+   Precision:
+          - if grid.single = true (see Grid::setSinglePrecision()), the extended
+            grid is grid.fG_unwrap_f, and the kernel weights and column buffers 
+            are float. Particle positions and kernel offsets remain double, and 
+            interpolation accumulates on the particles in double. 
+   Multiple right-hand sides:
+          - if grid.nrhs = particles.nrhs > 1, the data vectors are interleaved
+            as extra components of each point (see Grid::setNumRHS()), so the 
+            kernel weights of a column are evaluated once and applied to all of them.
+   Indexing:
+          - offsets into the extended grid are 32-bit unless the extended grid data 
+            has more than 2^32 - 1 elements (see Grid::largeIndex()), in which case
+            they are 64-bit. Offsets within a column are always 32-bit.
+   Layout:
+          - if grid.pencil = true (see Grid::setPencilLayout()), the extended grid is
+            stored z fastest, so the gather/scatter of a column reads/writes contiguous
+            runs of Nzeff points for each (i,j) pair. fold() and copy() must then be 
+            called with pencil = true, and do the transpose to/from grid.fG.
+          - if grid.planar = true (see Grid::setPlanarLayout()), the components of 
+            grid.fG and the extended grid are stored in contiguous planes (component d 
+            of point p is at p + N * d), and fold() and copy() must be called with planar = true.
+            The column buffers stay interleaved, so the kernels are unchanged.
 */
 
 
@@ -39,65 +59,194 @@ struct ParticleList;
 void spread(ParticleList& particles, Grid& grid); 
 void interpolate(ParticleList& particles, Grid& grid);
 
-// spread with z uniform or not
+// spread with z uniform or not (dispatches on grid.single and grid.largeIndex())
 void spreadUnifZ(ParticleList& particles, Grid& grid);
 void spreadNonUnifZ(ParticleList& particles, Grid& grid);
-// interpolate with z uniform or not
+// interpolate with z uniform or not (dispatches on grid.single and grid.largeIndex())
 void interpUnifZ(ParticleList& particles, Grid& grid);
 void interpNonUnifZ(ParticleList& particles, Grid& grid);
+// spread/interpolate with the extended grid fG_unwrap in precision Real,
+// with offsets into fG_unwrap computed in the integer type Index
+template<typename Real, typename Index> 
+void spreadUnifZ(ParticleList& particles, Grid& grid, Real* fG_unwrap);
+template<typename Real, typename Index> 
+void spreadNonUnifZ(ParticleList& particles, Grid& grid, Real* fG_unwrap);
+template<typename Real, typename Index> 
+void interpUnifZ(ParticleList& particles, Grid& grid, Real* fG_unwrap);
+template<typename Real, typename Index> 
+void interpNonUnifZ(ParticleList& particles, Grid& grid, Real* fG_unwrap);
 
 // ES kernel definition (two versions for optimization testing)
 #pragma omp declare simd
-inline double const esKernel(const double x, const double beta, const double alpha)
+inline double esKernel(const double x, const double beta, const double alpha)
 {
   return exp(beta * (sqrt(1 - x * x / (alpha * alpha)) - 1));
 }
 
 #pragma omp declare simd
-inline double const esKernel(const double x[3], const double beta, const double alpha)
+inline double esKernel(const double x[3], const double beta, const double alpha)
 {
   return exp(beta * (sqrt(1 - x[0] * x[0] / (alpha * alpha)) - 1)) * \
          exp(beta * (sqrt(1 - x[1] * x[1] / (alpha * alpha)) - 1)) * \
          exp(beta * (sqrt(1 - x[2] * x[2] / (alpha * alpha)) - 1));
 }
 
+// single precision ES kernel (used when grid.single = true)
+#pragma omp declare simd
+inline float esKernel(const float x, const float beta, const float alpha)
+{
+  return expf(beta * (sqrtf(1 - x * x / (alpha * alpha)) - 1));
+}
+
+#pragma omp declare simd
+inline float esKernel(const float x[3], const float beta, const float alpha)
+{
+  return expf(beta * (sqrtf(1 - x[0] * x[0] / (alpha * alpha)) - 1)) * \
+         expf(beta * (sqrtf(1 - x[1] * x[1] / (alpha * alpha)) - 1)) * \
+         expf(beta * (sqrtf(1 - x[2] * x[2] / (alpha * alpha)) - 1));
+}
+
 // flattened index into 3D array
-inline unsigned int const at(unsigned int i, unsigned int j,unsigned int k,\
-                             const unsigned int Nx, const unsigned int Ny)
+inline unsigned int at(unsigned int i, unsigned int j,unsigned int k,\
+                       const unsigned int Nx, const unsigned int Ny)
 {
   return i + Nx * (j + Ny * k);
 }
 
-// gather data from src at inds into trg
-template<typename T> 
-inline void gather(unsigned int N, T* trg, T const* src, 
-                   const unsigned int* inds, const unsigned int dof)
+// flattened index into 3D array, computed in the integer type Index 
+// (eg. size_t for arrays with more than 2^32 elements)
+template<typename Index>
+inline Index at(const Index i, const Index j, const Index k, 
+                const Index Nx, const Index Ny)
+{
+  return i + Nx * (j + Ny * k);
+}
+
+// offset of component d of the point at offset pt in a grid with N points and dof 
+// components, which are interleaved (d + dof * pt) or planar (pt + N * d) if Planar = true
+// (see Grid::setPlanarLayout())
+template<typename Index, bool Planar>
+inline Index atDof(const Index d, const Index pt, const Index dof, const Index N)
+{
+  return Planar ? pt + N * d : d + dof * pt;
+}
+
+// flattened index into the extended grid, which is stored x fastest as in at(), 
+// or z fastest (k + Nz * (i + Nx * j)) if Pencil = true (see Grid::setPencilLayout())
+template<typename Index, bool Pencil>
+inline Index atExt(const Index i, const Index j, const Index k, 
+                   const Index Nx, const Index Ny, const Index Nz)
+{
+  return Pencil ? k + Nz * (i + Nx * j) : i + Nx * (j + Ny * k);
+}
+
+// gather data from src at inds into trg (converting if the types differ).
+// The offsets into src are computed in size_t, so a 32-bit inds (eg. particle
+// indices) can address arrays of more than 2^32 elements
+template<typename T, typename S, typename Index> 
+inline void gather(unsigned int N, T* trg, S const* src, 
+                   const Index* inds, const unsigned int dof)
 {
   for (unsigned int i = 0; i < N; ++i) 
   {
     for (unsigned int j = 0; j < dof; ++j)
     {
-      trg[j + dof * i] = src[j + dof * inds[i]];
+      trg[j + dof * i] = src[j + (size_t) dof * inds[i]];
     }
   }
 }
 
-// scatter data from trg into src at inds
-template<typename T>
-inline void scatter(unsigned int N, T const* trg, T* src, 
-                    const unsigned int* inds, const unsigned int dof)
+// scatter data from trg into src at inds (converting if the types differ)
+template<typename T, typename S, typename Index>
+inline void scatter(unsigned int N, T const* trg, S* src, 
+                    const Index* inds, const unsigned int dof)
 {
   for (unsigned int i = 0; i < N; ++i) 
   {
     for (unsigned int j = 0; j < dof; ++j)
     {
-      src[j + dof * inds[i]] = trg[j + dof * i];
+      src[j + (size_t) dof * inds[i]] = trg[j + dof * i];
+    }
+  }
+}
+
+// gather data from a component-planar src (component j of point p at p + N * j) 
+// at inds into trg (interleaved, as for gather()). 
+template<typename T, typename S, typename Index> 
+inline void gather_planar(unsigned int n, T* trg, S const* src, const Index* inds, 
+                          const unsigned int dof, const Index N)
+{
+  for (unsigned int j = 0; j < dof; ++j)
+  {
+    S const* srcj = &(src[N * j]);
+    for (unsigned int i = 0; i < n; ++i) 
+    {
+      trg[j + dof * i] = srcj[inds[i]];
     }
   }
 }
 
-// evaluate the delta function weights for the current column for UnifZ = True
-inline void delta_eval_col(double* delta, const double* betafPc,
+// scatter data from trg (interleaved) into a component-planar src at inds
+template<typename T, typename S, typename Index>
+inline void scatter_planar(unsigned int n, T const* trg, S* src, const Index* inds, 
+                           const unsigned int dof, const Index N)
+{
+  for (unsigned int j = 0; j < dof; ++j)
+  {
+    S* srcj = &(src[N * j]);
+    for (unsigned int i = 0; i < n; ++i) 
+    {
+      srcj[inds[i]] = trg[j + dof * i];
+    }
+  }
+}
+
+// gather the w2 x Nz subarray of a column from a z fastest extended grid src into trg
+// (x fastest and interleaved, as for gather()). plane[m] is the offset of the first z 
+// point for the m-th (i,j) pair of the column, and component j of point p is at 
+// src[j * ds + ps * p] (ds = 1, ps = dof if interleaved, ds = N, ps = 1 if planar), 
+// so each pair is a contiguous stream of Nz points
+template<typename T, typename S, typename Index>
+inline void gather_pencil(const unsigned int w2, const unsigned int Nz, T* trg, 
+                          S const* src, const Index* plane, const unsigned int dof,
+                          const Index ds, const Index ps)
+{
+  for (unsigned int m = 0; m < w2; ++m)
+  {
+    for (unsigned int j = 0; j < dof; ++j)
+    {
+      S const* srcm = &(src[ds * j + ps * plane[m]]);
+      for (unsigned int k = 0; k < Nz; ++k)
+      {
+        trg[j + dof * (m + w2 * k)] = srcm[ps * k];
+      }
+    }
+  }
+}
+
+// scatter the w2 x Nz subarray of a column in trg into a z fastest extended grid src
+template<typename T, typename S, typename Index>
+inline void scatter_pencil(const unsigned int w2, const unsigned int Nz, T const* trg, 
+                           S* src, const Index* plane, const unsigned int dof,
+                           const Index ds, const Index ps)
+{
+  for (unsigned int m = 0; m < w2; ++m)
+  {
+    for (unsigned int j = 0; j < dof; ++j)
+    {
+      S* srcm = &(src[ds * j + ps * plane[m]]);
+      for (unsigned int k = 0; k < Nz; ++k)
+      {
+        srcm[ps * k] = trg[j + dof * (m + w2 * k)];
+      }
+    }
+  }
+}
+
+// evaluate the delta function weights for the current column for UnifZ = True.
+// The offsets are double, but the kernel is evaluated and stored in precision Real
+template<typename Real>
+inline void delta_eval_col(Real* delta, const double* betafPc,
                            const unsigned short* wfPc, const double* normfPc, 
                            const double* xunwrap, const double* yunwrap, 
                            const double* zunwrap, const double alphafP, const int npts, 
@@ -105,7 +254,7 @@ inline void delta_eval_col(double* delta, const double* betafPc,
                            const unsigned short wz, const unsigned short wfxP_max,
                            const unsigned short wfyP_max, const unsigned short wfzP_max)
 {
-  alignas(MEM_ALIGN) double x[3];
+  alignas(MEM_ALIGN) Real x[3];
   #pragma omp simd aligned(delta,betafPc,normfPc,xunwrap,yunwrap,zunwrap: MEM_ALIGN), collapse(3)
   for (unsigned int k = 0; k < wz; ++k)
   {
@@ -114,13 +263,14 @@ inline void delta_eval_col(double* delta, const double* betafPc,
       for (unsigned int i = 0; i < wx; ++i)
       {
         unsigned int m = at(i, j, k, wx, wy);
-        for (unsigned int ipt = 0; ipt < npts; ++ipt)
+        for (int ipt = 0; ipt < npts; ++ipt)
         {
           double norm = normfPc[ipt]; norm *= norm * norm;;
           x[0] = xunwrap[i + ipt * wfxP_max];
           x[1] = yunwrap[j + ipt * wfyP_max];
           x[2] = zunwrap[k + ipt * wfzP_max];
-          delta[ipt + m * npts] = esKernel(x, betafPc[ipt] * wfPc[ipt], alphafP) / norm;
+          delta[ipt + m * npts] = esKernel(x, (Real) (betafPc[ipt] * wfPc[ipt]), 
+                                           (Real) alphafP) / norm;
         }
       }
     }
@@ -128,7 +278,8 @@ inline void delta_eval_col(double* delta, const double* betafPc,
 }
 
 // evaluate the delta function weights for the current column for UnifZ = false
-inline void delta_eval_col(double* delta, const double* betafPc,
+template<typename Real>
+inline void delta_eval_col(Real* delta, const double* betafPc,
                            const unsigned short* wfPc, const double* normfPc, 
                            const double* xunwrap, const double* yunwrap, 
                            const double* zunwrap, const double alphafP, const int npts, 
@@ -136,8 +287,8 @@ inline void delta_eval_col(double* delta, const double* betafPc,
                            const unsigned short* wz, const unsigned short wfxP_max,
                            const unsigned short wfyP_max, const unsigned short wfzP_max)
 {
-  alignas(MEM_ALIGN) double x[3];
-  for (unsigned int ipt = 0; ipt < npts; ++ipt)
+  alignas(MEM_ALIGN) Real x[3];
+  for (int ipt = 0; ipt < npts; ++ipt)
   {
     for (unsigned int k = 0; k < wz[ipt]; ++k)
     {
@@ -150,15 +301,110 @@ inline void delta_eval_col(double* delta, const double* betafPc,
           x[0] = xunwrap[i + ipt * wfxP_max];
           x[1] = yunwrap[j + ipt * wfyP_max];
           x[2] = zunwrap[k + ipt * wfzP_max];
-          delta[ipt + m * npts] = esKernel(x, betafPc[ipt] * wfPc[ipt], alphafP) / norm;
+          delta[ipt + m * npts] = esKernel(x, (Real) (betafPc[ipt] * wfPc[ipt]), 
+                                           (Real) alphafP) / norm;
+        }
+      }
+    }
+  }
+}
+
+// evaluate the 1D x and y kernel weights for each particle in the current column.
+// This is used by the layered path (see ParticleList::findLayers()), where the
+// full kernel is the product of these with the z weights of the particle's layer
+template<typename Real>
+inline void delta_eval_col_xy(Real* deltax, Real* deltay, const double* betafPc,
+                              const unsigned short* wfPc, const double* normfPc,
+                              const double* xunwrap, const double* yunwrap, 
+                              const double alphafP, const int npts, 
+                              const unsigned short wx, const unsigned short wy,
+                              const unsigned short wfxP_max, const unsigned short wfyP_max)
+{
+  for (int ipt = 0; ipt < npts; ++ipt)
+  {
+    const Real betaw = betafPc[ipt] * wfPc[ipt], norm = normfPc[ipt], alpha = alphafP;
+    #pragma omp simd
+    for (unsigned int i = 0; i < wx; ++i)
+    {
+      deltax[i + ipt * wx] = esKernel((Real) xunwrap[i + ipt * wfxP_max], betaw, alpha) / norm;
+    }
+    #pragma omp simd
+    for (unsigned int j = 0; j < wy; ++j)
+    {
+      deltay[j + ipt * wy] = esKernel((Real) yunwrap[j + ipt * wfyP_max], betaw, alpha) / norm;
+    }
+  }
+}
+
+// form the delta function weights for the current column for UnifZ = true
+// from the cached 1D weights of each particle (see ParticleList::evalWeights())
+template<typename Real>
+inline void delta_col_cached(Real* delta, const double* kxc, const double* kyc,
+                             const double* kzc, const int npts, 
+                             const unsigned short wx, const unsigned short wy, 
+                             const unsigned short wz, const unsigned short wfxP_max,
+                             const unsigned short wfyP_max, const unsigned short wfzP_max)
+{
+  for (unsigned int k = 0; k < wz; ++k)
+  {
+    for (unsigned int j = 0; j < wy; ++j)
+    {
+      for (unsigned int i = 0; i < wx; ++i)
+      {
+        unsigned int m = at(i, j, k, wx, wy);
+        #pragma omp simd
+        for (int ipt = 0; ipt < npts; ++ipt)
+        {
+          delta[ipt + m * npts] = kxc[i + ipt * wfxP_max] * kyc[j + ipt * wfyP_max] * 
+                                  kzc[k + ipt * wfzP_max];
+        }
+      }
+    }
+  }
+}
+
+// form the delta function weights for the current column for UnifZ = false
+// from the cached 1D weights of each particle
+template<typename Real>
+inline void delta_col_cached(Real* delta, const double* kxc, const double* kyc,
+                             const double* kzc, const int npts, 
+                             const unsigned short wx, const unsigned short wy, 
+                             const unsigned short* wz, const unsigned short wfxP_max,
+                             const unsigned short wfyP_max, const unsigned short wfzP_max)
+{
+  for (int ipt = 0; ipt < npts; ++ipt)
+  {
+    for (unsigned int k = 0; k < wz[ipt]; ++k)
+    {
+      for (unsigned int j = 0; j < wy; ++j)
+      {
+        const double kyz = kyc[j + ipt * wfyP_max] * kzc[k + ipt * wfzP_max];
+        for (unsigned int i = 0; i < wx; ++i)
+        {
+          delta[ipt + at(i, j, k, wx, wy) * npts] = kxc[i + ipt * wfxP_max] * kyz;
         }
       }
     }
   }
 }
 
+// copy the cached 1D x and y weights of each particle for the layered path
+template<typename Real>
+inline void delta_col_xy_cached(Real* deltax, Real* deltay, const double* kxc, 
+                                const double* kyc, const int npts, 
+                                const unsigned short wx, const unsigned short wy,
+                                const unsigned short wfxP_max, const unsigned short wfyP_max)
+{
+  for (int ipt = 0; ipt < npts; ++ipt)
+  {
+    for (unsigned int i = 0; i < wx; ++i) {deltax[i + ipt * wx] = kxc[i + ipt * wfxP_max];}
+    for (unsigned int j = 0; j < wy; ++j) {deltay[j + ipt * wy] = kyc[j + ipt * wfyP_max];}
+  }
+}
+
 // spread the delta functions weights for the column for UnifZ = true
-inline void spread_col(double* Fec, const double* delta, const double* flc,
+template<typename Real>
+inline void spread_col(Real* Fec, const Real* delta, const Real* flc,
                        const unsigned int* zoffset, const int npts,
                        const int w3, const int dof)
 {
@@ -176,7 +422,8 @@ inline void spread_col(double* Fec, const double* delta, const double* flc,
 }
 
 // spread with forces and weights for the column for UnifZ = false
-inline void spread_col(double* Fec, const double* delta, const double* flc,
+template<typename Real>
+inline void spread_col(Real* Fec, const Real* delta, const Real* flc,
                        const unsigned int* zoffset, const int npts,
                        const int w2, const unsigned short* wz, const int dof)
 {
@@ -192,8 +439,59 @@ inline void spread_col(double* Fec, const double* delta, const double* flc,
   }
 }
 
-// interpolate with the forces and weights for the current column for UNIFORM Z
-inline void interp_col(const double* Fec, const double* delta, double* flc, 
+// spread with the separable weights for the column for the layered path.
+// The particles in the column must be sorted by layer. For each layer, the forces
+// are spread onto a wx x wy plane, which is then extruded in z with the layer weights
+template<typename Real>
+inline void spread_col_layer(Real* Fec, Real* plane, const Real* deltax, 
+                             const Real* deltay, const Real* flc, 
+                             const unsigned short* layerPc, const double* zkern_layer,
+                             const unsigned int* zoffset, const int npts, 
+                             const unsigned short wx, const unsigned short wy, 
+                             const unsigned short* wz, const unsigned short wfzP_max,
+                             const int dof)
+{
+  const unsigned int w2 = wx * wy;
+  int ipt = 0;
+  while (ipt < npts)
+  {
+    const int first = ipt;
+    const unsigned short layer = layerPc[first];
+    for (unsigned int m = 0; m < w2 * dof; ++m) {plane[m] = 0;}
+    // 2D spread of every particle on this layer
+    for (; ipt < npts && layerPc[ipt] == layer; ++ipt)
+    {
+      for (unsigned int j = 0; j < wy; ++j)
+      {
+        for (unsigned int i = 0; i < wx; ++i)
+        {
+          const Real wxy = deltax[i + ipt * wx] * deltay[j + ipt * wy];
+          for (int d = 0; d < dof; ++d)
+          {
+            plane[d + dof * (i + wx * j)] += wxy * flc[d + dof * ipt];
+          }
+        }
+      }
+    }
+    // outer product with the z weights of the layer
+    const double* zk = &(zkern_layer[layer * wfzP_max]);
+    for (unsigned int k = 0; k < wz[first]; ++k)
+    {
+      Real* Fek = &(Fec[dof * (w2 * k + zoffset[first])]);
+      const Real zkk = zk[k];
+      #pragma omp simd
+      for (unsigned int m = 0; m < w2 * dof; ++m)
+      {
+        Fek[m] += zkk * plane[m];
+      }
+    }
+  }
+}
+
+// interpolate with the forces and weights for the current column for UNIFORM Z.
+// The grid data and weights are in precision Real, but we accumulate in double
+template<typename Real>
+inline void interp_col(const Real* Fec, const Real* delta, double* flc, 
                        const unsigned int* zoffset, const int npts, 
                        const int w3, const int dof, const double weight)
 {
@@ -203,7 +501,7 @@ inline void interp_col(const double* Fec, const double* delta, double* flc,
     {
       for (unsigned int j = 0; j < dof; ++j)
       { 
-        flc[j + dof * ipt] += Fec[j + dof * (i + zoffset[ipt])] * 
+        flc[j + dof * ipt] += (double) Fec[j + dof * (i + zoffset[ipt])] * 
                                 delta[ipt + i * npts] * weight; 
       }
     }
@@ -212,7 +510,8 @@ inline void interp_col(const double* Fec, const double* delta, double* flc,
 
 
 // interpolate with the forces and weights for the current column for NON-UNIFORM Z
-inline void interp_col(const double* Fec, const double* delta, double* flc, 
+template<typename Real>
+inline void interp_col(const Real* Fec, const Real* delta, double* flc, 
                        const unsigned int* zoffset, const int npts, 
                        const unsigned short wx, const unsigned short wy, 
                        const unsigned short* wz, const unsigned short wfzP_max, 
@@ -229,7 +528,7 @@ inline void interp_col(const double* Fec, const double* delta, double* flc,
           unsigned int m = at(i, j, k, wx, wy);
           for (unsigned int d = 0; d < dof; ++d)
           {
-            flc[d + dof * ipt] += Fec[d + dof * (m + zoffset[ipt])] * 
+            flc[d + dof * ipt] += (double) Fec[d + dof * (m + zoffset[ipt])] * 
                                     delta[ipt + m * npts] * weight[k + ipt * wfzP_max];
           } 
         }
@@ -238,4 +537,57 @@ inline void interp_col(const double* Fec, const double* delta, double* flc,
   }
 }
 
+// interpolate with the separable weights for the column for the layered path.
+// The particles in the column must be sorted by layer. For each layer, the data is
+// contracted in z with the layer weights onto a wx x wy plane, which is then 
+// interpolated on each particle of the layer. If zwts_layer is null, the 
+// quadrature weight is the constant weight.
+template<typename Real>
+inline void interp_col_layer(const Real* Fec, double* plane, const Real* deltax, 
+                             const Real* deltay, double* flc, 
+                             const unsigned short* layerPc, const double* zkern_layer,
+                             const double* zwts_layer, const double weight,
+                             const unsigned int* zoffset, const int npts, 
+                             const unsigned short wx, const unsigned short wy, 
+                             const unsigned short* wz, const unsigned short wfzP_max,
+                             const int dof)
+{
+  const unsigned int w2 = wx * wy;
+  int ipt = 0;
+  while (ipt < npts)
+  {
+    const int first = ipt;
+    const unsigned short layer = layerPc[first];
+    const double* zk = &(zkern_layer[layer * wfzP_max]);
+    const double* zw = (zwts_layer ? &(zwts_layer[layer * wfzP_max]) : 0);
+    for (unsigned int m = 0; m < w2 * dof; ++m) {plane[m] = 0;}
+    // contract the column data with the z weights of the layer
+    for (unsigned int k = 0; k < wz[first]; ++k)
+    {
+      const double wk = zk[k] * (zw ? zw[k] : weight);
+      const Real* Fek = &(Fec[dof * (w2 * k + zoffset[first])]);
+      #pragma omp simd
+      for (unsigned int m = 0; m < w2 * dof; ++m)
+      {
+        plane[m] += wk * Fek[m];
+      }
+    }
+    // 2D interpolation on every particle of this layer
+    for (; ipt < npts && layerPc[ipt] == layer; ++ipt)
+    {
+      for (unsigned int j = 0; j < wy; ++j)
+      {
+        for (unsigned int i = 0; i < wx; ++i)
+        {
+          const double wxy = (double) deltax[i + ipt * wx] * deltay[j + ipt * wy];
+          for (int d = 0; d < dof; ++d)
+          {
+            flc[d + dof * ipt] += wxy * plane[d + dof * (i + wx * j)];
+          }
+        }
+      }
+    }
+  }
+}
+
 #endif
@@ -0,0 +1,63 @@
+#ifndef SPREAD_OPERATOR_H
+#define SPREAD_OPERATOR_H
+#include<stddef.h>
+#include"BoundaryConditions.h"
+
+/* SpreadOperator is an SoA holding the spreading and interpolation
+   operators for a fixed configuration of particles, assembled as
+   sparse matrices in CSR format.
+
+ * S       - spread operator from particles to the nodes of the (wrapped) grid.
+             The rows are the grid nodes (Nx * Ny * Nz) and the columns are particles.
+             The BC folding (see fold()) is baked in, so grid.fG = S * particles.fP.
+ * J       - interpolation operator from the grid to particles. The rows are particles
+             and the columns are grid nodes (the transpose pattern of S). The copy to the
+             ghost region (see copy()) and the quadrature weights are baked in, so
+             particles.fP = J * grid.fG. J is stored separately from S, since the fold
+             and copy maps are not transposes of each other for mirror BCs, and
+             J carries the quadrature weights.
+ * ngroups - number of distinct BC signatures (BCs at the 6 ends for a dof). Each group
+             has its own S and J, and dof_group[d] is the group of dof d.
+ * S_rowptr, S_colind, S_val, (same for J) - CSR arrays of each group. The row pointers and
+             the column indices of J (grid nodes) are 64-bit, since the grid may have more 
+             than 2^32 entries (see Grid::largeIndex()), and the column indices of S are particles
+ * nP, Nx, Ny, Nz, dof - number of particles, grid points and dof the operators were built for
+ * planar  - whether fG has its components in planes (see Grid::setPlanarLayout())
+
+ NOTES: - The BCs are applied as in fold()/copy(), except that ghost data for
+          BC = none is 0 during interpolation, rather than whatever is
+          currently on the extended grid.
+        - The operators must be rebuilt (by calling build() again) if the particles move.
+*/
+
+// forward declarations
+struct Grid;
+struct ParticleList;
+
+struct SpreadOperator
+{
+  size_t **S_rowptr;
+  unsigned int **S_colind;
+  size_t **J_rowptr, **J_colind;
+  double **S_val, **J_val;
+  unsigned int *dof_group;
+  unsigned int ngroups, nP, Nx, Ny, Nz, dof;
+  bool planar;
+
+  /* empty/null ctor */
+  SpreadOperator();
+  /* assemble S and J for the particles on the grid. The particles
+     must be setup on the grid (see ParticleList::setup()) */
+  void build(ParticleList& particles, Grid& grid);
+  /* spread: fG = S * fP, where fP is nP x dof and fG is Nx x Ny x Nz x dof */
+  void spread(const double* fP, double* fG) const;
+  /* interpolate: fP = J * fG */
+  void interpolate(const double* fG, double* fP) const;
+  /* number of nonzeros of S and J for group g */
+  size_t nnzS(const unsigned int g) const;
+  size_t nnzJ(const unsigned int g) const;
+  /* clean memory */
+  void cleanup();
+};
+
+#endif
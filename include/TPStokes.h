@@ -0,0 +1,77 @@
+#ifndef TPSTOKES_H
+#define TPSTOKES_H
+#include "Memory.h"
+
+/* TPStokes is an SoA holding the Fourier multipliers of the triply periodic
+   Stokes operator on a grid, so that solves only stream over the spectrum.
+
+   Given the Fourier coefficients f_hat of the forces, the velocity is
+     u_hat = (f_hat - k (k . f_hat) / |k|^2) / (eta |k|^2),
+   ie. the projection of f_hat onto divergence free fields, scaled by the inverse
+   Laplacian. The operator is real, so it is applied to the real and imaginary parts
+   of the spectrum separately, and with no complex arithmetic. The k = 0 mode is
+   ignored (the net force on the unit cell is assumed to be 0), so it is 0 in u_hat.
+
+ * kx, ky, kz  - wave numbers of each axis, 2 pi n / L for n = 0,..,ceil(N/2)-1, then
+                 -floor(N/2),..,-1, ie. the frequencies of the DFT in its order. If real,
+                 kx holds only the first Nx/2 + 1. For even N this is the convention of
+                 Solvers.py and of DPStokes (see waveNumbers() in DPStokes.cpp), but for
+                 odd N they take n = 0,..,floor(N/2)-1, then -ceil(N/2),..,-1, so the mode
+                 at index (N-1)/2 differs, and TP results on grids with an odd number of
+                 points do not match those of the Python solver
+ * ksqinv      - 1 / |k|^2 for each wave number of the spectrum (Nz x Ny x Nxs, x fastest),
+                 with 0 for k = 0. This is the only multiplier that is not separable, so
+                 it is computed once per grid (see setup()), rather than on every solve
+ * Nx, Ny, Nz  - number of points of the grid in each axis
+ * Nxs         - number of points in x of the spectrum (Nx / 2 + 1 if real, Nx otherwise)
+ * nrhs        - number of velocity fields solved for at once. The spectrum has
+                 dof = 3 * nrhs components, ordered as in Grid (component d of field r
+                 is d + 3 * r, see Grid::setNumRHS())
+ * eta         - viscosity
+ * planar      - whether the components of the spectrum are stored in planes of
+                 Nz * Ny * Nxs points (see Grid::setPlanarLayout()), or interleaved
+ * real        - whether the spectrum is the half spectrum of a real transform
+                 (see Transform.h), or the full one
+
+ NOTES: - the spectrum is in the layout of Transform (or of a grid, see
+          Grid::setupSpectral()), so a solve can run in place on the output of
+          the forward transform, and the backward transform on its output (see
+          examples/TPStokes.py). The wavenumber-major layout (kmajor) is for the
+          Chebyshev solves of the DP solvers, and is not supported here.
+        - the solver is templated on the precision of the spectrum, as Transform is,
+          and the multipliers are stored in that precision.
+*/
+
+template<typename Real>
+struct TPStokesT
+{
+  Real *kx, *ky, *kz, *ksqinv;
+  unsigned int Nx, Ny, Nz, Nxs, nrhs;
+  Real eta;
+  bool planar, real;
+
+  /* empty/null ctor */
+  TPStokesT();
+  /* compute the multipliers for an Nx x Ny x Nz grid spanning Lx x Ly x Lz */
+  TPStokesT(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+            const double Lx, const double Ly, const double Lz, const double eta,
+            const unsigned int nrhs = 1, const bool planar = false, const bool real = false);
+  void setup(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+             const double Lx, const double Ly, const double Lz, const double eta,
+             const unsigned int nrhs, const bool planar, const bool real);
+  /* solve for the velocity spectrum u_hat_r, u_hat_i given the force spectrum
+     f_hat_r, f_hat_i (both Nz * Ny * Nxs * dof). The outputs may be the inputs,
+     in which case the velocities overwrite the forces */
+  void solve(const Real* f_hat_r, const Real* f_hat_i, Real* u_hat_r, Real* u_hat_i) const;
+  /* number of elements of the spectrum */
+  size_t spectralSize() const {return (size_t) Nz * Ny * Nxs * 3 * nrhs;}
+  // bytes held by each allocated buffer (see Memory.h)
+  MemoryReport memoryReport() const;
+  void cleanup();
+};
+
+// double and single precision solvers (for the spectra of Transform and TransformF)
+typedef TPStokesT<double> TPStokes;
+typedef TPStokesT<float> TPStokesF;
+
+#endif
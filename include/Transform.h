@@ -2,40 +2,159 @@
 #define TRANSFORM_H
 #include<fftw3.h>
 #include<iostream>
+#include "FFTWTraits.h"
 #include "exceptions.h"
+#include "Memory.h"
 
 /* Forward and Backward Fourier transform object
-   which wraps desired features of fftw */
+   which wraps desired features of fftw 
 
-struct Transform
+ * The constructors taking data plan with FFTW_ESTIMATE, transform the data once
+   and keep the result in out_real, out_complex.
+ * The constructor taking only the sizes builds a persistent transform, planned once 
+   with FFTW_MEASURE (or FFTW_PATIENT) before any data is written, which can then be 
+   executed any number of times (see execute()). The planning time is only worth it if
+   the transform is reused, eg. every timestep.
+ * if a wisdom file is set (see setWisdomFile()), it is imported once and every
+   persistent plan is exported to it, so later runs plan from the wisdom instantly.
+ * with real = true, the forward transform is real-to-complex and the backward one
+   complex-to-real, so the input (forward) or output (backward) in real space has 
+   no complex part, and the spectrum holds only the Nx / 2 + 1 non-negative wave
+   numbers in x (the rest follow from Hermitian symmetry). It is stored like the
+   full one with Nx / 2 + 1 in place of Nx, ie. as (k,j,i,l), or (l,k,j,i) if planar.
+   This halves the flops and the memory of the spectrum, but the transform is out of 
+   place, so out_real (and out_complex) are separate from in_real (and in_complex).
+ * with cheb = true, z is a Chebyshev axis, sampled at the Nz extrema of the Chebyshev
+   polynomial of degree Nz - 1, and the transform is Fourier in (x,y) and Chebyshev in z.
+   The forward transform takes the values to the Fourier-Chebyshev coefficients
+   (a DCT-I (FFTW_REDFT00) along z followed by the 2D DFT of each z-plane), scaled 
+   so that f(z_n) = sum_k c_k T_k(z_n), and the backward transform takes them back. 
+   The scaling of the coefficients is done here, so the Fourier parts are unnormalized 
+   as above (the backward transform is Nx * Ny times the values).
+ * with kmajor = true, the spectrum (the output of the forward transform and the
+   input of the backward one) is stored wavenumber-major, so the Nz coefficients of 
+   each wave number (i,j) and component l are contiguous, as (j,i,l,k), or (l,j,i,k)
+   if planar. This is the layout of the per wave number solves along z (eg. the
+   banded Chebyshev solves of the DP solvers), which can then stream over the wave 
+   numbers with no transposes. The transpose is done by the strides of the plans, 
+   so the transform is out of place, as if real. The real space data keeps its layout.
+ * a persistent transform can be bound to the buffers of a Grid (fG and its spectrum
+   fG_hat_r, fG_hat_i, see Grid::setupSpectral()), so that execute() runs without any
+   copies: the forward transform takes fG to the spectrum, and the backward one takes
+   the spectrum back to fG, normalized (so fG then holds the values). Both overwrite 
+   their input (the complex transforms run in place on fG and fG_hat_i, and fG_hat_r 
+   is fG). Bound kmajor transforms must be real. The buffers are not owned by the transform, which must be bound again if
+   the grid reallocates them. With flags other than FFTW_ESTIMATE, planning overwrites
+   the buffers, so bind before spreading.
+ * the transform is templated on the precision of the data, Real = double (fftw, see
+   Transform) or float (fftwf, see TransformF). Everything above holds for both. The single
+   precision transforms halve the memory and bandwidth of the spectrum, at a relative error
+   of about 1e-7 instead of 1e-16 (see the README and testing/test_single_precision.cpp), so
+   they are for runs whose tolerance is looser than that, eg. the spread/interpolation
+   kernels at 1e-4 to 1e-6. Single precision plans keep their own wisdom (see setWisdomFile()).
+*/
+
+template<typename Real>
+struct TransformT
 {
   // real and complex input
-  double *in_real, *in_complex;
-  // real and complex output (these are aliased to input ptrs)
-  double *out_real, *out_complex;
-  // forward and backward plans
-  fftw_plan pF, pB;
+  Real *in_real, *in_complex;
+  // real and complex output (these are aliased to input ptrs, unless real or kmajor)
+  Real *out_real, *out_complex;
+  // forward and backward plans, and DCT-I along z if cheb
+  typename FFTW<Real>::plan pF, pB, pZ;
   // structs for configuring mem layout
-  fftw_iodim *dims, *howmany_dims;
+  fftw_iodim64 *dims, *howmany_dims;
   unsigned int Nx, Ny, Nz;
   // degrees of freedom in the input, dimension of the problem
   // eg. if 4-component vector field in 3D, dof = 4 and rank = 3
+  // for nrhs interleaved fields on a grid (see Grid::setNumRHS()), dof = nrhs * 4
   unsigned int dof, rank;
+  // whether the components are interleaved (false) or stored in contiguous
+  // planes of Nx * Ny * Nz points (true, see Grid::setPlanarLayout())
+  bool planar;
   // internal flag indicating whether we do a forward or back transform 
   int mode;
+  // whether the transform is real-to-complex/complex-to-real (see above)
+  bool real;
+  // whether z is a Chebyshev axis (see above)
+  bool cheb;
+  // whether the spectrum is stored wavenumber-major (see above)
+  bool kmajor;
+  // whether the buffers are those of a grid (see above)
+  bool bound;
 
-  Transform(); 
+  TransformT(); 
   // forward transform 
-  Transform(const double* in_real, const unsigned int Nx, 
+  TransformT(const Real* in_real, const unsigned int Nx, 
             const unsigned int Ny, const unsigned int Nz, 
-            const unsigned int dof);
-  // backwrad transform
-  Transform(const double* out_real, const double* out_complex,
+            const unsigned int dof, const bool planar = false,
+            const bool real = false, const bool cheb = false, 
+            const bool kmajor = false);
+  // backwrad transform (out_complex is ignored if real)
+  TransformT(const Real* out_real, const Real* out_complex,
             const unsigned int Nx, const unsigned int Ny, 
-            const unsigned int Nz, const unsigned int dof);
+            const unsigned int Nz, const unsigned int dof, 
+            const bool planar = false, const bool real = false,
+            const bool cheb = false, const bool kmajor = false);
+  // persistent transform in direction mode (FFTW_FORWARD or FFTW_BACKWARD), 
+  // planned with flags (eg. FFTW_MEASURE or FFTW_PATIENT)
+  TransformT(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+            const unsigned int dof, const int mode, const bool planar = false,
+            const bool real = false, const bool cheb = false,
+            const bool kmajor = false, const unsigned int flags = FFTW_MEASURE);
+  // persistent transform as above, bound to the data fG of a grid and its 
+  // spectrum fG_hat_r, fG_hat_i (see Grid::setupSpectral())
+  TransformT(Real* fG, Real* fG_hat_r, Real* fG_hat_i,
+            const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+            const unsigned int dof, const int mode, const bool planar = false,
+            const bool real = false, const bool cheb = false,
+            const bool kmajor = false, const unsigned int flags = FFTW_MEASURE);
+  // transform the data in in_real, in_complex (in place unless real or kmajor). If bound,
+  // the data is that of the grid (fG, or its spectrum if backward)
+  void execute();
+  /* transform in_real, in_complex (0 for a real input) into out_real, out_complex
+     (the complex parts of the real space data are ignored if real).
+     If the outputs are 0, the result is left in this->out_real, this->out_complex.
+     The transform runs directly on the output arrays if they have the alignment of 
+     the planned ones (see fftw_alignment_of()), and on the internal buffers otherwise */
+  void execute(const Real* in_real, const Real* in_complex, 
+               Real* out_real, Real* out_complex);
   // configure memory layout
   void configDims();
+  // set the strides of the spectrum (the output if out) for kmajor (see above)
+  void setKMajorStrides(const bool out);
+  // number of points in x of the spectrum (Nx / 2 + 1 if real)
+  unsigned int spectralNx() const {return real ? Nx / 2 + 1 : Nx;}
+  // allocate the buffers and create the plan for mode with flags
+  void plan(const unsigned int flags);
+  // allocate the buffers for mode (see plan())
+  void allocate();
+  // execute() for an out of place transform (real or kmajor)
+  void executeOutOfPlace(const Real* in_real, const Real* in_complex, 
+                         Real* out_real, Real* out_complex);
+  /* run the plans on input re, im into ore, oim (aliased to re, im unless real or kmajor), 
+     scaling the coefficients of the Chebyshev transforms and normalizing the backward 
+     transform if bound. If zero_im, im holds zeros and its DCT is skipped */
+  void transform(Real* re, Real* im, Real* ore, Real* oim, const bool zero_im);
+  /* weight of the Chebyshev coefficient of element i of the spectrum
+     (1 for the first and last in z, 2 otherwise). The forward transform multiplies
+     the DCT-I by weight / (2 * Nz - 2), and the backward one divides the input by it */
+  double chebWeight(const size_t i) const;
+  // scale the output of the forward Chebyshev transform (see chebWeight())
+  void scaleCheb(Real* re, Real* im);
+  // bytes held by each allocated buffer (see Memory.h)
+  MemoryReport memoryReport() const;
   void cleanup();
 };
 
+// double (fftw) and single (fftwf) precision transforms
+typedef TransformT<double> Transform;
+typedef TransformT<float> TransformF;
+
+/* set the wisdom file of the persistent transforms, importing it if it exists.
+   The single precision wisdom is kept in fname with .single appended, as fftw 
+   keeps separate wisdom for each precision. Returns whether wisdom was imported */
+bool setWisdomFile(const char* fname);
+
 #endif 
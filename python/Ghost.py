@@ -17,6 +17,11 @@ libBC.Ghostify.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
 libBC.Ghostify.restype = None
 libBC.DeGhostify.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
 libBC.DeGhostify.restype = None
+libBC.GhostTimes.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_double), \
+                             ctypes.POINTER(ctypes.c_double)]
+libBC.GhostTimes.restype = None
+libBC.ResetGhostTimes.argtypes = [ctypes.c_void_p]
+libBC.ResetGhostTimes.restype = None
 
 
 def Ghostify(g, s):
@@ -45,4 +50,32 @@ def DeGhostify(g,s):
     - The member g.fG_unwrap is modified according to the BC convention and interior data on g.fG
   Returns: none
   """
-  libBC.DeGhostify(g, s) 
+  libBC.DeGhostify(g, s)
+
+def GhostTimes(g):
+  """
+  Seconds spent in the fold (DeGhostify) and copy (Ghostify) of the grid,
+  since its ghost plan was built (eg. when the particles change) or the times were reset
+
+  Parameters:
+    g - a pointer to the C++ Grid struct
+  Side Effects: None
+  Returns: fold_time, copy_time - dicts with the time for each of
+           'x', 'y', 'z' (ghost transfers along each axis) and 'interior'
+           (copy between the extended and interior grid)
+  """
+  fold_time = (ctypes.c_double * 4)(); copy_time = (ctypes.c_double * 4)()
+  libBC.GhostTimes(g, fold_time, copy_time)
+  names = ('x', 'y', 'z', 'interior')
+  return {names[a] : fold_time[a] for a in range(4)}, {names[a] : copy_time[a] for a in range(4)}
+
+def ResetGhostTimes(g):
+  """
+  Zero the fold/copy times of the grid (see GhostTimes())
+
+  Parameters:
+    g - a pointer to the C++ Grid struct
+  Side Effects: the times stored in the grid are zeroed
+  Returns: none
+  """
+  libBC.ResetGhostTimes(g)
@@ -2,6 +2,70 @@ import ctypes
 import numpy as np
 libGrid = ctypes.CDLL('../lib/libgrid.so')
 
+# page placement policies (see Memory.h)
+NO_TOUCH, SERIAL_TOUCH, FIRST_TOUCH = 0, 1, 2
+
+def SetPlacement(placement):
+  """
+  Python wrapper for the SetPlacement(placement) C lib routine
+  This sets how the pages of grids and particle arrays allocated from
+  now on are placed on NUMA nodes. With FIRST_TOUCH (the default), each thread
+  zeros the part of a buffer it works on in the hot loops, so the pages are local
+  to it. This needs pinned threads (eg. OMP_PROC_BIND=close OMP_PLACES=cores).
+  With SERIAL_TOUCH, all pages are zeroed by the calling thread, and with
+  NO_TOUCH they are placed by whichever loop first writes to them.
+
+  Parameters:
+    placement (int) - one of NO_TOUCH, SERIAL_TOUCH, FIRST_TOUCH
+  Side Effects: the placement policy is changed for all later allocations
+  """
+  libGrid.SetPlacement.argtypes = [ctypes.c_uint]
+  libGrid.SetPlacement.restype = None
+  libGrid.SetPlacement(placement)
+
+def GetPlacement():
+  """
+  Python wrapper for the GetPlacement() C lib routine
+
+  Parameters: None
+  Returns: the current placement policy (NO_TOUCH, SERIAL_TOUCH or FIRST_TOUCH)
+  """
+  libGrid.GetPlacement.argtypes = None
+  libGrid.GetPlacement.restype = ctypes.c_uint
+  return libGrid.GetPlacement()
+
+def EstimateMemory(Nx, Ny, Nz, dof, nP, wx, wy, wz, dp, single = False, 
+                   cache_weights = False, nthreads = 1):
+  """
+  Python wrapper for the EstimateMemory(..) C lib routine
+  This predicts the bytes of each buffer allocated to spread, transform and 
+  interpolate for a problem size, before anything is allocated (see estimateMemory()
+  in Memory.h). The sum of the values bounds the peak memory.
+
+  Parameters:
+    Nx, Ny, Nz (int) - number of points in x,y,z
+    dof (int) - degrees of freedom
+    nP (int) - number of particles
+    wx, wy, wz (int) - max kernel width in x,y,z (in z, the max number of 
+                       Chebyshev points in a kernel support if dp)
+    dp (bool) - whether the grid is doubly periodic (Chebyshev in z)
+    single (bool) - whether the extended grid is single precision
+    cache_weights (bool) - whether the particles cache their kernel weights
+    nthreads (int) - number of OpenMP threads
+  Returns: dict of buffer name -> bytes
+  """
+  libGrid.EstimateMemory.argtypes = [ctypes.c_uint, ctypes.c_uint, ctypes.c_uint, ctypes.c_uint, 
+                                     ctypes.c_uint, ctypes.c_ushort, ctypes.c_ushort, 
+                                     ctypes.c_ushort, ctypes.c_bool, ctypes.c_bool, ctypes.c_bool,
+                                     ctypes.c_uint, ctypes.POINTER(ctypes.c_char_p), 
+                                     ctypes.POINTER(ctypes.c_size_t), ctypes.c_uint]
+  libGrid.EstimateMemory.restype = ctypes.c_uint
+  args = (Nx, Ny, Nz, dof, nP, wx, wy, wz, dp, single, cache_weights, nthreads)
+  n = libGrid.EstimateMemory(*args, None, None, 0)
+  names = (ctypes.c_char_p * n)(); sizes = (ctypes.c_size_t * n)()
+  libGrid.EstimateMemory(*args, names, sizes, n)
+  return {names[i].decode('utf-8') : sizes[i] for i in range(n)}
+
 class GridGen(object):
   """
   Python wrappers for C library Grid routines.
@@ -21,10 +85,14 @@ class GridGen(object):
     periodic(x,y,z) (bool) - periodicity of eaxh axis
     Ntotal (int) = N * dof
     BCs - Boundary conditions for each variable on grid, at end of each axis (dof x 6)
+    single (bool) - whether to spread/interpolate with a single precision extended grid
+    pencil (bool) - whether the extended grid is stored z fastest
+    planar (bool) - whether the dof components are stored in contiguous planes
     grid (ptr to C++ struct) - a pointer to the generated C++ Grid struct  
   """
   def __init__(self, _Lx, _Ly, _Lz, _hx, _hy, _hz, _Nx, _Ny, _Nz, _dof, _periodic_x,
-               _periodic_y, _periodic_z, _BCs, _zpts = None, _zwts = None):
+               _periodic_y, _periodic_z, _BCs, _zpts = None, _zwts = None, _single = False,
+               _pencil = False, _planar = False):
     """ 
     The constructor for the GridGen class.
     
@@ -38,6 +106,13 @@ class GridGen(object):
       zpts, zwts - z grid and associated quadrature weights
       BCs - Boundary conditions for each variable on grid, at end of each axis (dof x 6)
       Ntotal (int) = N * dof
+      single (bool) - if True, the extended grid, kernel weights and spreading/interpolation
+                      buffers are single precision (particle positions and fG remain double)
+      pencil (bool) - if True, the extended grid is stored z fastest, so that spreading/interpolation
+                      read and write contiguous columns. fG keeps the usual x fastest layout.
+      planar (bool) - if True, component d of point i of fG (and the extended grid) is at
+                      i + N * d rather than d + dof * i. Use Transformer(..., _planar = True)
+                      and the solvers with planar = True on such data.
 
     Side Effects:
       The prototypes for relevant functions from the 
@@ -71,6 +146,18 @@ class GridGen(object):
     libGrid.SetBCs.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint)]
     libGrid.SetBCs.restype = None
   
+    libGrid.SetSinglePrecision.argtypes = [ctypes.c_void_p, ctypes.c_bool]
+    libGrid.SetSinglePrecision.restype = None
+
+    libGrid.SetPencilLayout.argtypes = [ctypes.c_void_p, ctypes.c_bool]
+    libGrid.SetPencilLayout.restype = None
+
+    libGrid.SetPlanarLayout.argtypes = [ctypes.c_void_p, ctypes.c_bool]
+    libGrid.SetPlanarLayout.restype = None
+
+    libGrid.SetNumRHS.argtypes = [ctypes.c_void_p, ctypes.c_uint]
+    libGrid.SetNumRHS.restype = None
+
     libGrid.Setdof.argtypes = [ctypes.c_void_p, ctypes.c_uint]
     libGrid.Setdof.restype = None
 
@@ -79,6 +166,9 @@ class GridGen(object):
  
     libGrid.SetupGrid.argtypes = [ctypes.c_void_p]
     libGrid.SetupGrid.restype = None
+
+    libGrid.ResetGrid.argtypes = [ctypes.c_void_p]
+    libGrid.ResetGrid.restype = None
     
     libGrid.CleanGrid.argtypes = [ctypes.c_void_p]
     libGrid.CleanGrid.restype = None     
@@ -91,12 +181,25 @@ class GridGen(object):
   
     libGrid.WriteCoords.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
     libGrid.WriteCoords.restype = None
+
+    libGrid.GridMemoryReport.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_char_p), 
+                                         ctypes.POINTER(ctypes.c_size_t), ctypes.c_uint]
+    libGrid.GridMemoryReport.restype = ctypes.c_uint
   
     libGrid.SetSpread.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_double)] 
     libGrid.SetSpread.restype = None 
 
     libGrid.GetSpread.argtypes = [ctypes.c_void_p] 
     libGrid.GetSpread.restype = ctypes.POINTER(ctypes.c_double) 
+
+    libGrid.SetupSpectral.argtypes = [ctypes.c_void_p, ctypes.c_bool]
+    libGrid.SetupSpectral.restype = None
+
+    libGrid.GetSpectralReal.argtypes = [ctypes.c_void_p] 
+    libGrid.GetSpectralReal.restype = ctypes.POINTER(ctypes.c_double) 
+
+    libGrid.GetSpectralComplex.argtypes = [ctypes.c_void_p] 
+    libGrid.GetSpectralComplex.restype = ctypes.POINTER(ctypes.c_double) 
     
     # length in x,y,z
     self.Lx = _Lx
@@ -124,6 +227,16 @@ class GridGen(object):
     self.periodic_z = _periodic_z
     # boundary conditions
     self.BCs = _BCs 
+    # precision of the extended grid
+    self.single = _single
+    # layout of the extended grid
+    self.pencil = _pencil
+    # layout of the dof components
+    self.planar = _planar
+    # number of data vectors (right-hand sides) on the grid
+    self.nrhs = 1
+    # number of points in x of the spectrum of the grid data (see SetupSpectral())
+    self.Nxh = None
     # pointer to C++ Grid struct
     self.grid = None
 
@@ -152,8 +265,63 @@ class GridGen(object):
     libGrid.SetPeriodicity(self.grid, self.periodic_x, self.periodic_y, self.periodic_z)
     libGrid.Setdof(self.grid, self.dof) 
     libGrid.SetBCs(self.grid, self.BCs.ctypes.data_as(ctypes.POINTER(ctypes.c_uint))) 
+    libGrid.SetSinglePrecision(self.grid, self.single)
+    libGrid.SetPencilLayout(self.grid, self.pencil)
+    libGrid.SetPlanarLayout(self.grid, self.planar)
     libGrid.SetupGrid(self.grid)  
 
+  def Resize(self, _Lx, _Ly, _Lz, _hx, _hy, _hz, _Nx, _Ny, _Nz, _zpts = None, _zwts = None):
+    """
+    Python wrapper to change the size of the Grid made by Make(), reusing its
+    buffers. The interior grid and, once the particles are located again with
+    ParticlesGen.Reset(), the extended grid and locator are only reallocated if 
+    they are too small, so sweeps over resolutions do not rebuild the Grid.
+
+    Parameters:
+      same as the constructor
+    Side Effects:
+      self.grid is set up for the new sizes, and any particles on it must be
+      located again with ParticlesGen.Reset(self.grid)
+    """
+    self.Lx, self.Ly, self.Lz = _Lx, _Ly, _Lz
+    self.hx, self.hy, self.hz = _hx, _hy, _hz
+    self.Nx, self.Ny, self.Nz = _Nx, _Ny, _Nz
+    self.zpts, self.zwts = _zpts, _zwts
+    self.N = self.Nx * self.Ny * self.Nz
+    self.Ntotal = self.N * self.dof
+    libGrid.SetL(self.grid, self.Lx, self.Ly, self.Lz)
+    libGrid.SetN(self.grid, self.Nx, self.Ny, self.Nz)  
+    if self.zpts is None:
+      libGrid.Seth(self.grid, self.hx, self.hy, self.hz)
+    else:
+      libGrid.Seth(self.grid, self.hx, self.hy, 0.0)
+      libGrid.SetZ(self.grid, self.zpts.ctypes.data_as(ctypes.POINTER(ctypes.c_double)), \
+                   self.zwts.ctypes.data_as(ctypes.POINTER(ctypes.c_double)))
+    libGrid.SetupGrid(self.grid)  
+
+  def SetNumRHS(self, nrhs):
+    """
+    Python wrapper for the SetNumRHS(grid, nrhs) C lib routine
+    This sets the number of data vectors (right-hand sides) that are
+    spread/interpolated together. The data of each grid point is then
+    ordered as d + dof1 * r for component d of vector r, where dof1 is
+    the dof of one vector, and self.dof is updated to dof1 * nrhs. The
+    resulting grid data can be transformed with Transformer(..., self.dof).
+
+    Parameters: 
+      nrhs (int) - number of data vectors
+    Side Effects:
+      self.dof, self.Ntotal and self.nrhs are updated, the BCs of the first vector
+      are replicated for each vector (in self.BCs as well as the C++ Grid) and the 
+      grid data is reallocated
+    """
+    libGrid.SetNumRHS(self.grid, nrhs)
+    dof1 = self.dof // self.nrhs
+    self.BCs = np.tile(np.reshape(self.BCs, (6, self.dof))[:, 0:dof1], (1, nrhs)).ravel()
+    self.dof = dof1 * nrhs
+    self.Ntotal = self.N * self.dof
+    self.nrhs = nrhs
+
   def ZeroExtGrid(self):
     """
     Python wrapper for ZeroExtGrid(grid) C lib routine
@@ -162,7 +330,7 @@ class GridGen(object):
 
     Parameter : none
     Side Effects: 
-      self.grid.fG_unwrap is overwritten with 0s 
+      self.grid.fG_unwrap (or self.grid.fG_unwrap_f if single) is overwritten with 0s 
     """
     libGrid.ZeroExtGrid(self.grid)
 
@@ -190,6 +358,36 @@ class GridGen(object):
     """
     return np.ctypeslib.as_array(libGrid.GetSpread(self.grid), shape=(self.Ntotal, ))
 
+  def SetupSpectral(self, real = False):
+    """
+    Python wrapper for the SetupSpectral(grid, real) C lib routine
+    This allocates the spectrum of the grid data, so that transforms bound 
+    to the grid (see Transformer.Bind()) run without any copies.
+
+    Parameters:
+      real (bool) - whether the transforms are real-to-complex, in which case the 
+                    spectrum is the half spectrum (Nx//2+1 points in x). Otherwise,
+                    its real part is the grid data itself (fG)
+    Side Effects:
+      the spectrum is (re)allocated, and self.Nxh is set. This must be called again
+      after Resize(), and any bound transforms bound again
+    """
+    libGrid.SetupSpectral(self.grid, real)
+    self.Nxh = self.Nx // 2 + 1 if real else self.Nx
+
+  def GetSpectral(self):
+    """
+    Python wrapper for the GetSpectralReal(grid) and GetSpectralComplex(grid) C lib routines
+    
+    Parameters: None 
+    Side Effects: None
+    Returns: numpy arrays viewing the real and imaginary parts of the spectrum of
+             the grid data (see SetupSpectral()), each of size Nz * Ny * Nxh * dof
+    """
+    Nh = self.Nz * self.Ny * self.Nxh * self.dof
+    return np.ctypeslib.as_array(libGrid.GetSpectralReal(self.grid), shape=(Nh, )), \
+           np.ctypeslib.as_array(libGrid.GetSpectralComplex(self.grid), shape=(Nh, ))
+
   def WriteGrid(self, fname):
     """
     Python wrapper for the WriteGrid(grid,fname) C lib routine
@@ -214,6 +412,19 @@ class GridGen(object):
     b_fname = fname.encode('utf-8')
     libGrid.WriteCoords(self.grid, b_fname)
 
+  def MemoryReport(self):
+    """
+    Python wrapper for the GridMemoryReport(grid,..) C lib routine
+ 
+    Parameters: None
+    Side Effects: None
+    Returns: dict of buffer name -> bytes, for each buffer allocated by the Grid
+    """
+    n = libGrid.GridMemoryReport(self.grid, None, None, 0)
+    names = (ctypes.c_char_p * n)(); sizes = (ctypes.c_size_t * n)()
+    libGrid.GridMemoryReport(self.grid, names, sizes, n)
+    return {names[i].decode('utf-8') : sizes[i] for i in range(n)}
+
   def Clean(self):
     """
     Python wrapper for the CleanGrid(..) C lib routine.
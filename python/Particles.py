@@ -58,6 +58,21 @@ class ParticlesGen(object):
     libParticles.Setup.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
     libParticles.Setup.restype = None  
 
+    libParticles.Reset.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+    libParticles.Reset.restype = None  
+
+    libParticles.SetWeightCache.argtypes = [ctypes.c_void_p, ctypes.c_bool]
+    libParticles.SetWeightCache.restype = None
+
+    libParticles.SetReordering.argtypes = [ctypes.c_void_p, ctypes.c_bool, ctypes.c_double]
+    libParticles.SetReordering.restype = None
+
+    libParticles.SetNumRHS.argtypes = [ctypes.c_void_p, ctypes.c_uint]
+    libParticles.SetNumRHS.restype = None
+
+    libParticles.SetMaxLayers.argtypes = [ctypes.c_void_p, ctypes.c_uint]
+    libParticles.SetMaxLayers.restype = None
+
     libParticles.SetForces.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_double),\
                                        ctypes.c_uint]
     libParticles.SetForces.restype = None
@@ -84,10 +99,16 @@ class ParticlesGen(object):
     libParticles.WriteParticles.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
     libParticles.WriteParticles.restype = None
 
+    libParticles.ParticlesMemoryReport.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_char_p), 
+                                                   ctypes.POINTER(ctypes.c_size_t), ctypes.c_uint]
+    libParticles.ParticlesMemoryReport.restype = ctypes.c_uint
+
     # number of particles
     self.nP = _nP
     # deg of freedom
     self.dof = _dof
+    # number of data vectors (right-hand sides) on the particles
+    self.nrhs = 1
     # particle positions
     self.xP = _xP
     # particle forces
@@ -122,6 +143,66 @@ class ParticlesGen(object):
                                           self.wfP.ctypes.data_as(ctypes.POINTER(ctypes.c_ushort)), \
                                           self.nP, self.dof)
 
+  def SetWeightCache(self, cache_weights):
+    """
+    The python wrapper for turning caching of the kernel weights on or off.
+    If on, the separable 1D kernel weights of each particle are evaluated on 
+    the first spread/interpolation, and reused by later calls until the 
+    particles are updated. This is useful when spreading/interpolating many
+    times at fixed positions (eg. in iterative solvers).
+
+    Parameters: cache_weights (bool) - whether to cache the weights
+    Side Effects:
+      self.particles.cache_weights is set, and the cache is freed if False
+    """
+    libParticles.SetWeightCache(self.particles, cache_weights)
+
+  def SetReordering(self, reorder, tol = 0.25):
+    """
+    The python wrapper for turning reordering of the particles along a space-filling
+    (Morton) curve on or off. If on, the particles are stored internally in the order 
+    of their cells on the grid, which improves memory locality in spreading/interpolation.
+    Data passed to SetForces() and Update() and returned by GetForces() and 
+    WriteParticles() remains in the original order. The particles are reordered 
+    again in Update() if more than a fraction tol of them become out of order.
+    This must be called before Setup().
+
+    Parameters: 
+      reorder (bool) - whether to reorder the particles
+      tol (double) - fraction of out-of-order particles that triggers a reordering
+    Side Effects:
+      self.particles.reorder and self.particles.reorder_tol are set
+    """
+    libParticles.SetReordering(self.particles, reorder, tol)
+
+  def SetNumRHS(self, nrhs):
+    """
+    The python wrapper for setting the number of data vectors (right-hand sides)
+    on the particles. The data on each particle is then ordered as d + dof1 * r
+    for component d of vector r, where dof1 is the dof of one vector, and self.dof 
+    is updated to dof1 * nrhs. This must match the nrhs of the grid.
+
+    Parameters: nrhs (int) - number of data vectors
+    Side Effects:
+      self.dof and self.nrhs are updated, and self.particles.fP is reallocated and zeroed
+    """
+    libParticles.SetNumRHS(self.particles, nrhs)
+    self.dof = (self.dof // self.nrhs) * nrhs
+    self.nrhs = nrhs
+
+  def SetMaxLayers(self, max_layers):
+    """
+    The python wrapper for setting the max number of distinct z layers (height
+    and kernel) for which the separable layered spread/interp path is used. 
+    If the particles occupy more layers than this, the general path is used.
+    This must be called before Setup().
+
+    Parameters: max_layers (int) - max number of layers (0 disables the layered path)
+    Side Effects:
+      self.particles.max_layers is overwritten with max_layers
+    """
+    libParticles.SetMaxLayers(self.particles, max_layers)
+
   def SetForces(self, _fP):
     """
     The python wrapper for setting forces/other data on the particles. This
@@ -152,7 +233,7 @@ class ParticlesGen(object):
     Parameters: none
     Side Effects: none
     Returns:
-      self.particles.fP is returned and encapsulated in numpy array
+      self.particles.fP (in the original particle order) is returned and encapsulated in numpy array
     """
     return np.ctypeslib.as_array(libParticles.GetForces(self.particles), shape=(self.dof * self.nP, )) 
 
@@ -172,6 +253,20 @@ class ParticlesGen(object):
     """
     libParticles.Setup(self.particles, grid)
 
+  def Reset(self, grid):
+    """
+    The python wrapper for the Reset(particles,grid) C lib routine
+    This locates the particles on the grid again from scratch, eg. after
+    the grid was resized with GridGen.Resize(). The extended grid and 
+    locator buffers are kept and reused if they are large enough.
+
+    Parameters:
+      grid - a pointer to a valid C++ Grid instance (stored in GridGen)
+    Side Effects:
+      Same as Setup(grid)
+    """
+    libParticles.Reset(self.particles, grid)
+
   def Update(self, xP_new, grid):
     """
     Python wrapper for updating particles on ghe grid
@@ -197,6 +292,19 @@ class ParticlesGen(object):
     """
     b_fname = fname.encode('utf-8')
     libParticles.WriteParticles(self.particles, b_fname)    
+
+  def MemoryReport(self):
+    """
+    Python wrapper for the ParticlesMemoryReport(particles,..) C lib routine
+ 
+    Parameters: None
+    Side Effects: None
+    Returns: dict of buffer name -> bytes, for each buffer allocated by the ParticlesList
+    """
+    n = libParticles.ParticlesMemoryReport(self.particles, None, None, 0)
+    names = (ctypes.c_char_p * n)(); sizes = (ctypes.c_size_t * n)()
+    libParticles.ParticlesMemoryReport(self.particles, names, sizes, n)
+    return {names[i].decode('utf-8') : sizes[i] for i in range(n)}
   
   def Clean(self):
     """
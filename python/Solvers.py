@@ -6,13 +6,18 @@ import ctypes
 libLinSolve = ctypes.CDLL('../lib/liblinSolve.so')
 # get doubly periodic tools, parallelized with openMP and using blas/lapack
 libDPTools = ctypes.CDLL('../lib/libdpTools.so')
+# get the triply periodic solver, parallelized with openMP
+libTPStokes = ctypes.CDLL('../lib/libtpStokes.so')
+# get the doubly periodic solvers, parallelized with openMP and using blas/lapack
+libDPStokes = ctypes.CDLL('../lib/libdpStokes.so')
 # see end of file for lib function signatures
 
 ###################################################################################
 ########################## Main solver routines ###################################
 ###################################################################################
 
-def TriplyPeriodicStokes(fG_hat_r, fG_hat_i, eta, Lx, Ly, Lz, Nx, Ny, Nz):
+def TriplyPeriodicStokes(fG_hat_r, fG_hat_i, eta, Lx, Ly, Lz, Nx, Ny, Nz, planar = False, real = False,
+                         out = None):
   """
   Solve triply periodic Stokes eq in Fourier domain given the Fourier
   coefficients of the forcing.
@@ -25,20 +30,32 @@ def TriplyPeriodicStokes(fG_hat_r, fG_hat_i, eta, Lx, Ly, Lz, Nx, Ny, Nz):
     eta - viscocity
     Lx, Ly, Lz - length of unit cell in x,y,z
     Nx, Ny, Nz - number of points in x, y and z
+    planar - if True, the components of fG_hat and U_hat are stored in
+             contiguous planes rather than interleaved (see Grid.py)
+    real - if True, fG_hat and U_hat only hold the Nx // 2 + 1 non-negative wave 
+           numbers in x (the half spectrum of a real transform, see Transform.py)
+    out - optional (U_hat_r, U_hat_i) arrays to write the solution to, eg. the
+          spectrum of a grid (see GridGen.GetSpectral()). These may be fG_hat_r, fG_hat_i.
   
   Returns:
     U_hat_r, U_hat_i - real and complex part of Fourier coefficients of
-                       fluid velocity on the grid. 
+                       fluid velocity on the grid (out, if given). 
   
   Note: We assume the net force on the unit cell is 0 by *ignoring* 
         the k = 0 mode. That is, the k=0 mode of the output solution
         will be 0.
+
+  This builds the wave numbers and the multipliers on every call. For repeated
+  solves on the same grid, use TriplyPeriodicStokesSolver, which caches them
+  and solves in place in C.
   """
-  Ntotal = Nx * Ny * Nz * 3
+  # points of the spectrum in x
+  Nxh = Nx // 2 + 1 if real else Nx
+  Ntotal = Nxh * Ny * Nz * 3
   # separate x,y,z components
-  f_hat = (fG_hat_r[0::3] + 1j * fG_hat_i[0::3])
-  g_hat = (fG_hat_r[1::3] + 1j * fG_hat_i[1::3])
-  h_hat = (fG_hat_r[2::3] + 1j * fG_hat_i[2::3])
+  f_hat = (component(fG_hat_r, 0, 3, planar) + 1j * component(fG_hat_i, 0, 3, planar))
+  g_hat = (component(fG_hat_r, 1, 3, planar) + 1j * component(fG_hat_i, 1, 3, planar))
+  h_hat = (component(fG_hat_r, 2, 3, planar) + 1j * component(fG_hat_i, 2, 3, planar))
   # wave numbers
   kvec_x = 2*np.pi*np.concatenate((np.arange(0,np.floor(Nx/2)),\
                                    np.arange(-1*np.ceil(Nx/2),0)), axis=None) / Lx
@@ -48,6 +65,8 @@ def TriplyPeriodicStokes(fG_hat_r, fG_hat_i, eta, Lx, Ly, Lz, Nx, Ny, Nz):
   
   kvec_z = 2*np.pi*np.concatenate((np.arange(0,np.floor(Nz/2)),\
                                    np.arange(-1*np.ceil(Nz/2),0)), axis=None) / Lz
+  # the half spectrum has the first Nxh wave numbers in x
+  kvec_x = kvec_x[:Nxh]
   Kz, Ky, Kx = [a.flatten() for a in np.meshgrid(kvec_z, kvec_y, kvec_x, indexing='ij')]
   Ksq = Kx**2 + Ky**2 + Kz**2
   # precompute parts of RHS
@@ -62,20 +81,111 @@ def TriplyPeriodicStokes(fG_hat_r, fG_hat_i, eta, Lx, Ly, Lz, Nx, Ny, Nz):
   u_hat[0] = 0
   v_hat[0] = 0
   w_hat[0] = 0
-  # interleave solution components and split
+  # interleave solution components (or store in planes) and split
   # real/imaginary parts for passing back to c
-  U_hat_r = np.zeros((Ntotal,), dtype = np.double)
-  U_hat_r[0::3] = np.real(u_hat)
-  U_hat_r[1::3] = np.real(v_hat)
-  U_hat_r[2::3] = np.real(w_hat)
-  U_hat_i = np.zeros((Ntotal,), dtype = np.double)
-  U_hat_i[0::3] = np.imag(u_hat)
-  U_hat_i[1::3] = np.imag(v_hat)
-  U_hat_i[2::3] = np.imag(w_hat)
+  U_hat_r, U_hat_i = out if out is not None else \
+    (np.zeros((Ntotal,), dtype = np.double), np.zeros((Ntotal,), dtype = np.double))
+  component(U_hat_r, 0, 3, planar)[:] = np.real(u_hat)
+  component(U_hat_r, 1, 3, planar)[:] = np.real(v_hat)
+  component(U_hat_r, 2, 3, planar)[:] = np.real(w_hat)
+  component(U_hat_i, 0, 3, planar)[:] = np.imag(u_hat)
+  component(U_hat_i, 1, 3, planar)[:] = np.imag(v_hat)
+  component(U_hat_i, 2, 3, planar)[:] = np.imag(w_hat)
   return U_hat_r, U_hat_i
 
+class TriplyPeriodicStokesSolver(object):
+  """
+  Python wrapper for the C++ TPStokes struct (see TPStokes.h), which holds the
+  Fourier multipliers of the triply periodic Stokes operator for a grid, so 
+  that each solve is a single pass over the spectrum, with no temporaries. 
+  It solves the same problem as TriplyPeriodicStokes().
+
+  Attributes:
+    Nx, Ny, Nz - number of points in x, y and z
+    nrhs - number of velocity fields solved for at once (the spectrum has 3 * nrhs
+           components, see Grid.py)
+    planar, real - layout of the spectrum, as in TriplyPeriodicStokes()
+    single (bool) - whether the spectrum is float32 (see Transformer(_single = True))
+    dtype - dtype of the spectrum
+    solver (ptr to C++ struct) - a pointer to the C++ TPStokes struct
+  """
+  def __init__(self, Lx, Ly, Lz, Nx, Ny, Nz, eta, planar = False, real = False, nrhs = 1, 
+               single = False):
+    """
+    Precompute the multipliers (C lib).
+
+    Parameters:
+      Lx, Ly, Lz - length of unit cell in x,y,z
+      Nx, Ny, Nz - number of points in x, y and z
+      eta - viscosity
+      planar - if True, the components of the spectrum are stored in planes (see Grid.py)
+      real - if True, the spectrum only holds the Nx // 2 + 1 non-negative wave numbers
+             in x (the half spectrum of a real transform, see Transform.py)
+      nrhs - number of velocity fields solved for at once
+      single - if True, the spectrum is float32
+    """
+    self.Nx = Nx; self.Ny = Ny; self.Nz = Nz; self.nrhs = nrhs
+    self.planar = planar; self.real = real; self.single = single
+    self.dtype = np.float32 if single else np.double
+    self.solver = self._lib('MakeTPStokes')(Nx, Ny, Nz, Lx, Ly, Lz, eta, nrhs, planar, real)
+
+  def _lib(self, name):
+    """
+    The C lib routine name for the precision of this solver (the single precision
+    routines have an F suffix, see TPStokesWrapper.cpp).
+    """
+    return getattr(libTPStokes, name + ('F' if self.single else ''))
+
+  def Solve(self, fG_hat_r, fG_hat_i, out = None):
+    """
+    Python wrapper for the SolveTPStokes(solver,..) C lib routine.
+
+    Parameters:
+      fG_hat_r, fG_hat_i - real and complex part of Fourier coefficients of the
+                           spread forces (of dtype self.dtype, eg. the output of a Transformer)
+      out - optional (U_hat_r, U_hat_i) arrays to write the solution to. These may be
+            fG_hat_r, fG_hat_i, in which case the solve is in place.
+
+    Returns:
+      U_hat_r, U_hat_i - real and complex part of Fourier coefficients of
+                         fluid velocity on the grid (out, if given).
+    """
+    real_t = ctypes.c_float if self.single else ctypes.c_double
+    for U in (fG_hat_r, fG_hat_i) + (tuple(out) if out is not None else ()):
+      if U.dtype != self.dtype or not U.flags.c_contiguous:
+        raise ValueError('The spectra must be contiguous arrays of ' + np.dtype(self.dtype).name)
+    U_hat_r, U_hat_i = out if out is not None else (np.empty_like(fG_hat_r), np.empty_like(fG_hat_i))
+    ptr = lambda U: U.ctypes.data_as(ctypes.POINTER(real_t))
+    self._lib('SolveTPStokes')(self.solver, ptr(fG_hat_r), ptr(fG_hat_i), ptr(U_hat_r), ptr(U_hat_i))
+    return U_hat_r, U_hat_i
+
+  def MemoryReport(self):
+    """
+    Python wrapper for the TPStokesMemoryReport(solver,..) C lib routine
+
+    Parameters: None
+    Side Effects: None
+    Returns: dict of buffer name -> bytes
+    """
+    n = self._lib('TPStokesMemoryReport')(self.solver, None, None, 0)
+    names = (ctypes.c_char_p * n)(); sizes = (ctypes.c_size_t * n)()
+    self._lib('TPStokesMemoryReport')(self.solver, names, sizes, n)
+    return {names[i].decode('utf-8') : sizes[i] for i in range(n)}
+
+  def Clean(self):
+    """
+    Python wrapper for the CleanTPStokes(..) C lib routine, which frees the
+    multipliers and deletes the C++ struct.
+
+    Side Effects:
+      self.solver is deleted and nullified
+    """
+    self._lib('CleanTPStokes')(self.solver)
+    self._lib('DeleteTPStokes')(self.solver)
+    self.solver = None
+
 # Precomputations for all DP solvers
-def DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H):
+def DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H, real = False, single = False):
   """
   Precompute the linear operators and boundary conditions
   for the doubly periodic no wall problem. The return
@@ -90,6 +200,11 @@ def DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H):
     Nx, Ny, Nz - number of points in x,y,z
     Lx, Ly - extent of x and y grids
     H - half extent of z grid (Lz / 2)
+    real - if True, the operators are for the Nx // 2 + 1 non-negative wave numbers 
+           in x (the half spectrum of a real transform, see Transform.py)
+    single - if True, LU, Ainv_B, C and Ginv are float32, so the banded solves of the 
+             no_wall, bottom_wall and slit_channel solvers (and the wall corrections) are
+             done in single precision (see the README for the accuracy)
   
   Side Effects: None
   Returns:
@@ -116,14 +231,17 @@ def DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H):
   
   kvec_y = 2*np.pi*np.concatenate((np.arange(0,np.floor(Ny/2)),\
                                    np.arange(-1*np.ceil(Ny/2),0)), axis=None) / Ly
-  Ky, Kx = [K.reshape((Ny * Nx,)).copy() for K in np.meshgrid(kvec_y, kvec_x, indexing='ij')]
+  # the half spectrum has the first Nx // 2 + 1 wave numbers in x (including the unpaired one)
+  Nxh = Nx // 2 + 1 if real else Nx; kvec_x = kvec_x[:Nxh]
+  Ky, Kx = [K.reshape((Ny * Nxh,)).copy() for K in np.meshgrid(kvec_y, kvec_x, indexing='ij')]
   Ksq = Kx**2 + Ky**2; K = np.sqrt(Ksq)
   Dx = 1j * Kx; Dy = 1j * Ky; 
   # zero unpaired mode
   if Nx % 2 == 0: 
-    Dx.reshape((Ny,Nx))[:,int(Nx/2)] = 0
+    Dx.reshape((Ny,Nxh))[:,int(Nx/2)] = 0
   if Ny % 2 == 0:
-    Dy.reshape((Ny,Nx))[int(Ny/2),:] = 0
+    Dy.reshape((Ny,Nxh))[int(Ny/2),:] = 0
+  Nx = Nxh
   # get Chebyshev integration matrices
   FIMat = firstIntegralMatrix(Nz, H)
   SIMat = secondIntegralMatrix(Nz, H)
@@ -150,11 +268,13 @@ def DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H):
           np.einsum('ij, k->kij', SIMat[:,Nz::], -Ksq),(1,2,0)))
   C = np.asfortranarray(BCs_k[:,0:Nz,:]); C_k0 = BCs_k0[:,0:Nz]; 
   D = np.asfortranarray(BCs_k[:,Nz::,:]); D_k0 = -BCs_k0[:,Nz::]; 
+  # precision of the banded solves
+  dtype = np.float32 if single else np.double
+  A, B, C, D = [np.asfortranarray(M, dtype = dtype) for M in (A, B, C, D)]
   # precompute LU decompositions and precomputable linear solves for each k
-  Ainv_B = np.zeros((Nz, 2, Ny * Nx))
   PIV = np.asfortranarray(np.zeros((Nz, Ny * Nx), dtype = np.int32))
-  Ginv = np.asfortranarray(np.zeros((2, 2, Ny * Nx), dtype = np.double))
-  G = np.asfortranarray(np.zeros((2, 2, Ny * Nx), dtype = np.double))
+  Ginv = np.asfortranarray(np.zeros((2, 2, Ny * Nx), dtype = dtype))
+  G = np.asfortranarray(np.zeros((2, 2, Ny * Nx), dtype = dtype))
   # get LU decomposition of A for each k and Ainv * B
   # A is overwritten with LU and B is overwritten with Ainv * B
   # Ginv is the inverse of the 2x2 schur complement
@@ -172,7 +292,8 @@ def DoublyPeriodicStokes_init(Nx, Ny, Nz, Lx, Ly, H):
 def DoublyPeriodicStokes_no_wall(fG_hat_r, fG_hat_i, eta, Nx, Ny, Nz, H,\
                                  Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, \
                                  uvints, BCs_k0, BCs_k, LU, Ainv_B, C, \
-                                 PIV, C_k0, Ginv, Ginv_k0, k0):
+                                 PIV, C_k0, Ginv, Ginv_k0, k0, planar = False, real = False,
+                                 kmajor = False):
   """
   Solve doubly periodic Stokes eq in Fourier-Chebyshev domain given the Fourier-Chebyshev
   coefficients of the forcing.
@@ -203,6 +324,14 @@ def DoublyPeriodicStokes_no_wall(fG_hat_r, fG_hat_i, eta, Nx, Ny, Nz, H,\
        - if k0 = 0, k = 0 mode of RHS is assumed to be 0, and sol will be 0
        - if k0 = 1, the k = 0 mode of RHS is assumed to be non-zero. There
          will be a correction to the non-zero solution.
+    planar - if True, fG_hat has shape (dof, Nz, Ny, Nx) rather than (Nz, Ny, Nx, dof), 
+             and the components of U_hat are stored in planes (see Grid.py)
+    real - if True, fG_hat, U_hat and P_hat only hold the Nx // 2 + 1 non-negative wave numbers
+           in x (the half spectrum of a real transform), and the precomputations are
+           from DoublyPeriodicStokes_init(..., real = True)
+    kmajor - if True, fG_hat, U_hat and P_hat are stored wavenumber-major, with the Nz
+             coefficients of each wave number and component contiguous (see Transform.py),
+             so the Chebyshev columns are views rather than transposed copies
   
   Returns:
     U_hat_r, U_hat_i, P_hat_r, P_hat_i - real and complex part of 
@@ -210,10 +339,12 @@ def DoublyPeriodicStokes_no_wall(fG_hat_r, fG_hat_i, eta, Nx, Ny, Nz, H,\
                                          fluid velocity and pressure on the grid. 
   """
   dof = 3;
+  # points of the spectrum in x
+  if real: Nx = Nx // 2 + 1
   # separate x,y,z components
-  Cf = np.asfortranarray((fG_hat_r[:,:,:,0] + 1j * fG_hat_i[:,:,:,0]).reshape((Nz, Ny * Nx)))
-  Cg = np.asfortranarray((fG_hat_r[:,:,:,1] + 1j * fG_hat_i[:,:,:,1]).reshape((Nz, Ny * Nx)))
-  Ch = np.asfortranarray((fG_hat_r[:,:,:,2] + 1j * fG_hat_i[:,:,:,2]).reshape((Nz, Ny * Nx)))
+  Cf = np.asfortranarray(columns(fG_hat_r, 0, dof, Nz, planar, kmajor) + 1j * columns(fG_hat_i, 0, dof, Nz, planar, kmajor))
+  Cg = np.asfortranarray(columns(fG_hat_r, 1, dof, Nz, planar, kmajor) + 1j * columns(fG_hat_i, 1, dof, Nz, planar, kmajor))
+  Ch = np.asfortranarray(columns(fG_hat_r, 2, dof, Nz, planar, kmajor) + 1j * columns(fG_hat_i, 2, dof, Nz, planar, kmajor))
   Dh = np.asfortranarray(chebCoeffDiff(Ch, Nx, Ny, Nz, 1, H).reshape((Nz, Ny * Nx)))
   # compute RHS of pressure poisson eq
   p_RHS = Dx * Cf + Dy * Cg + Dh
@@ -247,22 +378,25 @@ def DoublyPeriodicStokes_no_wall(fG_hat_r, fG_hat_i, eta, Nx, Ny, Nz, H,\
   # interleave solution components and split
   # real/imaginary parts for passing back to c
   U_hat_r = np.zeros((Nz * Ny * Nx * dof,), dtype = np.double)
-  U_hat_r[0::3] = np.real(Cu).reshape((Nz * Ny * Nx,))
-  U_hat_r[1::3] = np.real(Cv).reshape((Nz * Ny * Nx,))
-  U_hat_r[2::3] = np.real(Cw).reshape((Nz * Ny * Nx,))
+  columns(U_hat_r, 0, dof, Nz, planar, kmajor)[:] = np.real(Cu)
+  columns(U_hat_r, 1, dof, Nz, planar, kmajor)[:] = np.real(Cv)
+  columns(U_hat_r, 2, dof, Nz, planar, kmajor)[:] = np.real(Cw)
   U_hat_i = np.zeros((Nz * Ny * Nx * dof,), dtype = np.double)
-  U_hat_i[0::3] = np.imag(Cu).reshape((Nz * Ny * Nx,))
-  U_hat_i[1::3] = np.imag(Cv).reshape((Nz * Ny * Nx,))
-  U_hat_i[2::3] = np.imag(Cw).reshape((Nz * Ny * Nx,))
-  P_hat_r = np.real(Cp).reshape((Nz * Ny * Nx,))
-  P_hat_i = np.imag(Cp).reshape((Nz * Ny * Nx,))
+  columns(U_hat_i, 0, dof, Nz, planar, kmajor)[:] = np.imag(Cu)
+  columns(U_hat_i, 1, dof, Nz, planar, kmajor)[:] = np.imag(Cv)
+  columns(U_hat_i, 2, dof, Nz, planar, kmajor)[:] = np.imag(Cw)
+  P_hat_r = np.zeros((Nz * Ny * Nx,), dtype = np.double)
+  columns(P_hat_r, 0, 1, Nz, False, kmajor)[:] = np.real(Cp)
+  P_hat_i = np.zeros((Nz * Ny * Nx,), dtype = np.double)
+  columns(P_hat_i, 0, 1, Nz, False, kmajor)[:] = np.imag(Cp)
   return U_hat_r, U_hat_i, P_hat_r, P_hat_i
 
 # DP bottom wall solver
 def DoublyPeriodicStokes_bottom_wall(fG_hat_r, fG_hat_i, zpts, eta, Nx, Ny, Nz, H,\
                                      Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, \
                                      uvints, BCs_k0, BCs_k, LU, Ainv_B, C, \
-                                     PIV, C_k0, Ginv, Ginv_k0, BCR1, BCL2):
+                                     PIV, C_k0, Ginv, Ginv_k0, BCR1, BCL2, planar = False, real = False,
+                                     kmajor = False):
   """
   Solve Stokes eq in doubly periodic bottom wall in the Fourier-Chebyshev domain 
   given the Fourier-Chebyshev coefficients of the forcing. We first solve a DP
@@ -292,27 +426,40 @@ def DoublyPeriodicStokes_bottom_wall(fG_hat_r, fG_hat_i, zpts, eta, Nx, Ny, Nz,
                        - See precomputeBandedLinOps and its side effects for details
     C_k0, Ginv_k0 - analog of C, Ginv above for k = 0
     BCR1, BCL2 - See DoublyPeriodicNoWallBCs for details
+    planar - if True, fG_hat has shape (dof, Nz, Ny, Nx) rather than (Nz, Ny, Nx, dof), 
+             and the components of U_hat are stored in planes (see Grid.py)
+    real - if True, fG_hat, U_hat and P_hat only hold the Nx // 2 + 1 non-negative wave numbers
+           in x (the half spectrum of a real transform), and the precomputations are
+           from DoublyPeriodicStokes_init(..., real = True)
+    kmajor - if True, fG_hat, U_hat and P_hat are stored wavenumber-major, with the Nz
+             coefficients of each wave number and component contiguous (see Transform.py),
+             so the Chebyshev columns are views rather than transposed copies
   
   Returns:
     U_hat_r, U_hat_i, P_hat_r, P_hat_i - real and complex part of 
                                        - Fourier-Chebyshev coefficients of
                                          fluid velocity and pressure on the grid. 
   """
-  dof = 3; Nyx = Ny * Nx;
+  dof = 3;
+  # points of the spectrum in x
+  if real: Nx = Nx // 2 + 1
+  Nyx = Ny * Nx;
   # solve the doubly periodic problem, ignoring k=0
   U_hat_r, U_hat_i, P_hat_r, P_hat_i = DoublyPeriodicStokes_no_wall(fG_hat_r, fG_hat_i, eta, Nx, Ny, Nz, H, \
                                                                     Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, \
                                                                     uvints, BCs_k0, BCs_k, LU, Ainv_B, C, \
-                                                                    PIV, C_k0, Ginv, Ginv_k0, 0)
+                                                                    PIV, C_k0, Ginv, Ginv_k0, 0, planar, \
+                                                                    kmajor = kmajor)
   
   # Cheb coeffs of forcing for k = 0
-  Cf_k0 = fG_hat_r[:,0,0,0] + 1j * fG_hat_i[:,0,0,0]
-  Cg_k0 = fG_hat_r[:,0,0,1] + 1j * fG_hat_i[:,0,0,1]
-  Ch_k0 = fG_hat_r[:,0,0,2] + 1j * fG_hat_i[:,0,0,2]
+  Cf_k0 = columns(fG_hat_r, 0, dof, Nz, planar, kmajor)[:,0] + 1j * columns(fG_hat_i, 0, dof, Nz, planar, kmajor)[:,0]
+  Cg_k0 = columns(fG_hat_r, 1, dof, Nz, planar, kmajor)[:,0] + 1j * columns(fG_hat_i, 1, dof, Nz, planar, kmajor)[:,0]
+  Ch_k0 = columns(fG_hat_r, 2, dof, Nz, planar, kmajor)[:,0] + 1j * columns(fG_hat_i, 2, dof, Nz, planar, kmajor)[:,0]
   Dh_k0 = chebCoeffDiff(Ch_k0, 1, 1, Nz, 1, H).reshape((Nz,))
   # First cheb coeff of pressure for k = 0
   Cp_k0 = P_hat_r[0] + 1j * P_hat_i[0]
-  Dp_k0 = chebCoeffDiff(P_hat_r[0::Ny * Nx] + 1j * P_hat_i[0::Ny * Nx], 1, 1, Nz, 1, H).reshape((Nz,)) 
+  Dp_k0 = chebCoeffDiff(columns(P_hat_r, 0, 1, Nz, False, kmajor)[:,0] + \
+                        1j * columns(P_hat_i, 0, 1, Nz, False, kmajor)[:,0], 1, 1, Nz, 1, H).reshape((Nz,)) 
   # RHS for k = 0 correction solve for pressure and vel
   p_RHS_k0 = Dh_k0
   u_RHS_k0 = -Cf_k0 / eta
@@ -320,11 +467,11 @@ def DoublyPeriodicStokes_bottom_wall(fG_hat_r, fG_hat_i, zpts, eta, Nx, Ny, Nz,
   w_RHS_k0 = (Dp_k0 - Ch_k0) / eta
 
   # get negative of velocities at bottom wall for BCs of correction problem
-  Cubw_r = -1.0 * evalTheta(U_hat_r, np.pi, Nyx, Nz, dof)
-  Cubw_i = -1.0 * evalTheta(U_hat_i, np.pi, Nyx, Nz, dof)
+  Cubw_r = -1.0 * evalTheta(U_hat_r, np.pi, Nyx, Nz, dof, planar, kmajor)
+  Cubw_i = -1.0 * evalTheta(U_hat_i, np.pi, Nyx, Nz, dof, planar, kmajor)
   # compute the correction field for k != 0 
   Cpcorr, Cucorr, Cvcorr, Cwcorr = \
-    evalCorrectionSol_bottomWall(Cubw_r, Cubw_i, zpts, Kx, Ky, eta, Nx, Ny, Nz, dof)
+    evalCorrectionSol_bottomWall(Cubw_r, Cubw_i, zpts, Kx, Ky, eta, Nx, Ny, Nz, dof, LU.dtype)
   # correct pressure for k = 0
   Cpcorr[:,0] = DoublyPeriodicStokes_wall_solvePressureBVP_k0(\
                    p_RHS_k0, C_k0, Ginv_k0, SIMat, Ch_k0, pints, Cp_k0)
@@ -340,17 +487,22 @@ def DoublyPeriodicStokes_bottom_wall(fG_hat_r, fG_hat_i, zpts, eta, Nx, Ny, Nz,
                                u_RHS_k0, v_RHS_k0, w_RHS_k0, C_k0_bw,\
                                Ginv_k0_bw, SIMat, Cf_k0, Cg_k0)
   # add the solutions to the two subproblems
-  P_hat_r += np.real(Cpcorr.reshape((Nz * Nyx,))); P_hat_i += np.imag(Cpcorr.reshape((Nz * Nyx)))
-  U_hat_r[0::3] += np.real(Cucorr.reshape((Nz * Nyx,))); U_hat_i[0::3] += np.imag(Cucorr.reshape((Nz * Nyx,)))
-  U_hat_r[1::3] += np.real(Cvcorr.reshape((Nz * Nyx,))); U_hat_i[1::3] += np.imag(Cvcorr.reshape((Nz * Nyx,)))
-  U_hat_r[2::3] += np.real(Cwcorr.reshape((Nz * Nyx,))); U_hat_i[2::3] += np.imag(Cwcorr.reshape((Nz * Nyx,)))
+  columns(P_hat_r, 0, 1, Nz, False, kmajor)[:] += np.real(Cpcorr)
+  columns(P_hat_i, 0, 1, Nz, False, kmajor)[:] += np.imag(Cpcorr)
+  columns(U_hat_r, 0, dof, Nz, planar, kmajor)[:] += np.real(Cucorr)
+  columns(U_hat_i, 0, dof, Nz, planar, kmajor)[:] += np.imag(Cucorr)
+  columns(U_hat_r, 1, dof, Nz, planar, kmajor)[:] += np.real(Cvcorr)
+  columns(U_hat_i, 1, dof, Nz, planar, kmajor)[:] += np.imag(Cvcorr)
+  columns(U_hat_r, 2, dof, Nz, planar, kmajor)[:] += np.real(Cwcorr)
+  columns(U_hat_i, 2, dof, Nz, planar, kmajor)[:] += np.imag(Cwcorr)
   return U_hat_r, U_hat_i, P_hat_r, P_hat_i  
 
 # DP slit channel solver
 def DoublyPeriodicStokes_slit_channel(fG_hat_r, fG_hat_i, zpts, eta, Nx, Ny, Nz, H,\
                                       Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, \
                                       uvints, BCs_k0, BCs_k, LU, Ainv_B, C, \
-                                      PIV, C_k0, Ginv, Ginv_k0, BCR2, BCL2):
+                                      PIV, C_k0, Ginv, Ginv_k0, BCR2, BCL2, planar = False, real = False,
+                                      kmajor = False):
   """
   Solve Stokes eq in doubly periodic slit channel in the Fourier-Chebyshev domain 
   given the Fourier-Chebyshev coefficients of the forcing. We first solve a DP
@@ -380,40 +532,53 @@ def DoublyPeriodicStokes_slit_channel(fG_hat_r, fG_hat_i, zpts, eta, Nx, Ny, Nz,
                        - See precomputeBandedLinOps and its side effects for details
     C_k0, Ginv_k0 - analog of C, Ginv above for k = 0
     BCR2, BCL2 - See DoublyPeriodicNoWallBCs for details
+    planar - if True, fG_hat has shape (dof, Nz, Ny, Nx) rather than (Nz, Ny, Nx, dof), 
+             and the components of U_hat are stored in planes (see Grid.py)
+    real - if True, fG_hat, U_hat and P_hat only hold the Nx // 2 + 1 non-negative wave numbers
+           in x (the half spectrum of a real transform), and the precomputations are
+           from DoublyPeriodicStokes_init(..., real = True)
+    kmajor - if True, fG_hat, U_hat and P_hat are stored wavenumber-major, with the Nz
+             coefficients of each wave number and component contiguous (see Transform.py),
+             so the Chebyshev columns are views rather than transposed copies
   
   Returns:
     U_hat_r, U_hat_i, P_hat_r, P_hat_i - real and complex part of 
                                        - Fourier-Chebyshev coefficients of
                                          fluid velocity and pressure on the grid. 
   """
-  dof = 3; Nyx = Ny * Nx; Lz = 2 * H
+  dof = 3; Lz = 2 * H
+  # points of the spectrum in x
+  if real: Nx = Nx // 2 + 1
+  Nyx = Ny * Nx;
   # solve the doubly periodic problem, ignoring k=0
   U_hat_r, U_hat_i, P_hat_r, P_hat_i = DoublyPeriodicStokes_no_wall(fG_hat_r, fG_hat_i, eta, Nx, Ny, Nz, H, \
                                                                     Kx, Ky, K, Dx, Dy, FIMat, SIMat, pints, \
                                                                     uvints, BCs_k0, BCs_k, LU, Ainv_B, C, \
-                                                                    PIV, C_k0, Ginv, Ginv_k0, 0)
+                                                                    PIV, C_k0, Ginv, Ginv_k0, 0, planar, \
+                                                                    kmajor = kmajor)
 
   # Cheb coeffs of forcing for k = 0
-  Cf_k0 = fG_hat_r[:,0,0,0] + 1j * fG_hat_i[:,0,0,0]
-  Cg_k0 = fG_hat_r[:,0,0,1] + 1j * fG_hat_i[:,0,0,1]
-  Ch_k0 = fG_hat_r[:,0,0,2] + 1j * fG_hat_i[:,0,0,2]
+  Cf_k0 = columns(fG_hat_r, 0, dof, Nz, planar, kmajor)[:,0] + 1j * columns(fG_hat_i, 0, dof, Nz, planar, kmajor)[:,0]
+  Cg_k0 = columns(fG_hat_r, 1, dof, Nz, planar, kmajor)[:,0] + 1j * columns(fG_hat_i, 1, dof, Nz, planar, kmajor)[:,0]
+  Ch_k0 = columns(fG_hat_r, 2, dof, Nz, planar, kmajor)[:,0] + 1j * columns(fG_hat_i, 2, dof, Nz, planar, kmajor)[:,0]
   Dh_k0 = chebCoeffDiff(Ch_k0, 1, 1, Nz, 1, H).reshape((Nz,))
   # First cheb coeff of pressure for k = 0
   Cp_k0 = P_hat_r[0] + 1j * P_hat_i[0]
-  Dp_k0 = chebCoeffDiff(P_hat_r[0::Ny * Nx] + 1j * P_hat_i[0::Ny * Nx], 1, 1, Nz, 1, H).reshape((Nz,)) 
+  Dp_k0 = chebCoeffDiff(columns(P_hat_r, 0, 1, Nz, False, kmajor)[:,0] + \
+                        1j * columns(P_hat_i, 0, 1, Nz, False, kmajor)[:,0], 1, 1, Nz, 1, H).reshape((Nz,)) 
   # RHS for k = 0 correction solve for pressure and vel
   p_RHS_k0 = Dh_k0
   u_RHS_k0 = -Cf_k0 / eta
   v_RHS_k0 = -Cg_k0 / eta
   w_RHS_k0 = (Dp_k0 - Ch_k0) / eta
   # get negative of velocities at walls for BCs of correction problem
-  Cubw_r = -1.0 * evalTheta(U_hat_r, np.pi, Nyx, Nz, dof)
-  Cubw_i = -1.0 * evalTheta(U_hat_i, np.pi, Nyx, Nz, dof)
-  Cutw_r = -1.0 * evalTheta(U_hat_r, 0, Nyx, Nz, dof)
-  Cutw_i = -1.0 * evalTheta(U_hat_i, 0, Nyx, Nz, dof)
+  Cubw_r = -1.0 * evalTheta(U_hat_r, np.pi, Nyx, Nz, dof, planar, kmajor)
+  Cubw_i = -1.0 * evalTheta(U_hat_i, np.pi, Nyx, Nz, dof, planar, kmajor)
+  Cutw_r = -1.0 * evalTheta(U_hat_r, 0, Nyx, Nz, dof, planar, kmajor)
+  Cutw_i = -1.0 * evalTheta(U_hat_i, 0, Nyx, Nz, dof, planar, kmajor)
   # compute the correction field for k != 0 
   Cpcorr, Cucorr, Cvcorr, Cwcorr = \
-    evalCorrectionSol_slitChannel(Cubw_r, Cubw_i, Cutw_r, Cutw_i, zpts, Kx, Ky, eta, Lz, Nx, Ny, Nz, dof)
+    evalCorrectionSol_slitChannel(Cubw_r, Cubw_i, Cutw_r, Cutw_i, zpts, Kx, Ky, eta, Lz, Nx, Ny, Nz, dof, LU.dtype)
 
   # correct pressure for k = 0
   Cpcorr[:,0] = DoublyPeriodicStokes_wall_solvePressureBVP_k0(\
@@ -430,12 +595,114 @@ def DoublyPeriodicStokes_slit_channel(fG_hat_r, fG_hat_i, zpts, eta, Nx, Ny, Nz,
                                u_RHS_k0, v_RHS_k0, w_RHS_k0, C_k0_tw,\
                                Ginv_k0_tw, SIMat, Cf_k0, Cg_k0)
   # add the solutions to the two subproblems
-  P_hat_r += np.real(Cpcorr.reshape((Nz * Nyx,))); P_hat_i += np.imag(Cpcorr.reshape((Nz * Nyx)))
-  U_hat_r[0::3] += np.real(Cucorr.reshape((Nz * Nyx,))); U_hat_i[0::3] += np.imag(Cucorr.reshape((Nz * Nyx,)))
-  U_hat_r[1::3] += np.real(Cvcorr.reshape((Nz * Nyx,))); U_hat_i[1::3] += np.imag(Cvcorr.reshape((Nz * Nyx,)))
-  U_hat_r[2::3] += np.real(Cwcorr.reshape((Nz * Nyx,))); U_hat_i[2::3] += np.imag(Cwcorr.reshape((Nz * Nyx,)))
+  columns(P_hat_r, 0, 1, Nz, False, kmajor)[:] += np.real(Cpcorr)
+  columns(P_hat_i, 0, 1, Nz, False, kmajor)[:] += np.imag(Cpcorr)
+  columns(U_hat_r, 0, dof, Nz, planar, kmajor)[:] += np.real(Cucorr)
+  columns(U_hat_i, 0, dof, Nz, planar, kmajor)[:] += np.imag(Cucorr)
+  columns(U_hat_r, 1, dof, Nz, planar, kmajor)[:] += np.real(Cvcorr)
+  columns(U_hat_i, 1, dof, Nz, planar, kmajor)[:] += np.imag(Cvcorr)
+  columns(U_hat_r, 2, dof, Nz, planar, kmajor)[:] += np.real(Cwcorr)
+  columns(U_hat_i, 2, dof, Nz, planar, kmajor)[:] += np.imag(Cwcorr)
   return U_hat_r, U_hat_i, P_hat_r, P_hat_i  
 
+class DoublyPeriodicStokesSolver(object):
+  """
+  Python wrapper for the C++ DPStokes struct (see DPStokes.h), which holds the
+  operators of DoublyPeriodicStokes_init() for a grid, and solves the no wall,
+  bottom wall and slit channel problems in place in C, one wave number per thread,
+  with no temporaries the size of the grid. It solves the same problems as
+  DoublyPeriodicStokes_no_wall(), _bottom_wall() and _slit_channel().
+
+  Attributes:
+    Nx, Ny, Nz - number of points in x, y and z
+    planar, real, kmajor - layout of the spectrum, as in DoublyPeriodicStokes_no_wall()
+    single (bool) - whether the spectrum is float32 (see Transformer(_single = True))
+    dtype - dtype of the spectrum
+    solver (ptr to C++ struct) - a pointer to the C++ DPStokes struct
+  """
+  # geometries (see DPGeometry in DPStokes.h)
+  geometries = {'no_wall' : 0, 'bottom_wall' : 1, 'slit_channel' : 2}
+
+  def __init__(self, Lx, Ly, H, Nx, Ny, Nz, eta, planar = False, real = False, kmajor = False,
+               single = False):
+    """
+    Precompute the operators (C lib).
+
+    Parameters:
+      Lx, Ly - extent of x and y grids
+      H - half extent of z grid (Lz / 2)
+      Nx, Ny, Nz - number of points in x, y and z
+      eta - viscosity
+      planar, real, kmajor - layout of the spectrum (see Transform.py)
+      single - if True, the spectrum is float32, and the solves are in single precision
+    """
+    self.Nx = Nx; self.Ny = Ny; self.Nz = Nz
+    self.planar = planar; self.real = real; self.kmajor = kmajor; self.single = single
+    self.dtype = np.float32 if single else np.double
+    self.solver = self._lib('MakeDPStokes')(Nx, Ny, Nz, Lx, Ly, H, eta, planar, real, kmajor)
+
+  def _lib(self, name):
+    """
+    The C lib routine name for the precision of this solver (the single precision
+    routines have an F suffix, see DPStokesWrapper.cpp).
+    """
+    return getattr(libDPStokes, name + ('F' if self.single else ''))
+
+  def Solve(self, fG_hat_r, fG_hat_i, geometry = 'no_wall', k0 = 0, pressure = False):
+    """
+    Python wrapper for the SolveDPStokes(solver,..) C lib routine. The solve is in place.
+
+    Parameters:
+      fG_hat_r, fG_hat_i - real and complex part of Fourier-Chebyshev coefficients of the
+                           spread forces (of dtype self.dtype, eg. the output of a Transformer
+                           with a Chebyshev z axis). These are overwritten with the velocity.
+      geometry - 'no_wall', 'bottom_wall' or 'slit_channel'
+      k0 - switch for the k = 0 mode of the no wall solve (see DoublyPeriodicStokes_no_wall())
+      pressure - if True, the coefficients of the pressure are returned too
+
+    Returns:
+      U_hat_r, U_hat_i - real and complex part of Fourier-Chebyshev coefficients of
+                         fluid velocity on the grid (fG_hat_r, fG_hat_i)
+      P_hat_r, P_hat_i - those of the pressure, if pressure is True
+    """
+    real_t = ctypes.c_float if self.single else ctypes.c_double
+    for U in (fG_hat_r, fG_hat_i):
+      if U.dtype != self.dtype or not U.flags.c_contiguous:
+        raise ValueError('The spectra must be contiguous arrays of ' + np.dtype(self.dtype).name)
+    ptr = lambda U: U.ctypes.data_as(ctypes.POINTER(real_t))
+    P_hat_r, P_hat_i = (np.zeros(fG_hat_r.size // 3, dtype = self.dtype) for _ in range(2)) \
+                       if pressure else (None, None)
+    self._lib('SolveDPStokes')(self.solver, ptr(fG_hat_r), ptr(fG_hat_i), self.geometries[geometry], k0,
+                               ptr(P_hat_r) if pressure else None, ptr(P_hat_i) if pressure else None)
+    if pressure:
+      return fG_hat_r, fG_hat_i, P_hat_r, P_hat_i
+    return fG_hat_r, fG_hat_i
+
+  def MemoryReport(self):
+    """
+    Python wrapper for the DPStokesMemoryReport(solver,..) C lib routine
+
+    Parameters: None
+    Side Effects: None
+    Returns: dict of buffer name -> bytes
+    """
+    n = self._lib('DPStokesMemoryReport')(self.solver, None, None, 0)
+    names = (ctypes.c_char_p * n)(); sizes = (ctypes.c_size_t * n)()
+    self._lib('DPStokesMemoryReport')(self.solver, names, sizes, n)
+    return {names[i].decode('utf-8') : sizes[i] for i in range(n)}
+
+  def Clean(self):
+    """
+    Python wrapper for the CleanDPStokes(..) C lib routine, which frees the
+    operators and deletes the C++ struct.
+
+    Side Effects:
+      self.solver is deleted and nullified
+    """
+    self._lib('CleanDPStokes')(self.solver)
+    self._lib('DeleteDPStokes')(self.solver)
+    self.solver = None
+
 # BCs for DP problem (not usually called externally)
 def DoublyPeriodic_no_wall_BCs(N):
   """
@@ -504,17 +771,14 @@ def DoublyPeriodicStokes_no_wall_solvePressureBVP_k(p_RHS, LU, PIV, C, Ainv_B, G
 
   """ 
   Nz, Nyx = p_RHS.shape
-  p_RHS_r = np.asfortranarray(np.real(p_RHS))
-  p_RHS_i = np.asfortranarray(np.imag(p_RHS))
-  Cp_r = np.asfortranarray(np.zeros((Nz, Nyx)))
-  Cp_i = np.asfortranarray(np.zeros((Nz, Nyx)))
-  Dp_r = np.asfortranarray(np.zeros((Nz, Nyx)))
-  Dp_i = np.asfortranarray(np.zeros((Nz, Nyx)))
-  bandedSchurSolve(LU, p_RHS_r, PIV, C, Ginv, Ainv_B, np.asfortranarray(FIMat), np.asfortranarray(SIMat), Cp_r, Dp_r, 2, 2, Nyx, Nz)
-  bandedSchurSolve(LU, p_RHS_i, PIV, C, Ginv, Ainv_B, np.asfortranarray(FIMat), np.asfortranarray(SIMat), Cp_i, Dp_i, 2, 2, Nyx, Nz)
-  Cp = Cp_r + 1j * Cp_i
-  Dp = Dp_r + 1j * Dp_i
-  return Cp, Dp
+  # the banded solves are in the precision of LU (see DoublyPeriodicStokes_init())
+  SIMat = np.asfortranarray(SIMat, dtype = LU.dtype); FIMat = np.asfortranarray(FIMat, dtype = LU.dtype)
+  # the real and imaginary parts are solved for together (Nz x 2 x Nyx)
+  p_RHS = np.asfortranarray(np.stack((np.real(p_RHS), np.imag(p_RHS)), axis = 1), dtype = LU.dtype)
+  Cp = np.asfortranarray(np.zeros((Nz, 2, Nyx), dtype = LU.dtype))
+  Dp = np.asfortranarray(np.zeros((Nz, 2, Nyx), dtype = LU.dtype))
+  bandedSchurSolveBatched(LU, p_RHS, None, PIV, C, Ginv, Ainv_B, FIMat, SIMat, Cp, Dp, 2, 2, Nyx, Nz, 2)
+  return Cp[:,0,:] + 1j * Cp[:,1,:], Dp[:,0,:] + 1j * Dp[:,1,:]
 
 def DoublyPeriodicStokes_no_wall_solvePressureBVP_k0(p_RHS, C, Ginv, SIMat, FIMat, Ch, pints, k0):
   """
@@ -601,33 +865,16 @@ def DoublyPeriodicStokes_no_wall_solveVelocityBVP_k(u_RHS, v_RHS, w_RHS, LU, PIV
     Cu, Cv, Cw - Fourier-Chebyshev coeffs of velocity components
   """
   Nz, Nyx = u_RHS.shape
-  u_RHS_r = np.asfortranarray(np.real(u_RHS))
-  u_RHS_i = np.asfortranarray(np.imag(u_RHS))
-  v_RHS_r = np.asfortranarray(np.real(v_RHS))
-  v_RHS_i = np.asfortranarray(np.imag(v_RHS))
-  w_RHS_r = np.asfortranarray(np.real(w_RHS))
-  w_RHS_i = np.asfortranarray(np.imag(w_RHS))
-  u_bc_RHS_r = np.asfortranarray(np.real(u_bc_RHS))
-  u_bc_RHS_i = np.asfortranarray(np.imag(u_bc_RHS))
-  v_bc_RHS_r = np.asfortranarray(np.real(v_bc_RHS))
-  v_bc_RHS_i = np.asfortranarray(np.imag(v_bc_RHS))
-  w_bc_RHS_r = np.asfortranarray(np.real(w_bc_RHS))
-  w_bc_RHS_i = np.asfortranarray(np.imag(w_bc_RHS))
-  Cu_r = np.asfortranarray(np.zeros((Nz, Nyx)))
-  Cu_i = np.asfortranarray(np.zeros((Nz, Nyx)))
-  Cv_r = np.asfortranarray(np.zeros((Nz, Nyx)))
-  Cv_i = np.asfortranarray(np.zeros((Nz, Nyx)))
-  Cw_r = np.asfortranarray(np.zeros((Nz, Nyx)))
-  Cw_i = np.asfortranarray(np.zeros((Nz, Nyx)))
-  bandedSchurSolve_noD(LU, u_RHS_r, u_bc_RHS_r, PIV, C, Ginv, Ainv_B, np.asfortranarray(SIMat), Cu_r, 2, 2, Nyx, Nz)
-  bandedSchurSolve_noD(LU, u_RHS_i, u_bc_RHS_i, PIV, C, Ginv, Ainv_B, np.asfortranarray(SIMat), Cu_i, 2, 2, Nyx, Nz)
-  bandedSchurSolve_noD(LU, v_RHS_r, v_bc_RHS_r, PIV, C, Ginv, Ainv_B, np.asfortranarray(SIMat), Cv_r, 2, 2, Nyx, Nz)
-  bandedSchurSolve_noD(LU, v_RHS_i, v_bc_RHS_i, PIV, C, Ginv, Ainv_B, np.asfortranarray(SIMat), Cv_i, 2, 2, Nyx, Nz)
-  bandedSchurSolve_noD(LU, w_RHS_r, w_bc_RHS_r, PIV, C, Ginv, Ainv_B, np.asfortranarray(SIMat), Cw_r, 2, 2, Nyx, Nz)
-  bandedSchurSolve_noD(LU, w_RHS_i, w_bc_RHS_i, PIV, C, Ginv, Ainv_B, np.asfortranarray(SIMat), Cw_i, 2, 2, Nyx, Nz)
-  Cu = Cu_r + 1j * Cu_i
-  Cv = Cv_r + 1j * Cv_i
-  Cw = Cw_r + 1j * Cw_i
+  # the banded solves are in the precision of LU (see DoublyPeriodicStokes_init())
+  SIMat = np.asfortranarray(SIMat, dtype = LU.dtype)
+  # the real and imaginary parts of u, v and w are solved for together (Nz x 6 x Nyx)
+  RHS = np.asfortranarray(np.stack([f(R) for R in (u_RHS, v_RHS, w_RHS) for f in (np.real, np.imag)], 
+                                   axis = 1), dtype = LU.dtype)
+  bc_RHS = np.asfortranarray(np.stack([f(R) for R in (u_bc_RHS, v_bc_RHS, w_bc_RHS) for f in (np.real, np.imag)],
+                                      axis = 1), dtype = LU.dtype)
+  Cuvw = np.asfortranarray(np.zeros((Nz, 6, Nyx), dtype = LU.dtype))
+  bandedSchurSolveBatched(LU, RHS, bc_RHS, PIV, C, Ginv, Ainv_B, None, SIMat, Cuvw, None, 2, 2, Nyx, Nz, 6)
+  Cu, Cv, Cw = [Cuvw[:,2 * d,:] + 1j * Cuvw[:,2 * d + 1,:] for d in range(3)]
   return Cu, Cv, Cw                                               
 
 def DoublyPeriodic_no_wall_solveVelocityBVP_k0(u_RHS, v_RHS, w_RHS, C, Ginv, SIMat,\
@@ -698,8 +945,54 @@ def DoublyPeriodic_wall_solveVelocityBVP_k0(u_RHS, v_RHS, w_RHS, C, Ginv, SIMat,
 ####################### DP wall correction subroutines ############################
 ###################################################################################
 
+def component(F, d, dof, planar):
+  """
+  Get a view of component d of data on the grid.
+
+  Parameters:
+    F - the data, either flat (size N * dof), or shaped (Nz, Ny, Nx, dof)
+      - (or (dof, Nz, Ny, Nx) if planar)
+    d - the component
+    dof - degrees of freedom
+    planar - whether the components are interleaved (False) or stored
+             in contiguous planes of N points (True)
+
+  Side Effects: None
+  Returns: a view of component d of F (writing to it modifies F)
+  """
+  if F.ndim == 1:
+    N = F.size // dof
+    return F[d * N:(d + 1) * N] if planar else F[d::dof]
+  return F[d] if planar else F[..., d]
+
+def columns(F, d, dof, Nz, planar, kmajor = False):
+  """
+  Get a view of the Chebyshev columns of component d of data on the grid (or
+  its spectrum), as an Nz x Nyx array whose column i holds the Nz values (or 
+  coefficients) in z of wave number i.
+
+  Parameters:
+    F - the data, flat or shaped (see component() and Transformer._shape())
+    d - the component
+    dof - degrees of freedom
+    Nz - number of points in z
+    planar - whether the components are stored in planes (see component())
+    kmajor - whether the data is stored wavenumber-major (see Transform.py),
+             in which case the columns are contiguous, so the view is column-major
+
+  Side Effects: None
+  Returns: a view of component d of F (writing to it modifies F)
+  """
+  F = F.reshape((F.size,))
+  Nyx = F.size // (dof * Nz)
+  if not kmajor:
+    return component(F, d, dof, planar).reshape((Nz, Nyx))
+  if planar:
+    return component(F, d, dof, True).reshape((Nyx, Nz)).T
+  return F.reshape((Nyx, dof, Nz))[:, d, :].T
+
 # define wrappers for dptools
-def evalTheta(phi_in, theta, Nyx, Nz, dof):
+def evalTheta(phi_in, theta, Nyx, Nz, dof, planar = False, kmajor = False):
   """
     This function is used to evaluate a Chebyshev series at a given
     value of theta (point on the cheb grid)
@@ -712,20 +1005,30 @@ def evalTheta(phi_in, theta, Nyx, Nz, dof):
       Nyx - total number of points in x,y
       Nz  - number of points in z
       dof - degrees of freedom
+      planar - whether the components of in are stored in planes (see Grid.py)
+      kmajor - whether in is stored wavenumber-major (see Transform.py)
     
     Side Effects: None
     
     Returns : Phi_out - the output array (size (Nyx * dof, 1))
                       - these are the Fourier-Chebyshev coeffs on the x-y
-                      - plane at a given z value 
+                      - plane at a given z value (interleaved for either layout)
   """
+  if kmajor:
+    # the series is sum_k c_k T_k(cos(theta)) = sum_k c_k cos(k theta) for each column
+    Tk = np.cos(np.arange(0, Nz) * theta)
+    return np.stack([Tk @ columns(phi_in, d, dof, Nz, planar, True) \
+                     for d in range(0, dof)], axis = 1).reshape((Nyx * dof,))
+  if planar:
+    return np.stack([evalTheta(component(phi_in, d, dof, True), theta, Nyx, Nz, 1) \
+                     for d in range(0, dof)], axis = 1).reshape((Nyx * dof,))
   phi_out = np.zeros((Nyx * dof,), dtype = np.double)
   libDPTools.evalTheta(phi_in.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
                        phi_out.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
                        theta, Nyx, Nz, dof)
   return phi_out
 
-def evalCorrectionSol_bottomWall(Cu_r, Cu_i, zpts, Kx, Ky, eta, Nx, Ny, Nz, dof):
+def evalCorrectionSol_bottomWall(Cu_r, Cu_i, zpts, Kx, Ky, eta, Nx, Ny, Nz, dof, dtype = np.double):
   """ 
   Evaluate the analytical correction to the DP solve to enforce no-slip 
   BCs at the bottom wall (calls c lib)
@@ -737,6 +1040,7 @@ def evalCorrectionSol_bottomWall(Cu_r, Cu_i, zpts, Kx, Ky, eta, Nx, Ny, Nz, dof)
     eta - viscosity
     Nx, Ny, Nz - num points in x,y,z
     dof - degrees of freedom   
+    dtype - precision of the evaluation (np.float32 calls the single precision c lib routine)
   
   Side Effects : None
   Returns : C(p,u,v,w)corr - combined real/complex Fourier-Chebyshev 
@@ -745,35 +1049,40 @@ def evalCorrectionSol_bottomWall(Cu_r, Cu_i, zpts, Kx, Ky, eta, Nx, Ny, Nz, dof)
                            - shape (Ny * Nx, Nz)
   """
   Nyx = Ny * Nx;
-  Cpcorr_r = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cpcorr_i = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cucorr_r = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cucorr_i = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cvcorr_r = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cvcorr_i = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cwcorr_r = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cwcorr_i = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  libDPTools.evalCorrectionSol_bottomWall(Cpcorr_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cpcorr_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cucorr_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cucorr_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cvcorr_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cvcorr_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cwcorr_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cwcorr_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cu_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cu_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Kx.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Ky.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          zpts.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          eta, Nyx, Nz, dof)
+  # the single precision routines have an F suffix (see DPTools.h)
+  single = dtype == np.float32
+  real_t = ctypes.c_float if single else ctypes.c_double
+  ptr = lambda U: np.ascontiguousarray(U, dtype = dtype).ctypes.data_as(ctypes.POINTER(real_t))
+  Cpcorr_r = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cpcorr_i = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cucorr_r = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cucorr_i = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cvcorr_r = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cvcorr_i = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cwcorr_r = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cwcorr_i = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  evalCorrectionSol = libDPTools.evalCorrectionSol_bottomWallF if single else libDPTools.evalCorrectionSol_bottomWall
+  evalCorrectionSol(ptr(Cpcorr_r),\
+                    ptr(Cpcorr_i),\
+                    ptr(Cucorr_r),\
+                    ptr(Cucorr_i),\
+                    ptr(Cvcorr_r),\
+                    ptr(Cvcorr_i),\
+                    ptr(Cwcorr_r),\
+                    ptr(Cwcorr_i),\
+                    ptr(Cu_r),\
+                    ptr(Cu_i),\
+                    ptr(Kx),\
+                    ptr(Ky),\
+                    ptr(zpts),\
+                    eta, Nyx, Nz, dof)
   Cpcorr = np.asfortranarray(np.transpose(np.reshape(Cpcorr_r + 1j * Cpcorr_i, (Ny * Nx, Nz)), (1,0)))
   Cucorr = np.asfortranarray(np.transpose(np.reshape(Cucorr_r + 1j * Cucorr_i, (Ny * Nx, Nz)), (1,0))) 
   Cvcorr = np.asfortranarray(np.transpose(np.reshape(Cvcorr_r + 1j * Cvcorr_i, (Ny * Nx, Nz)), (1,0))) 
   Cwcorr = np.asfortranarray(np.transpose(np.reshape(Cwcorr_r + 1j * Cwcorr_i, (Ny * Nx, Nz)), (1,0))) 
   return Cpcorr, Cucorr, Cvcorr, Cwcorr
 
-def evalCorrectionSol_slitChannel(Cub_r, Cub_i, Cut_r, Cut_i, zpts, Kx, Ky, eta, Lz, Nx, Ny, Nz, dof):
+def evalCorrectionSol_slitChannel(Cub_r, Cub_i, Cut_r, Cut_i, zpts, Kx, Ky, eta, Lz, Nx, Ny, Nz, dof, dtype = np.double):
   """ 
   Evaluate the analytical correction to the DP solve to enforce no-slip 
   BCs at the bottom and top wall (calls c lib)
@@ -787,6 +1096,7 @@ def evalCorrectionSol_slitChannel(Cub_r, Cub_i, Cut_r, Cut_i, zpts, Kx, Ky, eta,
     Lz - extent of z grid
     Nx, Ny, Nz - num points in x,y,z
     dof - degrees of freedom   
+    dtype - precision of the evaluation (np.float32 calls the single precision c lib routine)
   
   Side Effects : None
   Returns : C(p,u,v,w)corr - combined real/complex Fourier-Chebyshev 
@@ -795,30 +1105,35 @@ def evalCorrectionSol_slitChannel(Cub_r, Cub_i, Cut_r, Cut_i, zpts, Kx, Ky, eta,
                            - shape (Ny * Nx, Nz)
   """
   Nyx = Ny * Nx;
-  Cpcorr_r = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cpcorr_i = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cucorr_r = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cucorr_i = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cvcorr_r = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cvcorr_i = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cwcorr_r = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  Cwcorr_i = np.zeros((Nyx * Nz, 1), dtype = np.double) 
-  libDPTools.evalCorrectionSol_slitChannel(Cpcorr_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cpcorr_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cucorr_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cucorr_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cvcorr_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cvcorr_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cwcorr_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cwcorr_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cub_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cub_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cut_r.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Cut_i.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Kx.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Ky.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          zpts.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                          Lz, eta, Nyx, Nz, dof)
+  # the single precision routines have an F suffix (see DPTools.h)
+  single = dtype == np.float32
+  real_t = ctypes.c_float if single else ctypes.c_double
+  ptr = lambda U: np.ascontiguousarray(U, dtype = dtype).ctypes.data_as(ctypes.POINTER(real_t))
+  Cpcorr_r = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cpcorr_i = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cucorr_r = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cucorr_i = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cvcorr_r = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cvcorr_i = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cwcorr_r = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  Cwcorr_i = np.zeros((Nyx * Nz, 1), dtype = dtype) 
+  evalCorrectionSol = libDPTools.evalCorrectionSol_slitChannelF if single else libDPTools.evalCorrectionSol_slitChannel
+  evalCorrectionSol(ptr(Cpcorr_r),\
+                    ptr(Cpcorr_i),\
+                    ptr(Cucorr_r),\
+                    ptr(Cucorr_i),\
+                    ptr(Cvcorr_r),\
+                    ptr(Cvcorr_i),\
+                    ptr(Cwcorr_r),\
+                    ptr(Cwcorr_i),\
+                    ptr(Cub_r),\
+                    ptr(Cub_i),\
+                    ptr(Cut_r),\
+                    ptr(Cut_i),\
+                    ptr(Kx),\
+                    ptr(Ky),\
+                    ptr(zpts),\
+                    Lz, eta, Nyx, Nz, dof)
   Cpcorr = np.asfortranarray(np.transpose(np.reshape(Cpcorr_r + 1j * Cpcorr_i, (Ny * Nx, Nz)), (1,0)))
   Cucorr = np.asfortranarray(np.transpose(np.reshape(Cucorr_r + 1j * Cucorr_i, (Ny * Nx, Nz)), (1,0))) 
   Cvcorr = np.asfortranarray(np.transpose(np.reshape(Cvcorr_r + 1j * Cvcorr_i, (Ny * Nx, Nz)), (1,0))) 
@@ -870,15 +1185,23 @@ def precomputeBandedLinOps(A, B, C, D, G, Ginv, PIV, kl, ku, Nyx, Nz):
     A, B and PIV can be reused for future solves with LAPACK's dgbtrs routine,
     eg) they are passed to bandedSchurSolve
 
+  The operators A, B, C, D, G and Ginv are all float64, or all float32, in which case the
+  single precision LAPACK routines (sgbsv) are used, and the later solves with them are 
+  single precision too.
+
   """
-  libLinSolve.precomputeBandedLinOps(A.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                     B.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                     C.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                     D.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                     G.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                     Ginv.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                     PIV.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),\
-                                     kl, ku, Nyx, Nz)
+  # float32 operators (see DoublyPeriodicStokes_init()) use the single precision routine
+  single = A.dtype == np.float32
+  real_t = ctypes.c_float if single else ctypes.c_double
+  precompute = libLinSolve.precomputeBandedLinOpsF if single else libLinSolve.precomputeBandedLinOps
+  precompute(A.ctypes.data_as(ctypes.POINTER(real_t)),\
+             B.ctypes.data_as(ctypes.POINTER(real_t)),\
+             C.ctypes.data_as(ctypes.POINTER(real_t)),\
+             D.ctypes.data_as(ctypes.POINTER(real_t)),\
+             G.ctypes.data_as(ctypes.POINTER(real_t)),\
+             Ginv.ctypes.data_as(ctypes.POINTER(real_t)),\
+             PIV.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),\
+             kl, ku, Nyx, Nz)
 
 def bandedSchurSolve(LU, RHS, PIV, C, Ginv, AinvB, FIMat, SIMat, Cp, Dp, kl, ku, Nyx, Nz):
   """
@@ -905,17 +1228,20 @@ def bandedSchurSolve(LU, RHS, PIV, C, Ginv, AinvB, FIMat, SIMat, Cp, Dp, kl, ku,
   Side Effects:
     RHS is overwritten with A^{-1}RHS (from LAPACK solve)
   """
-  libLinSolve.bandedSchurSolve(LU.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                               RHS.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                               PIV.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),\
-                               C.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                               Ginv.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                               AinvB.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                               FIMat.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                               SIMat.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                               Cp.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                               Dp.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                               kl, ku, Nyx, Nz)
+  single = LU.dtype == np.float32
+  real_t = ctypes.c_float if single else ctypes.c_double
+  solve = libLinSolve.bandedSchurSolveF if single else libLinSolve.bandedSchurSolve
+  solve(LU.ctypes.data_as(ctypes.POINTER(real_t)),\
+        RHS.ctypes.data_as(ctypes.POINTER(real_t)),\
+        PIV.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),\
+        C.ctypes.data_as(ctypes.POINTER(real_t)),\
+        Ginv.ctypes.data_as(ctypes.POINTER(real_t)),\
+        AinvB.ctypes.data_as(ctypes.POINTER(real_t)),\
+        FIMat.ctypes.data_as(ctypes.POINTER(real_t)),\
+        SIMat.ctypes.data_as(ctypes.POINTER(real_t)),\
+        Cp.ctypes.data_as(ctypes.POINTER(real_t)),\
+        Dp.ctypes.data_as(ctypes.POINTER(real_t)),\
+        kl, ku, Nyx, Nz)
 def bandedSchurSolve_noD(LU, RHS, bc_RHS, PIV, C, Ginv, AinvB, SIMat, Cp, kl, ku, Nyx, Nz):
   """
   Given a block linear system of the form 
@@ -941,16 +1267,45 @@ def bandedSchurSolve_noD(LU, RHS, bc_RHS, PIV, C, Ginv, AinvB, SIMat, Cp, kl, ku
   Side Effects:
     RHS is overwritten with A^{-1}RHS (from LAPACK solve)
   """
-  libLinSolve.bandedSchurSolve_noD(LU.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                   RHS.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                   bc_RHS.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                   PIV.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),\
-                                   C.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                   Ginv.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                   AinvB.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                   SIMat.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                   Cp.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                   kl, ku, Nyx, Nz)
+  single = LU.dtype == np.float32
+  real_t = ctypes.c_float if single else ctypes.c_double
+  solve = libLinSolve.bandedSchurSolve_noDF if single else libLinSolve.bandedSchurSolve_noD
+  solve(LU.ctypes.data_as(ctypes.POINTER(real_t)),\
+        RHS.ctypes.data_as(ctypes.POINTER(real_t)),\
+        bc_RHS.ctypes.data_as(ctypes.POINTER(real_t)),\
+        PIV.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),\
+        C.ctypes.data_as(ctypes.POINTER(real_t)),\
+        Ginv.ctypes.data_as(ctypes.POINTER(real_t)),\
+        AinvB.ctypes.data_as(ctypes.POINTER(real_t)),\
+        SIMat.ctypes.data_as(ctypes.POINTER(real_t)),\
+        Cp.ctypes.data_as(ctypes.POINTER(real_t)),\
+        kl, ku, Nyx, Nz)
+
+def bandedSchurSolveBatched(LU, RHS, bc_RHS, PIV, C, Ginv, AinvB, FIMat, SIMat, Cp, Dp, kl, ku, Nyx, Nz, nrhs):
+  """
+  Batched form of bandedSchurSolve() and bandedSchurSolve_noD(), for the nrhs right-hand 
+  sides of each k that share its LU decomposition (eg. the real and imaginary parts of 
+  the pressure, or of the velocity components). They are solved for with one call to
+  LAPACK's dgbtrs and one Schur complement correction for each k.
+
+  Parameters:
+    as in bandedSchurSolve(), but for
+    RHS - Nz x nrhs x Nyx tensor containing the f of each right-hand side, in Fortran order
+    bc_RHS - 2 x nrhs x Nyx tensor containing (alpha, beta) of each right-hand side, or None
+             (for (alpha, beta) = 0, as in bandedSchurSolve())
+    FIMat, Dp - None if the derivative of the solution is not needed (as in bandedSchurSolve_noD())
+    Cp, Dp - Nz x nrhs x Nyx outputs, in Fortran order
+    nrhs - number of right-hand sides of each k
+    
+  Side Effects:
+    RHS is overwritten, and Cp (and Dp) hold the solution (and its derivative)
+  """
+  single = LU.dtype == np.float32
+  real_t = ctypes.c_float if single else ctypes.c_double
+  solve = libLinSolve.bandedSchurSolveBatchedF if single else libLinSolve.bandedSchurSolveBatched
+  ptr = lambda A: A.ctypes.data_as(ctypes.POINTER(real_t)) if A is not None else None
+  solve(ptr(LU), ptr(RHS), ptr(bc_RHS), PIV.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),\
+        ptr(C), ptr(Ginv), ptr(AinvB), ptr(FIMat), ptr(SIMat), ptr(Cp), ptr(Dp), kl, ku, Nyx, Nz, nrhs)
 
 
 def tobanded(A, kl, ku, _dtype):
@@ -980,44 +1335,61 @@ def tobanded(A, kl, ku, _dtype):
 ##################### Library function declarations ###############################
 ###################################################################################
 
-# declare lin solver lib funcs
-libLinSolve.precomputeBandedLinOps.argtypes = [ctypes.POINTER(ctypes.c_double),\
-                                               ctypes.POINTER(ctypes.c_double),\
-                                               ctypes.POINTER(ctypes.c_double),\
-                                               ctypes.POINTER(ctypes.c_double),\
-                                               ctypes.POINTER(ctypes.c_double),\
-                                               ctypes.POINTER(ctypes.c_double),\
-                                               ctypes.POINTER(ctypes.c_int),\
-                                               ctypes.c_int, ctypes.c_int,\
-                                               ctypes.c_int, ctypes.c_int]
-libLinSolve.precomputeBandedLinOps.restype = None
-
-libLinSolve.bandedSchurSolve.argtypes = [ctypes.POINTER(ctypes.c_double),\
-                                         ctypes.POINTER(ctypes.c_double),\
-                                         ctypes.POINTER(ctypes.c_int),\
-                                         ctypes.POINTER(ctypes.c_double),\
-                                         ctypes.POINTER(ctypes.c_double),\
-                                         ctypes.POINTER(ctypes.c_double),\
-                                         ctypes.POINTER(ctypes.c_double),\
-                                         ctypes.POINTER(ctypes.c_double),\
-                                         ctypes.POINTER(ctypes.c_double),\
-                                         ctypes.POINTER(ctypes.c_double),\
-                                         ctypes.c_int, ctypes.c_int,\
-                                         ctypes.c_int, ctypes.c_int]
-libLinSolve.bandedSchurSolve.restype = None
-
-libLinSolve.bandedSchurSolve_noD.argtypes = [ctypes.POINTER(ctypes.c_double),\
-                                             ctypes.POINTER(ctypes.c_double),\
-                                             ctypes.POINTER(ctypes.c_double),\
-                                             ctypes.POINTER(ctypes.c_int),\
-                                             ctypes.POINTER(ctypes.c_double),\
-                                             ctypes.POINTER(ctypes.c_double),\
-                                             ctypes.POINTER(ctypes.c_double),\
-                                             ctypes.POINTER(ctypes.c_double),\
-                                             ctypes.POINTER(ctypes.c_double),\
-                                             ctypes.c_int, ctypes.c_int,\
-                                             ctypes.c_int, ctypes.c_int]
-libLinSolve.bandedSchurSolve_noD.restype = None
+# declare lin solver lib funcs (the F routines are single precision)
+for suffix, real_t in (('', ctypes.c_double), ('F', ctypes.c_float)):
+  getattr(libLinSolve, 'precomputeBandedLinOps' + suffix).argtypes = [ctypes.POINTER(real_t),\
+                                                                      ctypes.POINTER(real_t),\
+                                                                      ctypes.POINTER(real_t),\
+                                                                      ctypes.POINTER(real_t),\
+                                                                      ctypes.POINTER(real_t),\
+                                                                      ctypes.POINTER(real_t),\
+                                                                      ctypes.POINTER(ctypes.c_int),\
+                                                                      ctypes.c_int, ctypes.c_int,\
+                                                                      ctypes.c_int, ctypes.c_int]
+  getattr(libLinSolve, 'precomputeBandedLinOps' + suffix).restype = None
+
+  getattr(libLinSolve, 'bandedSchurSolve' + suffix).argtypes = [ctypes.POINTER(real_t),\
+                                                                ctypes.POINTER(real_t),\
+                                                                ctypes.POINTER(ctypes.c_int),\
+                                                                ctypes.POINTER(real_t),\
+                                                                ctypes.POINTER(real_t),\
+                                                                ctypes.POINTER(real_t),\
+                                                                ctypes.POINTER(real_t),\
+                                                                ctypes.POINTER(real_t),\
+                                                                ctypes.POINTER(real_t),\
+                                                                ctypes.POINTER(real_t),\
+                                                                ctypes.c_int, ctypes.c_int,\
+                                                                ctypes.c_int, ctypes.c_int]
+  getattr(libLinSolve, 'bandedSchurSolve' + suffix).restype = None
+
+  getattr(libLinSolve, 'bandedSchurSolve_noD' + suffix).argtypes = [ctypes.POINTER(real_t),\
+                                                                    ctypes.POINTER(real_t),\
+                                                                    ctypes.POINTER(real_t),\
+                                                                    ctypes.POINTER(ctypes.c_int),\
+                                                                    ctypes.POINTER(real_t),\
+                                                                    ctypes.POINTER(real_t),\
+                                                                    ctypes.POINTER(real_t),\
+                                                                    ctypes.POINTER(real_t),\
+                                                                    ctypes.POINTER(real_t),\
+                                                                    ctypes.c_int, ctypes.c_int,\
+                                                                    ctypes.c_int, ctypes.c_int]
+  getattr(libLinSolve, 'bandedSchurSolve_noD' + suffix).restype = None
+
+  getattr(libLinSolve, 'bandedSchurSolveBatched' + suffix).argtypes = [ctypes.POINTER(real_t),\
+                                                                       ctypes.POINTER(real_t),\
+                                                                       ctypes.POINTER(real_t),\
+                                                                       ctypes.POINTER(ctypes.c_int),\
+                                                                       ctypes.POINTER(real_t),\
+                                                                       ctypes.POINTER(real_t),\
+                                                                       ctypes.POINTER(real_t),\
+                                                                       ctypes.POINTER(real_t),\
+                                                                       ctypes.POINTER(real_t),\
+                                                                       ctypes.POINTER(real_t),\
+                                                                       ctypes.POINTER(real_t),\
+                                                                       ctypes.c_int, ctypes.c_int,\
+                                                                       ctypes.c_int, ctypes.c_int,\
+                                                                       ctypes.c_int]
+  getattr(libLinSolve, 'bandedSchurSolveBatched' + suffix).restype = None
 
 # declare dptools lib funcs
 libDPTools.evalTheta.argtypes = [ctypes.POINTER(ctypes.c_double),\
@@ -1026,40 +1398,98 @@ libDPTools.evalTheta.argtypes = [ctypes.POINTER(ctypes.c_double),\
                                  ctypes.c_uint, ctypes.c_uint]
 libDPTools.evalTheta.restype = None
 
-libDPTools.evalCorrectionSol_bottomWall.argtypes = [ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.POINTER(ctypes.c_double),\
-                                                    ctypes.c_double, ctypes.c_uint,\
-                                                    ctypes.c_uint, ctypes.c_uint]
-libDPTools.evalCorrectionSol_bottomWall.restype = None
-
-libDPTools.evalCorrectionSol_slitChannel.argtypes = [ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.POINTER(ctypes.c_double),\
-                                                     ctypes.c_double, ctypes.c_double,
-                                                     ctypes.c_uint, ctypes.c_uint,\
-                                                     ctypes.c_uint]
-libDPTools.evalCorrectionSol_slitChannel.restype = None
+# the F routines are single precision
+for suffix, real_t in (('', ctypes.c_double), ('F', ctypes.c_float)):
+  getattr(libDPTools, 'evalCorrectionSol_bottomWall' + suffix).argtypes = [ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           ctypes.POINTER(real_t),\
+                                                                           real_t, ctypes.c_uint,\
+                                                                           ctypes.c_uint, ctypes.c_uint]
+  getattr(libDPTools, 'evalCorrectionSol_bottomWall' + suffix).restype = None
+
+  getattr(libDPTools, 'evalCorrectionSol_slitChannel' + suffix).argtypes = [ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            ctypes.POINTER(real_t),\
+                                                                            real_t, real_t,
+                                                                            ctypes.c_uint, ctypes.c_uint,\
+                                                                            ctypes.c_uint]
+  getattr(libDPTools, 'evalCorrectionSol_slitChannel' + suffix).restype = None
+
+# declare tp stokes lib funcs (the F routines are single precision)
+for suffix, real_t in (('', ctypes.c_double), ('F', ctypes.c_float)):
+  getattr(libTPStokes, 'MakeTPStokes' + suffix).argtypes = [ctypes.c_uint, ctypes.c_uint,\
+                                                            ctypes.c_uint, ctypes.c_double,\
+                                                            ctypes.c_double, ctypes.c_double,\
+                                                            ctypes.c_double, ctypes.c_uint,\
+                                                            ctypes.c_bool, ctypes.c_bool]
+  getattr(libTPStokes, 'MakeTPStokes' + suffix).restype = ctypes.c_void_p
+
+  getattr(libTPStokes, 'SolveTPStokes' + suffix).argtypes = [ctypes.c_void_p,\
+                                                             ctypes.POINTER(real_t),\
+                                                             ctypes.POINTER(real_t),\
+                                                             ctypes.POINTER(real_t),\
+                                                             ctypes.POINTER(real_t)]
+  getattr(libTPStokes, 'SolveTPStokes' + suffix).restype = None
+
+  getattr(libTPStokes, 'TPStokesMemoryReport' + suffix).argtypes = [ctypes.c_void_p,\
+                                                                    ctypes.POINTER(ctypes.c_char_p),\
+                                                                    ctypes.POINTER(ctypes.c_size_t),\
+                                                                    ctypes.c_uint]
+  getattr(libTPStokes, 'TPStokesMemoryReport' + suffix).restype = ctypes.c_uint
+
+  getattr(libTPStokes, 'CleanTPStokes' + suffix).argtypes = [ctypes.c_void_p]
+  getattr(libTPStokes, 'CleanTPStokes' + suffix).restype = None
+
+  getattr(libTPStokes, 'DeleteTPStokes' + suffix).argtypes = [ctypes.c_void_p]
+  getattr(libTPStokes, 'DeleteTPStokes' + suffix).restype = None
+
+# declare dp stokes lib funcs (the F routines are single precision)
+for suffix, real_t in (('', ctypes.c_double), ('F', ctypes.c_float)):
+  getattr(libDPStokes, 'MakeDPStokes' + suffix).argtypes = [ctypes.c_uint, ctypes.c_uint,\
+                                                            ctypes.c_uint, ctypes.c_double,\
+                                                            ctypes.c_double, ctypes.c_double,\
+                                                            ctypes.c_double, ctypes.c_bool,\
+                                                            ctypes.c_bool, ctypes.c_bool]
+  getattr(libDPStokes, 'MakeDPStokes' + suffix).restype = ctypes.c_void_p
+
+  getattr(libDPStokes, 'SolveDPStokes' + suffix).argtypes = [ctypes.c_void_p,\
+                                                             ctypes.POINTER(real_t),\
+                                                             ctypes.POINTER(real_t),\
+                                                             ctypes.c_int, ctypes.c_int,\
+                                                             ctypes.POINTER(real_t),\
+                                                             ctypes.POINTER(real_t)]
+  getattr(libDPStokes, 'SolveDPStokes' + suffix).restype = None
+
+  getattr(libDPStokes, 'DPStokesMemoryReport' + suffix).argtypes = [ctypes.c_void_p,\
+                                                                    ctypes.POINTER(ctypes.c_char_p),\
+                                                                    ctypes.POINTER(ctypes.c_size_t),\
+                                                                    ctypes.c_uint]
+  getattr(libDPStokes, 'DPStokesMemoryReport' + suffix).restype = ctypes.c_uint
+
+  getattr(libDPStokes, 'CleanDPStokes' + suffix).argtypes = [ctypes.c_void_p]
+  getattr(libDPStokes, 'CleanDPStokes' + suffix).restype = None
 
+  getattr(libDPStokes, 'DeleteDPStokes' + suffix).argtypes = [ctypes.c_void_p]
+  getattr(libDPStokes, 'DeleteDPStokes' + suffix).restype = None
@@ -0,0 +1,91 @@
+import ctypes
+import numpy as np
+
+"""
+Python wrappers for C library SpreadOperator routines
+
+See SpreadOperatorWrapper.cpp
+
+The prototypes for relevant functions from the
+C++ SpreadOperator library are declared. Any functions added
+to the "extern" definition in SpreadOperatorWrapper.cpp should be
+declared here.
+"""
+libSpreadOperator = ctypes.CDLL('../lib/libspreadOperator.so')
+
+libSpreadOperator.MakeSpreadOperator.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+libSpreadOperator.MakeSpreadOperator.restype = ctypes.c_void_p
+libSpreadOperator.RebuildSpreadOperator.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p]
+libSpreadOperator.RebuildSpreadOperator.restype = None
+libSpreadOperator.SpreadOp.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p]
+libSpreadOperator.SpreadOp.restype = None
+libSpreadOperator.InterpolateOp.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p]
+libSpreadOperator.InterpolateOp.restype = None
+libSpreadOperator.CleanSpreadOperator.argtypes = [ctypes.c_void_p]
+libSpreadOperator.CleanSpreadOperator.restype = None
+libSpreadOperator.DeleteSpreadOperator.argtypes = [ctypes.c_void_p]
+libSpreadOperator.DeleteSpreadOperator.restype = None
+
+def MakeSpreadOperator(s, g):
+  """
+  Assemble the sparse spread (S) and interpolation (J) operators
+  for the current configuration of particles s on the grid g.
+  The BCs of g are baked into the operators.
+
+  Parameters:
+    s - a pointer to the C++ ParticleList struct (already setup on g)
+    g - a pointer to the C++ Grid struct
+
+  Returns: a pointer to the C++ SpreadOperator struct
+  """
+  return libSpreadOperator.MakeSpreadOperator(s, g)
+
+def RebuildSpreadOperator(op, s, g):
+  """
+  Reassemble the operators in op, e.g. after the particles in s have moved.
+
+  Parameters:
+    op - a pointer to the C++ SpreadOperator struct
+    s - a pointer to the C++ ParticleList struct
+    g - a pointer to the C++ Grid struct
+  """
+  libSpreadOperator.RebuildSpreadOperator(op, s, g)
+
+def SpreadOp(op, s, g):
+  """
+  Spread data from the particles s onto the grid g with the assembled operator.
+  This is equivalent to spreading and folding, without touching the extended grid.
+
+  Parameters:
+    op - a pointer to the C++ SpreadOperator struct
+    s - a pointer to the C++ ParticleList struct
+    g - a pointer to the C++ Grid struct
+
+  Returns: None
+  Side Effects:
+    The C++ Grid data member g.fG is overwritten with the spread data
+  """
+  libSpreadOperator.SpreadOp(op, s, g)
+
+def InterpolateOp(op, s, g):
+  """
+  Interpolate data from the grid g onto the particles s with the assembled operator.
+  This is equivalent to copying to the extended grid and interpolating.
+
+  Parameters:
+    op - a pointer to the C++ SpreadOperator struct
+    s - a pointer to the C++ ParticleList struct
+    g - a pointer to the C++ Grid struct
+
+  Returns: None
+  Side Effects:
+    The C++ ParticleList data member s.fP is overwritten with the interpolated data
+  """
+  libSpreadOperator.InterpolateOp(op, s, g)
+
+def DeleteSpreadOperator(op):
+  """
+  Free the memory of the operators and delete op.
+  """
+  libSpreadOperator.CleanSpreadOperator(op)
+  libSpreadOperator.DeleteSpreadOperator(op)
@@ -2,6 +2,23 @@ import ctypes
 import numpy as np
 libTransform = ctypes.CDLL('../lib/libtransform.so')
 
+# planning rigor of persistent transforms (see Transformer.Plan() and fftw3.h)
+FFTW_MEASURE, FFTW_PATIENT, FFTW_ESTIMATE = 0, 1 << 5, 1 << 6
+
+def SetWisdomFile(fname):
+  """
+  Python wrapper for the SetWisdomFile(fname) C lib routine.
+  Sets the file that the FFTW wisdom of persistent transforms (see Transformer.Plan())
+  is exported to, and imports it if it exists, so a restarted run plans instantly.
+
+  Parameters:
+    fname (string) - name of the wisdom file
+  Returns: True if wisdom was imported from the file
+  """
+  libTransform.SetWisdomFile.argtypes = [ctypes.c_char_p]
+  libTransform.SetWisdomFile.restype = ctypes.c_bool
+  return libTransform.SetWisdomFile(fname.encode('utf-8'))
+
 class Transformer(object):
   """
   Python wrappers for C library Transform routines.
@@ -18,11 +35,24 @@ class Transformer(object):
     N - Nx * Ny * Nz.
     dof - degrees of freedom of the data.
     Ntotal - N * dof.
-    out_real (double array) - real part of output transform.
-    out_complex (double array) - complex part of output transform.
+    planar (bool) - whether the components are interleaved (False) or stored in planes (True).
+    real (bool) - whether the transforms are real-to-complex/complex-to-real (True), 
+                  in which case the spectrum only has the Nxh = Nx // 2 + 1 non-negative
+                  wave numbers in x, and the data in real space has no complex part.
+    kmajor (bool) - whether the spectrum is stored wavenumber-major, with the Nz coefficients 
+                    of each wave number and component contiguous (see _shape() and Transform.h).
+    single (bool) - whether the transforms are single precision (float32 data, see TransformF
+                    in Transform.h), or double precision (float64 data).
+    Nxh - number of points in x of the spectrum (Nx if not real).
+    Ntotal_hat - Nz * Ny * Nxh * dof, the size of the spectrum.
+    out_real (double array, float32 if single) - real part of output transform.
+    out_complex (double array, float32 if single) - complex part of output transform.
     transform (ptr to C++ struct) - a pointer to the generated C++ Transform struct
+    persistent (bool) - whether transform is a persistent plan (see Plan())
+    bound (bool) - whether the persistent plan runs on the buffers of a grid (see Bind())
   """
-  def __init__(self, _in_real, _in_complex, _Nx, _Ny, _Nz, _dof):
+  def __init__(self, _in_real, _in_complex, _Nx, _Ny, _Nz, _dof, _planar = False, _real = False,
+               _kmajor = False, _single = False):
     """ 
     The constructor for the Transformer class.
     
@@ -31,6 +61,21 @@ class Transformer(object):
       in_complex (doubles) - complex part of input.
       Nx, Ny, Nz (int) - number of points in x,y,z
       dof (int) - degrees of freedom.
+      planar (bool) - if True, the components of the input and output are stored
+                      in contiguous planes of N points (see Grid.py), rather than interleaved.
+      real (bool) - if True, the forward transform is real-to-complex and the backward one
+                    complex-to-real, so the spectrum (output of Ftransform, input of Btransform)
+                    has shape (Nz, Ny, Nx // 2 + 1, dof), or (dof, Nz, Ny, Nx // 2 + 1) if planar.
+                    This halves the cost of the transforms, and of solves on the spectrum.
+      kmajor (bool) - if True, the spectrum has shape (Ny, Nxh, dof, Nz), or (dof, Ny, Nxh, Nz)
+                      if planar, so the Chebyshev columns of each wave number are contiguous
+                      for the DP solvers (see Solvers.py). The transpose is fused into the 
+                      transforms, and the data in real space keeps its layout.
+      single (bool) - if True, the transforms are done in single precision (fftwf), so the 
+                      input is converted to and the output returned as float32 arrays. This 
+                      halves the memory and bandwidth of the transforms, at a relative error 
+                      of about 1e-7 (see the README), and pairs with the single precision
+                      DP solves (see DoublyPeriodicStokes_init() in Solvers.py).
 
     Side Effects:
       The prototypes for relevant functions from the 
@@ -39,28 +84,62 @@ class Transformer(object):
       declared here. The attributes out_real, out_complex 
       and transform are set to None.
     """ 
-    libTransform.Ftransform.argtypes = [ctypes.POINTER(ctypes.c_double), \
-                                        ctypes.c_uint, ctypes.c_uint, \
-                                        ctypes.c_uint, ctypes.c_uint]
-    libTransform.Ftransform.restype = ctypes.c_void_p
-
-    libTransform.Btransform.argtypes = [ctypes.POINTER(ctypes.c_double), \
-                                        ctypes.POINTER(ctypes.c_double), \
-                                        ctypes.c_uint, ctypes.c_uint, \
-                                        ctypes.c_uint, ctypes.c_uint]
-    libTransform.Btransform.restype = ctypes.c_void_p
-
-    libTransform.CleanTransform.argtypes = [ctypes.c_void_p]
-    libTransform.CleanTransform.restype = None
+    # the single precision routines (see TransformF in Transform.h) have the same 
+    # prototypes with float data, and an F suffix
+    for suffix, real_t in (('', ctypes.c_double), ('F', ctypes.c_float)):
+      lib = lambda name: getattr(libTransform, name + suffix)
+      lib('Ftransform').argtypes = [ctypes.POINTER(real_t), \
+                                    ctypes.c_uint, ctypes.c_uint, \
+                                    ctypes.c_uint, ctypes.c_uint, ctypes.c_bool, \
+                                    ctypes.c_bool, ctypes.c_bool, ctypes.c_bool]
+      lib('Ftransform').restype = ctypes.c_void_p
+
+      lib('Btransform').argtypes = [ctypes.POINTER(real_t), \
+                                    ctypes.POINTER(real_t), \
+                                    ctypes.c_uint, ctypes.c_uint, \
+                                    ctypes.c_uint, ctypes.c_uint, ctypes.c_bool, \
+                                    ctypes.c_bool, ctypes.c_bool, ctypes.c_bool]
+      lib('Btransform').restype = ctypes.c_void_p
+
+      lib('CleanTransform').argtypes = [ctypes.c_void_p]
+      lib('CleanTransform').restype = None
   
-    libTransform.DeleteTransform.argtypes = [ctypes.c_void_p]
-    libTransform.DeleteTransform.restype = None
+      lib('DeleteTransform').argtypes = [ctypes.c_void_p]
+      lib('DeleteTransform').restype = None
+
+      lib('MakeTransform').argtypes = [ctypes.c_uint, ctypes.c_uint, ctypes.c_uint, \
+                                       ctypes.c_uint, ctypes.c_int, ctypes.c_bool, \
+                                       ctypes.c_bool, ctypes.c_bool, ctypes.c_bool, \
+                                       ctypes.c_uint]
+      lib('MakeTransform').restype = ctypes.c_void_p
 
-    libTransform.getRealOut.argtypes = [ctypes.c_void_p]
-    libTransform.getRealOut.restype = ctypes.POINTER(ctypes.c_double)
+      lib('ExecuteTransform').argtypes = [ctypes.c_void_p, ctypes.POINTER(real_t), \
+                                          ctypes.POINTER(real_t), \
+                                          ctypes.POINTER(real_t), \
+                                          ctypes.POINTER(real_t)]
+      lib('ExecuteTransform').restype = None
 
-    libTransform.getComplexOut.argtypes = [ctypes.c_void_p]
-    libTransform.getComplexOut.restype = ctypes.POINTER(ctypes.c_double)
+      lib('getRealOut').argtypes = [ctypes.c_void_p]
+      lib('getRealOut').restype = ctypes.POINTER(real_t)
+
+      lib('getComplexOut').argtypes = [ctypes.c_void_p]
+      lib('getComplexOut').restype = ctypes.POINTER(real_t)
+
+      lib('TransformMemoryReport').argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_char_p), 
+                                               ctypes.POINTER(ctypes.c_size_t), ctypes.c_uint]
+      lib('TransformMemoryReport').restype = ctypes.c_uint
+
+    libTransform.BindTransform.argtypes = [ctypes.POINTER(ctypes.c_double), \
+                                           ctypes.POINTER(ctypes.c_double), \
+                                           ctypes.POINTER(ctypes.c_double), \
+                                           ctypes.c_uint, ctypes.c_uint, ctypes.c_uint, \
+                                           ctypes.c_uint, ctypes.c_int, ctypes.c_bool, \
+                                           ctypes.c_bool, ctypes.c_bool, ctypes.c_bool, \
+                                           ctypes.c_uint]
+    libTransform.BindTransform.restype = ctypes.c_void_p
+
+    libTransform.ExecuteBound.argtypes = [ctypes.c_void_p]
+    libTransform.ExecuteBound.restype = None
 
     # real part of input data (double array)
     self.in_real = _in_real
@@ -72,21 +151,152 @@ class Transformer(object):
     self.Nz = _Nz
     # degrees of freedom
     self.dof = _dof
+    # layout of the components
+    self.planar = _planar
+    # whether the transforms are real (half spectrum in x)
+    self.real = _real
+    self.Nxh = self.Nx // 2 + 1 if self.real else self.Nx
+    # layout of the spectrum
+    self.kmajor = _kmajor
+    # precision of the transforms, and of their data
+    self.single = _single
+    self.dtype = np.float32 if self.single else np.double
     # get total nums
     self.N = self.Nx * self.Ny * self.Nz
     self.Ntotal = self.N * self.dof
+    self.Ntotal_hat = self.Nxh * self.Ny * self.Nz * self.dof
     # pointer to c++ Transform struct
     self.transform = None
+    # whether it is a persistent plan, and its direction and kind of z axis
+    self.persistent = False
+    self.bound = False
+    self.forward = None
+    self.cheb = None
     # outputs
     self.out_real = None
     self.out_complex = None
   
 
+  def Plan(self, forward, cheb = False, flags = FFTW_MEASURE):
+    """
+    Python wrapper for the MakeTransform(...) C lib routine.
+
+    This builds a persistent transform in the given direction, which the 
+    F/Btransform(_cheb) methods in that direction then execute on the current
+    input instead of planning a new transform on each call. Planning with 
+    FFTW_MEASURE or FFTW_PATIENT takes much longer than FFTW_ESTIMATE, but 
+    finds a faster transform, so plan once and reuse the Transformer 
+    (see SetInput()), eg. across timesteps. See also SetWisdomFile().
+    Note that the out_real/out_complex of Ftransform(_cheb) are views of the C++ buffers,
+    so they are overwritten by the next forward transform of a persistent Transformer.
+
+    Parameters:
+      forward (bool) - True for a forward transform, False for a backward one
+      cheb (bool) - whether the z axis is Chebyshev (for the _cheb methods)
+      flags (int) - FFTW_MEASURE, FFTW_PATIENT or FFTW_ESTIMATE
+    Side Effects:
+      self.transform is assigned the pointer to the C++ Transform instance
+    """
+    self.transform = self._lib('MakeTransform')(self.Nx, self.Ny, self.Nz, self.dof, \
+                                                -1 if forward else 1, self.planar, self.real, \
+                                                cheb, self.kmajor, flags)
+    self.persistent = True; self.forward = forward; self.cheb = cheb
+
+  def Bind(self, gridGen, forward, cheb = False, flags = FFTW_MEASURE):
+    """
+    Python wrapper for the BindTransform(...) C lib routine.
+
+    This builds a persistent transform as in Plan(), but on the buffers of
+    a grid, so that Execute() transforms the data spread on the grid (or its spectrum)
+    in place, without any copies (see Transform.h). The spectrum of the grid must 
+    be set up first with gridGen.SetupSpectral(self.real) (a kmajor Transformer must 
+    be real to be bound, and a single precision one cannot be bound, as the buffers of
+    the grid are double). With flags other than
+    FFTW_ESTIMATE, planning overwrites the buffers, so bind before spreading.
+
+    Parameters:
+      gridGen (GridGen) - the grid, with the sizes, dof and layout of this Transformer
+      forward (bool) - True for a forward transform, False for a backward one
+      cheb (bool) - whether the z axis is Chebyshev
+      flags (int) - FFTW_MEASURE, FFTW_PATIENT or FFTW_ESTIMATE
+    Side Effects:
+      self.transform is assigned the pointer to the C++ Transform instance
+    """
+    if self.single:
+      raise ValueError('A single precision Transformer cannot be bound to a grid (see Bind())')
+    ptr = lambda U: U.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
+    self.grid_data = gridGen.GetSpread()
+    self.grid_hat = gridGen.GetSpectral()
+    self.transform = libTransform.BindTransform(ptr(self.grid_data), ptr(self.grid_hat[0]), \
+                                                ptr(self.grid_hat[1]), self.Nx, self.Ny, \
+                                                self.Nz, self.dof, -1 if forward else 1, \
+                                                self.planar, self.real, cheb, self.kmajor, flags)
+    self.persistent = True; self.bound = True; self.forward = forward; self.cheb = cheb
+
+  def Execute(self):
+    """
+    Python wrapper for the ExecuteBound(...) C lib routine.
+
+    This executes a transform bound to a grid (see Bind()). If forward, the grid data
+    is transformed to the spectrum of the grid, and out_real/out_complex are views of it
+    (shape (Ntotal_hat,)). If backward, the spectrum is transformed back to the grid data, 
+    normalized (so it holds the values, as the output of B/Btransform_cheb), and
+    out_real is a view of it. Either way, the input is overwritten.
+
+    Parameters: None
+    Side Effects:
+      self.out_real, self.out_complex are set to views of the grid buffers
+    """
+    if not self.bound:
+      raise ValueError('Execute() needs a transform bound to a grid (see Bind())')
+    libTransform.ExecuteBound(self.transform)
+    if self.forward:
+      self.out_real, self.out_complex = self.grid_hat
+    else:
+      self.out_real, self.out_complex = self.grid_data, None
+
+  def SetInput(self, _in_real, _in_complex = None):
+    """
+    Set new input data, eg. to execute a persistent transform again (see Plan()).
+
+    Parameters:
+      in_real (doubles) - real part of input.
+      in_complex (doubles) - complex part of input.
+    Side Effects:
+      self.in_real, self.in_complex are replaced
+    """
+    self.in_real = _in_real
+    self.in_complex = _in_complex
+
+  def _execute(self, forward, cheb, in_real, in_complex):
+    """
+    Transform in_real, in_complex (None if real), with z a Chebyshev axis if cheb, with the
+    persistent plan if there is one, or a new one otherwise. The result is in the
+    C++ Transform struct (see getRealOut/getComplexOut).
+    """
+    real_t = ctypes.c_float if self.single else ctypes.c_double
+    ptr = lambda U: None if U is None else \
+      np.ascontiguousarray(U, dtype = self.dtype).ctypes.data_as(ctypes.POINTER(real_t))
+    if self.bound:
+      raise ValueError('This Transformer is bound to a grid, so use Execute()')
+    if self.persistent:
+      if forward != self.forward or cheb != self.cheb:
+        raise ValueError('The input does not match the persistent transform of this Transformer')
+      self._lib('ExecuteTransform')(self.transform, ptr(in_real), ptr(in_complex), None, None)
+    elif forward:
+      self.transform = self._lib('Ftransform')(ptr(in_real), self.Nx, self.Ny, self.Nz, self.dof, \
+                                               self.planar, self.real, cheb, self.kmajor)
+    else:
+      self.transform = self._lib('Btransform')(ptr(in_real), ptr(in_complex), self.Nx, self.Ny, \
+                                               self.Nz, self.dof, self.planar, self.real, cheb, \
+                                               self.kmajor)
+
   def Ftransform(self):
     """
     Python wrapper for the Ftransform(...) C lib routine.
 
-    This computes the forward plan and executes a forward
+    This computes the forward plan (unless there is a persistent
+    one, see Plan()) and executes a forward
     transform on the input data, assuming that it is real.
 
     Parameters: None
@@ -96,55 +306,40 @@ class Transformer(object):
       self.out_complex is populated with the complex part of the output transform
 
     """
-    self.transform = libTransform.Ftransform(self.in_real.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                             self.Nx, self.Ny, self.Nz, self.dof)
-    self.out_real = np.ctypeslib.as_array(libTransform.getRealOut(self.transform), shape=(self.Ntotal,))
-    self.out_complex = np.ctypeslib.as_array(libTransform.getComplexOut(self.transform), shape=(self.Ntotal,))
+    self._execute(True, False, self.in_real, None)
+    self.out_real = np.ctypeslib.as_array(self._lib('getRealOut')(self.transform), shape=(self.Ntotal_hat,))
+    self.out_complex = np.ctypeslib.as_array(self._lib('getComplexOut')(self.transform), shape=(self.Ntotal_hat,))
   
   def Ftransform_cheb(self):
     """
     Python wrapper for the Ftransform(...) C lib routine when
     the z axis is Chebyshev.
 
-    This computes the forward plan and executes a forward
-    transform on the input data, assuming that it is real.
+    This computes the forward plan (unless there is a persistent
+    one, see Plan()) and executes a forward Fourier-Chebyshev
+    transform on the input data, assuming that it is real
+    (a DCT-I in z and a DFT in x,y, see Transform.h).
     The results in out_real/out_complex will be the Fourier-Chebyshev
     coefficients of the input
 
     Parameters: None
     Side Effects:
       self.transform is assigned the pointer to the C++ Transform instance
-      self.in_real is replaced by itself with the z axis periodically extended (doubled and flipped)
       self.out_real is populated with the real part of the output transform
       self.out_complex is populated with the complex part of the output transform
+      (these have the shape of the spectrum, see _shape())
 
     """
-    U = np.zeros(((2 * self.Nz - 2) * self.Ny * self.Nx * self.dof,), dtype = np.double).reshape(\
-          ((2 * self.Nz - 2), self.Ny, self.Nx, self.dof))
-    in_real_rs = np.reshape(self.in_real, (self.Nz, self.Ny, self.Nx, self.dof))
-    U[0:self.Nz,:,:,:] = in_real_rs
-    U[self.Nz::,:,:,:] = in_real_rs[-2:0:-1,:,:,:]
-    self.in_real = np.reshape(U, (self.dof * self.Nx * self.Ny * (2 * self.Nz - 2),)) 
-    self.transform = libTransform.Ftransform(self.in_real.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                             self.Nx, self.Ny, 2 * self.Nz - 2, self.dof)
-    _out_real = np.ctypeslib.as_array(libTransform.getRealOut(self.transform), shape=(2 * self.Nz - 2, self.Ny, self.Nx, self.dof))
-    _out_complex = np.ctypeslib.as_array(libTransform.getComplexOut(self.transform), shape=(2 * self.Nz - 2, self.Ny, self.Nx, self.dof))
-    self.out_real = np.zeros((self.Nz, self.Ny, self.Nx, self.dof), dtype = np.double)
-    self.out_complex = np.zeros((self.Nz, self.Ny, self.Nx, self.dof), dtype = np.double)
-    self.out_real[0,:,:,:] = _out_real[0,:,:,:]
-    self.out_real[1:-1,:,:,:] = _out_real[1:self.Nz-1,:,:,:] + _out_real[-1:self.Nz-1:-1,:,:,:]
-    self.out_real[-1,:,:,:] = _out_real[self.Nz-1,:,:,:]
-    self.out_complex[0,:,:,:] = _out_complex[0,:,:,:]
-    self.out_complex[1:-1,:,:,:] = _out_complex[1:self.Nz-1,:,:,:] + _out_complex[-1:self.Nz-1:-1,:,:,:]
-    self.out_complex[-1,:,:,:] = _out_complex[self.Nz-1,:,:,:]
-    self.out_real /= (2 * self.Nz - 2)
-    self.out_complex /= (2 * self.Nz - 2)
+    self._execute(True, True, self.in_real, None)
+    self.out_real = np.ctypeslib.as_array(self._lib('getRealOut')(self.transform), shape=self._shape(self.Nz, True))
+    self.out_complex = np.ctypeslib.as_array(self._lib('getComplexOut')(self.transform), shape=self._shape(self.Nz, True))
   
   def Btransform(self):
     """
     Python wrapper for the Btransform(...) C lib routine.
 
-    This computes the backward plan and executes a backward
+    This computes the backward plan (unless there is a persistent
+    one, see Plan()) and executes a backward
     transform on the input data. The output is normalized 
     by self.N
 
@@ -153,56 +348,77 @@ class Transformer(object):
       self.transform is assigned the pointer to the C++ Transform instance
       self.out_real is populated with the real part of the output transform
       self.out_complex is populated with the complex part of the output transform
+      (None if real, as the output of a complex-to-real transform has no complex part)
     """
-    self.transform = libTransform.Btransform(self.in_real.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                             self.in_complex.ctypes.data_as(ctypes.POINTER(ctypes.c_double)), \
-                                             self.Nx, self.Ny, self.Nz, self.dof)
-    self.out_real = np.ctypeslib.as_array(libTransform.getRealOut(self.transform), shape=(self.Ntotal,)) / self.N
-    self.out_complex = np.ctypeslib.as_array(libTransform.getComplexOut(self.transform), shape=(self.Ntotal,)) / self.N
+    self._execute(False, False, self.in_real, self.in_complex)
+    self.out_real = np.ctypeslib.as_array(self._lib('getRealOut')(self.transform), shape=(self.Ntotal,)) / self.N
+    self.out_complex = None if self.real else \
+      np.ctypeslib.as_array(self._lib('getComplexOut')(self.transform), shape=(self.Ntotal,)) / self.N
 
   def Btransform_cheb(self):
     """
-    Python wrapper for the Btransform_cheb(...) C lib routine when
+    Python wrapper for the Btransform(...) C lib routine when
     the z axis is Chebyshev.
 
-    This computes the backward plan and executes a backward
-    transform on the input data. The results in out_real/out_complex 
-    will be the Fourier-Chebyshev coefficients of the input
+    This computes the backward plan (unless there is a persistent
+    one, see Plan()) and executes a backward Fourier-Chebyshev
+    transform on the input data, which are Fourier-Chebyshev coefficients.
+    The results in out_real/out_complex will be the values on the grid.
 
     Parameters: None
     Side Effects:
       self.transform is assigned the pointer to the C++ Transform instance
-      self.in_real is replaced by itself with the z axis periodically extended (doubled and flipped)
-      self.in_complex is replaced by itself with the z axis periodically extended (doubled and flipped)
       self.out_real is populated with the real part of the output transform
-      self.out_complex is populated with the complex part of the output transform
+      self.out_complex is populated with the complex part of the output transform (None if real)
+
+    """
+    self._execute(False, True, self.in_real, self.in_complex)
+    self.out_real = np.ctypeslib.as_array(self._lib('getRealOut')(self.transform), shape=(self.Ntotal,)) / (self.Nx * self.Ny)
+    self.out_complex = None if self.real else \
+      np.ctypeslib.as_array(self._lib('getComplexOut')(self.transform), shape=(self.Ntotal,)) / (self.Nx * self.Ny)
 
+  def _lib(self, name):
+    """
+    The C lib routine name for the precision of this Transformer (the single precision
+    routines have an F suffix, see TransformWrapper.cpp).
+    """
+    return getattr(libTransform, name + ('F' if self.single else ''))
+
+  def _shape(self, Nz, spectral = False):
+    """
+    Shape of data on a grid with Nz points in z, in the order it is stored
+    ((Nz, Ny, Nx, dof), or (dof, Nz, Ny, Nx) if planar). If spectral, Nx 
+    is replaced by the number of points of the spectrum in x (Nxh), and
+    if kmajor, z is the fastest axis ((Ny, Nxh, dof, Nz), or (dof, Ny, Nxh, Nz)).
+    """
+    Nx = self.Nxh if spectral else self.Nx
+    if spectral and self.kmajor:
+      return (self.dof, self.Ny, Nx, Nz) if self.planar else (self.Ny, Nx, self.dof, Nz)
+    if self.planar:
+      return (self.dof, Nz, self.Ny, Nx)
+    return (Nz, self.Ny, Nx, self.dof)
+
+  def MemoryReport(self):
+    """
+    Python wrapper for the TransformMemoryReport(transform,..) C lib routine
+    The arrays owned by this class (copies, as opposed to views of the C buffers)
+    are reported as py.<name>.
+ 
+    Parameters: None
+    Side Effects: None
+    Returns: dict of buffer name -> bytes
     """
-    Ur = np.zeros(((2 * self.Nz - 2) * self.Ny * self.Nx * self.dof,), dtype = np.double).reshape(\
-          ((2 * self.Nz - 2), self.Ny, self.Nx, self.dof))
-    Uc = np.zeros(((2 * self.Nz - 2) * self.Ny * self.Nx * self.dof,), dtype = np.double).reshape(\
-          ((2 * self.Nz - 2), self.Ny, self.Nx, self.dof))
-    in_real_rs = self.in_real.reshape((self.Nz, self.Ny, self.Nx, self.dof))
-    in_complex_rs = self.in_complex.reshape((self.Nz, self.Ny, self.Nx, self.dof))
-    Ur[0,:,:,:] = in_real_rs[0,:,:,:]
-    Ur[1:self.Nz-1,:,:,:] = in_real_rs[1:-1,:,:,:] / 2
-    Ur[self.Nz-1,:,:,:] = in_real_rs[-1,:,:,:]
-    Ur[self.Nz::,:,:,:] = in_real_rs[-2:0:-1,:,:,:] / 2
-    Ur *= (2 * self.Nz - 2)
-    Uc[0,:,:,:] = in_complex_rs[0,:,:,:]
-    Uc[1:self.Nz-1,:,:,:] = in_complex_rs[1:-1,:,:,:] / 2
-    Uc[self.Nz-1,:,:,:] = in_complex_rs[-1,:,:,:]
-    Uc[self.Nz::,:,:,:] = in_complex_rs[-2:0:-1,:,:,:] / 2
-    Uc *= (2 * self.Nz - 2)
-    self.in_real = Ur.reshape((self.dof * self.Nx * self.Ny * (2 * self.Nz - 2),))
-    self.in_complex = Uc.reshape((self.dof * self.Nx * self.Ny * (2 * self.Nz - 2),))
-    self.transform = libTransform.Btransform(self.in_real.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),\
-                                             self.in_complex.ctypes.data_as(ctypes.POINTER(ctypes.c_double)), \
-                                             self.Nx, self.Ny, 2 * self.Nz - 2, self.dof)
-    _out_real = np.ctypeslib.as_array(libTransform.getRealOut(self.transform), shape=(2 * self.Nz - 2, self.Ny, self.Nx, self.dof))
-    _out_complex = np.ctypeslib.as_array(libTransform.getComplexOut(self.transform), shape=(2 * self.Nz - 2, self.Ny, self.Nx, self.dof)) 
-    self.out_real = _out_real[0:self.Nz,:,:,:].reshape((self.Ntotal,)) / (self.Nx * self.Ny * (2 * self.Nz - 2))
-    self.out_complex = _out_complex[0:self.Nz,:,:,:].reshape((self.Ntotal,)) / (self.Nx * self.Ny * (2 * self.Nz - 2))
+    report = {}
+    if self.transform is not None:
+      n = self._lib('TransformMemoryReport')(self.transform, None, None, 0)
+      names = (ctypes.c_char_p * n)(); sizes = (ctypes.c_size_t * n)()
+      self._lib('TransformMemoryReport')(self.transform, names, sizes, n)
+      report = {names[i].decode('utf-8') : sizes[i] for i in range(n)}
+    for name in ('in_real', 'in_complex', 'out_real', 'out_complex'):
+      U = getattr(self, name)
+      if isinstance(U, np.ndarray) and U.flags.owndata:
+        report['py.' + name] = U.nbytes
+    return report
 
   def Clean(self):
     """
@@ -217,5 +433,6 @@ class Transformer(object):
       self.out_real is deleted and nullified
       self.out_complex is deleted and nullified
     """
-    libTransform.CleanTransform(self.transform)
-    libTransform.DeleteTransform(self.transform)
+    self._lib('CleanTransform')(self.transform)
+    self._lib('DeleteTransform')(self.transform)
+    self.transform = None; self.persistent = False; self.bound = False
@@ -0,0 +1,556 @@
+#include "DPStokes.h"
+#include "LinearSolvers.h"
+#include "DPTools.h"
+#include "Quadrature.h"
+#include "exceptions.h"
+#include<omp.h>
+#include<math.h>
+#include<vector>
+
+template<typename Real>
+DPStokesT<Real>::DPStokesT() : kx(0), ky(0), z(0), SIMat(0), FIMat(0), pints(0), uvints(0),
+                               LU(0), PLU(0), Ainv_B(0), C(0), Ginv(0), C_k0(0), Ginv_k0(0),
+                               work(0), PIV(0), PLUmask(0), plan(0), Nx(0), Ny(0), Nz(0), Nxs(0), Nyx(0), nthreads(0),
+                               H(0), eta(0), planar(false), real(false), kmajor(false) {}
+
+template<typename Real>
+DPStokesT<Real>::DPStokesT(const unsigned int _Nx, const unsigned int _Ny, const unsigned int _Nz,
+                           const double Lx, const double Ly, const double _H, const double _eta,
+                           const bool _planar, const bool _real, const bool _kmajor)
+  : DPStokesT()
+{
+  setup(_Nx, _Ny, _Nz, Lx, Ly, _H, _eta, _planar, _real, _kmajor);
+}
+
+namespace
+{
+  // half bandwidths of the banded blocks
+  const int kl = 2, ku = 2, ldab = 2 * kl + ku + 1;
+
+  // wave numbers 2 pi n / L of an axis of N points, as in DoublyPeriodicStokes_init()
+  template<typename Real>
+  void waveNumbers(Real* k, const unsigned int n, const unsigned int N, const double L)
+  {
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      k[i] = 2 * M_PI / L * (i < N / 2 ? (double) i : (double) i - N);
+    }
+  }
+
+  // the unscaled Chebyshev integral matrices of Chebyshev.py (N x N + 2, column major)
+  void integralMatrices(std::vector<double>& SI, std::vector<double>& FI, const unsigned int N)
+  {
+    SI.assign((size_t) N * (N + 2), 0); FI.assign((size_t) N * (N + 2), 0);
+    auto si = [&](unsigned int i, unsigned int j) -> double& {return SI[i + (size_t) N * j];};
+    auto fi = [&](unsigned int i, unsigned int j) -> double& {return FI[i + (size_t) N * j];};
+    for (unsigned int m = 0; m < N; ++m)
+    {
+      if (m >= 2) si(m, m - 2) = m == 2 ? 0.25 : 1.0 / (2 * m * (2 * m - 2));
+      if (m >= 1) si(m, m) = m == 1 ? -0.125 : m == 2 ? -1.0 / 8 - 1.0 / 24 :
+                             -1.0 / (2 * m * (2 * m - 2)) - (m < N - 1 ? 1.0 / (2 * m * (2 * m + 2)) : 0);
+      si(m, m + 2) = m == 0 ? 0 : m == 1 ? 0.125 : m == 2 ? 1.0 / 24 :
+                     (m < N - 2 ? 1.0 / (2 * m * (2 * m + 2)) : 0);
+      if (m >= 1) fi(m, m - 1) = m == 1 ? 1 : 1.0 / (2 * m);
+      fi(m, m + 1) = m == 0 ? 0 : m == 1 ? -0.5 : (m < N - 1 ? -1.0 / (2 * m) : 0);
+    }
+    si(0, N) = 1; si(1, N + 1) = 1; fi(0, N + 1) = 1;
+  }
+
+  // the BC rows of DoublyPeriodic_no_wall_BCs() in Solvers.py (N + 2 each)
+  void noWallBCs(std::vector<double>& BCR1, std::vector<double>& BCR2, std::vector<double>& BCL1,
+                 std::vector<double>& BCL2, const unsigned int N)
+  {
+    BCR1.assign(N + 2, 0); BCR2.assign(N + 2, 0); BCL1.assign(N + 2, 0); BCL2.assign(N + 2, 0);
+    // special cases - right
+    BCR1[N + 1] = 1; BCR2[N] = 1; BCR1[0] = 1; BCR1[2] = -0.5;
+    BCR2[N + 1] += 1; BCR2[1] = -1.0 / 8; BCR2[3] = 1.0 / 8;
+    BCR1[1] += 0.25; BCR1[3] -= 0.25; BCR2[0] += 0.25; BCR2[2] -= (1.0 / 8 + 1.0 / 24);
+    BCR2[4] += 1.0 / 24;
+    // special cases - left
+    BCL1[N + 1] = 1; BCL2[N] = -1; BCL1[0] = -1; BCL1[2] = 0.5;
+    BCL2[N + 1] += 1; BCL2[1] = -1.0 / 8; BCL2[3] = 1.0 / 8;
+    BCL1[1] += 0.25; BCL1[3] -= 0.25; BCL2[0] -= 0.25; BCL2[2] += 1.0 / 8 + 1.0 / 24;
+    BCL2[4] -= 1.0 / 24;
+    // easy cases
+    for (unsigned int j = 3; j < N; ++j)
+    {
+      const double a = 1.0 / (2 * j), s = j % 2 ? -1 : 1;
+      const double bm = a / (2 * j - 2), bp = a / (2 * j + 2);
+      BCR1[j - 1] += a; BCL1[j - 1] += s * a;
+      if (j < N - 1) {BCR1[j + 1] -= a; BCL1[j + 1] -= s * a;}
+      BCR2[j - 2] += bm; BCL2[j - 2] -= bm * s;
+      if (j < N - 2) {BCR2[j + 2] += bp; BCL2[j + 2] -= bp * s;}
+      const double b0 = bm + (j < N - 1 ? bp : 0);
+      BCR2[j] -= b0; BCL2[j] += b0 * s;
+    }
+  }
+
+  // Chebyshev coefficients of the z derivative of f (chebCoeffDiff() in Chebyshev.py)
+  template<typename Real>
+  void chebDiff(const Real* f, Real* df, const unsigned int Nz, const Real H)
+  {
+    df[Nz - 1] = 0;
+    df[Nz - 2] = 2 / H * (Nz - 1) * f[Nz - 1];
+    for (unsigned int j = 2; j < Nz; ++j)
+    {
+      df[Nz - j - 1] = df[Nz - j + 1] + 2 / H * (Nz - j) * f[Nz - j];
+    }
+    df[0] /= 2;
+  }
+
+  template<typename Real>
+  Real dot(const Real* a, const Real* b, const unsigned int n)
+  {
+    Real s = 0;
+    for (unsigned int j = 0; j < n; ++j) {s += a[j] * b[j];}
+    return s;
+  }
+
+  /* solve of the k = 0 mode with homogeneous BCs (eg. the k0 = 1 branch of
+     DoublyPeriodicStokes_no_wall_solvePressureBVP_k0()): x = (rhs, ginv * c * rhs),
+     sol = SIMat * x and dsol = FIMat * x, unless FIMat is 0 */
+  template<typename Real>
+  void k0Solve(const Real* rhs, const Real* c, const Real* ginv, const Real* SIMat,
+               const Real* FIMat, Real* x, Real* sol, Real* dsol, const unsigned int Nz)
+  {
+    Real y[2] = {0, 0};
+    for (unsigned int j = 0; j < Nz; ++j)
+    {
+      x[j] = rhs[j]; y[0] += c[2 * j] * rhs[j]; y[1] += c[2 * j + 1] * rhs[j];
+    }
+    x[Nz] = ginv[0] * y[0] + ginv[2] * y[1];
+    x[Nz + 1] = ginv[1] * y[0] + ginv[3] * y[1];
+    for (unsigned int r = 0; r < Nz; ++r)
+    {
+      Real s = 0, ds = 0;
+      for (unsigned int j = 0; j < Nz + 2; ++j)
+      {
+        s += SIMat[r + (size_t) Nz * j] * x[j];
+        if (FIMat) {ds += FIMat[r + (size_t) Nz * j] * x[j];}
+      }
+      sol[r] = s;
+      if (dsol) {dsol[r] = ds;}
+    }
+  }
+
+  /* A^{-1} rhs for the nrhs columns (Nz x nrhs) of each of the nl wave numbers of a group,
+     at rhs, rhs + stride,..., with the interleaved factors plu of the group. The columns
+     are packed into X (Nz x nrhs x W) for pentaSolveT(), and those of the lanes in the
+     bit mask skip are not written back */
+  template<typename Real>
+  void groupSolve(const Real* plu, const unsigned int skip, Real* rhs, const size_t stride,
+                  const unsigned int nl, Real* X, const unsigned int Nz, const unsigned int nrhs)
+  {
+    const unsigned int W = PentaLanes<Real>::W, n = Nz * nrhs;
+    for (unsigned int k = 0; k < n; ++k)
+    {
+      for (unsigned int l = 0; l < W; ++l) {X[W * k + l] = l < nl ? rhs[stride * l + k] : 0;}
+    }
+    pentaSolveT<Real>(plu, X, Nz, nrhs);
+    for (unsigned int l = 0; l < nl; ++l)
+    {
+      if (skip >> l & 1) {continue;}
+      for (unsigned int k = 0; k < n; ++k) {rhs[stride * l + k] = X[W * k + l];}
+    }
+  }
+}
+
+template<typename Real>
+void DPStokesT<Real>::setup(const unsigned int _Nx, const unsigned int _Ny, const unsigned int _Nz,
+                            const double Lx, const double Ly, const double _H, const double _eta,
+                            const bool _planar, const bool _real, const bool _kmajor)
+{
+  if (_Nz < 3) {exitErr("DPStokes needs at least 3 Chebyshev points in z.");}
+  cleanup();
+  Nx = _Nx; Ny = _Ny; Nz = _Nz; H = _H; eta = _eta;
+  planar = _planar; real = _real; kmajor = _kmajor;
+  Nxs = real ? Nx / 2 + 1 : Nx; Nyx = Ny * Nxs;
+  nthreads = omp_get_max_threads();
+  kx = (Real*) alignedMalloc(Nxs * sizeof(Real));
+  ky = (Real*) alignedMalloc(Ny * sizeof(Real));
+  z = (Real*) alignedMalloc(Nz * sizeof(Real));
+  SIMat = (Real*) alignedMalloc((size_t) Nz * (Nz + 2) * sizeof(Real));
+  FIMat = (Real*) alignedMalloc((size_t) Nz * (Nz + 2) * sizeof(Real));
+  pints = (Real*) alignedMalloc(Nz * sizeof(Real));
+  uvints = (Real*) alignedMalloc(Nz * sizeof(Real));
+  LU = (Real*) alignedMalloc((size_t) ldab * Nz * Nyx * sizeof(Real));
+  Ainv_B = (Real*) alignedMalloc((size_t) Nz * 2 * Nyx * sizeof(Real));
+  C = (Real*) alignedMalloc((size_t) 2 * Nz * Nyx * sizeof(Real));
+  Ginv = (Real*) alignedMalloc((size_t) 4 * Nyx * sizeof(Real));
+  PIV = (int*) alignedMalloc((size_t) Nz * Nyx * sizeof(int));
+  const unsigned int W = PentaLanes<Real>::W, ngroups = (Nyx + W - 1) / W;
+  PLU = (Real*) alignedMalloc((size_t) 5 * W * Nz * ngroups * sizeof(Real));
+  PLUmask = (unsigned int*) alignedMalloc(ngroups * sizeof(unsigned int));
+  C_k0 = (Real*) alignedMalloc(3 * 2 * Nz * sizeof(Real));
+  Ginv_k0 = (Real*) alignedMalloc(3 * 4 * sizeof(Real));
+  work = (Real*) alignedMalloc(nthreads * workSize() * sizeof(Real));
+  if (not (kx && ky && z && SIMat && FIMat && pints && uvints && LU && PLU && Ainv_B && C &&
+           Ginv && PIV && PLUmask && C_k0 && Ginv_k0 && work))
+  {
+    exitErr("Could not allocate the DPStokes operators.");
+  }
+  waveNumbers(kx, Nxs, Nx, Lx); waveNumbers(ky, Ny, Ny, Ly);
+  for (unsigned int j = 0; j < Nz; ++j) {z[j] = H * cos(M_PI * j / (Nz - 1)) + H;}
+  // integral matrices, scaled by H^2 and H
+  std::vector<double> SI, FI;
+  integralMatrices(SI, FI, Nz);
+  for (size_t j = 0; j < SI.size(); ++j)
+  {
+    SI[j] *= H * H; FI[j] *= H; SIMat[j] = SI[j]; FIMat[j] = FI[j];
+  }
+  // integrals of the Chebyshev polynomials (precomputeInts() in Chebyshev.py)
+  const unsigned int nq = 1000;
+  std::vector<double> cpts(nq), cwts(nq);
+  clencurt(cpts.data(), cwts.data(), 0, 2 * H, nq);
+  for (unsigned int k = 0; k < Nz; ++k)
+  {
+    double p = 0, uv = 0;
+    for (unsigned int i = 0; i < nq; ++i)
+    {
+      const double theta = M_PI * i / (nq - 1), Tk = cos(k * theta);
+      p += cwts[i] * Tk; uv += cwts[i] * Tk * cos(theta);
+    }
+    pints[k] = p; uvints[k] = H * uv;
+  }
+  std::vector<double> BCR1, BCR2, BCL1, BCL2;
+  noWallBCs(BCR1, BCR2, BCL1, BCL2, Nz);
+  // BCs of the k = 0 mode, for each geometry: (BCR2, -BCL2) for no wall (and the pressure
+  // of the wall corrections), (BCR1, BCL2) for the bottom wall and (BCR2, BCL2) for the channel
+  const double* rows[3][2] = {{BCR2.data(), BCL2.data()}, {BCR1.data(), BCL2.data()},
+                              {BCR2.data(), BCL2.data()}};
+  const double sign[3][2] = {{1, -1}, {1, 1}, {1, 1}};
+  for (unsigned int g = 0; g < 3; ++g)
+  {
+    double D[4];
+    for (unsigned int r = 0; r < 2; ++r)
+    {
+      for (unsigned int j = 0; j < Nz; ++j) {C_k0[2 * (Nz * g + j) + r] = sign[g][r] * rows[g][r][j];}
+      for (unsigned int c = 0; c < 2; ++c) {D[r + 2 * c] = -sign[g][r] * rows[g][r][Nz + c];}
+    }
+    const double det = 1 / (D[0] * D[3] - D[2] * D[1]);
+    Real* ginv = Ginv_k0 + 4 * g;
+    ginv[0] = D[3] * det; ginv[1] = -D[1] * det; ginv[2] = -D[2] * det; ginv[3] = D[0] * det;
+  }
+  // blocks of the solve of each wave number (A, B, C and D of DoublyPeriodicStokes_init()).
+  // A and B are factored in place into LU and Ainv_B by precomputeBandedLinOps()
+  std::vector<Real> D((size_t) 4 * Nyx), G((size_t) 4 * Nyx);
+  #pragma omp parallel for schedule(static)
+  for (unsigned int p = 0; p < Nyx; ++p)
+  {
+    const double kxp = kx[p % Nxs], kyp = ky[p / Nxs];
+    const double ksq = kxp * kxp + kyp * kyp, K = sqrt(ksq);
+    Real* ab = LU + (size_t) ldab * Nz * p;
+    for (unsigned int j = 0; j < ldab * Nz; ++j) {ab[j] = 0;}
+    for (unsigned int j = 0; j < Nz; ++j)
+    {
+      for (unsigned int r = (j > ku ? j - ku : 0); r < Nz && r <= j + kl; ++r)
+      {
+        ab[kl + ku + r - j + (size_t) ldab * j] = (r == j) - ksq * SI[r + (size_t) Nz * j];
+      }
+    }
+    for (unsigned int c = 0; c < 2; ++c)
+    {
+      for (unsigned int r = 0; r < Nz; ++r)
+      {
+        Ainv_B[r + (size_t) Nz * (c + 2 * p)] = -ksq * SI[r + (size_t) Nz * (Nz + c)];
+      }
+    }
+    // BCs_k = BCs_k0 + H (BCR1, BCL1) + H^2 K (BCR2, BCL2) + (-BCR2, BCL2)
+    for (unsigned int j = 0; j < Nz + 2; ++j)
+    {
+      const double r0 = BCR2[j] + H * BCR1[j] + H * H * K * BCR2[j] - BCR2[j];
+      const double r1 = -BCL2[j] + H * BCL1[j] + H * H * K * BCL2[j] + BCL2[j];
+      Real* dst = j < Nz ? C + 2 * (j + (size_t) Nz * p) : D.data() + 2 * (j - Nz + 2 * p);
+      dst[0] = r0; dst[1] = r1;
+    }
+  }
+  // the interleaved factors of A of each group of wave numbers, before A is overwritten
+  #pragma omp parallel for schedule(static)
+  for (unsigned int g = 0; g < ngroups; ++g)
+  {
+    const unsigned int nl = Nyx - g * W < W ? Nyx - g * W : W;
+    PLUmask[g] = pentaFactorT<Real>(LU + (size_t) ldab * Nz * W * g, (size_t) ldab * Nz, nl,
+                                    PLU + (size_t) 5 * W * Nz * g, Nz);
+  }
+  precomputeBandedLinOpsT<Real>(LU, Ainv_B, C, D.data(), G.data(), Ginv, PIV, kl, ku, Nyx, Nz);
+  // forward plan of the Chebyshev transforms of the wall corrections (see DPTools.h)
+  typedef typename FFTW<Real>::complex Complex;
+  FFTW<Real>::init_threads();
+  FFTW<Real>::plan_with_nthreads(1);
+  Complex* in = (Complex*) alignedMalloc((2 * Nz - 2) * sizeof(Complex));
+  plan = FFTW<Real>::plan_dft_1d(2 * Nz - 2, in, in, FFTW_FORWARD, FFTW_ESTIMATE);
+  alignedFree(in);
+}
+
+template<typename Real>
+size_t DPStokesT<Real>::workSize() const
+{
+  // the buffer of the corrections, the columns of f (6), the rhs (6), p and dp/dz (4) and
+  // u, v, w (6) of each wave number of a group, the interleaved rhs (6 x W), the
+  // corrections (8), x (6 x (Nz + 2)) and the BCs (12 x W), rounded up to keep each
+  // thread aligned
+  const size_t W = PentaLanes<Real>::W;
+  const size_t n = correctionWorkSize(Nz) + (28 * W + 14) * Nz + 12 + 12 * W;
+  return (n + 15) / 16 * 16;
+}
+
+template<typename Real>
+void DPStokesT<Real>::solve(Real* fhat_r, Real* fhat_i, const DPGeometry geom, const int k0,
+                            Real* phat_r, Real* phat_i)
+{
+  // offsets of a component (sd), a wave number (sp) and a coefficient in z (sk) in the
+  // spectrum, and of a wave number (pp) and a coefficient (pk) in the pressure
+  const size_t N = (size_t) Nz * Nyx;
+  const size_t sd = planar ? N : (kmajor ? Nz : 1);
+  const size_t sp = kmajor ? (planar ? Nz : 3 * (size_t) Nz) : (planar ? 1 : 3);
+  const size_t sk = kmajor ? 1 : (planar ? Nyx : 3 * (size_t) Nyx);
+  const size_t pp = kmajor ? Nz : 1, pk = kmajor ? 1 : Nyx;
+  const size_t wsize = workSize();
+  const unsigned int W = PentaLanes<Real>::W, ngroups = (Nyx + W - 1) / W;
+  // workspace of each wave number of a group: the columns of f, g, h, the right-hand
+  // sides of the batched solves (Nz x 2 for p, Nz x 6 for u, v, w), p and dp/dz, and
+  // the columns of u, v, w (real and imaginary parts)
+  const size_t lsize = 22 * (size_t) Nz;
+  const Real etainv = 1 / eta;
+  #pragma omp parallel num_threads(nthreads)
+  {
+    Real* cwork = work + omp_get_thread_num() * wsize;
+    Real* lanes = cwork + correctionWorkSize(Nz);
+    // interleaved right-hand sides of the group (see pentaSolveT())
+    Real* X = lanes + lsize * W;
+    // corrections of p, u, v, w (real and imaginary parts)
+    Real* corr = X + 6 * (size_t) Nz * W;
+    Real* x = corr + 8 * Nz;
+    // BCs of the velocity solve of each wave number
+    Real* bcs = x + 6 * (Nz + 2);
+    #pragma omp for schedule(static)
+    for (unsigned int g = 0; g < ngroups; ++g)
+    {
+      const unsigned int p0 = g * W, nl = Nyx - p0 < W ? Nyx - p0 : W;
+      const Real* plu = PLU + (size_t) 5 * W * Nz * g;
+      // the lanes solved with the pivoted LU, and the k = 0 mode, are left out of pentaSolveT()
+      const unsigned int skip = PLUmask[g] | (p0 == 0);
+      for (unsigned int l = 0; l < nl; ++l)
+      {
+        const unsigned int p = p0 + l, i = p % Nxs, j = p / Nxs;
+        Real *F = lanes + lsize * l, *rhs_r = F + 6 * Nz, *rhs_i = rhs_r + Nz;
+        for (unsigned int d = 0; d < 3; ++d)
+        {
+          const size_t offset = d * sd + p * sp;
+          for (unsigned int k = 0; k < Nz; ++k)
+          {
+            F[2 * d * Nz + k] = fhat_r[offset + k * sk];
+            F[(2 * d + 1) * Nz + k] = fhat_i[offset + k * sk];
+          }
+        }
+        const Real *fr = F, *fi = F + Nz, *gr = F + 2 * Nz, *gi = F + 3 * Nz;
+        const Real *hr = F + 4 * Nz, *hi = F + 5 * Nz;
+        // Fourier derivatives i dx, i dy, with the unpaired modes zeroed
+        const Real dx = (Nx % 2 == 0 && i == Nx / 2) ? 0 : kx[i];
+        const Real dy = (Ny % 2 == 0 && j == Ny / 2) ? 0 : ky[j];
+        // RHS of the pressure Poisson equation, div f
+        chebDiff(hr, rhs_r, Nz, H); chebDiff(hi, rhs_i, Nz, H);
+        for (unsigned int k = 0; k < Nz; ++k)
+        {
+          rhs_r[k] -= dx * fi[k] + dy * gi[k];
+          rhs_i[k] += dx * fr[k] + dy * gr[k];
+        }
+      }
+      // A^{-1} of the real and imaginary parts of the RHS of p of the group
+      groupSolve<Real>(plu, skip, lanes + 6 * Nz, lsize, nl, X, Nz, 2);
+      for (unsigned int l = 0; l < nl; ++l)
+      {
+        const unsigned int p = p0 + l, i = p % Nxs, j = p / Nxs;
+        if (p == 0) {continue;}
+        Real *F = lanes + lsize * l, *rhs = F + 6 * Nz;
+        Real *Cp_r = rhs + 6 * Nz, *Cp_i = Cp_r + Nz, *Dp_r = Cp_i + Nz, *Dp_i = Dp_r + Nz;
+        const Real* c = C + (size_t) 2 * Nz * p;
+        const Real* ainvb = Ainv_B + (size_t) 2 * Nz * p;
+        const Real* ginv = Ginv + 4 * (size_t) p;
+        if (skip >> l & 1)
+        {
+          bandedSchurSolveK<Real>(LU + (size_t) ldab * Nz * p, rhs, 0, PIV + (size_t) Nz * p, c,
+                                  ginv, ainvb, SIMat, FIMat, x, Cp_r, Dp_r, kl, ku, Nz, 2);
+        }
+        else {schurCorrectK<Real>(rhs, 0, c, ginv, ainvb, SIMat, FIMat, x, Cp_r, Dp_r, Nz, 2);}
+        const Real dx = (Nx % 2 == 0 && i == Nx / 2) ? 0 : kx[i];
+        const Real dy = (Ny % 2 == 0 && j == Ny / 2) ? 0 : ky[j];
+        // sums of the pressure at z = 2H and z = 0, for the BCs of the velocity
+        Real Sr = 0, Si = 0, Ar = 0, Ai = 0;
+        for (unsigned int k = 0; k < Nz; ++k)
+        {
+          const Real s = k % 2 ? -1 : 1;
+          Sr += Cp_r[k]; Si += Cp_i[k]; Ar += s * Cp_r[k]; Ai += s * Cp_i[k];
+        }
+        const Real fac1 = 2 * eta, fac2 = fac1 * sqrt(kx[i] * kx[i] + ky[j] * ky[j]);
+        Real* bc = bcs + 12 * l;
+        for (unsigned int d = 0; d < 3; ++d)
+        {
+          // RHS (dp/dx - f_x) / eta (and y, z) and the BCs, as in DoublyPeriodicStokes_no_wall(),
+          // stored as the columns (u_r, u_i, v_r, v_i, w_r, w_i) of one batched solve
+          const Real dd = d == 0 ? dx : dy, *f_r = F + 2 * d * Nz, *f_i = f_r + Nz;
+          Real *r_r = rhs + 2 * d * Nz, *r_i = r_r + Nz, *bc_r = bc + 4 * d, *bc_i = bc_r + 2;
+          if (d < 2)
+          {
+            for (unsigned int k = 0; k < Nz; ++k)
+            {
+              r_r[k] = (-dd * Cp_i[k] - f_r[k]) * etainv;
+              r_i[k] = (dd * Cp_r[k] - f_i[k]) * etainv;
+            }
+            bc_r[0] = dd * Si / fac2; bc_r[1] = -dd * Ai / fac2;
+            bc_i[0] = -dd * Sr / fac2; bc_i[1] = dd * Ar / fac2;
+          }
+          else
+          {
+            for (unsigned int k = 0; k < Nz; ++k)
+            {
+              r_r[k] = (Dp_r[k] - f_r[k]) * etainv;
+              r_i[k] = (Dp_i[k] - f_i[k]) * etainv;
+            }
+            bc_r[0] = Sr / fac1; bc_r[1] = Ar / fac1;
+            bc_i[0] = Si / fac1; bc_i[1] = Ai / fac1;
+          }
+        }
+      }
+      // A^{-1} of the RHS of u, v, w of the group
+      groupSolve<Real>(plu, skip, lanes + 6 * Nz, lsize, nl, X, Nz, 6);
+      for (unsigned int l = 0; l < nl; ++l)
+      {
+        const unsigned int p = p0 + l, i = p % Nxs, j = p / Nxs;
+        Real *F = lanes + lsize * l, *rhs = F + 6 * Nz, *rhs_r = rhs, *rhs_i = rhs + Nz;
+        Real *Cp_r = rhs + 6 * Nz, *Cp_i = Cp_r + Nz, *Dp_r = Cp_i + Nz, *Dp_i = Dp_r + Nz;
+        Real* U = Dp_i + Nz;
+        const Real *hr = F + 4 * Nz, *hi = F + 5 * Nz;
+        if (p)
+        {
+          const Real* c = C + (size_t) 2 * Nz * p;
+          const Real* ainvb = Ainv_B + (size_t) 2 * Nz * p;
+          const Real* ginv = Ginv + 4 * (size_t) p;
+          if (skip >> l & 1)
+          {
+            bandedSchurSolveK<Real>(LU + (size_t) ldab * Nz * p, rhs, bcs + 12 * l,
+                                    PIV + (size_t) Nz * p, c, ginv, ainvb, SIMat, 0, x, U, 0,
+                                    kl, ku, Nz, 6);
+          }
+          else {schurCorrectK<Real>(rhs, bcs + 12 * l, c, ginv, ainvb, SIMat, 0, x, U, 0, Nz, 6);}
+          if (geom != no_wall)
+          {
+            // minus the velocities at the walls (z = 0 is theta = pi)
+            Real ub_r[3], ub_i[3], ut_r[3], ut_i[3];
+            for (unsigned int d = 0; d < 6; ++d)
+            {
+              Real b = 0, t = 0;
+              for (unsigned int k = 0; k < Nz; ++k) {b -= (k % 2 ? -1 : 1) * U[d * Nz + k]; t -= U[d * Nz + k];}
+              (d % 2 ? ub_i : ub_r)[d / 2] = b; (d % 2 ? ut_i : ut_r)[d / 2] = t;
+            }
+            if (geom == bottom_wall)
+            {
+              bottomWallCorrectionK<Real>(corr, corr + Nz, corr + 2 * Nz, corr + 3 * Nz, corr + 4 * Nz,
+                                          corr + 5 * Nz, corr + 6 * Nz, corr + 7 * Nz, ub_r, ub_i,
+                                          kx[i], ky[j], z, eta, Nz, plan, cwork);
+            }
+            else
+            {
+              slitChannelCorrectionK<Real>(corr, corr + Nz, corr + 2 * Nz, corr + 3 * Nz, corr + 4 * Nz,
+                                           corr + 5 * Nz, corr + 6 * Nz, corr + 7 * Nz, ub_r, ub_i,
+                                           ut_r, ut_i, kx[i], ky[j], z, 2 * H, eta, Nz, plan, cwork);
+            }
+            for (unsigned int k = 0; k < Nz; ++k) {Cp_r[k] += corr[k]; Cp_i[k] += corr[Nz + k];}
+            for (unsigned int k = 0; k < 6 * Nz; ++k) {U[k] += corr[2 * Nz + k];}
+          }
+        }
+        else if (geom == no_wall && k0 == 1)
+        {
+          // the k = 0 mode of DoublyPeriodicStokes_no_wall() (the RHS of p is dh/dz here)
+          k0Solve<Real>(rhs_r, C_k0, Ginv_k0, SIMat, FIMat, x, Cp_r, Dp_r, Nz);
+          k0Solve<Real>(rhs_i, C_k0, Ginv_k0, SIMat, FIMat, x, Cp_i, Dp_i, Nz);
+          Cp_r[1] += 0.5 * dot(pints, hr, Nz); Cp_i[1] += 0.5 * dot(pints, hi, Nz);
+          // u, v (real and imaginary parts) with the RHS -f / eta, and w with (dp/dz - h) / eta
+          for (unsigned int d = 0; d < 6; ++d)
+          {
+            const Real *f = F + d * Nz, *dp = d == 4 ? Dp_r : Dp_i;
+            for (unsigned int k = 0; k < Nz; ++k) {rhs_r[k] = ((d < 4 ? 0 : dp[k]) - f[k]) * etainv;}
+            k0Solve<Real>(rhs_r, C_k0, Ginv_k0, SIMat, 0, x, U + d * Nz, 0, Nz);
+            if (d < 4) {U[d * Nz + 1] += 0.5 * etainv * dot(uvints, f, Nz);}
+          }
+        }
+        else if (geom != no_wall)
+        {
+          // the k = 0 corrections of DoublyPeriodicStokes_bottom_wall() and _slit_channel()
+          // (the no wall solution is 0 there)
+          k0Solve<Real>(rhs_r, C_k0, Ginv_k0, SIMat, 0, x, Cp_r, 0, Nz);
+          k0Solve<Real>(rhs_i, C_k0, Ginv_k0, SIMat, 0, x, Cp_i, 0, Nz);
+          const Real ph_r = 0.5 * dot(pints, hr, Nz), ph_i = 0.5 * dot(pints, hi, Nz);
+          Cp_r[1] += ph_r; Cp_i[1] += ph_i; Cp_r[0] = ph_r; Cp_i[0] = ph_i;
+          for (unsigned int d = 0; d < 4; ++d)
+          {
+            for (unsigned int k = 0; k < Nz; ++k) {rhs_r[k] = -F[d * Nz + k] * etainv;}
+            k0Solve<Real>(rhs_r, C_k0 + 2 * Nz * geom, Ginv_k0 + 4 * geom, SIMat, 0, x,
+                          U + d * Nz, 0, Nz);
+          }
+          for (unsigned int k = 0; k < 2 * Nz; ++k) {U[4 * Nz + k] = 0;}
+        }
+        else
+        {
+          for (unsigned int k = 0; k < 2 * Nz; ++k) {Cp_r[k] = 0;}
+          for (unsigned int k = 0; k < 6 * Nz; ++k) {U[k] = 0;}
+        }
+        for (unsigned int d = 0; d < 3; ++d)
+        {
+          const size_t offset = d * sd + p * sp;
+          for (unsigned int k = 0; k < Nz; ++k)
+          {
+            fhat_r[offset + k * sk] = U[2 * d * Nz + k];
+            fhat_i[offset + k * sk] = U[(2 * d + 1) * Nz + k];
+          }
+        }
+        if (phat_r && phat_i)
+        {
+          for (unsigned int k = 0; k < Nz; ++k)
+          {
+            phat_r[p * pp + k * pk] = Cp_r[k]; phat_i[p * pp + k * pk] = Cp_i[k];
+          }
+        }
+      }
+    }
+  }
+}
+
+template<typename Real>
+MemoryReport DPStokesT<Real>::memoryReport() const
+{
+  MemoryReport report;
+  addBuffer(report, "dpstokes.kx", kx);
+  addBuffer(report, "dpstokes.ky", ky);
+  addBuffer(report, "dpstokes.z", z);
+  addBuffer(report, "dpstokes.SIMat", SIMat);
+  addBuffer(report, "dpstokes.FIMat", FIMat);
+  addBuffer(report, "dpstokes.pints", pints);
+  addBuffer(report, "dpstokes.uvints", uvints);
+  addBuffer(report, "dpstokes.LU", LU);
+  addBuffer(report, "dpstokes.PIV", PIV);
+  addBuffer(report, "dpstokes.PLU", PLU);
+  addBuffer(report, "dpstokes.PLUmask", PLUmask);
+  addBuffer(report, "dpstokes.Ainv_B", Ainv_B);
+  addBuffer(report, "dpstokes.C", C);
+  addBuffer(report, "dpstokes.Ginv", Ginv);
+  addBuffer(report, "dpstokes.C_k0", C_k0);
+  addBuffer(report, "dpstokes.Ginv_k0", Ginv_k0);
+  addBuffer(report, "dpstokes.work", work);
+  return report;
+}
+
+template<typename Real>
+void DPStokesT<Real>::cleanup()
+{
+  alignedFree(kx); alignedFree(ky); alignedFree(z); alignedFree(SIMat); alignedFree(FIMat);
+  alignedFree(pints); alignedFree(uvints); alignedFree(LU); alignedFree(Ainv_B); alignedFree(C);
+  alignedFree(Ginv); alignedFree(PIV); alignedFree(C_k0); alignedFree(Ginv_k0); alignedFree(work);
+  alignedFree(PLU); alignedFree(PLUmask);
+  kx = ky = z = SIMat = FIMat = pints = uvints = LU = PLU = Ainv_B = C = Ginv = C_k0 = Ginv_k0 = work = 0;
+  PIV = 0; PLUmask = 0;
+  if (plan) {FFTW<Real>::destroy_plan(plan); plan = 0;}
+}
+
+template struct DPStokesT<double>;
+template struct DPStokesT<float>;
@@ -4,6 +4,324 @@
 #include <lapacke.h>
 #include<omp.h>
 #include"DPTools.h"
+#include"FFTWTraits.h"
+#include"Memory.h"
+
+/* The Chebyshev transforms and the correction solutions are templated on the
+   precision, with the fftw, BLAS and LAPACK routines of each precision (see
+   FFTWTraits.h) picked by overloading */
+namespace
+{
+  template<typename Real> struct Lapack;
+  template<> struct Lapack<double> {typedef lapack_complex_double complex;};
+  template<> struct Lapack<float> {typedef lapack_complex_float complex;};
+
+  inline void axpy(int n, double a, const double* x, int incx, double* y, int incy)
+  {
+    cblas_daxpy(n, a, x, incx, y, incy);
+  }
+  inline void axpy(int n, float a, const float* x, int incx, float* y, int incy)
+  {
+    cblas_saxpy(n, a, x, incx, y, incy);
+  }
+  // solve the n x n system a x = b (one rhs, column major), overwriting b with x
+  inline void gesv(int n, lapack_complex_double* a, int* piv, lapack_complex_double* b)
+  {
+    LAPACKE_zgesv(LAPACK_COL_MAJOR, n, 1, a, n, piv, b, n);
+  }
+  inline void gesv(int n, lapack_complex_float* a, int* piv, lapack_complex_float* b)
+  {
+    LAPACKE_cgesv(LAPACK_COL_MAJOR, n, 1, a, n, piv, b, n);
+  }
+
+}
+
+template<typename Real>
+void chebTransformT(const Real* in_re, const Real* in_im, Real* out_re, Real* out_im, 
+                    const typename FFTW<Real>::plan plan, unsigned int N, Real* work)
+{
+  typedef typename FFTW<Real>::complex Complex;
+  unsigned int ext = 2 * N - 2;
+  Complex* in = (Complex*) work;
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    in[i][0] = in_re[i];
+    in[i][1] = in_im[i];
+  }
+  for (unsigned int i = N; i < ext; ++i)
+  {
+    in[i][0] = in_re[ext - i];
+    in[i][1] = in_im[ext - i];
+  }
+  FFTW<Real>::execute_dft(plan, in, in);
+  out_re[0] = in[0][0] / ((Real) ext); 
+  out_im[0] = in[0][1] / ((Real) ext);
+  for (unsigned int i = 1; i < N - 1; ++i)
+  {
+    out_re[i] = (in[i][0] + in[ext - i][0]) / ((Real) ext);
+    out_im[i] = (in[i][1] + in[ext - i][1]) / ((Real) ext);
+  } 
+  out_re[N-1] = in[N-1][0] / ((Real) ext);
+  out_im[N-1] = in[N-1][1] / ((Real) ext);
+}
+
+template<typename Real>
+void bottomWallCorrectionK(Real* Cpcorr_r, Real* Cpcorr_i, Real* Cucorr_r, Real* Cucorr_i, 
+                           Real* Cvcorr_r, Real* Cvcorr_i, Real* Cwcorr_r, Real* Cwcorr_i, 
+                           const Real* fhat_r, const Real* fhat_i, Real kx, Real ky, 
+                           const Real* z, Real eta, unsigned int Nz, 
+                           const typename FFTW<Real>::plan plan, Real* work)
+{
+  Real k = sqrt(kx * kx + ky * ky);
+  // the first 4 * Nz are for the Chebyshev transforms
+  Real* enkz = work + 4 * Nz;
+  Real* zenkz = enkz + Nz;
+  Real* Cp_r = zenkz + Nz;
+  Real* Cp_i = Cp_r + Nz;
+  Real* Cu_r = Cp_i + Nz;
+  Real* Cu_i = Cu_r + Nz;
+  Real* Cv_r = Cu_i + Nz;
+  Real* Cv_i = Cv_r + Nz;
+  Real* Cw_r = Cv_i + Nz;
+  Real* Cw_i = Cw_r + Nz;
+  #pragma omp simd
+  for (unsigned int j = 0; j < Nz; ++j) 
+  {
+    enkz[j] = exp(-k * z[j]);
+    zenkz[j] = z[j] * enkz[j];
+    Cp_r[j] = Cp_i[j] = Cu_r[j] = Cu_i[j] = 0;
+    Cv_r[j] = Cv_i[j] = Cw_r[j] = Cw_i[j] = 0;
+  }
+  Real alpha_r = kx * fhat_r[0] + ky * fhat_r[1] - k * fhat_i[2];
+  Real alpha_i = kx * fhat_i[0] + ky * fhat_i[1] + k * fhat_r[2];
+  // correction for pressure
+  axpy(Nz, 2.0 * eta * alpha_i, enkz, 1, Cp_r, 1);
+  axpy(Nz, -2.0 * eta * alpha_r, enkz, 1, Cp_i, 1); 
+  // correction for x vel
+  axpy(Nz, -kx * alpha_r / k, zenkz, 1, Cu_r, 1);      
+  axpy(Nz, fhat_r[0], enkz, 1, Cu_r, 1);
+  axpy(Nz, -kx * alpha_i / k, zenkz, 1, Cu_i, 1);      
+  axpy(Nz, fhat_i[0], enkz, 1, Cu_i, 1);
+  // correction for y vel
+  axpy(Nz, -ky * alpha_r / k, zenkz, 1, Cv_r, 1);      
+  axpy(Nz, fhat_r[1], enkz, 1, Cv_r, 1);
+  axpy(Nz, -ky * alpha_i / k, zenkz, 1, Cv_i, 1);      
+  axpy(Nz, fhat_i[1], enkz, 1, Cv_i, 1);
+  // correction for z vel
+  axpy(Nz, alpha_i, zenkz, 1, Cw_r, 1);
+  axpy(Nz, fhat_r[2], enkz, 1, Cw_r, 1); 
+  axpy(Nz, -alpha_r, zenkz, 1, Cw_i, 1);
+  axpy(Nz, fhat_i[2], enkz, 1, Cw_i, 1);
+  // forward transform in z to get cheb coeffs
+  chebTransformT<Real>(Cp_r, Cp_i, Cpcorr_r, Cpcorr_i, plan, Nz, work);
+  chebTransformT<Real>(Cu_r, Cu_i, Cucorr_r, Cucorr_i, plan, Nz, work);
+  chebTransformT<Real>(Cv_r, Cv_i, Cvcorr_r, Cvcorr_i, plan, Nz, work);
+  chebTransformT<Real>(Cw_r, Cw_i, Cwcorr_r, Cwcorr_i, plan, Nz, work);
+}
+
+namespace
+{
+  inline unsigned int at(unsigned int i, unsigned int j){return i + 8 * j;}
+}
+
+template<typename Real>
+void slitChannelCorrectionK(Real* Cpcorr_r, Real* Cpcorr_i, Real* Cucorr_r, Real* Cucorr_i, 
+                            Real* Cvcorr_r, Real* Cvcorr_i, Real* Cwcorr_r, Real* Cwcorr_i, 
+                            const Real* fbhat_r, const Real* fbhat_i, const Real* fthat_r, 
+                            const Real* fthat_i, Real kx, Real ky, const Real* z, Real H, 
+                            Real eta, unsigned int Nz, const typename FFTW<Real>::plan plan, 
+                            Real* work)
+{
+  typedef typename Lapack<Real>::complex LapackComplex;
+  Real fac = 1.0 / 2.0 / eta;
+  Real k = sqrt(kx * kx + ky * ky);
+  // the first 4 * Nz are for the Chebyshev transforms
+  // e^(-kz) 
+  Real* enkz = work + 4 * Nz;
+  // e^(k(z-H))
+  Real* ekzmh = enkz + Nz;
+  // ze^(k(z-H))
+  Real* zekzmh = ekzmh + Nz;
+  // e^(-kH)
+  Real enkh = exp(-k * H);
+  // ze^(-kz)
+  Real* zenkz = zekzmh + Nz;
+  // real and imaginary components of pressure and vel
+  Real* Cp_r = zenkz + Nz;
+  Real* Cp_i = Cp_r + Nz;
+  Real* Cu_r = Cp_i + Nz;
+  Real* Cu_i = Cu_r + Nz;
+  Real* Cv_r = Cu_i + Nz;
+  Real* Cv_i = Cv_r + Nz;
+  Real* Cw_r = Cv_i + Nz;
+  Real* Cw_i = Cw_r + Nz;
+  // matrix to solve for coeffs of exponentials in correction sol
+  LapackComplex coeffA[64];
+  // right hand side of coeffA_r c_r = x_r (real and complex parts)
+  LapackComplex x[8];
+  LapackComplex* c = x;
+  // pivot storage for lapack
+  int piv[8];
+  for (unsigned int j = 0; j < 64; ++j) {coeffA[j].real = coeffA[j].imag = 0;} 
+  #pragma omp simd
+  for (unsigned int j = 0; j < Nz; ++j) 
+  {
+    enkz[j] = exp(-k * z[j]);
+    ekzmh[j] = enkh / enkz[j];
+    zekzmh[j] = z[j] * ekzmh[j];
+    zenkz[j] = z[j] * enkz[j];
+    Cp_r[j] = Cp_i[j] = Cu_r[j] = Cu_i[j] = 0;
+    Cv_r[j] = Cv_i[j] = Cw_r[j] = Cw_i[j] = 0;
+  }
+  coeffA[at(0,0)].real = fac;
+  coeffA[at(0,1)].real = enkh * fac;
+  coeffA[at(0,6)].real = -k;
+  coeffA[at(0,7)].real = k * enkh;
+  coeffA[at(1,0)].real = (1 - k * H) * enkh * fac;
+  coeffA[at(1,1)].real = (1 + k * H) * fac;
+  coeffA[at(1,6)].real = -k * enkh;
+  coeffA[at(1,7)].real = k;
+  coeffA[at(2,2)].real = 1;
+  coeffA[at(2,3)].real = enkh;
+  coeffA[at(3,4)].real = 1;
+  coeffA[at(3,5)].real = enkh;
+  coeffA[at(4,6)].real = 1;
+  coeffA[at(4,7)].real = enkh;
+  coeffA[at(5,0)].imag = -kx * H * enkh * fac / k;
+  coeffA[at(5,1)].imag = kx * H * fac / k;
+  coeffA[at(5,2)].real = enkh;
+  coeffA[at(5,3)].real = 1;
+  coeffA[at(6,0)].imag = -ky * H * enkh * fac / k;
+  coeffA[at(6,1)].imag = ky * H * fac / k;
+  coeffA[at(6,4)].real = enkh;
+  coeffA[at(6,5)].real = 1;
+  coeffA[at(7,0)].real = H * enkh * fac;
+  coeffA[at(7,1)].real = H * fac;
+  coeffA[at(7,6)].real = enkh;
+  coeffA[at(7,7)].real = 1; 
+
+  x[0].real = kx * fbhat_i[0] + ky * fbhat_i[1];
+  x[0].imag = -kx * fbhat_r[0] - ky * fbhat_r[1]; 
+  x[1].real = kx * fthat_i[0] + ky * fthat_i[1];
+  x[1].imag = -kx * fthat_r[0] - ky * fthat_r[1]; 
+  x[2].real = fbhat_r[0]; x[2].imag = fbhat_i[0];
+  x[3].real = fbhat_r[1]; x[3].imag = fbhat_i[1];
+  x[4].real = fbhat_r[2]; x[4].imag = fbhat_i[2];
+  x[5].real = fthat_r[0]; x[5].imag = fthat_i[0];
+  x[6].real = fthat_r[1]; x[6].imag = fthat_i[1];
+  x[7].real = fthat_r[2]; x[7].imag = fthat_i[2];
+  // solve for coefficients of exponentials   
+  gesv(8, coeffA, piv, x);      
+  // correction for pressure
+  axpy(Nz, c[0].real, enkz, 1, Cp_r, 1);
+  axpy(Nz, c[1].real, ekzmh, 1, Cp_r, 1); 
+  axpy(Nz, c[0].imag, enkz, 1, Cp_i, 1);
+  axpy(Nz, c[1].imag, ekzmh, 1, Cp_i, 1); 
+  // correction for x vel
+  axpy(Nz, c[0].imag * kx * fac / k, zenkz, 1,Cu_r, 1);
+  axpy(Nz, -c[1].imag * kx * fac / k, zekzmh, 1, Cu_r, 1);
+  axpy(Nz, c[2].real, enkz, 1, Cu_r, 1);
+  axpy(Nz, c[3].real, ekzmh, 1, Cu_r, 1);
+  axpy(Nz, -c[0].real * kx * fac / k, zenkz, 1, Cu_i, 1);
+  axpy(Nz, c[1].real * kx * fac / k, zekzmh, 1, Cu_i, 1);
+  axpy(Nz, c[2].imag, enkz, 1, Cu_i, 1);
+  axpy(Nz, c[3].imag, ekzmh, 1, Cu_i, 1);
+  // correction for y vel
+  axpy(Nz, c[0].imag * ky * fac / k, zenkz, 1, Cv_r, 1);
+  axpy(Nz, -c[1].imag * ky * fac / k, zekzmh, 1, Cv_r, 1);
+  axpy(Nz, c[4].real, enkz, 1, Cv_r, 1);
+  axpy(Nz, c[5].real, ekzmh, 1, Cv_r, 1);
+  axpy(Nz, -c[0].real * ky * fac / k, zenkz, 1, Cv_i, 1);
+  axpy(Nz, c[1].real * ky * fac / k, zekzmh, 1, Cv_i, 1);
+  axpy(Nz, c[4].imag, enkz, 1, Cv_i, 1);
+  axpy(Nz, c[5].imag, ekzmh, 1, Cv_i, 1);
+  // correction for z vel
+  axpy(Nz, c[0].real * fac, zenkz, 1, Cw_r, 1);
+  axpy(Nz, c[1].real * fac, zekzmh, 1, Cw_r, 1);
+  axpy(Nz, c[6].real, enkz, 1, Cw_r, 1);
+  axpy(Nz, c[7].real, ekzmh, 1, Cw_r, 1);
+  axpy(Nz, c[0].imag * fac, zenkz, 1, Cw_i, 1);
+  axpy(Nz, c[1].imag * fac, zekzmh, 1, Cw_i, 1);
+  axpy(Nz, c[6].imag, enkz, 1, Cw_i, 1);
+  axpy(Nz, c[7].imag, ekzmh, 1, Cw_i, 1);
+  // forward transform in z to get cheb coeffs
+  chebTransformT<Real>(Cp_r, Cp_i, Cpcorr_r, Cpcorr_i, plan, Nz, work);
+  chebTransformT<Real>(Cu_r, Cu_i, Cucorr_r, Cucorr_i, plan, Nz, work);
+  chebTransformT<Real>(Cv_r, Cv_i, Cvcorr_r, Cvcorr_i, plan, Nz, work);
+  chebTransformT<Real>(Cw_r, Cw_i, Cwcorr_r, Cwcorr_i, plan, Nz, work);
+}
+
+namespace
+{
+  // single forward plan for the Chebyshev transforms of Nz points (see chebTransformT)
+  template<typename Real>
+  typename FFTW<Real>::plan chebPlan(unsigned int Nz)
+  {
+    typedef typename FFTW<Real>::complex Complex;
+    FFTW<Real>::init_threads();
+    FFTW<Real>::plan_with_nthreads(1);
+    Complex* in = (Complex*) alignedMalloc((2 * Nz - 2) * sizeof(Complex));
+    typename FFTW<Real>::plan fplan = FFTW<Real>::plan_dft_1d(2 * Nz - 2, in, in, FFTW_FORWARD, 
+                                                              FFTW_ESTIMATE);
+    alignedFree(in);
+    return fplan;
+  }
+
+  template<typename Real>
+  void evalCorrectionSol_bottomWallT(Real* Cpcorr_r, Real* Cpcorr_i, Real* Cucorr_r, 
+                                     Real* Cucorr_i, Real* Cvcorr_r, Real* Cvcorr_i,
+                                     Real* Cwcorr_r, Real* Cwcorr_i, const Real* fhat_r,
+                                     const Real* fhat_i, const Real* Kx, const Real* Ky, 
+                                     const Real* z, Real eta, unsigned int Nyx, 
+                                     unsigned int Nz, unsigned int dof)
+  {
+    // create single fftw forward plan for re-use in loop
+    typename FFTW<Real>::plan fplan = chebPlan<Real>(Nz);
+    #pragma omp parallel
+    {
+      Real* work = (Real*) alignedMalloc(correctionWorkSize(Nz) * sizeof(Real));
+      #pragma omp for
+      for (unsigned int i = 1; i < Nyx; ++i)
+      {
+        size_t offset = (size_t) i * Nz;
+        bottomWallCorrectionK<Real>(&(Cpcorr_r[offset]), &(Cpcorr_i[offset]), &(Cucorr_r[offset]),
+                                    &(Cucorr_i[offset]), &(Cvcorr_r[offset]), &(Cvcorr_i[offset]),
+                                    &(Cwcorr_r[offset]), &(Cwcorr_i[offset]), &(fhat_r[dof * i]),
+                                    &(fhat_i[dof * i]), Kx[i], Ky[i], z, eta, Nz, fplan, work);
+      }
+      alignedFree(work);
+    }
+    FFTW<Real>::destroy_plan(fplan);
+  }
+
+  template<typename Real>
+  void evalCorrectionSol_slitChannelT(Real* Cpcorr_r, Real* Cpcorr_i, Real* Cucorr_r, 
+                                      Real* Cucorr_i, Real* Cvcorr_r, Real* Cvcorr_i,
+                                      Real* Cwcorr_r, Real* Cwcorr_i, const Real* fbhat_r, 
+                                      const Real* fbhat_i, const Real* fthat_r, const Real* fthat_i, 
+                                      const Real* Kx, const Real* Ky, const Real* z, Real H, 
+                                      Real eta, unsigned int Nyx, unsigned int Nz, unsigned int dof)
+  {
+    // create single fftw forward plan for re-use in loop
+    typename FFTW<Real>::plan fplan = chebPlan<Real>(Nz);
+    #pragma omp parallel
+    {
+      Real* work = (Real*) alignedMalloc(correctionWorkSize(Nz) * sizeof(Real));
+      #pragma omp for
+      for (unsigned int i = 1; i < Nyx; ++i)
+      {
+        size_t offset = (size_t) i * Nz;
+        slitChannelCorrectionK<Real>(&(Cpcorr_r[offset]), &(Cpcorr_i[offset]), &(Cucorr_r[offset]),
+                                     &(Cucorr_i[offset]), &(Cvcorr_r[offset]), &(Cvcorr_i[offset]),
+                                     &(Cwcorr_r[offset]), &(Cwcorr_i[offset]), &(fbhat_r[dof * i]),
+                                     &(fbhat_i[dof * i]), &(fthat_r[dof * i]), &(fthat_i[dof * i]),
+                                     Kx[i], Ky[i], z, H, eta, Nz, fplan, work);
+      }
+      alignedFree(work);
+    }
+    FFTW<Real>::destroy_plan(fplan);
+  }
+}
 
 extern "C"
 {
@@ -16,7 +334,7 @@ extern "C"
       double* out_xy = &(out[dof * i]);
       for (unsigned int j = 0; j < Nz; ++j)
       {
-        const double* in_xyz = &(in[dof * (i + Nyx * j)]);
+        const double* in_xyz = &(in[dof * (i + (size_t) Nyx * j)]);
         double alpha = cos(j * theta);
         #pragma omp simd
         for (unsigned int l = 0; l < dof; ++l)
@@ -30,29 +348,9 @@ extern "C"
   void chebTransform(double* in_re, double* in_im, double* out_re, 
                      double* out_im, const fftw_plan plan, unsigned int N)
   {
-    unsigned int ext = 2 * N - 2;
-    fftw_complex* in = (fftw_complex*) fftw_malloc(ext * sizeof(fftw_complex));
-    for (unsigned int i = 0; i < N; ++i)
-    {
-      in[i][0] = in_re[i];
-      in[i][1] = in_im[i];
-    }
-    for (unsigned int i = N; i < ext; ++i)
-    {
-      in[i][0] = in_re[ext - i];
-      in[i][1] = in_im[ext - i];
-    }
-    fftw_execute_dft(plan, in, in);
-    out_re[0] = in[0][0] / ((double) ext); 
-    out_im[0] = in[0][1] / ((double) ext);
-    for (unsigned int i = 1; i < N - 1; ++i)
-    {
-      out_re[i] = (in[i][0] + in[ext - i][0]) / ((double) ext);
-      out_im[i] = (in[i][1] + in[ext - i][1]) / ((double) ext);
-    } 
-    out_re[N-1] = in[N-1][0] / ((double) ext);
-    out_im[N-1] = in[N-1][1] / ((double) ext);
-    fftw_free(in);
+    double* work = (double*) alignedMalloc(correctionWorkSize(N) * sizeof(double));
+    chebTransformT<double>(in_re, in_im, out_re, out_im, plan, N, work);
+    alignedFree(work);
   }
 
   void evalCorrectionSol_bottomWall(double* Cpcorr_r, double* Cpcorr_i, double* Cucorr_r, 
@@ -62,84 +360,9 @@ extern "C"
                                     const double* z, double eta, unsigned int Nyx, 
                                     unsigned int Nz, unsigned int dof)
   {
-    // create single fftw forward plan using tmp arrays
-    // for re-use in loop
-    fftw_init_threads();
-    fftw_plan_with_nthreads(1);
-    fftw_complex* in = (fftw_complex*) fftw_malloc((2 * Nz - 2) * sizeof(fftw_complex));
-    fftw_complex* out = in;
-    fftw_plan fplan = fftw_plan_dft_1d(2 * Nz - 2, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-    fftw_free(in);
-  
-    #pragma omp parallel for
-    for (unsigned int i = 1; i < Nyx; ++i)
-    {
-      unsigned int ix = dof * i, iy = ix + 1, iz = iy + 1;
-      double kx = Kx[i], ky = Ky[i], k = sqrt(kx * kx + ky * ky); 
-      double* enkz = (double*) fftw_malloc(Nz * sizeof(double));
-      double* zenkz = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cp_r = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cp_i = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cu_r = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cu_i = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cv_r = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cv_i = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cw_r = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cw_i = (double*) fftw_malloc(Nz * sizeof(double));
-      #pragma omp simd
-      for (unsigned int j = 0; j < Nz; ++j) 
-      {
-        enkz[j] = exp(-k * z[j]);
-        zenkz[j] = z[j] * enkz[j];
-        Cp_r[j] = Cp_i[j] = Cu_r[j] = Cu_i[j] = 0;
-        Cv_r[j] = Cv_i[j] = Cw_r[j] = Cw_i[j] = 0;
-      }
-      double alpha_r = kx * fhat_r[ix] + ky * fhat_r[iy] - k * fhat_i[iz];
-      double alpha_i = kx * fhat_i[ix] + ky * fhat_i[iy] + k * fhat_r[iz];
-      // correction for pressure
-      cblas_daxpy(Nz, 2.0 * eta * alpha_i, enkz, 1, Cp_r, 1);
-      cblas_daxpy(Nz, -2.0 * eta * alpha_r, enkz, 1, Cp_i, 1); 
-      // correction for x vel
-      cblas_daxpy(Nz, -kx * alpha_r / k, zenkz, 1, Cu_r, 1);      
-      cblas_daxpy(Nz, fhat_r[ix], enkz, 1, Cu_r, 1);
-      cblas_daxpy(Nz, -kx * alpha_i / k, zenkz, 1, Cu_i, 1);      
-      cblas_daxpy(Nz, fhat_i[ix], enkz, 1, Cu_i, 1);
-      // correction for y vel
-      cblas_daxpy(Nz, -ky * alpha_r / k, zenkz, 1, Cv_r, 1);      
-      cblas_daxpy(Nz, fhat_r[iy], enkz, 1, Cv_r, 1);
-      cblas_daxpy(Nz, -ky * alpha_i / k, zenkz, 1, Cv_i, 1);      
-      cblas_daxpy(Nz, fhat_i[iy], enkz, 1, Cv_i, 1);
-      // correction for z vel
-      cblas_daxpy(Nz, alpha_i, zenkz, 1, Cw_r, 1);
-      cblas_daxpy(Nz, fhat_r[iz], enkz, 1, Cw_r, 1); 
-      cblas_daxpy(Nz, -alpha_r, zenkz, 1, Cw_i, 1);
-      cblas_daxpy(Nz, fhat_i[iz], enkz, 1, Cw_i, 1);
-      // forward transform in z to get cheb coeffs
-      unsigned int offset = i * Nz;
-      chebTransform(Cp_r, Cp_i, &(Cpcorr_r[offset]), 
-                    &(Cpcorr_i[offset]), fplan, Nz);
-      chebTransform(Cu_r, Cu_i, &(Cucorr_r[offset]),
-                    &(Cucorr_i[offset]), fplan, Nz);
-      chebTransform(Cv_r, Cv_i, &(Cvcorr_r[offset]),
-                    &(Cvcorr_i[offset]), fplan, Nz);
-      chebTransform(Cw_r, Cw_i, &(Cwcorr_r[offset]),
-                    &(Cwcorr_i[offset]), fplan, Nz);
-      // clean
-      fftw_free(enkz);
-      fftw_free(zenkz);
-      fftw_free(Cp_r);  
-      fftw_free(Cp_i);  
-      fftw_free(Cu_r);  
-      fftw_free(Cu_i);  
-      fftw_free(Cv_r);  
-      fftw_free(Cv_i);  
-      fftw_free(Cw_r);  
-      fftw_free(Cw_i);  
-    }
-    fftw_destroy_plan(fplan);
+    evalCorrectionSol_bottomWallT(Cpcorr_r, Cpcorr_i, Cucorr_r, Cucorr_i, Cvcorr_r, Cvcorr_i,
+                                  Cwcorr_r, Cwcorr_i, fhat_r, fhat_i, Kx, Ky, z, eta, Nyx, Nz, dof);
   }
- 
-  inline unsigned int at(unsigned int i, unsigned int j){return i + 8 * j;}
 
   void evalCorrectionSol_slitChannel(double* Cpcorr_r, double* Cpcorr_i, double* Cucorr_r, 
                                      double* Cucorr_i, double* Cvcorr_r, double* Cvcorr_i,
@@ -148,156 +371,46 @@ extern "C"
                                      const double* Kx, const double* Ky, const double* z, double H, 
                                      double eta, unsigned int Nyx, unsigned int Nz, unsigned int dof)
   {
-    // create single fftw forward plan using tmp arrays
-    // for re-use in loop
-    fftw_init_threads();
-    fftw_plan_with_nthreads(1);
-    fftw_complex* in = (fftw_complex*) fftw_malloc((2 * Nz - 2) * sizeof(fftw_complex));
-    fftw_complex* out = in;
-    fftw_plan fplan = fftw_plan_dft_1d(2 * Nz - 2, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-    fftw_free(in);
-    double fac = 1.0 / 2.0 / eta;
-    #pragma omp parallel for
-    for (unsigned int i = 1; i < Nyx; ++i)
-    {
-      unsigned int ix = dof * i, iy = ix + 1, iz = iy + 1;
-      double kx = Kx[i], ky = Ky[i], k = sqrt(kx * kx + ky * ky);
-      // e^(-kz) 
-      double* enkz = (double*) fftw_malloc(Nz * sizeof(double));
-      // e^(k(z-H))
-      double* ekzmh = (double*) fftw_malloc(Nz * sizeof(double));
-      // ze^(k(z-H))
-      double* zekzmh = (double*) fftw_malloc(Nz * sizeof(double));
-      // e^(-kH)
-      double enkh = exp(-k * H);
-      // ze^(-kz)
-      double* zenkz = (double*) fftw_malloc(Nz * sizeof(double));
-      // real and imaginary components of pressure and vel
-      double* Cp_r = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cp_i = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cu_r = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cu_i = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cv_r = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cv_i = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cw_r = (double*) fftw_malloc(Nz * sizeof(double));
-      double* Cw_i = (double*) fftw_malloc(Nz * sizeof(double));
-      // matrix to solve for coeffs of exponentials in correction sol
-      lapack_complex_double* coeffA = (lapack_complex_double*) fftw_malloc(64 * sizeof(lapack_complex_double));
-      // right hand side of coeffA_r c_r = x_r (real and complex parts)
-      lapack_complex_double* x = (lapack_complex_double*) fftw_malloc(8 * sizeof(lapack_complex_double));
-      lapack_complex_double* c = x;
-      // pivot storage for lapack
-      int* piv = (int*) fftw_malloc(8 * sizeof(int));
-      #pragma omp simd
-      for (unsigned int j = 0; j < 64; ++j) {coeffA[j].real = coeffA[j].imag = 0;} 
-      #pragma omp simd
-      for (unsigned int j = 0; j < Nz; ++j) 
-      {
-        enkz[j] = exp(-k * z[j]);
-        ekzmh[j] = enkh / enkz[j];
-        zekzmh[j] = z[j] * ekzmh[j];
-        zenkz[j] = z[j] * enkz[j];
-        Cp_r[j] = Cp_i[j] = Cu_r[j] = Cu_i[j] = 0;
-        Cv_r[j] = Cv_i[j] = Cw_r[j] = Cw_i[j] = 0;
-      }
-      coeffA[at(0,0)].real = fac;
-      coeffA[at(0,1)].real = enkh * fac;
-      coeffA[at(0,6)].real = -k;
-      coeffA[at(0,7)].real = k * enkh;
-      coeffA[at(1,0)].real = (1 - k * H) * enkh * fac;
-      coeffA[at(1,1)].real = (1 + k * H) * fac;
-      coeffA[at(1,6)].real = -k * enkh;
-      coeffA[at(1,7)].real = k;
-      coeffA[at(2,2)].real = 1;
-      coeffA[at(2,3)].real = enkh;
-      coeffA[at(3,4)].real = 1;
-      coeffA[at(3,5)].real = enkh;
-      coeffA[at(4,6)].real = 1;
-      coeffA[at(4,7)].real = enkh;
-      coeffA[at(5,0)].imag = -kx * H * enkh * fac / k;
-      coeffA[at(5,1)].imag = kx * H * fac / k;
-      coeffA[at(5,2)].real = enkh;
-      coeffA[at(5,3)].real = 1;
-      coeffA[at(6,0)].imag = -ky * H * enkh * fac / k;
-      coeffA[at(6,1)].imag = ky * H * fac / k;
-      coeffA[at(6,4)].real = enkh;
-      coeffA[at(6,5)].real = 1;
-      coeffA[at(7,0)].real = H * enkh * fac;
-      coeffA[at(7,1)].real = H * fac;
-      coeffA[at(7,6)].real = enkh;
-      coeffA[at(7,7)].real = 1; 
+    evalCorrectionSol_slitChannelT(Cpcorr_r, Cpcorr_i, Cucorr_r, Cucorr_i, Cvcorr_r, Cvcorr_i,
+                                   Cwcorr_r, Cwcorr_i, fbhat_r, fbhat_i, fthat_r, fthat_i, 
+                                   Kx, Ky, z, H, eta, Nyx, Nz, dof);
+  }
 
-      x[0].real = kx * fbhat_i[ix] + ky * fbhat_i[iy];
-      x[0].imag = -kx * fbhat_r[ix] - ky * fbhat_r[iy]; 
-      x[1].real = kx * fthat_i[ix] + ky * fthat_i[iy];
-      x[1].imag = -kx * fthat_r[ix] - ky * fthat_r[iy]; 
-      x[2].real = fbhat_r[ix]; x[2].imag = fbhat_i[ix];
-      x[3].real = fbhat_r[iy]; x[3].imag = fbhat_i[iy];
-      x[4].real = fbhat_r[iz]; x[4].imag = fbhat_i[iz];
-      x[5].real = fthat_r[ix]; x[5].imag = fthat_i[ix];
-      x[6].real = fthat_r[iy]; x[6].imag = fthat_i[iy];
-      x[7].real = fthat_r[iz]; x[7].imag = fthat_i[iz];
-      // solve for coefficients of exponentials   
-      LAPACKE_zgesv(LAPACK_COL_MAJOR, 8, 1, coeffA, 8, piv, x, 8);      
-      // correction for pressure
-      cblas_daxpy(Nz, c[0].real, enkz, 1, Cp_r, 1);
-      cblas_daxpy(Nz, c[1].real, ekzmh, 1, Cp_r, 1); 
-      cblas_daxpy(Nz, c[0].imag, enkz, 1, Cp_i, 1);
-      cblas_daxpy(Nz, c[1].imag, ekzmh, 1, Cp_i, 1); 
-      // correction for x vel
-      cblas_daxpy(Nz, c[0].imag * kx * fac / k, zenkz, 1,Cu_r, 1);
-      cblas_daxpy(Nz, -c[1].imag * kx * fac / k, zekzmh, 1, Cu_r, 1);
-      cblas_daxpy(Nz, c[2].real, enkz, 1, Cu_r, 1);
-      cblas_daxpy(Nz, c[3].real, ekzmh, 1, Cu_r, 1);
-      cblas_daxpy(Nz, -c[0].real * kx * fac / k, zenkz, 1, Cu_i, 1);
-      cblas_daxpy(Nz, c[1].real * kx * fac / k, zekzmh, 1, Cu_i, 1);
-      cblas_daxpy(Nz, c[2].imag, enkz, 1, Cu_i, 1);
-      cblas_daxpy(Nz, c[3].imag, ekzmh, 1, Cu_i, 1);
-      // correction for y vel
-      cblas_daxpy(Nz, c[0].imag * ky * fac / k, zenkz, 1, Cv_r, 1);
-      cblas_daxpy(Nz, -c[1].imag * ky * fac / k, zekzmh, 1, Cv_r, 1);
-      cblas_daxpy(Nz, c[4].real, enkz, 1, Cv_r, 1);
-      cblas_daxpy(Nz, c[5].real, ekzmh, 1, Cv_r, 1);
-      cblas_daxpy(Nz, -c[0].real * ky * fac / k, zenkz, 1, Cv_i, 1);
-      cblas_daxpy(Nz, c[1].real * ky * fac / k, zekzmh, 1, Cv_i, 1);
-      cblas_daxpy(Nz, c[4].imag, enkz, 1, Cv_i, 1);
-      cblas_daxpy(Nz, c[5].imag, ekzmh, 1, Cv_i, 1);
-      // correction for z vel
-      cblas_daxpy(Nz, c[0].real * fac, zenkz, 1, Cw_r, 1);
-      cblas_daxpy(Nz, c[1].real * fac, zekzmh, 1, Cw_r, 1);
-      cblas_daxpy(Nz, c[6].real, enkz, 1, Cw_r, 1);
-      cblas_daxpy(Nz, c[7].real, ekzmh, 1, Cw_r, 1);
-      cblas_daxpy(Nz, c[0].imag * fac, zenkz, 1, Cw_i, 1);
-      cblas_daxpy(Nz, c[1].imag * fac, zekzmh, 1, Cw_i, 1);
-      cblas_daxpy(Nz, c[6].imag, enkz, 1, Cw_i, 1);
-      cblas_daxpy(Nz, c[7].imag, ekzmh, 1, Cw_i, 1);
-      // forward transform in z to get cheb coeffs
-      unsigned int offset = i * Nz;
-      chebTransform(Cp_r, Cp_i, &(Cpcorr_r[offset]), 
-                    &(Cpcorr_i[offset]), fplan, Nz);
-      chebTransform(Cu_r, Cu_i, &(Cucorr_r[offset]),
-                    &(Cucorr_i[offset]), fplan, Nz);
-      chebTransform(Cv_r, Cv_i, &(Cvcorr_r[offset]),
-                    &(Cvcorr_i[offset]), fplan, Nz);
-      chebTransform(Cw_r, Cw_i, &(Cwcorr_r[offset]),
-                    &(Cwcorr_i[offset]), fplan, Nz);
-      // clean
-      fftw_free(enkz);
-      fftw_free(ekzmh);
-      fftw_free(zekzmh);
-      fftw_free(zenkz);
-      fftw_free(Cp_r);  
-      fftw_free(Cp_i);  
-      fftw_free(Cu_r);  
-      fftw_free(Cu_i);  
-      fftw_free(Cv_r);  
-      fftw_free(Cv_i);  
-      fftw_free(Cw_r);  
-      fftw_free(Cw_i); 
-      fftw_free(coeffA);
-      fftw_free(x); 
-      fftw_free(piv);
-    }
-    fftw_destroy_plan(fplan);
+  void evalCorrectionSol_bottomWallF(float* Cpcorr_r, float* Cpcorr_i, float* Cucorr_r, 
+                                     float* Cucorr_i, float* Cvcorr_r, float* Cvcorr_i,
+                                     float* Cwcorr_r, float* Cwcorr_i, const float* fhat_r,
+                                     const float* fhat_i, const float* Kx, const float* Ky, 
+                                     const float* z, float eta, unsigned int Nyx, 
+                                     unsigned int Nz, unsigned int dof)
+  {
+    evalCorrectionSol_bottomWallT(Cpcorr_r, Cpcorr_i, Cucorr_r, Cucorr_i, Cvcorr_r, Cvcorr_i,
+                                  Cwcorr_r, Cwcorr_i, fhat_r, fhat_i, Kx, Ky, z, eta, Nyx, Nz, dof);
+  }
+
+  void evalCorrectionSol_slitChannelF(float* Cpcorr_r, float* Cpcorr_i, float* Cucorr_r, 
+                                      float* Cucorr_i, float* Cvcorr_r, float* Cvcorr_i,
+                                      float* Cwcorr_r, float* Cwcorr_i, const float* fbhat_r, 
+                                      const float* fbhat_i, const float* fthat_r, const float* fthat_i, 
+                                      const float* Kx, const float* Ky, const float* z, float H, 
+                                      float eta, unsigned int Nyx, unsigned int Nz, unsigned int dof)
+  {
+    evalCorrectionSol_slitChannelT(Cpcorr_r, Cpcorr_i, Cucorr_r, Cucorr_i, Cvcorr_r, Cvcorr_i,
+                                   Cwcorr_r, Cwcorr_i, fbhat_r, fbhat_i, fthat_r, fthat_i, 
+                                   Kx, Ky, z, H, eta, Nyx, Nz, dof);
   }
 }
+
+#define INSTANTIATE_DP_KERNELS(Real)                                                            \
+template void chebTransformT<Real>(const Real*, const Real*, Real*, Real*,                      \
+                                   const FFTW<Real>::plan, unsigned int, Real*);                \
+template void bottomWallCorrectionK<Real>(Real*, Real*, Real*, Real*, Real*, Real*, Real*,      \
+                                          Real*, const Real*, const Real*, Real, Real,          \
+                                          const Real*, Real, unsigned int,                      \
+                                          const FFTW<Real>::plan, Real*);                       \
+template void slitChannelCorrectionK<Real>(Real*, Real*, Real*, Real*, Real*, Real*, Real*,     \
+                                           Real*, const Real*, const Real*, const Real*,        \
+                                           const Real*, Real, Real, const Real*, Real, Real,    \
+                                           unsigned int, const FFTW<Real>::plan, Real*);
+
+INSTANTIATE_DP_KERNELS(double)
+INSTANTIATE_DP_KERNELS(float)
@@ -2,34 +2,48 @@
 #include<iomanip>
 #include<fftw3.h>
 #include<omp.h>
+#include<climits>
 #include"Grid.h"
 #include"exceptions.h"
+#include"Memory.h"
 #include"Quadrature.h"
 
-Grid::Grid() : fG(0), fG_unwrap(0), xG(0), yG(0), zG(0), firstn(0), 
-               nextn(0), number(0), Nx(0), Ny(0), Nz(0), Lx(0), 
-               Ly(0), Lz(0), hx(0), hy(0), hz(0), Nxeff(0), 
-               Nyeff(0), Nzeff(0), has_locator(false), 
-               dof(0), BCs(0), zG_wts(0), has_periodicity(false), 
-               has_bc(false), unifZ(false)
+Grid::Grid() : fG(0), fG_unwrap(0), xG(0), yG(0), zG(0), zG_wts(0), zG_ext(0), 
+               zG_ext_wts(0), fG_hat_r(0), fG_hat_i(0), fG_unwrap_f(0), firstn(0), 
+               nextn(0), number(0), Nx(0), Ny(0), Nz(0), dof(0), nrhs(1), Lx(0), 
+               Ly(0), Lz(0), hx(0), hy(0), hz(0), Nxeff(0), Nyeff(0), Nzeff(0), 
+               has_locator(false), has_bc(false), unifZ(false), single(false), 
+               pencil(false), planar(false), has_periodicity(false), BCs(0)
 {}
 
 void Grid::setup()
 {
-  // allocate interior grid
-  if (!this->fG) 
+  // allocate interior grid, or reuse it if it is large enough
+  const size_t bytes = (size_t) dof * Nx * Ny * Nz * sizeof(double);
+  if (alignedCapacity(this->fG) < bytes) 
   {
-    this->fG = (double*) fftw_malloc(dof * Nx * Ny * Nz * sizeof(double));
+    // the spectrum of the complex transforms is fG itself (see setupSpectral())
+    const bool aliased = fG_hat_r && fG_hat_r == fG;
+    this->fG = (double*) alignedReserve(this->fG, bytes);
+    if (aliased) {fG_hat_r = fG;}
+    this->touchGrid();
   }
   if (this->validState())
   {
-    // these will be added to when the grid is extended based on kernel widths
-    Nxeff = Nx; Nyeff = Ny; Nzeff = Nz;
-    if (hz > 0) unifZ = true;
+    // any particles must be located again for the new sizes
+    this->reset();
+    unifZ = (hz > 0);
   }
   else {exitErr("Grid is invalid.");}
 }
 
+void Grid::reset()
+{
+  // these will be added to when the grid is extended based on kernel widths
+  Nxeff = Nx; Nyeff = Ny; Nzeff = Nz;
+  has_locator = false;
+}
+
 void Grid::setL(const double Lx, const double Ly, const double Lz)
 {
   this->Lx = Lx;
@@ -59,7 +73,7 @@ void Grid::setPeriodicity(bool x, bool y, bool z)
 
 void Grid::setBCs(const BC* _BCs)
 {
-  this->BCs = (BC*) malloc(dof * 6 * sizeof(BC));
+  this->BCs = (BC*) alignedReserve(this->BCs, dof * 6 * sizeof(BC));
   for (unsigned int i = 0; i < 6 * dof; ++i)
   {
     this->BCs[i] = _BCs[i];
@@ -67,10 +81,76 @@ void Grid::setBCs(const BC* _BCs)
   this->has_bc = true; 
 }
 
+void Grid::setSinglePrecision(bool single)
+{
+  if (this->has_locator) 
+  {
+    exitErr("Precision must be set before the particles are located on the grid.");
+  }
+  this->single = single;
+}
+
+void Grid::setPencilLayout(bool pencil)
+{
+  if (this->has_locator) 
+  {
+    exitErr("Layout must be set before the particles are located on the grid.");
+  }
+  this->pencil = pencil;
+}
+
+void Grid::setPlanarLayout(bool planar)
+{
+  if (this->has_locator) 
+  {
+    exitErr("Layout must be set before the particles are located on the grid.");
+  }
+  this->planar = planar;
+}
+
+void Grid::setNumRHS(const unsigned int _nrhs)
+{
+  if (not _nrhs) {exitErr("Number of right-hand sides must be positive.");}
+  if (not dof || not this->has_bc)
+  {
+    exitErr("dof and BCs must be set before the number of right-hand sides.");
+  }
+  if (_nrhs == nrhs) return;
+  const unsigned int dof1 = dof / nrhs, dof_new = dof1 * _nrhs;
+  // replicate the BCs of the first vector for each rhs
+  BC* BCs_new = (BC*) alignedMalloc(6 * dof_new * sizeof(BC));
+  for (unsigned int end = 0; end < 6; ++end)
+  {
+    for (unsigned int r = 0; r < _nrhs; ++r)
+    {
+      for (unsigned int d = 0; d < dof1; ++d)
+      {
+        BCs_new[d + dof1 * r + end * dof_new] = BCs[d + end * dof];
+      }
+    }
+  }
+  alignedFree(BCs); BCs = BCs_new;
+  // reallocate interior and extended grids
+  if (fG) 
+  {
+    fG = (double*) alignedReserve(fG, (size_t) dof_new * Nx * Ny * Nz * sizeof(double));
+  }
+  if (fG_unwrap) 
+  {
+    fG_unwrap = (double*) alignedReserve(fG_unwrap, (size_t) dof_new * Nxeff * Nyeff * Nzeff * sizeof(double));
+  }
+  if (fG_unwrap_f) 
+  {
+    fG_unwrap_f = (float*) alignedReserve(fG_unwrap_f, (size_t) dof_new * Nxeff * Nyeff * Nzeff * sizeof(float));
+  }
+  this->dof = dof_new; this->nrhs = _nrhs;
+  this->touchGrid(); this->touchExtGrid();
+}
+
 void Grid::setZ(const double* zpts, const double* zwts)
 {
-  this->zG = (double*) fftw_malloc(Nz * sizeof(double));
-  this->zG_wts = (double*) fftw_malloc(Nz * sizeof(double));   
+  this->zG = (double*) alignedReserve(this->zG, Nz * sizeof(double));
+  this->zG_wts = (double*) alignedReserve(this->zG_wts, Nz * sizeof(double));   
   for (unsigned int i = 0; i < Nz; ++i)
   {
     this->zG[i] = zpts[i];
@@ -78,21 +158,77 @@ void Grid::setZ(const double* zpts, const double* zwts)
   }
 }
 
-void Grid::zeroExtGrid()
+bool Grid::largeIndex() const
+{
+  return (size_t) Nxeff * Nyeff * Nzeff * dof > UINT_MAX;
+}
+
+// zero the extended grid F by blocks of (x,y) columns. In parallel, each thread
+// gets the columns it spreads to/interpolates from (i outer, j inner, static)
+template<typename Real>
+void zeroColumns(Real* F, const Grid& grid, const bool parallel)
 {
-  if (this->fG_unwrap)
+  const unsigned int Nx = grid.Nxeff, Ny = grid.Nyeff, Nz = grid.Nzeff, dof = grid.dof;
+  const size_t Ne = (size_t) Nx * Ny * Nz;
+  #pragma omp parallel for collapse(2) schedule(static) if(parallel)
+  for (unsigned int i = 0; i < Nx; ++i)
   {
-    #pragma omp parallel for
-    for (unsigned int i = 0; i < Nxeff * Nyeff * Nzeff * dof; ++i)
+    for (unsigned int j = 0; j < Ny; ++j)
     {
-      fG_unwrap[i] = 0;
+      for (unsigned int k = 0; k < Nz; ++k)
+      {
+        const size_t pt = grid.pencil ? atExt<size_t, true>(i, j, k, Nx, Ny, Nz) : 
+                                        atExt<size_t, false>(i, j, k, Nx, Ny, Nz);
+        for (unsigned int d = 0; d < dof; ++d) 
+        {
+          F[grid.planar ? atDof<size_t, true>(d, pt, dof, Ne) : atDof<size_t, false>(d, pt, dof, Ne)] = 0;
+        }
+      }
     }
   }
+}
+
+void Grid::zeroExtGrid()
+{
+  if (this->fG_unwrap) {zeroColumns(fG_unwrap, *this, true);}
+  else if (this->fG_unwrap_f) {zeroColumns(fG_unwrap_f, *this, true);}
   else
   {
     exitErr("Extended grid has not been allocated.");
   }
 }
+
+void Grid::touchExtGrid()
+{
+  const Placement placement = getPlacement();
+  if (placement == no_touch) return;
+  if (this->fG_unwrap) {zeroColumns(fG_unwrap, *this, placement == first_touch);}
+  if (this->fG_unwrap_f) {zeroColumns(fG_unwrap_f, *this, placement == first_touch);}
+}
+
+void Grid::touchGrid()
+{
+  const Placement placement = getPlacement();
+  if (placement == no_touch or not this->fG) return;
+  // each thread gets the z-slab it folds into/copies from (k outer, static)
+  const size_t N = (size_t) Nx * Ny * Nz;
+  #pragma omp parallel for collapse(2) schedule(static) if(placement == first_touch)
+  for (unsigned int k = 0; k < Nz; ++k)
+  {
+    for (unsigned int j = 0; j < Ny; ++j)
+    {
+      for (unsigned int i = 0; i < Nx; ++i)
+      {
+        const size_t pt = i + Nx * (j + (size_t) Ny * k);
+        for (unsigned int d = 0; d < dof; ++d) 
+        {
+          fG[planar ? atDof<size_t, true>(d, pt, dof, N) : atDof<size_t, false>(d, pt, dof, N)] = 0;
+        }
+      }
+    }
+  }
+}
+
 void Grid::makeTP(const double Lx, const double Ly, const double Lz, 
                   const double hx, const double hy, const double hz,
                   const unsigned int Nx, const unsigned int Ny, 
@@ -101,10 +237,11 @@ void Grid::makeTP(const double Lx, const double Ly, const double Lz,
   this->Lx = Lx; this->Ly = Ly; this->Lz = Lz;
   this->Nx = Nx; this->Ny = Ny; this->Nz = Nz;
   this->hx = hx; this->hy = hy; this->hz = hz;
-  this->dof = dof;
-  this->fG = (double*) fftw_malloc(dof * Nx * Ny * Nz * sizeof(double));
+  this->dof = dof; this->nrhs = 1;
+  this->fG = (double*) alignedReserve(this->fG, (size_t) dof * Nx * Ny * Nz * sizeof(double));
+  this->touchGrid();
   this->isperiodic[0] = this->isperiodic[1] = this->isperiodic[2] = true;
-  this->BCs = (BC*) malloc(6 * dof * sizeof(BC));
+  this->BCs = (BC*) alignedReserve(this->BCs, 6 * dof * sizeof(BC));
   for (unsigned int i = 0; i < 6 * dof; ++i)
   {
     this->BCs[i] = none;
@@ -120,13 +257,14 @@ void Grid::makeDP(const double Lx, const double Ly, const double Lz,
   this->Lx = Lx; this->Ly = Ly; this->Lz = Lz;
   this->Nx = Nx; this->Ny = Ny; this->Nz = Nz;
   this->hx = hx; this->hy = hy; 
-  this->dof = dof;
-  this->fG = (double*) fftw_malloc(dof * Nx * Ny * Nz * sizeof(double));
-  this->zG = (double*) fftw_malloc(Nz * sizeof(double));
-  this->zG_wts = (double*) fftw_malloc(Nz * sizeof(double)); 
+  this->dof = dof; this->nrhs = 1;
+  this->fG = (double*) alignedReserve(this->fG, (size_t) dof * Nx * Ny * Nz * sizeof(double));
+  this->touchGrid();
+  this->zG = (double*) alignedReserve(this->zG, Nz * sizeof(double));
+  this->zG_wts = (double*) alignedReserve(this->zG_wts, Nz * sizeof(double)); 
   clencurt(zG, zG_wts, 0., Lz, Nz);
   this->isperiodic[0] = this->isperiodic[1] = true; this->isperiodic[2] = false;
-  this->BCs = (BC*) malloc(6 * dof * sizeof(BC));
+  this->BCs = (BC*) alignedReserve(this->BCs, 6 * dof * sizeof(BC));
   for (unsigned int i = 0; i < 6 * dof; ++i)
   {
     this->BCs[i] = none;
@@ -135,28 +273,73 @@ void Grid::makeDP(const double Lx, const double Ly, const double Lz,
   this->setup();
 }
 
+void Grid::setupSpectral(const bool real)
+{
+  if (not fG) {exitErr("Grid must be set up before its spectrum.");}
+  const size_t N = (size_t) dof * Ny * Nz * (real ? Nx / 2 + 1 : Nx);
+  if (real)
+  {
+    if (fG_hat_r == fG) {fG_hat_r = 0;}
+    fG_hat_r = (double*) alignedReserve(fG_hat_r, N * sizeof(double));
+  }
+  else
+  {
+    if (fG_hat_r != fG) {alignedFree(fG_hat_r);}
+    fG_hat_r = fG;
+  }
+  fG_hat_i = (double*) alignedReserve(fG_hat_i, N * sizeof(double));
+  if (!fG_hat_r || !fG_hat_i) {exitErr("alloc failed in Grid::setupSpectral()");}
+}
+
 void Grid::cleanup()
 {
   if (this->validState())
   {
-    if (fG_unwrap) {fftw_free(fG_unwrap); fG_unwrap = 0;}
-    if (firstn) {fftw_free(firstn); firstn = 0;}
-    if (nextn) {fftw_free(nextn); nextn = 0;}
-    if (number) {fftw_free(number); number = 0;}
-    if (fG) {fftw_free(fG); fG = 0;}
-    if (zG) {fftw_free(zG); zG = 0;}
-    if (zG_wts) {fftw_free(zG_wts); zG_wts = 0;}
+    if (fG_unwrap) {alignedFree(fG_unwrap); fG_unwrap = 0;}
+    if (fG_unwrap_f) {alignedFree(fG_unwrap_f); fG_unwrap_f = 0;}
+    if (firstn) {alignedFree(firstn); firstn = 0;}
+    if (nextn) {alignedFree(nextn); nextn = 0;}
+    if (number) {alignedFree(number); number = 0;}
+    if (fG_hat_r && fG_hat_r != fG) {alignedFree(fG_hat_r);}
+    if (fG_hat_i) {alignedFree(fG_hat_i);}
+    fG_hat_r = fG_hat_i = 0;
+    if (fG) {alignedFree(fG); fG = 0;}
+    if (zG) {alignedFree(zG); zG = 0;}
+    if (zG_wts) {alignedFree(zG_wts); zG_wts = 0;}
+    if (zG_ext) {alignedFree(zG_ext); zG_ext = 0;}
+    if (zG_ext_wts) {alignedFree(zG_ext_wts); zG_ext_wts = 0;}
+    if (BCs) {alignedFree(BCs); BCs = 0;}
+    this->ghost = GhostExchange();
   }
   else {exitErr("Could not clean up grid.");}
 }
 
 
+MemoryReport Grid::memoryReport() const
+{
+  MemoryReport report;
+  addBuffer(report, "grid.fG", fG);
+  if (fG_hat_r != fG) {addBuffer(report, "grid.fG_hat_r", fG_hat_r);}
+  addBuffer(report, "grid.fG_hat_i", fG_hat_i);
+  addBuffer(report, "grid.fG_unwrap", fG_unwrap);
+  addBuffer(report, "grid.fG_unwrap_f", fG_unwrap_f);
+  addBuffer(report, "grid.firstn", firstn);
+  addBuffer(report, "grid.number", number);
+  addBuffer(report, "grid.nextn", nextn);
+  addBuffer(report, "grid.BCs", BCs);
+  addBuffer(report, "grid.zG", zG);
+  addBuffer(report, "grid.zG_wts", zG_wts);
+  addBuffer(report, "grid.zG_ext", zG_ext);
+  addBuffer(report, "grid.zG_ext_wts", zG_ext_wts);
+  return report;
+}
+
 void Grid::writeGrid(std::ostream& outputStream) const
 {
   if (this->validState() && outputStream.good()) 
   {
-    const int N = Nx * Ny * Nz; 
-    for (unsigned int i = 0; i < N; ++i)
+    const size_t N = (size_t) Nx * Ny * Nz; 
+    for (size_t i = 0; i < N; ++i)
     {
       for (unsigned int j = 0; j < this->dof; ++j)
       {
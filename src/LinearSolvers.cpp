@@ -1,143 +1,293 @@
 #include <lapacke.h>
 #include <cblas.h>
 #include <omp.h>
+#include <math.h>
+#include <limits>
+#include "LinearSolvers.h"
+#include "Memory.h"
 
-extern "C"
+/* The solvers are templated on the precision, with the LAPACK and BLAS
+   routines of each precision (d* for double, s* for float) picked by overloading */
+namespace
+{
+  inline void gbsv(int n, int kl, int ku, int nrhs, double* ab, int ldab, int* ipiv, double* b, int ldb)
+  {
+    LAPACKE_dgbsv_work(LAPACK_COL_MAJOR, n, kl, ku, nrhs, ab, ldab, ipiv, b, ldb);
+  }
+  inline void gbsv(int n, int kl, int ku, int nrhs, float* ab, int ldab, int* ipiv, float* b, int ldb)
+  {
+    LAPACKE_sgbsv_work(LAPACK_COL_MAJOR, n, kl, ku, nrhs, ab, ldab, ipiv, b, ldb);
+  }
+  inline void gbtrs(int n, int kl, int ku, int nrhs, const double* ab, int ldab, const int* ipiv, double* b)
+  {
+    LAPACKE_dgbtrs_work(LAPACK_COL_MAJOR, 'N', n, kl, ku, nrhs, ab, ldab, ipiv, b, n);
+  }
+  inline void gbtrs(int n, int kl, int ku, int nrhs, const float* ab, int ldab, const int* ipiv, float* b)
+  {
+    LAPACKE_sgbtrs_work(LAPACK_COL_MAJOR, 'N', n, kl, ku, nrhs, ab, ldab, ipiv, b, n);
+  }
+  // c = alpha * a * b + beta * c, with a m x k and b k x n (column major)
+  inline void gemm(int m, int n, int k, double alpha, const double* a, int lda,
+                   const double* b, int ldb, double beta, double* c, int ldc)
+  {
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+  }
+  inline void gemm(int m, int n, int k, float alpha, const float* a, int lda,
+                   const float* b, int ldb, float beta, float* c, int ldc)
+  {
+    cblas_sgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+  }
+}
+
+template<typename Real>
+void precomputeBandedLinOpsT(Real* A, Real* B, Real* C, Real* D, Real* G, Real* G_inv,
+                             int* PIV, int kl, int ku, int Nyx, int Nz)
 {
-  /* compute LU of banded matrix A as well as X in AX = B
-     A is overwritten with LU info on output, and B is 
-     overwritten with X. */
-  void precomputeBandedLinOps(double* A, double* B, double* C, 
-                              double* D, double* G, double* G_inv, int* PIV, int kl, 
-                              int ku, int Nyx, int Nz) 
-  {
-    int nrhs = 2, ldab = 2 * kl + ku + 1;
-    #pragma omp parallel for
-    for (unsigned int i = 1; i < Nyx; ++i)
+  int nrhs = 2, ldab = 2 * kl + ku + 1;
+  #pragma omp parallel for
+  for (int i = 1; i < Nyx; ++i)
+  {
+    size_t offset_a = (size_t) ldab * Nz * i;
+    size_t offset_bc = (size_t) nrhs * Nz * i;
+    size_t offset_dg = (size_t) nrhs * nrhs * i;
+    size_t offset_p = (size_t) Nz * i;
+    Real* ab = &(A[offset_a]);
+    Real* b = &(B[offset_bc]);
+    Real* c = &(C[offset_bc]);
+    Real* d = &(D[offset_dg]);
+    Real* g = &(G[offset_dg]);
+    Real* g_inv = &(G_inv[offset_dg]);
+    int* ipiv = &(PIV[offset_p]);
+    // ab is overwritten with LU of ab
+    // b is overwritten with ab^-1 b
+    gbsv(Nz, kl, ku, nrhs, ab, ldab, ipiv, b, Nz);
+    gemm(nrhs, nrhs, Nz, 1, c, nrhs, b, Nz, 0, g, nrhs);
+    g[0] -= d[0]; g[1] -= d[1]; g[2] -= d[2]; g[3] -= d[3];
+    Real det = 1 / (g[0] * g[3] - g[2] * g[1]);
+    g_inv[0] = g[3] * det;
+    g_inv[1] = -g[1] * det;
+    g_inv[2] = -g[2] * det;
+    g_inv[3] = g[0] * det;
+  }
+}
+
+template<typename Real>
+void schurCorrectK(Real* rhs, const Real* bc_rhs, const Real* c, const Real* ginv,
+                   const Real* ainvb, const Real* SIMat, const Real* FIMat, Real* x, Real* cp,
+                   Real* dp, int Nz, int nrhs)
+{
+  const int ldx = Nz + 2;
+  // compute y = c*lu^{-1}*rhs - (alpha,beta) (2 x nrhs) into the last two rows of x
+  gemm(2, nrhs, Nz, 1, c, 2, rhs, Nz, 0, x + Nz, ldx);
+  for (int r = 0; r < nrhs; ++r)
+  {
+    Real* y = x + (size_t) ldx * r + Nz;
+    if (bc_rhs) {y[0] -= bc_rhs[2 * r]; y[1] -= bc_rhs[2 * r + 1];}
+    // compute g^{-1}*y
+    const Real y0 = y[0], y1 = y[1];
+    y[0] = ginv[0] * y0 + ginv[2] * y1;
+    y[1] = ginv[1] * y0 + ginv[3] * y1;
+  }
+  // compute lu^{-1}*rhs - lu^{-1}*b*g^{-1}*y and save into rhs
+  gemm(Nz, nrhs, 2, -1, ainvb, Nz, x + Nz, ldx, 1, rhs, Nz);
+  // copy into x
+  for (int r = 0; r < nrhs; ++r)
+  {
+    for (int j = 0; j < Nz; ++j) {x[(size_t) ldx * r + j] = rhs[(size_t) Nz * r + j];}
+  }
+  // compute sol and its derivative
+  gemm(Nz, nrhs, ldx, 1, SIMat, Nz, x, ldx, 0, cp, Nz);
+  if (dp) {gemm(Nz, nrhs, ldx, 1, FIMat, Nz, x, ldx, 0, dp, Nz);}
+}
+
+template<typename Real>
+void bandedSchurSolveK(const Real* lu, Real* rhs, const Real* bc_rhs, const int* piv,
+                       const Real* c, const Real* ginv, const Real* ainvb, const Real* SIMat,
+                       const Real* FIMat, Real* x, Real* cp, Real* dp, int kl, int ku, int Nz,
+                       int nrhs)
+{
+  // compute lu^{-1}*rhs, for all the right-hand sides in one call
+  gbtrs(Nz, kl, ku, nrhs, lu, 2 * kl + ku + 1, piv, rhs);
+  schurCorrectK(rhs, bc_rhs, c, ginv, ainvb, SIMat, FIMat, x, cp, dp, Nz, nrhs);
+}
+
+template<typename Real>
+unsigned int pentaFactorT(const Real* ab, size_t stride, int nlanes, Real* F, int Nz)
+{
+  const int W = PentaLanes<Real>::W, kl = 2, ku = 2, ldab = 2 * kl + ku + 1;
+  const double tol = sqrt(std::numeric_limits<Real>::epsilon());
+  unsigned int fallback = 0;
+  for (int l = 0; l < W; ++l)
+  {
+    const Real* a = ab + stride * l;
+    // u0 (not inverted), u1 and u2 of the rows j - 2 and j - 1
+    double u0m2 = 1, u1m2 = 0, u2m2 = 0, u0m1 = 1, u1m1 = 0, u2m1 = 0;
+    for (int j = 0; j < Nz; ++j)
     {
-      unsigned int offset_a = ldab * Nz * i;
-      unsigned int offset_bc = nrhs * Nz * i;
-      unsigned int offset_dg = nrhs * nrhs * i;
-      unsigned int offset_p = Nz * i;
-      double* ab = &(A[offset_a]);
-      double* b = &(B[offset_bc]);
-      double* c = &(C[offset_bc]);
-      double* d = &(D[offset_dg]);
-      double* g = &(G[offset_dg]);
-      double* g_inv = &(G_inv[offset_dg]);
-      int* ipiv = &(PIV[offset_p]);
-      // ab is overwritten with LU of ab
-      // b is overwritten with ab^-1 b
-      LAPACKE_dgbsv_work(LAPACK_COL_MAJOR, Nz, kl, ku, nrhs, ab, ldab, ipiv, b, Nz);
-      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
-                  nrhs, nrhs, Nz, 1.0, c, nrhs, b, Nz, 0.0, g, nrhs);
-      g[0] -= d[0]; g[1] -= d[1]; g[2] -= d[2]; g[3] -= d[3];
-      double det = 1.0 / (g[0] * g[3] - g[2] * g[1]);
-      g_inv[0] = g[3] * det;
-      g_inv[1] = -g[1] * det;
-      g_inv[2] = -g[2] * det;
-      g_inv[3] = g[0] * det; 
+      // A(j, j - 2),...,A(j, j + 2) (the identity in the unused lanes)
+      double e[5] = {0, 0, (double) (l >= nlanes), 0, 0}, row = 0;
+      for (int k = (j > kl ? j - kl : 0); l < nlanes && k < Nz && k <= j + ku; ++k)
+      {
+        e[k - j + kl] = a[kl + ku + j - k + (size_t) ldab * k];
+      }
+      for (int k = 0; k < 5; ++k) {row += fabs(e[k]);}
+      const double l2 = j >= 2 ? e[0] / u0m2 : 0;
+      const double b = e[1] - l2 * u1m2, c = e[2] - l2 * u2m2;
+      const double l1 = j >= 1 ? b / u0m1 : 0;
+      const double u0 = c - l1 * u1m1, u1 = e[3] - l1 * u2m1, u2 = e[4];
+      // no pivoting is only safe if the pivots stay of the order of the rows of A
+      if (not (fabs(u0) > tol * row) || not std::isfinite(u0 + l1 + l2)) {fallback |= 1u << l;}
+      Real* f = F + (size_t) 5 * W * j + l;
+      f[0] = l2; f[W] = l1; f[2 * W] = 1 / u0; f[3 * W] = u1; f[4 * W] = u2;
+      u0m2 = u0m1; u1m2 = u1m1; u2m2 = u2m1; u0m1 = u0; u1m1 = u1; u2m1 = u2;
     }
   }
+  return fallback;
+}
 
-  /* Use the precomputed LU of banded matrix A to solve AX = RHS.
-     RHS is overwritten with X */ 
-  void bandedSchurSolve(double* LU, double* RHS, int* PIV, double* C, double* GINV, double* AINVB,
-                        double* FIMat, double* SIMat, double* Cp, double* Dp, int kl, int ku, int Nyx, int Nz)
+template<typename Real>
+void pentaSolveT(const Real* F, Real* X, int Nz, int nrhs)
+{
+  const int W = PentaLanes<Real>::W;
+  for (int r = 0; r < nrhs; ++r)
   {
-    int nrhs = 1, nrhs1 = 2, ldab = 2 * kl + ku + 1;
-    #pragma omp parallel for
-    for (unsigned int i = 1; i < Nyx; ++i)
+    Real* x = X + (size_t) Nz * W * r;
+    // forward substitution, x_j -= l1_j x_{j-1} + l2_j x_{j-2} (l2_1 = 0)
+    for (int j = 1; j < Nz; ++j)
+    {
+      const Real* f = F + (size_t) 5 * W * j;
+      Real *xj = x + (size_t) W * j;
+      const Real *xm1 = xj - W, *xm2 = x + (size_t) W * (j > 1 ? j - 2 : 0);
+      #pragma omp simd
+      for (int l = 0; l < W; ++l) {xj[l] -= f[W + l] * xm1[l] + f[l] * xm2[l];}
+    }
+    // back substitution, x_j = (x_j - u1_j x_{j+1} - u2_j x_{j+2}) / u0_j
+    // (u1 and u2 are 0 past the last row)
+    for (int j = Nz - 1; j >= 0; --j)
     {
-      unsigned int offset_lu = ldab * Nz * i;
-      unsigned int offset_rhs = Nz * i;
-      unsigned int offset_bc = 2 * Nz * i;
-      unsigned int offset_p = Nz * i;
-      unsigned int offset_g = 2 * 2 * i;
-      double* lu = &(LU[offset_lu]);
-      int* ipiv = &(PIV[offset_p]);
-      double* rhs = &(RHS[offset_rhs]);
-      double* c = &(C[offset_bc]);
-      double* ainvb = &(AINVB[offset_bc]);
-      double* ginv = &(GINV[offset_g]);
-      double* cp = &(Cp[offset_rhs]);
-      double* dp = &(Dp[offset_rhs]);
-      double* x = (double*) malloc((Nz + 2) * sizeof(double));
-      double* y = (double*) malloc(2 * sizeof(double));
-      // compute lu^{-1}*rhs
-      LAPACKE_dgbtrs_work(LAPACK_COL_MAJOR, 'N', Nz, kl, ku,
-                          1, lu, ldab, ipiv, rhs, Nz); 
-      // compute  c*lu^{-1}*rhs (2x1)
-      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
-                  2, 1, Nz, 1.0, c, 2, rhs, Nz, 0.0, y, 2);
-      // compute g^{-1}*(c*lu^{-1}*rhs)  (2 x 1)
-      y[0] = ginv[0] * y[0] + ginv[2] * y[1];
-      y[1] = ginv[1] * y[0] + ginv[3] * y[1];
-      // compute lu^{-1}*rhs - lu^{-1}*b*y and save into rhs
-      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
-                  Nz, 1, 2, -1.0, ainvb, Nz, y, 2, 1.0, rhs, Nz);
-      // copy into x
-      for (unsigned int j = 0; j < Nz; ++j){x[j] = rhs[j];}
-      x[Nz] = y[0]; x[Nz+1] = y[1];
-      // compute sol and its derivative
-      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, 
-                  Nz, 1, Nz + 2, 1.0, SIMat, Nz, x, Nz + 2, 0.0, cp, Nz); 
-      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, 
-                  Nz, 1, Nz + 2, 1.0, FIMat, Nz, x, Nz + 2, 0.0, dp, Nz); 
-      free(x);
-      free(y);
+      const Real* f = F + (size_t) 5 * W * j;
+      Real *xj = x + (size_t) W * j;
+      const Real *xp1 = x + (size_t) W * (j + 1 < Nz ? j + 1 : j);
+      const Real *xp2 = x + (size_t) W * (j + 2 < Nz ? j + 2 : j);
+      #pragma omp simd
+      for (int l = 0; l < W; ++l)
+      {
+        xj[l] = (xj[l] - f[3 * W + l] * xp1[l] - f[4 * W + l] * xp2[l]) * f[2 * W + l];
+      }
     }
   }
+}
 
-  /* Use the precomputed LU of banded matrix A to solve AX = RHS.
-     RHS is overwritten with X */ 
-  void bandedSchurSolve_noD(double* LU, double* RHS, double* bc_RHS, int* PIV, 
-                            double* C, double* GINV, double* AINVB, double* SIMat, 
-                            double* Cp, int kl, int ku, int Nyx, int Nz)
+namespace
+{
+  /* bandedSchurSolveK for each wave number but the first, with the nrhs right-hand sides
+     of a wave number (and their solutions) stored contiguously, as Nz x nrhs. bc_RHS
+     (2 x nrhs per wave number) and Dp may be 0, and x is allocated once per thread */
+  template<typename Real>
+  void bandedSchurSolveBatchedT(Real* LU, Real* RHS, Real* bc_RHS, int* PIV, Real* C,
+                                Real* GINV, Real* AINVB, Real* FIMat, Real* SIMat, Real* Cp,
+                                Real* Dp, int kl, int ku, int Nyx, int Nz, int nrhs)
   {
-    int nrhs = 1, nrhs1 = 2, ldab = 2 * kl + ku + 1;
-    #pragma omp parallel for
-    for (unsigned int i = 1; i < Nyx; ++i)
+    int ldab = 2 * kl + ku + 1;
+    #pragma omp parallel
     {
-      unsigned int offset_lu = ldab * Nz * i;
-      unsigned int offset_rhs = Nz * i;
-      unsigned int offset_bc = 2 * Nz * i;
-      unsigned int offset_p = Nz * i;
-      unsigned int offset_g = 2 * 2 * i;
-      unsigned int offset_g1 = 2 * i;
-      double* lu = &(LU[offset_lu]);
-      int* ipiv = &(PIV[offset_p]);
-      double* rhs = &(RHS[offset_rhs]);
-      double* c = &(C[offset_bc]);
-      double* ainvb = &(AINVB[offset_bc]);
-      double* ginv = &(GINV[offset_g]);
-      double* bc_rhs = &(bc_RHS[offset_g1]);
-      double* cp = &(Cp[offset_rhs]);
-      double* x = (double*) malloc((Nz + 2) * sizeof(double));
-      double* y = (double*) malloc(2 * sizeof(double));
-      // compute lu^{-1}*rhs
-      LAPACKE_dgbtrs_work(LAPACK_COL_MAJOR, 'N', Nz, kl, ku,
-                          1, lu, ldab, ipiv, rhs, Nz); 
-      // compute  c*lu^{-1}*rhs (2x1)
-      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
-                  2, 1, Nz, 1.0, c, 2, rhs, Nz, 0.0, y, 2);
-      // compute g^{-1}*(c*lu^{-1}*rhs - (alpha,beta))  (2 x 1)
-      y[0] = ginv[0] * (y[0] - bc_RHS[0]) + ginv[2] * (y[1] - bc_RHS[1]);
-      y[1] = ginv[1] * (y[0] - bc_RHS[0]) + ginv[3] * (y[1] - bc_RHS[1]);
-      // compute lu^{-1}*rhs - lu^{-1}*b*y and save into rhs
-      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans,
-                  Nz, 1, 2, -1.0, ainvb, Nz, y, 2, 1.0, rhs, Nz);
-      // copy into x
-      for (unsigned int j = 0; j < Nz; ++j){x[j] = rhs[j];}
-      x[Nz] = y[0]; x[Nz+1] = y[1];
-      // compute sol and its derivative
-      cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, 
-                  Nz, 1, Nz + 2, 1.0, SIMat, Nz, x, Nz + 2, 0.0, cp, Nz); 
-
-      free(x);
-      free(y);
+      Real* x = (Real*) alignedMalloc((size_t) (Nz + 2) * nrhs * sizeof(Real));
+      #pragma omp for
+      for (int i = 1; i < Nyx; ++i)
+      {
+        size_t offset_lu = (size_t) ldab * Nz * i;
+        size_t offset_rhs = (size_t) Nz * nrhs * i;
+        size_t offset_bc = (size_t) 2 * Nz * i;
+        size_t offset_g = (size_t) 2 * 2 * i;
+        Real* bc = bc_RHS ? &(bc_RHS[(size_t) 2 * nrhs * i]) : 0;
+        Real* dp = Dp ? &(Dp[offset_rhs]) : 0;
+        bandedSchurSolveK<Real>(&(LU[offset_lu]), &(RHS[offset_rhs]), bc, &(PIV[(size_t) Nz * i]),
+                                &(C[offset_bc]), &(GINV[offset_g]), &(AINVB[offset_bc]), SIMat,
+                                FIMat, x, &(Cp[offset_rhs]), dp, kl, ku, Nz, nrhs);
+      }
+      alignedFree(x);
     }
   }
+}
+
+extern "C"
+{
+  void precomputeBandedLinOps(double* A, double* B, double* C,
+                              double* D, double* G, double* G_inv, int* PIV, int kl,
+                              int ku, int Nyx, int Nz)
+  {
+    precomputeBandedLinOpsT(A, B, C, D, G, G_inv, PIV, kl, ku, Nyx, Nz);
+  }
 
+  void bandedSchurSolve(double* LU, double* RHS, int* PIV, double* C, double* GINV, double* AINVB,
+                        double* FIMat, double* SIMat, double* Cp, double* Dp, int kl, int ku, int Nyx, int Nz)
+  {
+    bandedSchurSolveBatchedT(LU, RHS, (double*) 0, PIV, C, GINV, AINVB, FIMat, SIMat, Cp, Dp,
+                             kl, ku, Nyx, Nz, 1);
+  }
 
+  void bandedSchurSolve_noD(double* LU, double* RHS, double* bc_RHS, int* PIV,
+                            double* C, double* GINV, double* AINVB, double* SIMat,
+                            double* Cp, int kl, int ku, int Nyx, int Nz)
+  {
+    bandedSchurSolveBatchedT(LU, RHS, bc_RHS, PIV, C, GINV, AINVB, (double*) 0, SIMat, Cp,
+                             (double*) 0, kl, ku, Nyx, Nz, 1);
+  }
+
+  void bandedSchurSolveBatched(double* LU, double* RHS, double* bc_RHS, int* PIV, double* C,
+                               double* GINV, double* AINVB, double* FIMat, double* SIMat,
+                               double* Cp, double* Dp, int kl, int ku, int Nyx, int Nz, int nrhs)
+  {
+    bandedSchurSolveBatchedT(LU, RHS, bc_RHS, PIV, C, GINV, AINVB, FIMat, SIMat, Cp, Dp,
+                             kl, ku, Nyx, Nz, nrhs);
+  }
+
+  void precomputeBandedLinOpsF(float* A, float* B, float* C,
+                               float* D, float* G, float* G_inv, int* PIV, int kl,
+                               int ku, int Nyx, int Nz)
+  {
+    precomputeBandedLinOpsT(A, B, C, D, G, G_inv, PIV, kl, ku, Nyx, Nz);
+  }
+
+  void bandedSchurSolveF(float* LU, float* RHS, int* PIV, float* C, float* GINV, float* AINVB,
+                         float* FIMat, float* SIMat, float* Cp, float* Dp, int kl, int ku, int Nyx, int Nz)
+  {
+    bandedSchurSolveBatchedT(LU, RHS, (float*) 0, PIV, C, GINV, AINVB, FIMat, SIMat, Cp, Dp,
+                             kl, ku, Nyx, Nz, 1);
+  }
+
+  void bandedSchurSolve_noDF(float* LU, float* RHS, float* bc_RHS, int* PIV,
+                             float* C, float* GINV, float* AINVB, float* SIMat,
+                             float* Cp, int kl, int ku, int Nyx, int Nz)
+  {
+    bandedSchurSolveBatchedT(LU, RHS, bc_RHS, PIV, C, GINV, AINVB, (float*) 0, SIMat, Cp,
+                             (float*) 0, kl, ku, Nyx, Nz, 1);
+  }
+
+  void bandedSchurSolveBatchedF(float* LU, float* RHS, float* bc_RHS, int* PIV, float* C,
+                                float* GINV, float* AINVB, float* FIMat, float* SIMat,
+                                float* Cp, float* Dp, int kl, int ku, int Nyx, int Nz, int nrhs)
+  {
+    bandedSchurSolveBatchedT(LU, RHS, bc_RHS, PIV, C, GINV, AINVB, FIMat, SIMat, Cp, Dp,
+                             kl, ku, Nyx, Nz, nrhs);
+  }
 }
+
+template void precomputeBandedLinOpsT<double>(double*, double*, double*, double*, double*, double*,
+                                             int*, int, int, int, int);
+template void precomputeBandedLinOpsT<float>(float*, float*, float*, float*, float*, float*,
+                                            int*, int, int, int, int);
+template void bandedSchurSolveK<double>(const double*, double*, const double*, const int*, const double*,
+                                        const double*, const double*, const double*, const double*,
+                                        double*, double*, double*, int, int, int, int);
+template void bandedSchurSolveK<float>(const float*, float*, const float*, const int*, const float*,
+                                       const float*, const float*, const float*, const float*,
+                                       float*, float*, float*, int, int, int, int);
+template void schurCorrectK<double>(double*, const double*, const double*, const double*, const double*,
+                                    const double*, const double*, double*, double*, double*, int, int);
+template void schurCorrectK<float>(float*, const float*, const float*, const float*, const float*,
+                                   const float*, const float*, float*, float*, float*, int, int);
+template unsigned int pentaFactorT<double>(const double*, size_t, int, double*, int);
+template unsigned int pentaFactorT<float>(const float*, size_t, int, float*, int);
+template void pentaSolveT<double>(const double*, double*, int, int);
+template void pentaSolveT<float>(const float*, float*, int, int);
@@ -0,0 +1,157 @@
+#include<stdlib.h>
+#include<atomic>
+#include<algorithm>
+#include<iomanip>
+#include<climits>
+#include<sys/mman.h>
+#include"Memory.h"
+
+namespace
+{
+  // bookkeeping for a buffer, stored just before it (in the MEM_ALIGN bytes of padding)
+  struct AllocHeader
+  {
+    void* base;
+    size_t bytes;
+  };
+
+  std::atomic<size_t> current_bytes(0), peak_bytes(0);
+  std::atomic<size_t> hugepage_min(HUGEPAGE_MIN);
+  std::atomic<AllocHook> alloc_hook(nullptr);
+  std::atomic<Placement> page_placement(first_touch);
+}
+
+static_assert(sizeof(AllocHeader) <= MEM_ALIGN, "MEM_ALIGN is too small to hold the allocation header");
+
+void* alignedMalloc(size_t bytes)
+{
+  const bool huge = bytes >= hugepage_min.load(std::memory_order_relaxed);
+  void* base = 0;
+  // pad by MEM_ALIGN to keep the header without breaking the alignment of the buffer
+  if (posix_memalign(&base, huge ? HUGEPAGE_SIZE : MEM_ALIGN, bytes + MEM_ALIGN)) {return 0;}
+  #ifdef MADV_HUGEPAGE
+  // this is only a hint, so failure (eg. THP disabled) is not an error
+  if (huge) {madvise(base, bytes + MEM_ALIGN, MADV_HUGEPAGE);}
+  #endif
+  void* ptr = static_cast<char*>(base) + MEM_ALIGN;
+  AllocHeader* header = static_cast<AllocHeader*>(ptr) - 1;
+  header->base = base; header->bytes = bytes;
+  // update current and peak usage
+  const size_t current = current_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  size_t peak = peak_bytes.load(std::memory_order_relaxed);
+  while (current > peak &&
+         not peak_bytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+  AllocHook hook = alloc_hook.load(std::memory_order_relaxed);
+  if (hook) {hook(ptr, bytes, true);}
+  return ptr;
+}
+
+void alignedFree(void* ptr)
+{
+  if (not ptr) return;
+  AllocHeader* header = static_cast<AllocHeader*>(ptr) - 1;
+  AllocHook hook = alloc_hook.load(std::memory_order_relaxed);
+  if (hook) {hook(ptr, header->bytes, false);}
+  current_bytes.fetch_sub(header->bytes, std::memory_order_relaxed);
+  free(header->base);
+}
+
+void* alignedReserve(void* ptr, size_t bytes)
+{
+  const size_t capacity = alignedCapacity(ptr);
+  if (ptr and bytes <= capacity) return ptr;
+  alignedFree(ptr);
+  return alignedMalloc(std::max(bytes, capacity + capacity / 2));
+}
+
+size_t alignedCapacity(const void* ptr)
+{
+  return ptr ? (static_cast<const AllocHeader*>(ptr) - 1)->bytes : 0;
+}
+
+void setAllocHook(AllocHook hook) {alloc_hook.store(hook);}
+
+void setHugePageThreshold(size_t bytes) {hugepage_min.store(bytes);}
+
+size_t allocatedBytes() {return current_bytes.load();}
+
+size_t peakAllocatedBytes() {return peak_bytes.load();}
+
+void setPlacement(Placement placement) {page_placement.store(placement);}
+
+Placement getPlacement() {return page_placement.load();}
+
+size_t totalBytes(const MemoryReport& report)
+{
+  size_t total = 0;
+  for (const BufferBytes& buf : report) {total += buf.bytes;}
+  return total;
+}
+
+void writeMemoryReport(const MemoryReport& report, std::ostream& outputStream)
+{
+  for (const BufferBytes& buf : report)
+  {
+    outputStream << std::left << std::setw(24) << buf.name << std::right << std::setw(16) 
+                 << buf.bytes << std::setw(12) << std::fixed << std::setprecision(2) 
+                 << buf.bytes / 1048576.0 << " MiB" << std::endl;
+  }
+  const size_t total = totalBytes(report);
+  outputStream << std::left << std::setw(24) << "total" << std::right << std::setw(16) 
+               << total << std::setw(12) << std::fixed << std::setprecision(2) 
+               << total / 1048576.0 << " MiB" << std::endl;
+}
+
+MemoryReport estimateMemory(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+                            const unsigned int dof, const unsigned int nP, 
+                            const unsigned short wx, const unsigned short wy, const unsigned short wz, 
+                            const bool dp, const bool single, 
+                            const bool cache_weights, const unsigned int nthreads)
+{
+  MemoryReport report;
+  const size_t d = sizeof(double), n = nP, N = (size_t) Nx * Ny * Nz;
+  const size_t Nxeff = Nx + 2 * wx, Nyeff = Ny + 2 * wy, Nzeff = Nz + 2 * wz;
+  const size_t N2 = Nxeff * Nyeff, N3 = N2 * Nzeff;
+  const size_t real = single ? sizeof(float) : sizeof(double);
+  const size_t index = (N3 * dof > UINT_MAX) ? sizeof(size_t) : sizeof(unsigned int);
+  // Grid (the BCs are passed around as unsigned int, see GridWrapper.cpp)
+  report.push_back({"grid.fG", N * dof * d});
+  report.push_back({single ? "grid.fG_unwrap_f" : "grid.fG_unwrap", N3 * dof * real});
+  report.push_back({"grid.firstn", N2 * sizeof(int)});
+  report.push_back({"grid.number", N2 * sizeof(unsigned int)});
+  report.push_back({"grid.nextn", n * sizeof(int)});
+  report.push_back({"grid.BCs", 6 * dof * sizeof(unsigned int)});
+  if (dp)
+  {
+    report.push_back({"grid.zG", Nz * d}); report.push_back({"grid.zG_wts", Nz * d});
+    report.push_back({"grid.zG_ext", Nzeff * d}); report.push_back({"grid.zG_ext_wts", Nzeff * d});
+  }
+  // ParticleList
+  report.push_back({"particles.xP", 3 * n * d});
+  report.push_back({"particles.fP", n * dof * d});
+  report.push_back({"particles.radP", n * d}); report.push_back({"particles.betafP", n * d});
+  report.push_back({"particles.cwfP", n * d}); report.push_back({"particles.alphafP", n * d});
+  report.push_back({"particles.normfP", n * d});
+  report.push_back({"particles.wfP", n * sizeof(unsigned short)});
+  report.push_back({"particles.wfxP", n * sizeof(unsigned short)});
+  report.push_back({"particles.wfyP", n * sizeof(unsigned short)});
+  report.push_back({"particles.wfzP", n * sizeof(unsigned short)});
+  report.push_back({"particles.nodeP", 3 * n * sizeof(int)});
+  report.push_back({"particles.zoffset", n * sizeof(unsigned int)});
+  if (cache_weights)
+  {
+    report.push_back({"particles.kxP", wx * n * d}); report.push_back({"particles.kyP", wy * n * d});
+    report.push_back({"particles.kzP", wz * n * d});
+  }
+  // gathered column of the extended grid and its indices, for each thread
+  report.push_back({"spread.columns", nthreads * wx * wy * Nzeff * (dof * real + index)});
+  // Transform (the Chebyshev transforms are done in place, like the Fourier ones)
+  report.push_back({"ftransform.real", N * dof * d});
+  report.push_back({"ftransform.complex", N * dof * d});
+  report.push_back({"btransform.real", N * dof * d});
+  report.push_back({"btransform.complex", N * dof * d});
+  // Python Transformer (see Transform.py). The forward transforms return views of 
+  // the C buffers, and the backward ones normalized copies
+  report.push_back({"py.btransform.out", 2 * N * dof * d});
+  return report;
+}
@@ -1,8 +1,11 @@
 #include<unordered_set>
+#include<unordered_map>
+#include<vector>
 #include<algorithm>
 #include<fstream>
 #include<iomanip>
 #include<random>
+#include<cstdint>
 #include<omp.h>
 #include<math.h>
 #include<fftw3.h>
@@ -10,11 +13,42 @@
 #include"Grid.h"
 #include"Quadrature.h"
 #include"exceptions.h"
+#include"Memory.h"
 
+// spread the low 21 bits of v so that there are 2 zero bits between each
+inline uint64_t spreadBits(uint64_t v)
+{
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffff;
+  v = (v | v << 16) & 0x1f0000ff0000ff;
+  v = (v | v << 8) & 0x100f00f00f00f00f;
+  v = (v | v << 4) & 0x10c30c30c30c30c3;
+  v = (v | v << 2) & 0x1249249249249249;
+  return v;
+}
+
+// Morton key of the (x column, y column, z) cell of the position x on the grid
+inline uint64_t mortonKey(const double* x, const Grid& grid)
+{
+  const uint64_t i = std::max(x[0] / grid.hx, 0.0);
+  const uint64_t j = std::max(x[1] / grid.hy, 0.0);
+  const uint64_t k = std::max(grid.unifZ ? x[2] / grid.hz : x[2] * grid.Nz / grid.Lz, 0.0);
+  return spreadBits(i) | (spreadBits(j) << 1) | (spreadBits(k) << 2);
+}
 
-#ifndef MEM_ALIGN
-  #define MEM_ALIGN 16 
-#endif
+// reorder array a with stride values per particle so that a_new[i] = a[order[i]]
+template<typename T>
+void permute(T*& a, const unsigned int stride, const unsigned int* order, const unsigned int nP)
+{
+  if (not a) return;
+  T* a_new = (T*) alignedMalloc((size_t) nP * stride * sizeof(T));
+  #pragma omp parallel for
+  for (unsigned int i = 0; i < nP; ++i)
+  {
+    for (unsigned int j = 0; j < stride; ++j) {a_new[j + stride * (size_t) i] = a[j + stride * (size_t) order[i]];}
+  }
+  alignedFree(a); a = a_new;
+}
 
 //#pragma omp declare simd
 //inline double const esKernel(const double x, const double beta, const double alpha)
@@ -23,45 +57,49 @@
 //}
 
 // null initialization
-ParticleList::ParticleList() : xP(0), fP(0), betafP(0), alphafP(0), 
-                             radP(0), normfP(0), wfP(0), wfxP(0), wfyP(0),
-                             wfzP(0), nP(0), normalized(false), dof(0), 
+ParticleList::ParticleList() : xP(0), fP(0), nodeP(0), zoffset(0), layerP(0), 
+                             zkern_layer(0), zwts_layer(0), nlayers(0), max_layers(16),
+                             nrhs(1), kxP(0), kyP(0), kzP(0), cache_weights(false),
+                             perm(0), iperm(0), fP_out(0), reorder(false), reorder_tol(0.25),
+                             radP(0), betafP(0), normfP(0), alphafP(0), cwfP(0), 
+                             wfP(0), wfxP(0), wfyP(0), wfzP(0), nP(0), dof(0), 
                              unique_monopoles(ESParticleSet(20,esparticle_hash)),
-                             xunwrap(0), yunwrap(0), zunwrap(0), zoffset(0), pt_wts(0)
+                             normalized(false)
 {}
 
 /* construct with external data by copy */
 ParticleList::ParticleList(const double* _xP, const double* _fP, const double* _radP, 
                          const double* _betafP, const double* _cwfP, const unsigned short* _wfP, 
                          const unsigned int _nP, const unsigned int _dof) :
-  nP(_nP), dof(_dof), alphafP(0), normfP(0), wfxP(0), wfyP(0), wfzP(0), normalized(false),
-  unique_monopoles(ESParticleSet(20,esparticle_hash)), xunwrap(0), yunwrap(0), zunwrap(0),
-  zoffset(0), pt_wts(0)
-{
-  xP = (double*) fftw_malloc(nP * 3 * sizeof(double));
-  fP = (double*) fftw_malloc(nP * dof * sizeof(double));
-  betafP = (double*) fftw_malloc(nP * sizeof(double));
-  radP = (double*) fftw_malloc(nP * sizeof(double));
-  cwfP = (double*) fftw_malloc(nP * sizeof(double));
-  alphafP = (double*) fftw_malloc(nP * sizeof(double));
-  normfP = (double*) fftw_malloc(nP * sizeof(double));
-  wfP = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
-  wfxP = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
-  wfyP = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
-  wfzP = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
+  nodeP(0), zoffset(0), layerP(0), zkern_layer(0), zwts_layer(0), nlayers(0), max_layers(16),
+  nrhs(1), kxP(0), kyP(0), kzP(0), cache_weights(false), perm(0), iperm(0), fP_out(0),
+  reorder(false), reorder_tol(0.25), normfP(0), alphafP(0), wfxP(0), wfyP(0), wfzP(0), 
+  nP(_nP), dof(_dof), unique_monopoles(ESParticleSet(20,esparticle_hash)), normalized(false)
+{
+  xP = (double*) alignedMalloc((size_t) nP * 3 * sizeof(double));
+  fP = (double*) alignedMalloc((size_t) nP * dof * sizeof(double));
+  betafP = (double*) alignedMalloc(nP * sizeof(double));
+  radP = (double*) alignedMalloc(nP * sizeof(double));
+  cwfP = (double*) alignedMalloc(nP * sizeof(double));
+  alphafP = (double*) alignedMalloc(nP * sizeof(double));
+  normfP = (double*) alignedMalloc(nP * sizeof(double));
+  wfP = (unsigned short*) alignedMalloc(nP * sizeof(unsigned short));
+  wfxP = (unsigned short*) alignedMalloc(nP * sizeof(unsigned short));
+  wfyP = (unsigned short*) alignedMalloc(nP * sizeof(unsigned short));
+  wfzP = (unsigned short*) alignedMalloc(nP * sizeof(unsigned short));
   #pragma omp parallel for
   for (unsigned int i = 0; i < nP; ++i)
   {
-    xP[3 * i] = _xP[3 * i];
-    xP[1 + 3 * i] = _xP[1 + 3 * i];
-    xP[2 + 3 * i] = _xP[2 + 3 * i];
+    xP[3 * (size_t) i] = _xP[3 * (size_t) i];
+    xP[1 + 3 * (size_t) i] = _xP[1 + 3 * (size_t) i];
+    xP[2 + 3 * (size_t) i] = _xP[2 + 3 * (size_t) i];
     radP[i] = _radP[i];
     betafP[i] = _betafP[i];
     cwfP[i] = _cwfP[i];
     wfP[i] = _wfP[i];
     for (unsigned int j = 0; j < dof; ++j)
     {
-      fP[j + dof * i] = _fP[j + dof * i];
+      fP[j + dof * (size_t) i] = _fP[j + dof * (size_t) i];
     }
   }
   this->setup();
@@ -73,10 +111,43 @@ void ParticleList::setForces(const double* _fP, unsigned int _dof)
   else if (this->dof != _dof) exitErr("DOF does not match current.");
   if(!this->fP)
   {
-    this->fP = (double*) fftw_malloc(nP * dof * sizeof(double));
+    this->fP = (double*) alignedMalloc((size_t) nP * dof * sizeof(double));
+  }
+  if (perm)
+  {
+    #pragma omp parallel for
+    for (unsigned int i = 0; i < nP; ++i)
+    {
+      for (unsigned int j = 0; j < dof; ++j) {this->fP[j + dof * (size_t) i] = _fP[j + dof * (size_t) perm[i]];}
+    }
+  }
+  else
+  {
+    #pragma omp parallel for
+    for (size_t i = 0; i < (size_t) dof * nP; ++i) this->fP[i] = _fP[i]; 
   }
+}
+
+const double* ParticleList::getForces()
+{
+  if (not perm) return fP;
+  if (not fP_out) {fP_out = (double*) alignedMalloc((size_t) nP * dof * sizeof(double));}
   #pragma omp parallel for
-  for (unsigned int i = 0; i < dof * nP; ++i) this->fP[i] = _fP[i]; 
+  for (unsigned int i = 0; i < nP; ++i)
+  {
+    for (unsigned int j = 0; j < dof; ++j) {fP_out[j + dof * (size_t) perm[i]] = fP[j + dof * (size_t) i];}
+  }
+  return fP_out;
+}
+
+void ParticleList::setNumRHS(const unsigned int _nrhs)
+{
+  if (not _nrhs) {exitErr("Number of right-hand sides must be positive.");}
+  if (_nrhs == nrhs) return;
+  this->dof = (dof / nrhs) * _nrhs; this->nrhs = _nrhs;
+  if (this->fP_out) {alignedFree(fP_out); fP_out = 0;}
+  this->fP = (double*) alignedReserve(fP, (size_t) nP * dof * sizeof(double));
+  this->zeroForces();
 }
 
 void ParticleList::zeroForces()
@@ -84,7 +155,7 @@ void ParticleList::zeroForces()
   if (this->fP)
   {
     #pragma omp parallel for
-    for (unsigned int i = 0; i < dof * nP; ++i) this->fP[i] = 0;
+    for (size_t i = 0; i < (size_t) dof * nP; ++i) this->fP[i] = 0;
   }
   else exitErr("Forces have not been allocated.");
 }
@@ -111,6 +182,7 @@ void ParticleList::setup(Grid& grid)
       exitErr("DOF of ParticleList must match DOF of grid.");
     }
     this->setup();
+    if (reorder && not grid.has_locator) {this->reorderParticles(grid, xP);}
     this->locateOnGrid(grid);
   }
   else
@@ -119,6 +191,12 @@ void ParticleList::setup(Grid& grid)
   }
 }
 
+void ParticleList::reset(Grid& grid)
+{
+  grid.reset();
+  this->setup(grid);
+}
+
 void ParticleList::findUniqueKernels()
 {
   if (this->unique_monopoles.size() == 0)
@@ -138,9 +216,9 @@ void ParticleList::normalizeKernels()
   {
     // cheb grid size, pts, weights and f for kernel vals
     unsigned int N = 1000;
-    double* cpts = (double*) fftw_malloc(N * sizeof(double));
-    double* cwts = (double*) fftw_malloc(N * sizeof(double)); 
-    double* f = (double*) fftw_malloc(N * sizeof(double));
+    double* cpts = (double*) alignedMalloc(N * sizeof(double));
+    double* cwts = (double*) alignedMalloc(N * sizeof(double)); 
+    double* f = (double*) alignedMalloc(N * sizeof(double));
     double alpha, beta, betaw, norm, cw, rad; unsigned short w;
     // iterate over unique tuples of (w, beta, c(w), Rh)
     for (const auto& tuple : unique_monopoles)
@@ -171,9 +249,9 @@ void ParticleList::normalizeKernels()
         }
       }
     }
-    fftw_free(cpts);
-    fftw_free(cwts);
-    fftw_free(f);
+    alignedFree(cpts);
+    alignedFree(cwts);
+    alignedFree(f);
     this->normalized = true;
   }
 }
@@ -184,10 +262,260 @@ void ParticleList::locateOnGrid(Grid& grid)
   {
     if (grid.unifZ) {this->locateOnGridUnifZ(grid);}
     else {this->locateOnGridNonUnifZ(grid);}
+    this->findLayers(grid);
+    this->clearWeights();
     grid.has_locator = true; 
   }
 }
 
+void ParticleList::setMaxLayers(const unsigned int _max_layers)
+{
+  this->max_layers = _max_layers;
+}
+
+void ParticleList::setWeightCache(bool _cache_weights)
+{
+  this->cache_weights = _cache_weights;
+  if (not cache_weights) {this->clearWeights();}
+}
+
+void ParticleList::stencils(const Grid& grid, const unsigned int* indx, const unsigned int npts,
+                            double* xunwrap, double* yunwrap, double* zunwrap, double* pt_wts) const
+{
+  // offsets on the edge of the support are moved onto it (uniform z) 
+  // or just inside of it (Chebyshev z), as they were when located
+  const double snap = (grid.unifZ ? 0 : 1e-14);
+  for (unsigned int ipt = 0; ipt < npts; ++ipt)
+  {
+    const unsigned int i = indx[ipt];
+    const double alpha = alphafP[i];
+    if (xunwrap)
+    {
+      for (unsigned int j = 0; j < wfxP_max; ++j)
+      {
+        double& u = xunwrap[j + ipt * wfxP_max]; u = 0;
+        if (j < wfxP[i])
+        {
+          u = ((double) nodeP[3 * (size_t) i] + j) * grid.hx - xP[3 * (size_t) i];
+          if (fabs(pow(u,2) - pow(alpha,2)) < 1e-14) {u = alpha - snap;}
+        }
+      }
+    }
+    if (yunwrap)
+    {
+      for (unsigned int j = 0; j < wfyP_max; ++j)
+      {
+        double& u = yunwrap[j + ipt * wfyP_max]; u = 0;
+        if (j < wfyP[i])
+        {
+          u = ((double) nodeP[1 + 3 * (size_t) i] + j) * grid.hy - xP[1 + 3 * (size_t) i];
+          if (fabs(pow(u,2) - pow(alpha,2)) < 1e-14) {u = alpha - snap;}
+        }
+      }
+    }
+    if (zunwrap)
+    {
+      for (unsigned int k = 0; k < wfzP_max; ++k)
+      {
+        double& u = zunwrap[k + ipt * wfzP_max]; u = 0;
+        if (k < wfzP[i])
+        {
+          if (grid.unifZ) {u = ((double) nodeP[2 + 3 * (size_t) i] + k) * grid.hz - xP[2 + 3 * (size_t) i];}
+          else {u = grid.zG_ext[nodeP[2 + 3 * (size_t) i] + k] - xP[2 + 3 * (size_t) i];}
+          if (fabs(pow(u,2) - pow(alpha,2)) < 1e-14) {u = alpha - snap;}
+        }
+      }
+    }
+    if (pt_wts && not grid.unifZ)
+    {
+      for (unsigned int k = 0; k < wfzP_max; ++k)
+      {
+        pt_wts[k + ipt * wfzP_max] = (k < wfzP[i] ? 
+          grid.hx * grid.hy * grid.zG_ext_wts[nodeP[2 + 3 * (size_t) i] + k] : 0);
+      }
+    }
+  }
+}
+
+void ParticleList::evalWeights(const Grid& grid)
+{
+  this->clearWeights();
+  kxP = (double*) alignedMalloc((size_t) wfxP_max * nP * sizeof(double));
+  kyP = (double*) alignedMalloc((size_t) wfyP_max * nP * sizeof(double));
+  kzP = (double*) alignedMalloc((size_t) wfzP_max * nP * sizeof(double));
+  #pragma omp parallel
+  {
+    double* xunwrap = (double*) alignedMalloc(wfxP_max * sizeof(double));
+    double* yunwrap = (double*) alignedMalloc(wfyP_max * sizeof(double));
+    double* zunwrap = (double*) alignedMalloc(wfzP_max * sizeof(double));
+    #pragma omp for
+    for (unsigned int i = 0; i < nP; ++i)
+    {
+      const double betaw = betafP[i] * wfP[i], alpha = alphafP[i], norm = normfP[i];
+      this->stencils(grid, &i, 1, xunwrap, yunwrap, zunwrap, 0);
+      // weights beyond the width of the particle's kernel are 0
+      for (unsigned int j = 0; j < wfxP_max; ++j)
+      {
+        kxP[j + (size_t) i * wfxP_max] = (j < wfxP[i] ? esKernel(xunwrap[j], betaw, alpha) / norm : 0);
+      }
+      for (unsigned int j = 0; j < wfyP_max; ++j)
+      {
+        kyP[j + (size_t) i * wfyP_max] = (j < wfyP[i] ? esKernel(yunwrap[j], betaw, alpha) / norm : 0);
+      }
+      for (unsigned int j = 0; j < wfzP_max; ++j)
+      {
+        kzP[j + (size_t) i * wfzP_max] = (j < wfzP[i] ? esKernel(zunwrap[j], betaw, alpha) / norm : 0);
+      }
+    }
+    alignedFree(xunwrap); alignedFree(yunwrap); alignedFree(zunwrap);
+  }
+}
+
+void ParticleList::setReordering(bool _reorder, double tol)
+{
+  this->reorder = _reorder; 
+  this->reorder_tol = tol;
+}
+
+void ParticleList::reorderParticles(Grid& grid, const double* x)
+{
+  std::vector<uint64_t> keys(nP);
+  #pragma omp parallel for
+  for (unsigned int i = 0; i < nP; ++i) {keys[i] = mortonKey(&x[3 * (size_t) i], grid);}
+  // order[i] is the current index of the particle moved to index i
+  std::vector<unsigned int> order(nP);
+  for (unsigned int i = 0; i < nP; ++i) {order[i] = i;}
+  std::stable_sort(order.begin(), order.end(), 
+                   [&keys](unsigned int a, unsigned int b) {return keys[a] < keys[b];});
+  permute(xP, 3, order.data(), nP); 
+  permute(fP, dof, order.data(), nP); 
+  permute(radP, 1, order.data(), nP); 
+  permute(betafP, 1, order.data(), nP); 
+  permute(cwfP, 1, order.data(), nP); 
+  permute(alphafP, 1, order.data(), nP); 
+  permute(normfP, 1, order.data(), nP); 
+  permute(wfP, 1, order.data(), nP); 
+  permute(wfxP, 1, order.data(), nP); 
+  permute(wfyP, 1, order.data(), nP); 
+  permute(wfzP, 1, order.data(), nP); 
+  if (grid.has_locator)
+  {
+    permute(nodeP, 3, order.data(), nP);
+    permute(zoffset, 1, order.data(), nP);
+    permute(layerP, 1, order.data(), nP);
+    permute(kxP, wfxP_max, order.data(), nP);
+    permute(kyP, wfyP_max, order.data(), nP);
+    permute(kzP, wfzP_max, order.data(), nP);
+    // rebuild the column lists so particles in a column are in increasing order
+    const unsigned int N2 = grid.Nxeff * grid.Nyeff;
+    std::vector<unsigned int> colP(nP);
+    for (unsigned int c = 0; c < N2; ++c)
+    {
+      for (int n = grid.firstn[c]; n > -1; n = grid.nextn[n]) {colP[n] = c;}
+    }
+    std::vector<int> last(N2, -1);
+    for (unsigned int c = 0; c < N2; ++c) {grid.firstn[c] = -1;}
+    for (unsigned int i = 0; i < nP; ++i)
+    {
+      const unsigned int c = colP[order[i]];
+      grid.nextn[i] = -1;
+      if (last[c] < 0) {grid.firstn[c] = i;}
+      else {grid.nextn[last[c]] = i;}
+      last[c] = i;
+    }
+  }
+  // compose with the current permutation
+  if (not perm) 
+  {
+    perm = (unsigned int*) alignedMalloc(nP * sizeof(unsigned int));
+    iperm = (unsigned int*) alignedMalloc(nP * sizeof(unsigned int));
+    for (unsigned int i = 0; i < nP; ++i) {perm[i] = i;}
+  }
+  permute(perm, 1, order.data(), nP);
+  for (unsigned int i = 0; i < nP; ++i) {iperm[perm[i]] = i;}
+}
+
+double ParticleList::disorder(const Grid& grid, const double* x) const
+{
+  unsigned int count = 0;
+  #pragma omp parallel for reduction(+:count)
+  for (unsigned int i = 1; i < nP; ++i)
+  {
+    if (mortonKey(&x[3 * (size_t) i], grid) < mortonKey(&x[3 * (size_t) (i - 1)], grid)) {count += 1;}
+  }
+  return nP ? (double) count / nP : 0;
+}
+
+void ParticleList::clearWeights()
+{
+  if (kxP) {alignedFree(kxP); kxP = 0;}
+  if (kyP) {alignedFree(kyP); kyP = 0;}
+  if (kzP) {alignedFree(kzP); kzP = 0;}
+}
+
+void ParticleList::findLayers(const Grid& grid)
+{
+  if (layerP) {alignedFree(layerP); layerP = 0;}
+  if (zkern_layer) {alignedFree(zkern_layer); zkern_layer = 0;}
+  if (zwts_layer) {alignedFree(zwts_layer); zwts_layer = 0;}
+  nlayers = 0;
+  if (not max_layers) return;
+  // a layer is identified by the height and the kernel of a particle,
+  // as these determine the z weights, z offset and z width 
+  typedef std::tuple<double, unsigned short, double, double> ZLayer;
+  auto zlayer_hash = [](const ZLayer& v)
+  {
+    size_t seed = 0;
+    hash_combine<double>(seed, std::get<0>(v));
+    hash_combine<unsigned short>(seed, std::get<1>(v));
+    hash_combine<double>(seed, std::get<2>(v));
+    hash_combine<double>(seed, std::get<3>(v));
+    return seed;
+  };
+  std::unordered_map<ZLayer, unsigned short, decltype(zlayer_hash)> layers(20, zlayer_hash);
+  // index of a particle representing each layer
+  std::vector<unsigned int> rep;
+  layerP = (unsigned short*) alignedMalloc(nP * sizeof(unsigned short));
+  for (unsigned int i = 0; i < nP; ++i)
+  {
+    ZLayer layer(xP[2 + 3 * (size_t) i], wfP[i], betafP[i], alphafP[i]);
+    auto it = layers.find(layer);
+    if (it == layers.end())
+    {
+      // too many layers, so we use the general path
+      if (layers.size() == max_layers) 
+      {
+        alignedFree(layerP); layerP = 0;
+        return;
+      }
+      layerP[i] = layers.size();
+      layers.emplace(layer, layerP[i]);
+      rep.push_back(i);
+    }
+    else {layerP[i] = it->second;}
+  }
+  nlayers = layers.size();
+  // evaluate the z weights once per layer
+  zkern_layer = (double*) alignedMalloc(nlayers * wfzP_max * sizeof(double));
+  if (not grid.unifZ) 
+  {
+    zwts_layer = (double*) alignedMalloc(nlayers * wfzP_max * sizeof(double));
+  }
+  double* zunwrap = (double*) alignedMalloc(wfzP_max * sizeof(double));
+  for (unsigned int l = 0; l < nlayers; ++l)
+  {
+    const unsigned int i = rep[l];
+    const double betaw = betafP[i] * wfP[i];
+    this->stencils(grid, &i, 1, 0, 0, zunwrap, zwts_layer ? &zwts_layer[l * wfzP_max] : 0);
+    for (unsigned int k = 0; k < wfzP_max; ++k)
+    {
+      zkern_layer[k + l * wfzP_max] = (k < wfzP[i] ? 
+        esKernel(zunwrap[k], betaw, alphafP[i]) / normfP[i] : 0);
+    }
+  }
+  alignedFree(zunwrap);
+}
+
 void ParticleList::locateOnGridUnifZ(Grid& grid)
 {
   // get widths on effective uniform grid
@@ -202,21 +530,22 @@ void ParticleList::locateOnGridUnifZ(Grid& grid)
   wfyP_max = *std::max_element(wfyP, wfyP + nP); grid.Nyeff += 2 * wfyP_max;
   wfzP_max = *std::max_element(wfzP, wfzP + nP); grid.Nzeff += 2 * wfzP_max;
  
-  unsigned int N2 = grid.Nxeff * grid.Nyeff, N3 = N2 * grid.Nzeff;
-  grid.fG_unwrap = (double*) fftw_malloc(N3 * grid.dof * sizeof(double)); 
-  grid.firstn = (int*) fftw_malloc(N2 * sizeof(int));
-  grid.number = (unsigned int*) fftw_malloc(N2 * sizeof(unsigned int));  
-  grid.nextn = (int*) fftw_malloc(nP * sizeof(int));
-
-  xunwrap = (double *) fftw_malloc(wfxP_max * nP * sizeof(double));
-  yunwrap = (double *) fftw_malloc(wfyP_max * nP * sizeof(double));
-  zunwrap = (double *) fftw_malloc(wfzP_max * nP * sizeof(double));
+  unsigned int N2 = grid.Nxeff * grid.Nyeff; size_t N3 = (size_t) N2 * grid.Nzeff;
+  // the extended grid and locator are reused if they are large enough (see Grid::reset())
+  if (grid.single) {grid.fG_unwrap_f = (float*) alignedReserve(grid.fG_unwrap_f, N3 * grid.dof * sizeof(float));}
+  else {grid.fG_unwrap = (double*) alignedReserve(grid.fG_unwrap, N3 * grid.dof * sizeof(double));}
+  grid.touchExtGrid();
+  grid.firstn = (int*) alignedReserve(grid.firstn, N2 * sizeof(int));
+  grid.number = (unsigned int*) alignedReserve(grid.number, N2 * sizeof(unsigned int));  
+  grid.nextn = (int*) alignedReserve(grid.nextn, nP * sizeof(int));
+
+  nodeP = (int*) alignedReserve(nodeP, 3 * (size_t) nP * sizeof(int));
   
-  unsigned int* xclose = (unsigned int*) fftw_malloc(nP * sizeof(unsigned int));
-  unsigned int* yclose = (unsigned int*) fftw_malloc(nP * sizeof(unsigned int));
-  unsigned int* zclose = (unsigned int*) fftw_malloc(nP * sizeof(unsigned int));
+  unsigned int* xclose = (unsigned int*) alignedMalloc(nP * sizeof(unsigned int));
+  unsigned int* yclose = (unsigned int*) alignedMalloc(nP * sizeof(unsigned int));
+  unsigned int* zclose = (unsigned int*) alignedMalloc(nP * sizeof(unsigned int));
   
-  zoffset = (unsigned int *) fftw_malloc(nP * sizeof(unsigned int));
+  zoffset = (unsigned int *) alignedReserve(zoffset, nP * sizeof(unsigned int));
  
   #pragma omp parallel
   { 
@@ -228,51 +557,16 @@ void ParticleList::locateOnGridUnifZ(Grid& grid)
       const unsigned short wz = wfzP[i];
       const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
       const int evenz = -1 * (wz % 2) + 1;
-      xclose[i] = (int) (xP[3 * i] / grid.hx);
-      yclose[i] = (int) (xP[1 + 3 * i] / grid.hy);
-      zclose[i] = (int) (xP[2 + 3 * i] / grid.hz);
-      xclose[i] += ((wx % 2) && (xP[3 * i] / grid.hx - xclose[i] > 1.0 / 2.0) ? 1 : 0);
-      yclose[i] += ((wy % 2) && (xP[1 + 3 * i] / grid.hy - yclose[i] > 1.0 / 2.0) ? 1 : 0);
-      zclose[i] += ((wz % 2) && (xP[2 + 3 * i] / grid.hz - zclose[i] > 1.0 / 2.0) ? 1 : 0);
-      for (unsigned int j = 0; j < wx; ++j)
-      {
-        xunwrap[j + i * wfxP_max] = ((double) xclose[i] + j - wx / 2 + evenx) * grid.hx - xP[3 * i];
-        if (fabs(pow(xunwrap[j + i * wfxP_max],2) - pow(alphafP[i],2)) < 1e-14) 
-        {
-          xunwrap[j + i * wfxP_max] = alphafP[i];
-        }
-        // initialize buffer region if needed
-        if (j == wx - 1 && wx < wfxP_max)
-        {
-          for (unsigned int k = wx; k < wfxP_max; ++k) {xunwrap[k + i * wfxP_max] = 0;}
-        }
-      } 
-      for (unsigned int j = 0; j < wy; ++j)
-      {
-        yunwrap[j + i * wfyP_max] = ((double) yclose[i] + j - wy / 2 + eveny) * grid.hy - xP[1 + 3 * i];
-        if (fabs(pow(yunwrap[j + i * wfyP_max],2) - pow(alphafP[i],2)) < 1e-14) 
-        {
-          yunwrap[j + i * wfyP_max] = alphafP[i];
-        }
-        // initialize buffer region if needed
-        if (j == wy - 1 && wy < wfyP_max)
-        {
-          for (unsigned int k = wy; k < wfyP_max; ++k) {yunwrap[k + i * wfyP_max] = 0;}
-        }
-      } 
-      for (unsigned int j = 0; j < wz; ++j)
-      {
-        zunwrap[j + i * wfzP_max] = ((double) zclose[i] + j - wz / 2 + evenz) * grid.hz - xP[2 + 3 * i];
-        if (fabs(pow(zunwrap[j + i * wfzP_max],2) - pow(alphafP[i],2)) < 1e-14) 
-        {
-          zunwrap[j + i * wfzP_max] = alphafP[i];
-        }
-        // initialize buffer region if needed
-        if (j == wz - 1 && wz < wfzP_max)
-        {
-          for (unsigned int k = wz; k < wfzP_max; ++k) {zunwrap[k + i * wfzP_max] = 0;}
-        }
-      }
+      xclose[i] = (int) (xP[3 * (size_t) i] / grid.hx);
+      yclose[i] = (int) (xP[1 + 3 * (size_t) i] / grid.hy);
+      zclose[i] = (int) (xP[2 + 3 * (size_t) i] / grid.hz);
+      xclose[i] += ((wx % 2) && (xP[3 * (size_t) i] / grid.hx - xclose[i] > 1.0 / 2.0) ? 1 : 0);
+      yclose[i] += ((wy % 2) && (xP[1 + 3 * (size_t) i] / grid.hy - yclose[i] > 1.0 / 2.0) ? 1 : 0);
+      zclose[i] += ((wz % 2) && (xP[2 + 3 * (size_t) i] / grid.hz - zclose[i] > 1.0 / 2.0) ? 1 : 0);
+      // first node of the stencil on each axis
+      nodeP[3 * (size_t) i] = (int) xclose[i] - wx / 2 + evenx;
+      nodeP[1 + 3 * (size_t) i] = (int) yclose[i] - wy / 2 + eveny;
+      nodeP[2 + 3 * (size_t) i] = (int) zclose[i] - wz / 2 + evenz;
       zoffset[i] = wx * wy * (zclose[i] - wz / 2 + evenz + wfzP_max);    
       grid.nextn[i] = -1;
     }
@@ -296,9 +590,9 @@ void ParticleList::locateOnGridUnifZ(Grid& grid)
     }
     grid.number[ind] += 1;
   }
-  if (xclose) {fftw_free(xclose); xclose = 0;}
-  if (yclose) {fftw_free(yclose); yclose = 0;}
-  if (zclose) {fftw_free(zclose); zclose = 0;}
+  if (xclose) {alignedFree(xclose); xclose = 0;}
+  if (yclose) {alignedFree(yclose); yclose = 0;}
+  if (zclose) {alignedFree(zclose); zclose = 0;}
 }
 
 void ParticleList::locateOnGridNonUnifZ(Grid& grid)
@@ -316,34 +610,33 @@ void ParticleList::locateOnGridNonUnifZ(Grid& grid)
 
   // define extended z grid
   ext_down = 0; ext_up = 0;
-  double *zG_ext, *zG_ext_wts;
-  unsigned short* indl = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
-  unsigned short* indr = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
+  unsigned short* indl = (unsigned short*) alignedMalloc(nP * sizeof(unsigned short));
+  unsigned short* indr = (unsigned short*) alignedMalloc(nP * sizeof(unsigned short));
  
   unsigned int i = 1;
   while (grid.zG[0] - grid.zG[i] <= alphafP_max) {ext_up += 1; i += 1;} 
   i = grid.Nz - 2;
   while (grid.zG[i] - grid.zG[grid.Nz - 1] <= alphafP_max) {ext_down += 1; i -= 1;}
   grid.Nzeff += ext_up + ext_down;
-  zG_ext = (double*) fftw_malloc(grid.Nzeff * sizeof(double));
-  zG_ext_wts = (double*) fftw_malloc(grid.Nzeff * sizeof(double));
+  grid.zG_ext = (double*) alignedReserve(grid.zG_ext, grid.Nzeff * sizeof(double));
+  grid.zG_ext_wts = (double*) alignedReserve(grid.zG_ext_wts, grid.Nzeff * sizeof(double));
   for (unsigned int i = ext_up; i < grid.Nzeff - ext_down; ++i)
   {
-    zG_ext[i] = grid.zG[i - ext_up];
-    zG_ext_wts[i] = grid.zG_wts[i - ext_up];
+    grid.zG_ext[i] = grid.zG[i - ext_up];
+    grid.zG_ext_wts[i] = grid.zG_wts[i - ext_up];
   } 
   unsigned int j = 0;
   for (unsigned int i = ext_up; i > 0; --i) 
   {
-    zG_ext[j] = 2.0 * grid.zG[0] - grid.zG[i]; 
-    zG_ext_wts[j] = grid.zG_wts[i];
+    grid.zG_ext[j] = 2.0 * grid.zG[0] - grid.zG[i]; 
+    grid.zG_ext_wts[j] = grid.zG_wts[i];
     j += 1;
   }
   j = grid.Nzeff - ext_down;;
   for (unsigned int i = grid.Nz - 2; i > grid.Nz - 2 - ext_down; --i)
   { 
-    zG_ext[j] = -1.0 * grid.zG[i]; 
-    zG_ext_wts[j] = grid.zG_wts[i]; 
+    grid.zG_ext[j] = -1.0 * grid.zG[i]; 
+    grid.zG_ext_wts[j] = grid.zG_wts[i]; 
     j += 1; 
   } 
   // find wz for each particle
@@ -351,31 +644,31 @@ void ParticleList::locateOnGridNonUnifZ(Grid& grid)
   {
     
     // find index of z grid pt w/i alpha below 
-    auto high = std::lower_bound(&zG_ext[0], &zG_ext[0] + grid.Nzeff, \
-                                 xP[2 + 3 * i] - alphafP[i], std::greater<double>());
-    auto low = std::lower_bound(&zG_ext[0], &zG_ext[0] + grid.Nzeff, \
-                                xP[2 + 3 * i] + alphafP[i], std::greater<double>());
-    indl[i] = low - &zG_ext[0];  
-    indr[i] = high - &zG_ext[0];
+    auto high = std::lower_bound(&grid.zG_ext[0], &grid.zG_ext[0] + grid.Nzeff, \
+                                 xP[2 + 3 * (size_t) i] - alphafP[i], std::greater<double>());
+    auto low = std::lower_bound(&grid.zG_ext[0], &grid.zG_ext[0] + grid.Nzeff, \
+                                xP[2 + 3 * (size_t) i] + alphafP[i], std::greater<double>());
+    indl[i] = low - &grid.zG_ext[0];  
+    indr[i] = high - &grid.zG_ext[0];
     if (indr[i] == grid.Nzeff) {indr[i] -= 1;}
-    else if (xP[2 + 3 * i] - alphafP[i] > zG_ext[indr[i]]) {indr[i] -= 1;}
+    else if (xP[2 + 3 * (size_t) i] - alphafP[i] > grid.zG_ext[indr[i]]) {indr[i] -= 1;}
     wfzP[i] = indr[i] - indl[i] + 1; 
   }
   
   wfzP_max = *std::max_element(wfzP, wfzP + nP); 
-  unsigned int N2 = grid.Nxeff * grid.Nyeff, N3 = N2 * grid.Nzeff;
-  grid.fG_unwrap = (double*) fftw_malloc(N3 * grid.dof * sizeof(double)); 
-  grid.firstn = (int*) fftw_malloc(N2 * sizeof(int));
-  grid.number = (unsigned int*) fftw_malloc(N2 * sizeof(unsigned int));  
-  grid.nextn = (int*) fftw_malloc(nP * sizeof(int));
-
-  xunwrap = (double*) fftw_malloc(wfxP_max * nP * sizeof(double));
-  yunwrap = (double*) fftw_malloc(wfyP_max * nP * sizeof(double));
-  zunwrap = (double*) fftw_malloc(wfzP_max * nP * sizeof(double));
-  pt_wts = (double*) fftw_malloc(wfzP_max * nP * sizeof(double));  
-  unsigned int* xclose = (unsigned int*) fftw_malloc(nP * sizeof(unsigned int));
-  unsigned int* yclose = (unsigned int*) fftw_malloc(nP * sizeof(unsigned int));
-  zoffset = (unsigned int *) fftw_malloc(nP * sizeof(unsigned int));
+  unsigned int N2 = grid.Nxeff * grid.Nyeff; size_t N3 = (size_t) N2 * grid.Nzeff;
+  // the extended grid and locator are reused if they are large enough (see Grid::reset())
+  if (grid.single) {grid.fG_unwrap_f = (float*) alignedReserve(grid.fG_unwrap_f, N3 * grid.dof * sizeof(float));}
+  else {grid.fG_unwrap = (double*) alignedReserve(grid.fG_unwrap, N3 * grid.dof * sizeof(double));}
+  grid.touchExtGrid();
+  grid.firstn = (int*) alignedReserve(grid.firstn, N2 * sizeof(int));
+  grid.number = (unsigned int*) alignedReserve(grid.number, N2 * sizeof(unsigned int));  
+  grid.nextn = (int*) alignedReserve(grid.nextn, nP * sizeof(int));
+
+  nodeP = (int*) alignedReserve(nodeP, 3 * (size_t) nP * sizeof(int));
+  unsigned int* xclose = (unsigned int*) alignedMalloc(nP * sizeof(unsigned int));
+  unsigned int* yclose = (unsigned int*) alignedMalloc(nP * sizeof(unsigned int));
+  zoffset = (unsigned int *) alignedReserve(zoffset, nP * sizeof(unsigned int));
 
   #pragma omp parallel
   { 
@@ -384,58 +677,15 @@ void ParticleList::locateOnGridNonUnifZ(Grid& grid)
     {
       const unsigned short wx = wfxP[i];
       const unsigned short wy = wfyP[i];
-      const unsigned short wz = wfzP[i];
       const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
-      xclose[i] = (int) (xP[3 * i] / grid.hx);
-      yclose[i] = (int) (xP[1 + 3 * i] / grid.hy);
-      xclose[i] += ((wx % 2) && (xP[3 * i] / grid.hx - xclose[i] > 1.0 / 2.0) ? 1 : 0);
-      yclose[i] += ((wy % 2) && (xP[1 + 3 * i] / grid.hy - yclose[i] > 1.0 / 2.0) ? 1 : 0);
-      for (unsigned int j = 0; j < wx; ++j)
-      {
-        xunwrap[j + i * wfxP_max] = ((double) xclose[i] + j - wx / 2 + evenx) * grid.hx - xP[3 * i];
-        if (fabs(pow(xunwrap[j + i * wfxP_max],2) - pow(alphafP[i],2)) < 1e-14) 
-        {
-          xunwrap[j + i * wfxP_max] = alphafP[i] - 1e-14;
-        }
-        // initialize buffer region if needed
-        if (j == wx - 1 && wx < wfxP_max)
-        {
-          for (unsigned int k = wx; k < wfxP_max; ++k) {xunwrap[k + i * wfxP_max] = 0;}
-        }
-      } 
-      for (unsigned int j = 0; j < wy; ++j)
-      {
-        yunwrap[j + i * wfyP_max] = ((double) yclose[i] + j - wy / 2 + eveny) * grid.hy - xP[1 + 3 * i];
-        if (fabs(pow(yunwrap[j + i * wfyP_max],2) - pow(alphafP[i],2)) < 1e-14) 
-        {
-          yunwrap[j + i * wfyP_max] = alphafP[i] - 1e-14;
-        }
-        // initialize buffer region if needed
-        if (j == wy - 1 && wy < wfyP_max)
-        {
-          for (unsigned int k = wy; k < wfyP_max; ++k) {yunwrap[k + i * wfyP_max] = 0;}
-        }
-      }
-      unsigned int k = 0;
-      for (unsigned int j = indl[i]; j <= indr[i]; ++j)
-      {
-        zunwrap[k + i * wfzP_max] = zG_ext[j] - xP[2 + 3 * i]; 
-        if (fabs(pow(zunwrap[k + i * wfzP_max],2) - pow(alphafP[i],2)) < 1e-14) 
-        {
-          zunwrap[k + i * wfzP_max] = alphafP[i] - 1e-14;
-        }
-        pt_wts[k + i * wfzP_max] = grid.hx * grid.hy * zG_ext_wts[j];
-        k += 1;
-        // initialize buffer region if needed
-        if (k == wz - 1 && wz < wfzP_max)
-        {
-          for (unsigned int l = wz; l < wfzP_max; ++l) 
-          {
-            zunwrap[l + i * wfzP_max] = 0;
-            pt_wts[l + i * wfzP_max] = 0;
-          }
-        }
-      }
+      xclose[i] = (int) (xP[3 * (size_t) i] / grid.hx);
+      yclose[i] = (int) (xP[1 + 3 * (size_t) i] / grid.hy);
+      xclose[i] += ((wx % 2) && (xP[3 * (size_t) i] / grid.hx - xclose[i] > 1.0 / 2.0) ? 1 : 0);
+      yclose[i] += ((wy % 2) && (xP[1 + 3 * (size_t) i] / grid.hy - yclose[i] > 1.0 / 2.0) ? 1 : 0);
+      // first node of the stencil on each axis (index into grid.zG_ext for z)
+      nodeP[3 * (size_t) i] = (int) xclose[i] - wx / 2 + evenx;
+      nodeP[1 + 3 * (size_t) i] = (int) yclose[i] - wy / 2 + eveny;
+      nodeP[2 + 3 * (size_t) i] = indl[i];
       zoffset[i] = wx * wy * indl[i];   
       grid.nextn[i] = -1;
     }
@@ -460,16 +710,27 @@ void ParticleList::locateOnGridNonUnifZ(Grid& grid)
     grid.number[ind] += 1;
   }
 
-  if (zG_ext) {fftw_free(zG_ext); zG_ext = 0;}
-  if (zG_ext_wts) {fftw_free(zG_ext_wts); zG_ext_wts = 0;}
-  if (indl) {fftw_free(indl); indl = 0;}
-  if (indr) {fftw_free(indr); indr = 0;}
-  if (xclose) {fftw_free(xclose); xclose = 0;}
-  if (yclose) {fftw_free(yclose); yclose = 0;}
+  if (indl) {alignedFree(indl); indl = 0;}
+  if (indr) {alignedFree(indr); indr = 0;}
+  if (xclose) {alignedFree(xclose); xclose = 0;}
+  if (yclose) {alignedFree(yclose); yclose = 0;}
 }
 
-void ParticleList::update(const double* xP_new, Grid& grid)
+void ParticleList::update(const double* _xP_new, Grid& grid)
 {
+  // new positions in the internal order
+  std::vector<double> xP_perm;
+  const double* xP_new = _xP_new;
+  if (perm)
+  {
+    xP_perm.resize(3 * (size_t) nP);
+    #pragma omp parallel for
+    for (unsigned int i = 0; i < nP; ++i)
+    {
+      for (unsigned int j = 0; j < 3; ++j) {xP_perm[j + 3 * (size_t) i] = _xP_new[j + 3 * (size_t) perm[i]];}
+    }
+    xP_new = xP_perm.data();
+  }
   // loop over unique alphas
   for (const double& alphaf : unique_alphafP)
   {
@@ -539,6 +800,13 @@ void ParticleList::update(const double* xP_new, Grid& grid)
       }
     }
   }
+  // the cached kernel weights are stale once the particles move
+  this->clearWeights();
+  // reorder lazily, once locality has degraded enough
+  if (reorder && this->disorder(grid, xP_new) > reorder_tol) 
+  {
+    this->reorderParticles(grid, xP_new);
+  }
 }
 
 /* write current state of ParticleList to ostream */
@@ -546,15 +814,17 @@ void ParticleList::writeParticles(std::ostream& outputStream) const
 {
   if (this->validState() && outputStream.good()) 
   { 
-    for (unsigned int i = 0; i < nP; ++i)
+    for (unsigned int c = 0; c < nP; ++c)
     {
+      // write in the caller's order
+      const unsigned int i = (iperm ? iperm[c] : c);
       for (unsigned int j = 0; j < 3; ++j)
       {
-        outputStream << std::setprecision(16) << xP[j + i * 3] << " ";
+        outputStream << std::setprecision(16) << xP[j + (size_t) i * 3] << " ";
       }
       for (unsigned int j = 0; j < this->dof; ++j)
       {
-        outputStream << fP[j + i * dof] << " ";
+        outputStream << fP[j + (size_t) i * dof] << " ";
       }
       outputStream << wfP[i] << " " << betafP[i] << " ";
       if (this->normalized) {outputStream << std::setprecision(16) << normfP[i] << " ";}
@@ -601,43 +871,86 @@ void ParticleList::cleanup()
 {
   if (this->validState())
   {
-    if (xP) {fftw_free(xP); xP = 0;}
-    if (fP) {fftw_free(fP); fP = 0;}
-    if (betafP) {fftw_free(betafP); betafP = 0;}
-    if (radP) {fftw_free(radP); radP = 0;}
-    if (cwfP) {fftw_free(cwfP); cwfP = 0;}
-    if (alphafP) {fftw_free(alphafP); alphafP = 0;}  
-    if (normfP) {fftw_free(normfP); normfP = 0;}  
-    if (wfP) {fftw_free(wfP); wfP = 0;} 
-    if (wfxP) {fftw_free(wfxP); wfxP = 0;} 
-    if (wfyP) {fftw_free(wfyP); wfyP = 0;} 
-    if (wfzP) {fftw_free(wfzP); wfzP = 0;} 
-    if (xunwrap) {fftw_free(xunwrap); xunwrap = 0;}
-    if (yunwrap) {fftw_free(yunwrap); yunwrap = 0;}
-    if (zunwrap) {fftw_free(zunwrap); zunwrap = 0;}
-    if (zoffset) {fftw_free(zoffset); zoffset = 0;}
+    if (xP) {alignedFree(xP); xP = 0;}
+    if (fP) {alignedFree(fP); fP = 0;}
+    if (betafP) {alignedFree(betafP); betafP = 0;}
+    if (radP) {alignedFree(radP); radP = 0;}
+    if (cwfP) {alignedFree(cwfP); cwfP = 0;}
+    if (alphafP) {alignedFree(alphafP); alphafP = 0;}  
+    if (normfP) {alignedFree(normfP); normfP = 0;}  
+    if (wfP) {alignedFree(wfP); wfP = 0;} 
+    if (wfxP) {alignedFree(wfxP); wfxP = 0;} 
+    if (wfyP) {alignedFree(wfyP); wfyP = 0;} 
+    if (wfzP) {alignedFree(wfzP); wfzP = 0;} 
+    if (nodeP) {alignedFree(nodeP); nodeP = 0;}
+    if (zoffset) {alignedFree(zoffset); zoffset = 0;}
 
-    if (pt_wts) {fftw_free(pt_wts); pt_wts = 0;}
+    if (layerP) {alignedFree(layerP); layerP = 0;}
+    if (zkern_layer) {alignedFree(zkern_layer); zkern_layer = 0;}
+    if (zwts_layer) {alignedFree(zwts_layer); zwts_layer = 0;}
+    if (perm) {alignedFree(perm); perm = 0;}
+    if (iperm) {alignedFree(iperm); iperm = 0;}
+    if (fP_out) {alignedFree(fP_out); fP_out = 0;}
+    this->clearWeights();
   }
 }
 
+MemoryReport ParticleList::memoryReport() const
+{
+  MemoryReport report;
+  addBuffer(report, "particles.xP", xP);
+  addBuffer(report, "particles.fP", fP);
+  addBuffer(report, "particles.radP", radP);
+  addBuffer(report, "particles.betafP", betafP);
+  addBuffer(report, "particles.cwfP", cwfP);
+  addBuffer(report, "particles.alphafP", alphafP);
+  addBuffer(report, "particles.normfP", normfP);
+  addBuffer(report, "particles.wfP", wfP);
+  addBuffer(report, "particles.wfxP", wfxP);
+  addBuffer(report, "particles.wfyP", wfyP);
+  addBuffer(report, "particles.wfzP", wfzP);
+  addBuffer(report, "particles.nodeP", nodeP);
+  addBuffer(report, "particles.zoffset", zoffset);
+  addBuffer(report, "particles.layerP", layerP);
+  addBuffer(report, "particles.zkern_layer", zkern_layer);
+  addBuffer(report, "particles.zwts_layer", zwts_layer);
+  addBuffer(report, "particles.kxP", kxP);
+  addBuffer(report, "particles.kyP", kyP);
+  addBuffer(report, "particles.kzP", kzP);
+  addBuffer(report, "particles.perm", perm);
+  addBuffer(report, "particles.iperm", iperm);
+  addBuffer(report, "particles.fP_out", fP_out);
+  return report;
+}
+
 void ParticleList::randInit(Grid& grid, const unsigned int _nP)
 {
   if (grid.validState())
   {
+    // any previous configuration is replaced, reusing its buffers
+    unique_monopoles.clear(); unique_alphafP.clear(); normalized = false;
+    if (perm) {alignedFree(perm); perm = 0;}
+    if (iperm) {alignedFree(iperm); iperm = 0;}
+    if (fP_out) {alignedFree(fP_out); fP_out = 0;}
+    grid.reset();
     nP = _nP;
     dof = grid.dof;
-    xP = (double*) fftw_malloc(nP * 3 * sizeof(double));
-    fP = (double*) fftw_malloc(nP * dof * sizeof(double));
-    betafP = (double*) fftw_malloc(nP * sizeof(double));
-    radP = (double*) fftw_malloc(nP * sizeof(double));
-    cwfP = (double*) fftw_malloc(nP * sizeof(double));
-    alphafP = (double*) fftw_malloc(nP * sizeof(double));
-    normfP = (double*) fftw_malloc(nP * sizeof(double));
-    wfP = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
-    wfxP = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
-    wfyP = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
-    wfzP = (unsigned short*) fftw_malloc(nP * sizeof(unsigned short));
+    xP = (double*) alignedReserve(xP, (size_t) nP * 3 * sizeof(double));
+    fP = (double*) alignedReserve(fP, (size_t) nP * dof * sizeof(double));
+    betafP = (double*) alignedReserve(betafP, nP * sizeof(double));
+    radP = (double*) alignedReserve(radP, nP * sizeof(double));
+    cwfP = (double*) alignedReserve(cwfP, nP * sizeof(double));
+    alphafP = (double*) alignedReserve(alphafP, nP * sizeof(double));
+    normfP = (double*) alignedReserve(normfP, nP * sizeof(double));
+    wfP = (unsigned short*) alignedReserve(wfP, nP * sizeof(unsigned short));
+    wfxP = (unsigned short*) alignedReserve(wfxP, nP * sizeof(unsigned short));
+    wfyP = (unsigned short*) alignedReserve(wfyP, nP * sizeof(unsigned short));
+    wfzP = (unsigned short*) alignedReserve(wfzP, nP * sizeof(unsigned short));
+    // the fill below is serial, so place the pages by the static particle partition first
+    firstTouch(xP, 3 * (size_t) nP); firstTouch(fP, (size_t) dof * nP);
+    firstTouch(betafP, nP); firstTouch(radP, nP); firstTouch(cwfP, nP);
+    firstTouch(alphafP, nP); firstTouch(normfP, nP); firstTouch(wfP, nP);
+    firstTouch(wfxP, nP); firstTouch(wfyP, nP); firstTouch(wfzP, nP);
     unsigned short ws[3] = {4, 5, 6};
     //unsigned short ws[3] = {6, 6, 6};
     //unsigned short ws[3] = {5, 5, 5};
@@ -657,12 +970,12 @@ void ParticleList::randInit(Grid& grid, const unsigned int _nP)
       unsigned int randInd;
       for (unsigned int i = 0; i < nP; ++i) 
       {
-        xP[3 * i] = drand48() * (grid.Lx - grid.hx); 
-        xP[1 + 3 * i] = drand48() * (grid.Ly - grid.hy); 
-        xP[2 + 3 * i] = drand48() * (grid.Lz - grid.hz); 
+        xP[3 * (size_t) i] = drand48() * (grid.Lx - grid.hx); 
+        xP[1 + 3 * (size_t) i] = drand48() * (grid.Ly - grid.hy); 
+        xP[2 + 3 * (size_t) i] = drand48() * (grid.Lz - grid.hz); 
         for (unsigned int j = 0; j < dof; ++j)
         {
-          fP[j + dof * i] = 10;//2 * drand48() - 1;
+          fP[j + dof * (size_t) i] = 10;//2 * drand48() - 1;
         }
         randInd = unifInd(gen);
         // usually, we multiply this by h 
@@ -678,12 +991,12 @@ void ParticleList::randInit(Grid& grid, const unsigned int _nP)
       unsigned int randInd;
       for (unsigned int i = 0; i < nP; ++i) 
       {
-        xP[3 * i] = drand48() * (grid.Lx - grid.hx); 
-        xP[1 + 3 * i] = drand48() * (grid.Ly - grid.hy); 
-        xP[2 + 3 * i] = drand48() * grid.Lz; 
+        xP[3 * (size_t) i] = drand48() * (grid.Lx - grid.hx); 
+        xP[1 + 3 * (size_t) i] = drand48() * (grid.Ly - grid.hy); 
+        xP[2 + 3 * (size_t) i] = drand48() * grid.Lz; 
         for (unsigned int j = 0; j < dof; ++j)
         {
-          fP[j + dof * i] = 10;//2 * drand48() - 1;
+          fP[j + dof * (size_t) i] = 10;//2 * drand48() - 1;
         }
         randInd = unifInd(gen);
         // usually, we multiply this by h 
@@ -2,9 +2,7 @@
 #include<math.h>
 #include<omp.h>
 
-#ifndef MEM_ALIGN
-  #define MEM_ALIGN 16
-#endif
+#include"Memory.h"
 
 /* Clenshaw-curtis nodes cpts and weights cwts,
  * i.e. the Chebyshev points of the second kind,
@@ -3,489 +3,801 @@
 #include"Grid.h"
 #include"ParticleList.h"
 #include"exceptions.h"
+#include"Memory.h"
 #include<omp.h>
 #include<fftw3.h>
 #include<algorithm>
 
+/* Column buffers of one thread for a spread/interp call. They are sized for the
+   largest column (npts particles, with kernels of at most wfxP_max x wfyP_max x wfzP_max
+   points), so each thread allocates them once per call rather than once per column.
+   Real is the type of the extended grid, and PReal that of the particle data of a column
+   (Real to spread, double to interpolate, which accumulates on the particles in double) */
+template<typename Real, typename PReal, typename Index>
+struct ColumnScratch
+{
+  Index* indc3D; Real *fGc, *delta, *deltax, *deltay; PReal *fPc, *plane;
+  double *betafPc, *normfPc, *xunwrap, *yunwrap, *zunwrap, *pt_wts;
+  unsigned int *indx, *zoffset; unsigned short *wfPc, *wzc, *layerPc;
+
+  ColumnScratch(const ParticleList& particles, const Grid& grid, const unsigned int npts)
+  {
+    const size_t wx = particles.wfxP_max, wy = particles.wfyP_max, wz = particles.wfzP_max;
+    const size_t subsz = wx * wy * grid.Nzeff;
+    indc3D = (Index*) alignedMalloc(subsz * sizeof(Index));
+    fGc = (Real*) alignedMalloc(subsz * grid.dof * sizeof(Real));
+    indx = (unsigned int*) alignedMalloc(npts * sizeof(unsigned int));
+    fPc = (PReal*) alignedMalloc(npts * particles.dof * sizeof(PReal));
+    betafPc = (double*) alignedMalloc(npts * sizeof(double));
+    normfPc = (double*) alignedMalloc(npts * sizeof(double));
+    wfPc = (unsigned short*) alignedMalloc(npts * sizeof(unsigned short));
+    wzc = (unsigned short*) alignedMalloc(npts * sizeof(unsigned short));
+    zoffset = (unsigned int*) alignedMalloc(npts * sizeof(unsigned int));
+    xunwrap = (double*) alignedMalloc(wx * npts * sizeof(double));
+    yunwrap = (double*) alignedMalloc(wy * npts * sizeof(double));
+    zunwrap = (double*) alignedMalloc(wz * npts * sizeof(double));
+    pt_wts = grid.unifZ ? 0 : (double*) alignedMalloc(wz * npts * sizeof(double));
+    // the layered path weighs the columns plane by plane, the other with full kernels
+    layerPc = 0; deltax = deltay = delta = 0; plane = 0;
+    if (particles.nlayers)
+    {
+      layerPc = (unsigned short*) alignedMalloc(npts * sizeof(unsigned short));
+      deltax = (Real*) alignedMalloc(wx * npts * sizeof(Real));
+      deltay = (Real*) alignedMalloc(wy * npts * sizeof(Real));
+      plane = (PReal*) alignedMalloc(wx * wy * grid.dof * sizeof(PReal));
+    }
+    else {delta = (Real*) alignedMalloc(wx * wy * wz * npts * sizeof(Real));}
+  }
+
+  ~ColumnScratch()
+  {
+    alignedFree(indc3D); alignedFree(fGc); alignedFree(indx); alignedFree(fPc);
+    alignedFree(betafPc); alignedFree(normfPc); alignedFree(wfPc); alignedFree(wzc);
+    alignedFree(zoffset); alignedFree(xunwrap); alignedFree(yunwrap); alignedFree(zunwrap);
+    alignedFree(pt_wts); alignedFree(layerPc); alignedFree(deltax); alignedFree(deltay);
+    alignedFree(plane); alignedFree(delta);
+  }
+};
+
+// largest number of particles in a column of the grid
+inline unsigned int maxColumnPoints(const Grid& grid)
+{
+  const size_t N2 = (size_t) grid.Nxeff * grid.Nyeff;
+  return N2 ? *std::max_element(grid.number, grid.number + N2) : 0;
+}
+
 void spread(ParticleList& particles, Grid& grid)
 {
+  if (particles.cache_weights && not particles.kxP) {particles.evalWeights(grid);}
   if (grid.unifZ) {spreadUnifZ(particles, grid);}
   else {spreadNonUnifZ(particles, grid);} 
 }
 
 void interpolate(ParticleList& particles, Grid& grid)
 {
+  if (particles.cache_weights && not particles.kxP) {particles.evalWeights(grid);}
   if (grid.unifZ) {interpUnifZ(particles, grid);}
   else {interpNonUnifZ(particles, grid);}
 }
 
-void spreadUnifZ(ParticleList& particles, Grid& grid)
+template<typename Real, typename Index>
+void spreadUnifZ(ParticleList& particles, Grid& grid, Real* fG_unwrap)
 {
-  // loop over unique alphas
-  for (const double& alphaf : particles.unique_alphafP)
+  // number of points on the extended grid, and strides between the 
+  // components and points of the extended grid (interleaved or planar)
+  const Index Neff = (Index) grid.Nxeff * grid.Nyeff * grid.Nzeff;
+  const Index ds = grid.planar ? Neff : 1, ps = grid.planar ? 1 : grid.dof;
+  // the column workspace of each thread, sized for the most populated column
+  const unsigned int npts_max = maxColumnPoints(grid);
+  #pragma omp parallel
   {
-    const unsigned short wx = std::round(2 * alphaf / grid.hx);
-    const unsigned short wy = std::round(2 * alphaf / grid.hy);
-    const unsigned short wz = std::round(2 * alphaf / grid.hz);
-    const unsigned short w2 = wx * wy;
-    const unsigned int kersz = w2 * wz; 
-    const unsigned int subsz = w2 * grid.Nzeff;
-    const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
-    // loop over w^2 groups of columns
-    for (unsigned int izero = 0; izero < wx; ++izero)
+    ColumnScratch<Real, Real, Index> scratch(particles, grid, npts_max);
+    // loop over unique alphas
+    for (const double& alphaf : particles.unique_alphafP)
     {
-      for (unsigned int jzero = 0; jzero < wy; ++jzero)
+      const unsigned short wx = std::round(2 * alphaf / grid.hx);
+      const unsigned short wy = std::round(2 * alphaf / grid.hy);
+      const unsigned short wz = std::round(2 * alphaf / grid.hz);
+      const unsigned short w2 = wx * wy;
+      const unsigned int kersz = w2 * wz; 
+      const unsigned int subsz = w2 * grid.Nzeff;
+      const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
+      // loop over w^2 groups of columns
+      for (unsigned int izero = 0; izero < wx; ++izero)
       {
-        // parallelize over the N^2/w^2 columns in a group
-        #pragma omp parallel for collapse(2)
-        for (unsigned int ii = izero; ii < grid.Nxeff; ii += wx)
+        for (unsigned int jzero = 0; jzero < wy; ++jzero)
         {
-          for (unsigned int jj = jzero; jj < grid.Nyeff; jj += wy)
-          { 
-            // number of pts in this column
-            unsigned int npts = grid.number[jj + ii * grid.Nyeff];
-            // find first particle in column(ii,jj) with matching alpha 
-            int l = grid.firstn[jj + ii * grid.Nyeff];
-            while (l >= 0 && particles.alphafP[l] != alphaf) 
-            {
-              l = grid.nextn[l];
-              npts -= 1;
-            }
-            // continue if it's there
-            if (l >= 0 && particles.alphafP[l] == alphaf)
-            {
-              // global indices of wx x wy x Nz subarray influenced by column(i,j)
-              unsigned int* indc3D = (unsigned int*) fftw_malloc(subsz * sizeof(unsigned int));
-              for (int k3D = 0; k3D < grid.Nzeff; ++k3D)
+          // parallelize over the N^2/w^2 columns in a group
+          #pragma omp for collapse(2)
+          for (unsigned int ii = izero; ii < grid.Nxeff; ii += wx)
+          {
+            for (unsigned int jj = jzero; jj < grid.Nyeff; jj += wy)
+            { 
+              // number of pts in this column
+              unsigned int npts = grid.number[jj + ii * grid.Nyeff];
+              // find first particle in column(ii,jj) with matching alpha 
+              int l = grid.firstn[jj + ii * grid.Nyeff];
+              while (l >= 0 && particles.alphafP[l] != alphaf) 
+              {
+                l = grid.nextn[l];
+                npts -= 1;
+              }
+              // continue if it's there
+              if (l >= 0 && particles.alphafP[l] == alphaf)
               {
-                for (int j = 0; j < wy; ++j)
+                // global indices of wx x wy x Nz subarray influenced by column(i,j)
+                Index* indc3D = scratch.indc3D;
+                for (int k3D = 0; k3D < grid.Nzeff; ++k3D)
                 {
-                  int j3D = jj + j - wy / 2 + eveny;
-                  for (int i = 0; i < wx; ++i) 
+                  for (int j = 0; j < wy; ++j)
                   {
-                    int i3D = ii + i - wx / 2 + evenx;
-                    indc3D[at(i,j,k3D,wx,wy)] = at(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff);
+                    int j3D = jj + j - wy / 2 + eveny;
+                    for (int i = 0; i < wx; ++i) 
+                    {
+                      int i3D = ii + i - wx / 2 + evenx;
+                      indc3D[at(i,j,k3D,wx,wy)] = (grid.pencil ? 
+                        atExt<Index, true>(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff, grid.Nzeff) :
+                        at<Index>(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff));
+                    }
                   }
                 }
-              }
-              // gather forces from grid subarray
-              double* fGc = (double*) fftw_malloc(subsz * grid.dof * sizeof(double));
-              gather(subsz, fGc, grid.fG_unwrap, indc3D, grid.dof);
-              // particle indices
-              unsigned int npts_match = 1, count  = 1; int ltmp = l;
-              // get other particles in col with this alphaf
-              for (unsigned int ipt = 1; ipt < npts; ++ipt) 
-              {
-                ltmp = grid.nextn[ltmp];
-                if (particles.alphafP[ltmp] == alphaf) {npts_match += 1;}
-              }
-              unsigned int* indx = (unsigned int*) fftw_malloc(npts_match * sizeof(unsigned int));
-              indx[0] = l;
-              for (unsigned int ipt = 1; ipt < npts; ++ipt)
-              {
-                l = grid.nextn[l];
-                if (particles.alphafP[l] == alphaf) {indx[count] = l; count += 1;}
-              }
+                // gather forces from grid subarray
+                Real* fGc = scratch.fGc;
+                if (grid.pencil) {gather_pencil(w2, grid.Nzeff, fGc, fG_unwrap, indc3D, grid.dof, ds, ps);}
+                else if (grid.planar) {gather_planar(subsz, fGc, fG_unwrap, indc3D, grid.dof, Neff);}
+                else {gather(subsz, fGc, fG_unwrap, indc3D, grid.dof);}
+                // particle indices
+                unsigned int npts_match = 1, count  = 1; int ltmp = l;
+                // get other particles in col with this alphaf
+                for (unsigned int ipt = 1; ipt < npts; ++ipt) 
+                {
+                  ltmp = grid.nextn[ltmp];
+                  if (particles.alphafP[ltmp] == alphaf) {npts_match += 1;}
+                }
+                unsigned int* indx = scratch.indx;
+                indx[0] = l;
+                for (unsigned int ipt = 1; ipt < npts; ++ipt)
+                {
+                  l = grid.nextn[l];
+                  if (particles.alphafP[l] == alphaf) {indx[count] = l; count += 1;}
+                }
+                // the layered path needs the particles in the column sorted by layer
+                if (particles.nlayers)
+                {
+                  std::stable_sort(indx, indx + npts_match, [&particles](const unsigned int a, 
+                                   const unsigned int b) {return particles.layerP[a] < particles.layerP[b];});
+                }
+
+                // gather particle pts, betas, forces etc. for this column
+                Real* fPc; double *betafPc, *normfPc, *xunwrap, *yunwrap, *zunwrap;
+                unsigned int* zoffset;
+                unsigned short* wfPc;
+                fPc = scratch.fPc; betafPc = scratch.betafPc; wfPc = scratch.wfPc;
+                normfPc = scratch.normfPc; xunwrap = scratch.xunwrap; yunwrap = scratch.yunwrap;
+                zunwrap = scratch.zunwrap; zoffset = scratch.zoffset;
+
+                gather(npts_match, betafPc, particles.betafP, indx, 1);
+                gather(npts_match, fPc, particles.fP, indx, particles.dof);
+                gather(npts_match, normfPc, particles.normfP, indx, 1);
+                gather(npts_match, wfPc, particles.wfP, indx, 1);
+                // if the kernel weights are cached, we gather them instead of the offsets
+                const bool cached = particles.kxP;
+                if (cached)
+                {
+                  gather(npts_match, xunwrap, particles.kxP, indx, particles.wfxP_max);
+                  gather(npts_match, yunwrap, particles.kyP, indx, particles.wfyP_max);
+                  gather(npts_match, zunwrap, particles.kzP, indx, particles.wfzP_max);
+                }
+                else {particles.stencils(grid, indx, npts_match, xunwrap, yunwrap, zunwrap, 0);}
+                gather(npts_match, zoffset, particles.zoffset, indx, 1);
+
+                if (particles.nlayers)
+                {
+                  // get the 1D x, y weights and spread layer by layer
+                  unsigned short *layerPc = scratch.layerPc, *wzc = scratch.wzc;
+                  gather(npts_match, layerPc, particles.layerP, indx, 1);
+                  gather(npts_match, wzc, particles.wfzP, indx, 1);
+                  Real* deltax = scratch.deltax;
+                  Real* deltay = scratch.deltay;
+                  Real* plane = scratch.plane;
+                  if (cached)
+                  {
+                    delta_col_xy_cached(deltax, deltay, xunwrap, yunwrap, npts_match, 
+                                        wx, wy, particles.wfxP_max, particles.wfyP_max);
+                  }
+                  else
+                  {
+                    delta_eval_col_xy(deltax, deltay, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
+                                      alphaf, npts_match, wx, wy, particles.wfxP_max, 
+                                      particles.wfyP_max);
+                  }
+                  spread_col_layer(fGc, plane, deltax, deltay, fPc, layerPc, particles.zkern_layer,
+                                   zoffset, npts_match, wx, wy, wzc, particles.wfzP_max, grid.dof);
+                }
+                else
+                {
+                  // get the kernel w x w x w kernel weights for each particle in col 
+                  Real* delta = scratch.delta;
+                  if (cached)
+                  {
+                    delta_col_cached(delta, xunwrap, yunwrap, zunwrap, npts_match, wx, wy, wz,
+                                     particles.wfxP_max, particles.wfyP_max, particles.wfzP_max);
+                  }
+                  else
+                  {
+                    delta_eval_col(delta, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
+                                   zunwrap, alphaf, npts_match, wx, wy, wz, particles.wfxP_max,
+                                   particles.wfyP_max, particles.wfzP_max);
+                  }
+
+                  // spread the particle forces with the kernel weights
+                  spread_col(fGc, delta, fPc, zoffset, npts_match, kersz, grid.dof);
+                }
 
-              // gather particle pts, betas, forces etc. for this column
-              double *fPc, *betafPc, *normfPc, *xunwrap, *yunwrap, *zunwrap;
-              unsigned int* zoffset;
-              unsigned short* wfPc;
-              fPc = (double*) fftw_malloc(npts_match * particles.dof * sizeof(double));
-              betafPc = (double*) fftw_malloc(npts_match * sizeof(double));
-              wfPc = (unsigned short*) fftw_malloc(npts_match * sizeof(unsigned short));
-              normfPc = (double*) fftw_malloc(npts_match * sizeof(double)); 
-              xunwrap = (double*) fftw_malloc(particles.wfxP_max * npts_match * sizeof(double)); 
-              yunwrap = (double*) fftw_malloc(particles.wfyP_max * npts_match * sizeof(double)); 
-              zunwrap = (double*) fftw_malloc(particles.wfzP_max * npts_match * sizeof(double));
-              zoffset = (unsigned int*) fftw_malloc(npts_match * sizeof(unsigned int));
-
-              gather(npts_match, betafPc, particles.betafP, indx, 1);
-              gather(npts_match, fPc, particles.fP, indx, particles.dof);
-              gather(npts_match, normfPc, particles.normfP, indx, 1);
-              gather(npts_match, wfPc, particles.wfP, indx, 1);
-              gather(npts_match, xunwrap, particles.xunwrap, indx, particles.wfxP_max);
-              gather(npts_match, yunwrap, particles.yunwrap, indx, particles.wfyP_max);
-              gather(npts_match, zunwrap, particles.zunwrap, indx, particles.wfzP_max);
-              gather(npts_match, zoffset, particles.zoffset, indx, 1);
-
-              // get the kernel w x w x w kernel weights for each particle in col 
-              double* delta = (double*) fftw_malloc(kersz * npts_match * sizeof(double));
-              delta_eval_col(delta, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
-                             zunwrap, alphaf, npts_match, wx, wy, wz, particles.wfxP_max,
-                             particles.wfyP_max, particles.wfzP_max);
-
-              // spread the particle forces with the kernel weights
-              spread_col(fGc, delta, fPc, zoffset, npts_match, kersz, grid.dof);
-
-              // scatter back to global eulerian grid
-              scatter(subsz, fGc, grid.fG_unwrap, indc3D, grid.dof);
-
-              fftw_free(fPc); fPc = 0; fftw_free(betafPc); 
-              betafPc = 0; fftw_free(wfPc); wfPc = 0; fftw_free(normfPc); normfPc = 0; 
-              fftw_free(xunwrap); xunwrap = 0; fftw_free(yunwrap); yunwrap = 0;
-              fftw_free(zunwrap); zunwrap = 0; fftw_free(zoffset); zoffset = 0; 
-              fftw_free(delta); delta = 0; fftw_free(indc3D); indc3D = 0; fftw_free(fGc); 
-              fGc = 0; fftw_free(indx); indx = 0;
-            } // finished with column
-          } 
-        } // finished with group of columns
-      }
-    } // finished with all groups
-  } // finished with this alphaf
+                // scatter back to global eulerian grid
+                if (grid.pencil) {scatter_pencil(w2, grid.Nzeff, fGc, fG_unwrap, indc3D, grid.dof, ds, ps);}
+                else if (grid.planar) {scatter_planar(subsz, fGc, fG_unwrap, indc3D, grid.dof, Neff);}
+                else {scatter(subsz, fGc, fG_unwrap, indc3D, grid.dof);}
+              } // finished with column
+            } 
+          } // finished with group of columns
+        }
+      } // finished with all groups
+    } // finished with this alphaf
+  } // finished with the parallel region
 }
 
-void interpUnifZ(ParticleList& particles, Grid& grid)
+template<typename Real, typename Index>
+void interpUnifZ(ParticleList& particles, Grid& grid, Real* fG_unwrap)
 {
-  // loop over unique alphas
-  for (const double& alphaf : particles.unique_alphafP)
+  // number of points on the extended grid, and strides between the 
+  // components and points of the extended grid (interleaved or planar)
+  const Index Neff = (Index) grid.Nxeff * grid.Nyeff * grid.Nzeff;
+  const Index ds = grid.planar ? Neff : 1, ps = grid.planar ? 1 : grid.dof;
+  // the column workspace of each thread, sized for the most populated column
+  const unsigned int npts_max = maxColumnPoints(grid);
+  #pragma omp parallel
   {
-    const unsigned short wx = std::round(2 * alphaf / grid.hx);
-    const unsigned short wy = std::round(2 * alphaf / grid.hy);
-    const unsigned short wz = std::round(2 * alphaf / grid.hz);
-    const unsigned short w2 = wx * wy;
-    const unsigned int kersz = w2 * wz; 
-    const unsigned int subsz = w2 * grid.Nzeff;
-    const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
-    const double weight = grid.hx * grid.hy * grid.hz;
-    // loop over w^2 groups of columns
-    for (unsigned int izero = 0; izero < wx; ++izero)
+    ColumnScratch<Real, double, Index> scratch(particles, grid, npts_max);
+    // loop over unique alphas
+    for (const double& alphaf : particles.unique_alphafP)
     {
-      for (unsigned int jzero = 0; jzero < wy; ++jzero)
+      const unsigned short wx = std::round(2 * alphaf / grid.hx);
+      const unsigned short wy = std::round(2 * alphaf / grid.hy);
+      const unsigned short wz = std::round(2 * alphaf / grid.hz);
+      const unsigned short w2 = wx * wy;
+      const unsigned int kersz = w2 * wz; 
+      const unsigned int subsz = w2 * grid.Nzeff;
+      const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
+      const double weight = grid.hx * grid.hy * grid.hz;
+      // loop over w^2 groups of columns
+      for (unsigned int izero = 0; izero < wx; ++izero)
       {
-        // parallelize over the N^2/w^2 columns in a group
-        #pragma omp parallel for collapse(2)
-        for (unsigned int ii = izero; ii < grid.Nxeff; ii += wx)
+        for (unsigned int jzero = 0; jzero < wy; ++jzero)
         {
-          for (unsigned int jj = jzero; jj < grid.Nyeff; jj += wy)
-          { 
-            // number of pts in this column
-            unsigned int npts = grid.number[jj + ii * grid.Nyeff];
-            // find first particle in column(ii,jj) with matching alpha 
-            int l = grid.firstn[jj + ii * grid.Nyeff];
-            while (l >= 0 && particles.alphafP[l] != alphaf) 
-            {
-              l = grid.nextn[l];
-              npts -= 1;
-            }
-            // continue if it's there
-            if (l >= 0 && particles.alphafP[l] == alphaf)
-            {
-              // global indices of wx x wy x Nz subarray influenced by column(i,j)
-              unsigned int* indc3D = (unsigned int*) fftw_malloc(subsz * sizeof(unsigned int));
-              for (int k3D = 0; k3D < grid.Nzeff; ++k3D)
+          // parallelize over the N^2/w^2 columns in a group
+          #pragma omp for collapse(2)
+          for (unsigned int ii = izero; ii < grid.Nxeff; ii += wx)
+          {
+            for (unsigned int jj = jzero; jj < grid.Nyeff; jj += wy)
+            { 
+              // number of pts in this column
+              unsigned int npts = grid.number[jj + ii * grid.Nyeff];
+              // find first particle in column(ii,jj) with matching alpha 
+              int l = grid.firstn[jj + ii * grid.Nyeff];
+              while (l >= 0 && particles.alphafP[l] != alphaf) 
               {
-                for (int j = 0; j < wy; ++j)
+                l = grid.nextn[l];
+                npts -= 1;
+              }
+              // continue if it's there
+              if (l >= 0 && particles.alphafP[l] == alphaf)
+              {
+                // global indices of wx x wy x Nz subarray influenced by column(i,j)
+                Index* indc3D = scratch.indc3D;
+                for (int k3D = 0; k3D < grid.Nzeff; ++k3D)
                 {
-                  int j3D = jj + j - wy / 2 + eveny;
-                  for (int i = 0; i < wx; ++i) 
+                  for (int j = 0; j < wy; ++j)
                   {
-                    int i3D = ii + i - wx / 2 + evenx;
-                    indc3D[at(i,j,k3D,wx,wy)] = at(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff);
+                    int j3D = jj + j - wy / 2 + eveny;
+                    for (int i = 0; i < wx; ++i) 
+                    {
+                      int i3D = ii + i - wx / 2 + evenx;
+                      indc3D[at(i,j,k3D,wx,wy)] = (grid.pencil ? 
+                        atExt<Index, true>(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff, grid.Nzeff) :
+                        at<Index>(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff));
+                    }
                   }
                 }
-              }
-              // gather forces from grid subarray
-              double* fGc = (double*) fftw_malloc(subsz * grid.dof * sizeof(double));
-              gather(subsz, fGc, grid.fG_unwrap, indc3D, grid.dof);
-              // particle indices
-              unsigned int npts_match = 1, count  = 1; int ltmp = l;
-              // get other particles in col with this alphaf
-              for (unsigned int ipt = 1; ipt < npts; ++ipt) 
-              {
-                ltmp = grid.nextn[ltmp];
-                if (particles.alphafP[ltmp] == alphaf) {npts_match += 1;}
-              }
-              unsigned int* indx = (unsigned int*) fftw_malloc(npts_match * sizeof(unsigned int));
-              indx[0] = l;
-              for (unsigned int ipt = 1; ipt < npts; ++ipt)
-              {
-                l = grid.nextn[l];
-                if (particles.alphafP[l] == alphaf) {indx[count] = l; count += 1;}
-              }
+                // gather forces from grid subarray
+                Real* fGc = scratch.fGc;
+                if (grid.pencil) {gather_pencil(w2, grid.Nzeff, fGc, fG_unwrap, indc3D, grid.dof, ds, ps);}
+                else if (grid.planar) {gather_planar(subsz, fGc, fG_unwrap, indc3D, grid.dof, Neff);}
+                else {gather(subsz, fGc, fG_unwrap, indc3D, grid.dof);}
+                // particle indices
+                unsigned int npts_match = 1, count  = 1; int ltmp = l;
+                // get other particles in col with this alphaf
+                for (unsigned int ipt = 1; ipt < npts; ++ipt) 
+                {
+                  ltmp = grid.nextn[ltmp];
+                  if (particles.alphafP[ltmp] == alphaf) {npts_match += 1;}
+                }
+                unsigned int* indx = scratch.indx;
+                indx[0] = l;
+                for (unsigned int ipt = 1; ipt < npts; ++ipt)
+                {
+                  l = grid.nextn[l];
+                  if (particles.alphafP[l] == alphaf) {indx[count] = l; count += 1;}
+                }
+                // the layered path needs the particles in the column sorted by layer
+                if (particles.nlayers)
+                {
+                  std::stable_sort(indx, indx + npts_match, [&particles](const unsigned int a, 
+                                   const unsigned int b) {return particles.layerP[a] < particles.layerP[b];});
+                }
+
+                // gather particle pts, betas, forces etc. for this column
+                double *fPc, *betafPc, *normfPc, *xunwrap, *yunwrap, *zunwrap;
+                unsigned int* zoffset; unsigned short* wfPc;
+                fPc = scratch.fPc; betafPc = scratch.betafPc; wfPc = scratch.wfPc;
+                normfPc = scratch.normfPc; xunwrap = scratch.xunwrap; yunwrap = scratch.yunwrap;
+                zunwrap = scratch.zunwrap; zoffset = scratch.zoffset;
+
+                gather(npts_match, betafPc, particles.betafP, indx, 1);
+                gather(npts_match, fPc, particles.fP, indx, particles.dof);
+                gather(npts_match, normfPc, particles.normfP, indx, 1);
+                gather(npts_match, wfPc, particles.wfP, indx, 1);
+                // if the kernel weights are cached, we gather them instead of the offsets
+                const bool cached = particles.kxP;
+                if (cached)
+                {
+                  gather(npts_match, xunwrap, particles.kxP, indx, particles.wfxP_max);
+                  gather(npts_match, yunwrap, particles.kyP, indx, particles.wfyP_max);
+                  gather(npts_match, zunwrap, particles.kzP, indx, particles.wfzP_max);
+                }
+                else {particles.stencils(grid, indx, npts_match, xunwrap, yunwrap, zunwrap, 0);}
+                gather(npts_match, zoffset, particles.zoffset, indx, 1);
 
-              // gather particle pts, betas, forces etc. for this column
-              double *fPc, *betafPc, *normfPc, *xunwrap, *yunwrap, *zunwrap;
-              unsigned int* zoffset; unsigned short* wfPc;
-              fPc = (double*) fftw_malloc(npts_match * particles.dof * sizeof(double));
-              betafPc = (double*) fftw_malloc(npts_match * sizeof(double));
-              wfPc = (unsigned short*) fftw_malloc(npts_match * sizeof(unsigned short));
-              normfPc = (double*) fftw_malloc(npts_match * sizeof(double)); 
-              xunwrap = (double*) fftw_malloc(particles.wfxP_max * npts_match * sizeof(double)); 
-              yunwrap = (double*) fftw_malloc(particles.wfyP_max * npts_match * sizeof(double)); 
-              zunwrap = (double*) fftw_malloc(particles.wfzP_max * npts_match * sizeof(double));
-              zoffset = (unsigned int*) fftw_malloc(npts_match * sizeof(unsigned int));
-
-              gather(npts_match, betafPc, particles.betafP, indx, 1);
-              gather(npts_match, fPc, particles.fP, indx, particles.dof);
-              gather(npts_match, normfPc, particles.normfP, indx, 1);
-              gather(npts_match, wfPc, particles.wfP, indx, 1);
-              gather(npts_match, xunwrap, particles.xunwrap, indx, particles.wfxP_max);
-              gather(npts_match, yunwrap, particles.yunwrap, indx, particles.wfyP_max);
-              gather(npts_match, zunwrap, particles.zunwrap, indx, particles.wfzP_max);
-              gather(npts_match, zoffset, particles.zoffset, indx, 1);
-
-              // get the kernel w x w x w kernel weights for each particle in col 
-              double* delta = (double*) fftw_malloc(kersz * npts_match * sizeof(double));
-              delta_eval_col(delta, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
-                             zunwrap, alphaf, npts_match, wx, wy, wz, particles.wfxP_max,
-                             particles.wfyP_max, particles.wfzP_max);
-
-              // interpolate on the particles with the kernel weights
-              interp_col(fGc, delta, fPc, zoffset, npts_match, kersz, grid.dof, weight);
-
-              // scatter back to global lagrangian grid
-              scatter(npts_match, fPc, particles.fP, indx, particles.dof);
-
-              fftw_free(fPc); fPc = 0; fftw_free(betafPc); 
-              betafPc = 0; fftw_free(wfPc); wfPc = 0; fftw_free(normfPc); normfPc = 0; 
-              fftw_free(xunwrap); xunwrap = 0; fftw_free(yunwrap); yunwrap = 0;
-              fftw_free(zunwrap); zunwrap = 0; fftw_free(zoffset); zoffset = 0; 
-              fftw_free(delta); delta = 0; fftw_free(indc3D); indc3D = 0; fftw_free(fGc); 
-              fGc = 0; fftw_free(indx); indx = 0;
-            } // finished with column
-          } 
-        } // finished with group of columns
-      }
-    } // finished with all groups
-  } // finished with this alphaf
+                if (particles.nlayers)
+                {
+                  // get the 1D x, y weights and interpolate layer by layer
+                  unsigned short *layerPc = scratch.layerPc, *wzc = scratch.wzc;
+                  gather(npts_match, layerPc, particles.layerP, indx, 1);
+                  gather(npts_match, wzc, particles.wfzP, indx, 1);
+                  Real* deltax = scratch.deltax;
+                  Real* deltay = scratch.deltay;
+                  double* plane = scratch.plane;
+                  if (cached)
+                  {
+                    delta_col_xy_cached(deltax, deltay, xunwrap, yunwrap, npts_match, 
+                                        wx, wy, particles.wfxP_max, particles.wfyP_max);
+                  }
+                  else
+                  {
+                    delta_eval_col_xy(deltax, deltay, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
+                                      alphaf, npts_match, wx, wy, particles.wfxP_max, 
+                                      particles.wfyP_max);
+                  }
+                  interp_col_layer(fGc, plane, deltax, deltay, fPc, layerPc, particles.zkern_layer,
+                                   0, weight, zoffset, npts_match, wx, wy, wzc, 
+                                   particles.wfzP_max, grid.dof);
+                }
+                else
+                {
+                  // get the kernel w x w x w kernel weights for each particle in col 
+                  Real* delta = scratch.delta;
+                  if (cached)
+                  {
+                    delta_col_cached(delta, xunwrap, yunwrap, zunwrap, npts_match, wx, wy, wz,
+                                     particles.wfxP_max, particles.wfyP_max, particles.wfzP_max);
+                  }
+                  else
+                  {
+                    delta_eval_col(delta, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
+                                   zunwrap, alphaf, npts_match, wx, wy, wz, particles.wfxP_max,
+                                   particles.wfyP_max, particles.wfzP_max);
+                  }
+
+                  // interpolate on the particles with the kernel weights
+                  interp_col(fGc, delta, fPc, zoffset, npts_match, kersz, grid.dof, weight);
+                }
+
+                // scatter back to global lagrangian grid
+                scatter(npts_match, fPc, particles.fP, indx, particles.dof);
+              } // finished with column
+            } 
+          } // finished with group of columns
+        }
+      } // finished with all groups
+    } // finished with this alphaf
+  } // finished with the parallel region
 }
 
-void spreadNonUnifZ(ParticleList& particles, Grid& grid)
+template<typename Real, typename Index>
+void spreadNonUnifZ(ParticleList& particles, Grid& grid, Real* fG_unwrap)
 {
-  // loop over unique alphas
-  for (const double& alphaf : particles.unique_alphafP)
+  // number of points on the extended grid, and strides between the 
+  // components and points of the extended grid (interleaved or planar)
+  const Index Neff = (Index) grid.Nxeff * grid.Nyeff * grid.Nzeff;
+  const Index ds = grid.planar ? Neff : 1, ps = grid.planar ? 1 : grid.dof;
+  // the column workspace of each thread, sized for the most populated column
+  const unsigned int npts_max = maxColumnPoints(grid);
+  #pragma omp parallel
   {
-    const unsigned short wx = std::round(2 * alphaf / grid.hx);
-    const unsigned short wy = std::round(2 * alphaf / grid.hy);
-    const unsigned short w2 = wx * wy;
-    const unsigned int subsz = w2 * grid.Nzeff;
-    const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
-    // loop over w^2 groups of columns
-    for (unsigned int izero = 0; izero < wx; ++izero)
+    ColumnScratch<Real, Real, Index> scratch(particles, grid, npts_max);
+    // loop over unique alphas
+    for (const double& alphaf : particles.unique_alphafP)
     {
-      for (unsigned int jzero = 0; jzero < wy; ++jzero)
+      const unsigned short wx = std::round(2 * alphaf / grid.hx);
+      const unsigned short wy = std::round(2 * alphaf / grid.hy);
+      const unsigned short w2 = wx * wy;
+      const unsigned int subsz = w2 * grid.Nzeff;
+      const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
+      // loop over w^2 groups of columns
+      for (unsigned int izero = 0; izero < wx; ++izero)
       {
-        // parallelize over the N^2/w^2 columns in a group
-        #pragma omp parallel for collapse(2)
-        for (unsigned int ii = izero; ii < grid.Nxeff; ii += wx)
+        for (unsigned int jzero = 0; jzero < wy; ++jzero)
         {
-          for (unsigned int jj = jzero; jj < grid.Nyeff; jj += wy)
+          // parallelize over the N^2/w^2 columns in a group
+          #pragma omp for collapse(2)
+          for (unsigned int ii = izero; ii < grid.Nxeff; ii += wx)
           {
-            // number of pts in this column
-            unsigned int npts = grid.number[jj + ii * grid.Nyeff];
-            // find first particle in column(ii,jj) with matching alpha 
-            int l = grid.firstn[jj + ii * grid.Nyeff];
-            while (l >= 0 && particles.alphafP[l] != alphaf) 
-            {
-              l = grid.nextn[l];
-              npts -= 1;
-            }
-            // continue if it's there
-            if (l >= 0 && particles.alphafP[l] == alphaf)
+            for (unsigned int jj = jzero; jj < grid.Nyeff; jj += wy)
             {
-              // global indices of wx x wy x Nz subarray influenced by column(i,j)
-              unsigned int* indc3D = (unsigned int*) fftw_malloc(subsz * sizeof(unsigned int));
-              for (int k3D = 0; k3D < grid.Nzeff; ++k3D)
+              // number of pts in this column
+              unsigned int npts = grid.number[jj + ii * grid.Nyeff];
+              // find first particle in column(ii,jj) with matching alpha 
+              int l = grid.firstn[jj + ii * grid.Nyeff];
+              while (l >= 0 && particles.alphafP[l] != alphaf) 
               {
-                for (int j = 0; j < wy; ++j)
+                l = grid.nextn[l];
+                npts -= 1;
+              }
+              // continue if it's there
+              if (l >= 0 && particles.alphafP[l] == alphaf)
+              {
+                // global indices of wx x wy x Nz subarray influenced by column(i,j)
+                Index* indc3D = scratch.indc3D;
+                for (int k3D = 0; k3D < grid.Nzeff; ++k3D)
                 {
-                  int j3D = jj + j - wy / 2 + eveny;
-                  for (int i = 0; i < wx; ++i) 
+                  for (int j = 0; j < wy; ++j)
                   {
-                    int i3D = ii + i - wx / 2 + evenx;
-                    indc3D[at(i,j,k3D,wx,wy)] = at(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff);
+                    int j3D = jj + j - wy / 2 + eveny;
+                    for (int i = 0; i < wx; ++i) 
+                    {
+                      int i3D = ii + i - wx / 2 + evenx;
+                      indc3D[at(i,j,k3D,wx,wy)] = (grid.pencil ? 
+                        atExt<Index, true>(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff, grid.Nzeff) :
+                        at<Index>(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff));
+                    }
                   }
                 }
-              }
-              // gather forces from grid subarray
-              double* fGc = (double*) fftw_malloc(subsz * grid.dof * sizeof(double));
-              gather(subsz, fGc, grid.fG_unwrap, indc3D, grid.dof);
-              // particle indices
-              unsigned int npts_match = 1, count  = 1; int ltmp = l;
-              // get other particles in col with this alphaf
-              for (unsigned int ipt = 1; ipt < npts; ++ipt) 
-              {
-                ltmp = grid.nextn[ltmp];
-                if (particles.alphafP[ltmp] == alphaf) {npts_match += 1;}
-              }
-              unsigned int* indx = (unsigned int*) fftw_malloc(npts_match * sizeof(unsigned int));
-              indx[0] = l;
-              for (unsigned int ipt = 1; ipt < npts; ++ipt)
-              {
-                l = grid.nextn[l];
-                if (particles.alphafP[l] == alphaf) {indx[count] = l; count += 1;}
-              }
+                // gather forces from grid subarray
+                Real* fGc = scratch.fGc;
+                if (grid.pencil) {gather_pencil(w2, grid.Nzeff, fGc, fG_unwrap, indc3D, grid.dof, ds, ps);}
+                else if (grid.planar) {gather_planar(subsz, fGc, fG_unwrap, indc3D, grid.dof, Neff);}
+                else {gather(subsz, fGc, fG_unwrap, indc3D, grid.dof);}
+                // particle indices
+                unsigned int npts_match = 1, count  = 1; int ltmp = l;
+                // get other particles in col with this alphaf
+                for (unsigned int ipt = 1; ipt < npts; ++ipt) 
+                {
+                  ltmp = grid.nextn[ltmp];
+                  if (particles.alphafP[ltmp] == alphaf) {npts_match += 1;}
+                }
+                unsigned int* indx = scratch.indx;
+                indx[0] = l;
+                for (unsigned int ipt = 1; ipt < npts; ++ipt)
+                {
+                  l = grid.nextn[l];
+                  if (particles.alphafP[l] == alphaf) {indx[count] = l; count += 1;}
+                }
+                // the layered path needs the particles in the column sorted by layer
+                if (particles.nlayers)
+                {
+                  std::stable_sort(indx, indx + npts_match, [&particles](const unsigned int a, 
+                                   const unsigned int b) {return particles.layerP[a] < particles.layerP[b];});
+                }
+
+                // gather particle pts, betas, forces etc. for this column
+                Real* fPc; double *betafPc, *normfPc, *xunwrap, *yunwrap, *zunwrap;
+                unsigned int* zoffset; unsigned short *wfPc, *wz;
+                fPc = scratch.fPc; betafPc = scratch.betafPc; wfPc = scratch.wfPc; wz = scratch.wzc;
+                normfPc = scratch.normfPc; xunwrap = scratch.xunwrap; yunwrap = scratch.yunwrap;
+                zunwrap = scratch.zunwrap; zoffset = scratch.zoffset;
+
+                gather(npts_match, betafPc, particles.betafP, indx, 1);
+                gather(npts_match, fPc, particles.fP, indx, particles.dof);
+                gather(npts_match, normfPc, particles.normfP, indx, 1);
+                gather(npts_match, wfPc, particles.wfP, indx, 1);
+                gather(npts_match, wz, particles.wfzP, indx, 1);
+                // if the kernel weights are cached, we gather them instead of the offsets
+                const bool cached = particles.kxP;
+                if (cached)
+                {
+                  gather(npts_match, xunwrap, particles.kxP, indx, particles.wfxP_max);
+                  gather(npts_match, yunwrap, particles.kyP, indx, particles.wfyP_max);
+                  gather(npts_match, zunwrap, particles.kzP, indx, particles.wfzP_max);
+                }
+                else {particles.stencils(grid, indx, npts_match, xunwrap, yunwrap, zunwrap, 0);}
+                gather(npts_match, zoffset, particles.zoffset, indx, 1);
+
 
-              // gather particle pts, betas, forces etc. for this column
-              double *fPc, *betafPc, *normfPc, *xunwrap, *yunwrap, *zunwrap;
-              unsigned int* zoffset; unsigned short *wfPc, *wz;
-              fPc = (double*) fftw_malloc(npts_match * particles.dof * sizeof(double));
-              betafPc = (double*) fftw_malloc(npts_match * sizeof(double));
-              wfPc = (unsigned short*) fftw_malloc(npts_match * sizeof(unsigned short));
-              wz = (unsigned short*) fftw_malloc(npts_match * sizeof(unsigned short));
-              normfPc = (double*) fftw_malloc(npts_match * sizeof(double)); 
-              xunwrap = (double*) fftw_malloc(particles.wfxP_max * npts_match * sizeof(double)); 
-              yunwrap = (double*) fftw_malloc(particles.wfyP_max * npts_match * sizeof(double)); 
-              zunwrap = (double*) fftw_malloc(particles.wfzP_max * npts_match * sizeof(double));
-              zoffset = (unsigned int*) fftw_malloc(npts_match * sizeof(unsigned int));
-
-              gather(npts_match, betafPc, particles.betafP, indx, 1);
-              gather(npts_match, fPc, particles.fP, indx, particles.dof);
-              gather(npts_match, normfPc, particles.normfP, indx, 1);
-              gather(npts_match, wfPc, particles.wfP, indx, 1);
-              gather(npts_match, wz, particles.wfzP, indx, 1);
-              gather(npts_match, xunwrap, particles.xunwrap, indx, particles.wfxP_max);
-              gather(npts_match, yunwrap, particles.yunwrap, indx, particles.wfyP_max);
-              gather(npts_match, zunwrap, particles.zunwrap, indx, particles.wfzP_max);
-              gather(npts_match, zoffset, particles.zoffset, indx, 1);
-
-
-              
-              const unsigned int kersz = w2 * (*std::max_element(wz, wz + npts_match));
-
-              // get the kernel w x w x w kernel weights for each particle in col 
-              double* delta = (double*) fftw_malloc(kersz * npts_match * sizeof(double));
-              delta_eval_col(delta, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
-                             zunwrap, alphaf, npts_match, wx, wy, wz, particles.wfxP_max,
-                             particles.wfyP_max, particles.wfzP_max);
-
-              // spread the particle forces with the kernel weights
-              spread_col(fGc, delta, fPc, zoffset, npts_match, w2, wz, grid.dof);
-
-              // scatter back to global eulerian grid
-              scatter(subsz, fGc, grid.fG_unwrap, indc3D, grid.dof);
-
-              fftw_free(fPc); fPc = 0; fftw_free(betafPc); fftw_free(wz); wz = 0; 
-              betafPc = 0; fftw_free(wfPc); wfPc = 0; fftw_free(normfPc); normfPc = 0; 
-              fftw_free(xunwrap); xunwrap = 0; fftw_free(yunwrap); yunwrap = 0;
-              fftw_free(zunwrap); zunwrap = 0; fftw_free(zoffset); zoffset = 0; 
-              fftw_free(delta); delta = 0; fftw_free(indc3D); indc3D = 0; fftw_free(fGc); 
-              fGc = 0; fftw_free(indx); indx = 0;
-            } // finished with column
-          } 
-        } // finished with group of columns
-      }
-    } // finished with all groups
-  } // finished with this alphaf
+                if (particles.nlayers)
+                {
+                  // get the 1D x, y weights and spread layer by layer
+                  unsigned short* layerPc = scratch.layerPc;
+                  gather(npts_match, layerPc, particles.layerP, indx, 1);
+                  Real* deltax = scratch.deltax;
+                  Real* deltay = scratch.deltay;
+                  Real* plane = scratch.plane;
+                  if (cached)
+                  {
+                    delta_col_xy_cached(deltax, deltay, xunwrap, yunwrap, npts_match, 
+                                        wx, wy, particles.wfxP_max, particles.wfyP_max);
+                  }
+                  else
+                  {
+                    delta_eval_col_xy(deltax, deltay, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
+                                      alphaf, npts_match, wx, wy, particles.wfxP_max, 
+                                      particles.wfyP_max);
+                  }
+                  spread_col_layer(fGc, plane, deltax, deltay, fPc, layerPc, particles.zkern_layer,
+                                   zoffset, npts_match, wx, wy, wz, particles.wfzP_max, grid.dof);
+                }
+                else
+                {
+                  // get the kernel w x w x w kernel weights for each particle in col 
+                  Real* delta = scratch.delta;
+                  if (cached)
+                  {
+                    delta_col_cached(delta, xunwrap, yunwrap, zunwrap, npts_match, wx, wy, wz,
+                                     particles.wfxP_max, particles.wfyP_max, particles.wfzP_max);
+                  }
+                  else
+                  {
+                    delta_eval_col(delta, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
+                                   zunwrap, alphaf, npts_match, wx, wy, wz, particles.wfxP_max,
+                                   particles.wfyP_max, particles.wfzP_max);
+                  }
+
+                  // spread the particle forces with the kernel weights
+                  spread_col(fGc, delta, fPc, zoffset, npts_match, w2, wz, grid.dof);
+                }
+
+                // scatter back to global eulerian grid
+                if (grid.pencil) {scatter_pencil(w2, grid.Nzeff, fGc, fG_unwrap, indc3D, grid.dof, ds, ps);}
+                else if (grid.planar) {scatter_planar(subsz, fGc, fG_unwrap, indc3D, grid.dof, Neff);}
+                else {scatter(subsz, fGc, fG_unwrap, indc3D, grid.dof);}
+              } // finished with column
+            } 
+          } // finished with group of columns
+        }
+      } // finished with all groups
+    } // finished with this alphaf
+  } // finished with the parallel region
 }
 
-void interpNonUnifZ(ParticleList& particles, Grid& grid)
+template<typename Real, typename Index>
+void interpNonUnifZ(ParticleList& particles, Grid& grid, Real* fG_unwrap)
 {
-  // loop over unique alphas
-  for (const double& alphaf : particles.unique_alphafP)
+  // number of points on the extended grid, and strides between the 
+  // components and points of the extended grid (interleaved or planar)
+  const Index Neff = (Index) grid.Nxeff * grid.Nyeff * grid.Nzeff;
+  const Index ds = grid.planar ? Neff : 1, ps = grid.planar ? 1 : grid.dof;
+  // the column workspace of each thread, sized for the most populated column
+  const unsigned int npts_max = maxColumnPoints(grid);
+  #pragma omp parallel
   {
-    const unsigned short wx = std::round(2 * alphaf / grid.hx);
-    const unsigned short wy = std::round(2 * alphaf / grid.hy);
-    const unsigned short w2 = wx * wy;
-    const unsigned int subsz = w2 * grid.Nzeff;
-    const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
-    // loop over w^2 groups of columns
-    for (unsigned int izero = 0; izero < wx; ++izero)
+    ColumnScratch<Real, double, Index> scratch(particles, grid, npts_max);
+    // loop over unique alphas
+    for (const double& alphaf : particles.unique_alphafP)
     {
-      for (unsigned int jzero = 0; jzero < wy; ++jzero)
+      const unsigned short wx = std::round(2 * alphaf / grid.hx);
+      const unsigned short wy = std::round(2 * alphaf / grid.hy);
+      const unsigned short w2 = wx * wy;
+      const unsigned int subsz = w2 * grid.Nzeff;
+      const int evenx = -1 * (wx % 2) + 1, eveny = -1 * (wy % 2) + 1;
+      // loop over w^2 groups of columns
+      for (unsigned int izero = 0; izero < wx; ++izero)
       {
-        // parallelize over the N^2/w^2 columns in a group
-        #pragma omp parallel for collapse(2)
-        for (unsigned int ii = izero; ii < grid.Nxeff; ii += wx)
+        for (unsigned int jzero = 0; jzero < wy; ++jzero)
         {
-          for (unsigned int jj = jzero; jj < grid.Nyeff; jj += wy)
+          // parallelize over the N^2/w^2 columns in a group
+          #pragma omp for collapse(2)
+          for (unsigned int ii = izero; ii < grid.Nxeff; ii += wx)
           {
-            // number of pts in this column
-            unsigned int npts = grid.number[jj + ii * grid.Nyeff];
-            // find first particle in column(ii,jj) with matching alpha 
-            int l = grid.firstn[jj + ii * grid.Nyeff];
-            while (l >= 0 && particles.alphafP[l] != alphaf) 
-            {
-              l = grid.nextn[l];
-              npts -= 1;
-            }
-            // continue if it's there
-            if (l >= 0 && particles.alphafP[l] == alphaf)
+            for (unsigned int jj = jzero; jj < grid.Nyeff; jj += wy)
             {
-              // global indices of wx x wy x Nz subarray influenced by column(i,j)
-              unsigned int* indc3D = (unsigned int*) fftw_malloc(subsz * sizeof(unsigned int));
-              for (int k3D = 0; k3D < grid.Nzeff; ++k3D)
+              // number of pts in this column
+              unsigned int npts = grid.number[jj + ii * grid.Nyeff];
+              // find first particle in column(ii,jj) with matching alpha 
+              int l = grid.firstn[jj + ii * grid.Nyeff];
+              while (l >= 0 && particles.alphafP[l] != alphaf) 
+              {
+                l = grid.nextn[l];
+                npts -= 1;
+              }
+              // continue if it's there
+              if (l >= 0 && particles.alphafP[l] == alphaf)
               {
-                for (int j = 0; j < wy; ++j)
+                // global indices of wx x wy x Nz subarray influenced by column(i,j)
+                Index* indc3D = scratch.indc3D;
+                for (int k3D = 0; k3D < grid.Nzeff; ++k3D)
                 {
-                  int j3D = jj + j - wy / 2 + eveny;
-                  for (int i = 0; i < wx; ++i) 
+                  for (int j = 0; j < wy; ++j)
                   {
-                    int i3D = ii + i - wx / 2 + evenx;
-                    indc3D[at(i,j,k3D,wx,wy)] = at(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff);
+                    int j3D = jj + j - wy / 2 + eveny;
+                    for (int i = 0; i < wx; ++i) 
+                    {
+                      int i3D = ii + i - wx / 2 + evenx;
+                      indc3D[at(i,j,k3D,wx,wy)] = (grid.pencil ? 
+                        atExt<Index, true>(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff, grid.Nzeff) :
+                        at<Index>(i3D, j3D, k3D, grid.Nxeff, grid.Nyeff));
+                    }
                   }
                 }
-              }
-              // gather forces from grid subarray
-              double* fGc = (double*) fftw_malloc(subsz * grid.dof * sizeof(double));
-              gather(subsz, fGc, grid.fG_unwrap, indc3D, grid.dof);
-              // particle indices
-              unsigned int npts_match = 1, count  = 1; int ltmp = l;
-              // get other particles in col with this alphaf
-              for (unsigned int ipt = 1; ipt < npts; ++ipt) 
-              {
-                ltmp = grid.nextn[ltmp];
-                if (particles.alphafP[ltmp] == alphaf) {npts_match += 1;}
-              }
-              unsigned int* indx = (unsigned int*) fftw_malloc(npts_match * sizeof(unsigned int));
-              indx[0] = l;
-              for (unsigned int ipt = 1; ipt < npts; ++ipt)
-              {
-                l = grid.nextn[l];
-                if (particles.alphafP[l] == alphaf) {indx[count] = l; count += 1;}
-              }
+                // gather forces from grid subarray
+                Real* fGc = scratch.fGc;
+                if (grid.pencil) {gather_pencil(w2, grid.Nzeff, fGc, fG_unwrap, indc3D, grid.dof, ds, ps);}
+                else if (grid.planar) {gather_planar(subsz, fGc, fG_unwrap, indc3D, grid.dof, Neff);}
+                else {gather(subsz, fGc, fG_unwrap, indc3D, grid.dof);}
+                // particle indices
+                unsigned int npts_match = 1, count  = 1; int ltmp = l;
+                // get other particles in col with this alphaf
+                for (unsigned int ipt = 1; ipt < npts; ++ipt) 
+                {
+                  ltmp = grid.nextn[ltmp];
+                  if (particles.alphafP[ltmp] == alphaf) {npts_match += 1;}
+                }
+                unsigned int* indx = scratch.indx;
+                indx[0] = l;
+                for (unsigned int ipt = 1; ipt < npts; ++ipt)
+                {
+                  l = grid.nextn[l];
+                  if (particles.alphafP[l] == alphaf) {indx[count] = l; count += 1;}
+                }
+                // the layered path needs the particles in the column sorted by layer
+                if (particles.nlayers)
+                {
+                  std::stable_sort(indx, indx + npts_match, [&particles](const unsigned int a, 
+                                   const unsigned int b) {return particles.layerP[a] < particles.layerP[b];});
+                }
+
+                // gather particle pts, betas, forces etc. for this column
+                double *fPc, *betafPc, *normfPc, *xunwrap, *yunwrap, *zunwrap, *pt_wts;
+                unsigned int* zoffset; unsigned short *wfPc, *wz;
+                fPc = scratch.fPc; betafPc = scratch.betafPc; wfPc = scratch.wfPc; wz = scratch.wzc;
+                normfPc = scratch.normfPc; xunwrap = scratch.xunwrap; yunwrap = scratch.yunwrap;
+                zunwrap = scratch.zunwrap; pt_wts = scratch.pt_wts; zoffset = scratch.zoffset;
+
+                gather(npts_match, betafPc, particles.betafP, indx, 1);
+                gather(npts_match, fPc, particles.fP, indx, particles.dof);
+                gather(npts_match, normfPc, particles.normfP, indx, 1);
+                gather(npts_match, wfPc, particles.wfP, indx, 1);
+                gather(npts_match, wz, particles.wfzP, indx, 1);
+                // if the kernel weights are cached, we gather them instead of the offsets
+                const bool cached = particles.kxP;
+                if (cached)
+                {
+                  gather(npts_match, xunwrap, particles.kxP, indx, particles.wfxP_max);
+                  gather(npts_match, yunwrap, particles.kyP, indx, particles.wfyP_max);
+                  gather(npts_match, zunwrap, particles.kzP, indx, particles.wfzP_max);
+                }
+                else {particles.stencils(grid, indx, npts_match, xunwrap, yunwrap, zunwrap, 0);}
+                particles.stencils(grid, indx, npts_match, 0, 0, 0, pt_wts);
+                gather(npts_match, zoffset, particles.zoffset, indx, 1);
+
+                if (particles.nlayers)
+                {
+                  // get the 1D x, y weights and interpolate layer by layer
+                  unsigned short* layerPc = scratch.layerPc;
+                  gather(npts_match, layerPc, particles.layerP, indx, 1);
+                  Real* deltax = scratch.deltax;
+                  Real* deltay = scratch.deltay;
+                  double* plane = scratch.plane;
+                  if (cached)
+                  {
+                    delta_col_xy_cached(deltax, deltay, xunwrap, yunwrap, npts_match, 
+                                        wx, wy, particles.wfxP_max, particles.wfyP_max);
+                  }
+                  else
+                  {
+                    delta_eval_col_xy(deltax, deltay, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
+                                      alphaf, npts_match, wx, wy, particles.wfxP_max, 
+                                      particles.wfyP_max);
+                  }
+                  interp_col_layer(fGc, plane, deltax, deltay, fPc, layerPc, particles.zkern_layer,
+                                   particles.zwts_layer, 0, zoffset, npts_match, wx, wy, wz, 
+                                   particles.wfzP_max, grid.dof);
+                }
+                else
+                {
+                  // get the kernel w x w x w kernel weights for each particle in col 
+                  Real* delta = scratch.delta;
+                  if (cached)
+                  {
+                    delta_col_cached(delta, xunwrap, yunwrap, zunwrap, npts_match, wx, wy, wz,
+                                     particles.wfxP_max, particles.wfyP_max, particles.wfzP_max);
+                  }
+                  else
+                  {
+                    delta_eval_col(delta, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
+                                   zunwrap, alphaf, npts_match, wx, wy, wz, particles.wfxP_max,
+                                   particles.wfyP_max, particles.wfzP_max);
+                  }
 
-              // gather particle pts, betas, forces etc. for this column
-              double *fPc, *betafPc, *normfPc, *xunwrap, *yunwrap, *zunwrap, *pt_wts;
-              unsigned int* zoffset; unsigned short *wfPc, *wz;
-              fPc = (double*) fftw_malloc(npts_match * particles.dof * sizeof(double));
-              betafPc = (double*) fftw_malloc(npts_match * sizeof(double));
-              wfPc = (unsigned short*) fftw_malloc(npts_match * sizeof(unsigned short));
-              wz = (unsigned short*) fftw_malloc(npts_match * sizeof(unsigned short));
-              normfPc = (double*) fftw_malloc(npts_match * sizeof(double)); 
-              xunwrap = (double*) fftw_malloc(particles.wfxP_max * npts_match * sizeof(double)); 
-              yunwrap = (double*) fftw_malloc(particles.wfyP_max * npts_match * sizeof(double)); 
-              zunwrap = (double*) fftw_malloc(particles.wfzP_max * npts_match * sizeof(double));
-              pt_wts = (double*) fftw_malloc(particles.wfzP_max * npts_match * sizeof(double));
-              zoffset = (unsigned int*) fftw_malloc(npts_match * sizeof(unsigned int));
-
-              gather(npts_match, betafPc, particles.betafP, indx, 1);
-              gather(npts_match, fPc, particles.fP, indx, particles.dof);
-              gather(npts_match, normfPc, particles.normfP, indx, 1);
-              gather(npts_match, wfPc, particles.wfP, indx, 1);
-              gather(npts_match, wz, particles.wfzP, indx, 1);
-              gather(npts_match, xunwrap, particles.xunwrap, indx, particles.wfxP_max);
-              gather(npts_match, yunwrap, particles.yunwrap, indx, particles.wfyP_max);
-              gather(npts_match, zunwrap, particles.zunwrap, indx, particles.wfzP_max);
-              gather(npts_match, pt_wts, particles.pt_wts, indx, particles.wfzP_max);
-              gather(npts_match, zoffset, particles.zoffset, indx, 1);
-
-              const unsigned int kersz = w2 * (*std::max_element(wz, wz + npts_match));
-
-              // get the kernel w x w x w kernel weights for each particle in col 
-              //alignas(MEM_ALIGN) double delta[kersz * npts_match];
-              double* delta = (double*) fftw_malloc(kersz * npts_match * sizeof(double));
-              delta_eval_col(delta, betafPc, wfPc, normfPc, xunwrap, yunwrap, 
-                             zunwrap, alphaf, npts_match, wx, wy, wz, particles.wfxP_max,
-                             particles.wfyP_max, particles.wfzP_max);
-
-              // spread the particle forces with the kernel weights
-              interp_col(fGc, delta, fPc, zoffset, npts_match, wx, wy, wz, particles.wfzP_max, grid.dof, pt_wts);
-
-              // scatter back to global lagrangian grid
-              scatter(npts_match, fPc, particles.fP, indx, particles.dof);
-
-              fftw_free(fPc); fPc = 0; fftw_free(betafPc); fftw_free(wz); wz = 0; 
-              betafPc = 0; fftw_free(wfPc); wfPc = 0; fftw_free(normfPc); normfPc = 0; 
-              fftw_free(xunwrap); xunwrap = 0; fftw_free(yunwrap); yunwrap = 0;
-              fftw_free(zunwrap); zunwrap = 0; fftw_free(zoffset); zoffset = 0; 
-              fftw_free(delta); delta = 0; fftw_free(indc3D); indc3D = 0; fftw_free(fGc); 
-              fGc = 0; fftw_free(indx); indx = 0;
-            } // finished with column
-          } 
-        } // finished with group of columns
-      }
-    } // finished with all groups
-  } // finished with this alphaf
+                  // interpolate on the particles with the kernel weights
+                  interp_col(fGc, delta, fPc, zoffset, npts_match, wx, wy, wz, particles.wfzP_max, grid.dof, pt_wts);
+                }
+
+                // scatter back to global lagrangian grid
+                scatter(npts_match, fPc, particles.fP, indx, particles.dof);
+              } // finished with column
+            } 
+          } // finished with group of columns
+        }
+      } // finished with all groups
+    } // finished with this alphaf
+  } // finished with the parallel region
+}
+
+void spreadUnifZ(ParticleList& particles, Grid& grid)
+{
+  // 64-bit offsets are only used if the extended grid data needs them
+  if (grid.largeIndex())
+  {
+    if (grid.single) {spreadUnifZ<float, size_t>(particles, grid, grid.fG_unwrap_f);}
+    else {spreadUnifZ<double, size_t>(particles, grid, grid.fG_unwrap);}
+  }
+  else
+  {
+    if (grid.single) {spreadUnifZ<float, unsigned int>(particles, grid, grid.fG_unwrap_f);}
+    else {spreadUnifZ<double, unsigned int>(particles, grid, grid.fG_unwrap);}
+  }
+}
+
+void interpUnifZ(ParticleList& particles, Grid& grid)
+{
+  // 64-bit offsets are only used if the extended grid data needs them
+  if (grid.largeIndex())
+  {
+    if (grid.single) {interpUnifZ<float, size_t>(particles, grid, grid.fG_unwrap_f);}
+    else {interpUnifZ<double, size_t>(particles, grid, grid.fG_unwrap);}
+  }
+  else
+  {
+    if (grid.single) {interpUnifZ<float, unsigned int>(particles, grid, grid.fG_unwrap_f);}
+    else {interpUnifZ<double, unsigned int>(particles, grid, grid.fG_unwrap);}
+  }
+}
+
+void spreadNonUnifZ(ParticleList& particles, Grid& grid)
+{
+  // 64-bit offsets are only used if the extended grid data needs them
+  if (grid.largeIndex())
+  {
+    if (grid.single) {spreadNonUnifZ<float, size_t>(particles, grid, grid.fG_unwrap_f);}
+    else {spreadNonUnifZ<double, size_t>(particles, grid, grid.fG_unwrap);}
+  }
+  else
+  {
+    if (grid.single) {spreadNonUnifZ<float, unsigned int>(particles, grid, grid.fG_unwrap_f);}
+    else {spreadNonUnifZ<double, unsigned int>(particles, grid, grid.fG_unwrap);}
+  }
+}
+
+void interpNonUnifZ(ParticleList& particles, Grid& grid)
+{
+  // 64-bit offsets are only used if the extended grid data needs them
+  if (grid.largeIndex())
+  {
+    if (grid.single) {interpNonUnifZ<float, size_t>(particles, grid, grid.fG_unwrap_f);}
+    else {interpNonUnifZ<double, size_t>(particles, grid, grid.fG_unwrap);}
+  }
+  else
+  {
+    if (grid.single) {interpNonUnifZ<float, unsigned int>(particles, grid, grid.fG_unwrap_f);}
+    else {interpNonUnifZ<double, unsigned int>(particles, grid, grid.fG_unwrap);}
+  }
 }
@@ -0,0 +1,311 @@
+#include<vector>
+#include<map>
+#include<array>
+#include<algorithm>
+#include<omp.h>
+#include<fftw3.h>
+#include"SpreadOperator.h"
+#include"SpreadInterp.h"
+#include"Grid.h"
+#include"ParticleList.h"
+#include"exceptions.h"
+#include"Memory.h"
+
+// for each index of an axis of the extended grid, the (interior index, coefficient)
+// pairs it contributes to (for fold) or receives from (for copy)
+typedef std::vector<std::vector<std::pair<size_t, double>>> AxisMap;
+// BCs at the 6 ends for a dof
+typedef std::array<BC, 6> BCSignature;
+
+// sign applied by a mirror BC
+inline double bcSign(const BC bc) {return (bc == mirror_inv ? -1.0 : 1.0);}
+
+/* 1D version of the fold along an axis with N extended points, lo and hi of which are
+   ghost points at the left and right ends. The ops match those of fold() */
+AxisMap foldMap(const unsigned int N, const unsigned int lo, const unsigned int hi,
+                const bool periodic, const BC bcl, const BC bcr)
+{
+  const unsigned int Nw = N - lo - hi, rbeg = N - hi;
+  // V[b] is the combination of extended points accumulated at point b
+  std::vector<std::map<unsigned int, double>> V(N);
+  for (unsigned int b = 0; b < N; ++b) {V[b][b] = 1;}
+  auto add = [&V](const unsigned int t, const unsigned int s, const double c)
+  {
+    const std::map<unsigned int, double> src = V[s];
+    for (const auto& e : src) {V[t][e.first] += c * e.second;}
+  };
+  if (periodic)
+  {
+    for (unsigned int a = 0; a < lo; ++a) {add(a + Nw, a, 1.0);}
+    for (unsigned int a = rbeg; a < N; ++a) {add(a - Nw, a, 1.0);}
+  }
+  else
+  {
+    if (bcl != none) {for (unsigned int a = 0; a <= lo; ++a) {add(2 * lo - a, a, bcSign(bcl));}}
+    if (bcr != none) {for (unsigned int a = rbeg - 1; a < N; ++a) {add(2 * rbeg - a - 2, a, bcSign(bcr));}}
+  }
+  AxisMap map(N);
+  for (unsigned int i = 0; i < Nw; ++i)
+  {
+    for (const auto& e : V[lo + i]) {if (e.second != 0) map[e.first].emplace_back(i, e.second);}
+  }
+  return map;
+}
+
+/* 1D version of the copy along an axis with N extended points. The ops match those
+   of copy(), except that ghost points with BC = none receive nothing */
+AxisMap copyMap(const unsigned int N, const unsigned int lo, const unsigned int hi,
+                const bool periodic, const BC bcl, const BC bcr)
+{
+  const unsigned int Nw = N - lo - hi, rbeg = N - hi;
+  // V[a] is the combination of interior points copied to extended point a
+  std::vector<std::map<unsigned int, double>> V(N);
+  for (unsigned int i = 0; i < Nw; ++i) {V[lo + i][i] = 1;}
+  auto set = [&V](const unsigned int t, const unsigned int s, const double c)
+  {
+    V[t].clear();
+    for (const auto& e : V[s]) {V[t][e.first] = c * e.second;}
+  };
+  if (periodic)
+  {
+    for (unsigned int a = 0; a < lo; ++a) {set(a, a + Nw, 1.0);}
+    for (unsigned int a = rbeg; a < N; ++a) {set(a, a - Nw, 1.0);}
+  }
+  else
+  {
+    if (bcl != none) {for (unsigned int a = 0; a < lo; ++a) {set(a, 2 * lo - a, bcSign(bcl));}}
+    if (bcr != none) {for (unsigned int a = rbeg; a < N; ++a) {set(a, 2 * rbeg - a - 2, bcSign(bcr));}}
+  }
+  AxisMap map(N);
+  for (unsigned int a = 0; a < N; ++a)
+  {
+    for (const auto& e : V[a]) {if (e.second != 0) map[a].emplace_back(e.first, e.second);}
+  }
+  return map;
+}
+
+// sort (index, value) pairs by index and sum duplicates
+void compress(std::vector<std::pair<size_t, double>>& entries)
+{
+  std::sort(entries.begin(), entries.end(), [](const std::pair<size_t, double>& a,
+            const std::pair<size_t, double>& b) {return a.first < b.first;});
+  size_t n = 0;
+  for (size_t e = 0; e < entries.size(); ++e)
+  {
+    if (n > 0 && entries[n - 1].first == entries[e].first) {entries[n - 1].second += entries[e].second;}
+    else {entries[n++] = entries[e];}
+  }
+  entries.resize(n);
+}
+
+SpreadOperator::SpreadOperator() : S_rowptr(0), S_colind(0), J_rowptr(0), J_colind(0),
+                                   S_val(0), J_val(0), dof_group(0), ngroups(0),
+                                   nP(0), Nx(0), Ny(0), Nz(0), dof(0), planar(false)
+{}
+
+void SpreadOperator::build(ParticleList& particles, Grid& grid)
+{
+  if (not grid.has_locator)
+  {
+    exitErr("Particles must be setup on the grid before building the spread operator.");
+  }
+  this->cleanup();
+  nP = particles.nP; dof = grid.dof; planar = grid.planar;
+  Nx = grid.Nx; Ny = grid.Ny; Nz = grid.Nz;
+  const unsigned short wx_max = particles.wfxP_max, wy_max = particles.wfyP_max;
+  const unsigned int ext_up = grid.unifZ ? particles.wfzP_max : particles.ext_up;
+  const unsigned int ext_down = grid.unifZ ? particles.wfzP_max : particles.ext_down;
+
+  // group the dofs by BC signature (BCs of periodic axes don't matter)
+  std::vector<BCSignature> signatures;
+  dof_group = (unsigned int*) alignedMalloc(dof * sizeof(unsigned int));
+  for (unsigned int d = 0; d < dof; ++d)
+  {
+    BCSignature sig;
+    for (unsigned int end = 0; end < 6; ++end)
+    {
+      sig[end] = (grid.isperiodic[end / 2] ? none : grid.BCs[d + end * dof]);
+    }
+    auto it = std::find(signatures.begin(), signatures.end(), sig);
+    dof_group[d] = it - signatures.begin();
+    if (it == signatures.end()) {signatures.push_back(sig);}
+  }
+  ngroups = signatures.size();
+  S_rowptr = (size_t**) alignedMalloc(ngroups * sizeof(size_t*));
+  S_colind = (unsigned int**) alignedMalloc(ngroups * sizeof(unsigned int*));
+  S_val = (double**) alignedMalloc(ngroups * sizeof(double*));
+  J_rowptr = (size_t**) alignedMalloc(ngroups * sizeof(size_t*));
+  J_colind = (size_t**) alignedMalloc(ngroups * sizeof(size_t*));
+  J_val = (double**) alignedMalloc(ngroups * sizeof(double*));
+
+  // separable kernel weights of each particle
+  const bool cached = particles.kxP;
+  if (not cached) {particles.evalWeights(grid);}
+  const double weight = grid.hx * grid.hy * grid.hz;
+  const size_t N = (size_t) Nx * Ny * Nz;
+
+  for (unsigned int g = 0; g < ngroups; ++g)
+  {
+    const BCSignature& sig = signatures[g];
+    const AxisMap fx = foldMap(grid.Nxeff, wx_max, wx_max, grid.isperiodic[0], sig[0], sig[1]);
+    const AxisMap fy = foldMap(grid.Nyeff, wy_max, wy_max, grid.isperiodic[1], sig[2], sig[3]);
+    const AxisMap fz = foldMap(grid.Nzeff, ext_up, ext_down, grid.isperiodic[2], sig[4], sig[5]);
+    const AxisMap cx = copyMap(grid.Nxeff, wx_max, wx_max, grid.isperiodic[0], sig[0], sig[1]);
+    const AxisMap cy = copyMap(grid.Nyeff, wy_max, wy_max, grid.isperiodic[1], sig[2], sig[3]);
+    const AxisMap cz = copyMap(grid.Nzeff, ext_up, ext_down, grid.isperiodic[2], sig[4], sig[5]);
+    // columns of S and rows of J for each particle
+    std::vector<std::vector<std::pair<size_t, double>>> Scols(nP), Jrows(nP);
+    #pragma omp parallel
+    {
+      // quadrature weights of the z stencil of a particle, one buffer per thread
+      double* pt_wts = (double*) alignedMalloc(particles.wfzP_max * sizeof(double));
+      #pragma omp for
+      for (unsigned int p = 0; p < nP; ++p)
+      {
+        const unsigned short wx = particles.wfxP[p], wy = particles.wfyP[p], wz = particles.wfzP[p];
+        // first node of the stencil on the extended grid 
+        const unsigned int i0 = particles.nodeP[3 * (size_t) p] + wx_max;
+        const unsigned int j0 = particles.nodeP[1 + 3 * (size_t) p] + wy_max;
+        const unsigned int k0 = particles.zoffset[p] / (wx * wy);
+        std::fill(pt_wts, pt_wts + particles.wfzP_max, weight);
+        particles.stencils(grid, &p, 1, 0, 0, 0, pt_wts);
+        for (unsigned int k = 0; k < wz; ++k)
+        {
+          const double kz = particles.kzP[k + (size_t) p * particles.wfzP_max];
+          const double wk = pt_wts[k];
+          for (unsigned int j = 0; j < wy; ++j)
+          {
+            const double kyz = particles.kyP[j + (size_t) p * wy_max] * kz;
+            for (unsigned int i = 0; i < wx; ++i)
+            {
+              const double delta = particles.kxP[i + (size_t) p * wx_max] * kyz;
+              for (const auto& ez : fz[k0 + k])
+                for (const auto& ey : fy[j0 + j])
+                  for (const auto& ex : fx[i0 + i])
+                  {
+                    Scols[p].emplace_back(at<size_t>(ex.first, ey.first, ez.first, Nx, Ny),
+                                          delta * ex.second * ey.second * ez.second);
+                  }
+              for (const auto& ez : cz[k0 + k])
+                for (const auto& ey : cy[j0 + j])
+                  for (const auto& ex : cx[i0 + i])
+                  {
+                    Jrows[p].emplace_back(at<size_t>(ex.first, ey.first, ez.first, Nx, Ny),
+                                          delta * wk * ex.second * ey.second * ez.second);
+                  }
+            }
+          }
+        }
+        compress(Scols[p]); compress(Jrows[p]);
+      }
+      alignedFree(pt_wts);
+    }
+    // J is already in row (particle) order
+    J_rowptr[g] = (size_t*) alignedMalloc((nP + 1) * sizeof(size_t));
+    J_rowptr[g][0] = 0;
+    for (unsigned int p = 0; p < nP; ++p) {J_rowptr[g][p + 1] = J_rowptr[g][p] + Jrows[p].size();}
+    J_colind[g] = (size_t*) alignedMalloc(J_rowptr[g][nP] * sizeof(size_t));
+    J_val[g] = (double*) alignedMalloc(J_rowptr[g][nP] * sizeof(double));
+    #pragma omp parallel for
+    for (unsigned int p = 0; p < nP; ++p)
+    {
+      for (size_t e = 0; e < Jrows[p].size(); ++e)
+      {
+        J_colind[g][J_rowptr[g][p] + e] = Jrows[p][e].first;
+        J_val[g][J_rowptr[g][p] + e] = Jrows[p][e].second;
+      }
+    }
+    // transpose the columns of S into rows (grid nodes)
+    S_rowptr[g] = (size_t*) alignedMalloc((N + 1) * sizeof(size_t));
+    for (size_t r = 0; r <= N; ++r) {S_rowptr[g][r] = 0;}
+    for (unsigned int p = 0; p < nP; ++p)
+    {
+      for (const auto& e : Scols[p]) {S_rowptr[g][e.first + 1] += 1;}
+    }
+    for (size_t r = 0; r < N; ++r) {S_rowptr[g][r + 1] += S_rowptr[g][r];}
+    S_colind[g] = (unsigned int*) alignedMalloc(S_rowptr[g][N] * sizeof(unsigned int));
+    S_val[g] = (double*) alignedMalloc(S_rowptr[g][N] * sizeof(double));
+    std::vector<size_t> fill(S_rowptr[g], S_rowptr[g] + N);
+    for (unsigned int p = 0; p < nP; ++p)
+    {
+      for (const auto& e : Scols[p])
+      {
+        S_colind[g][fill[e.first]] = p;
+        S_val[g][fill[e.first]] = e.second;
+        fill[e.first] += 1;
+      }
+    }
+  }
+  if (not cached && not particles.cache_weights) {particles.clearWeights();}
+}
+
+void SpreadOperator::spread(const double* fP, double* fG) const
+{
+  const size_t N = (size_t) Nx * Ny * Nz;
+  // strides between the components and points of fG (interleaved or planar)
+  const size_t ds = planar ? N : 1, ps = planar ? 1 : dof;
+  for (unsigned int g = 0; g < ngroups; ++g)
+  {
+    const size_t* rowptr = S_rowptr[g];
+    const unsigned int* colind = S_colind[g];
+    const double* val = S_val[g];
+    #pragma omp parallel for
+    for (size_t r = 0; r < N; ++r)
+    {
+      for (unsigned int d = 0; d < dof; ++d)
+      {
+        if (dof_group[d] != g) continue;
+        double sum = 0;
+        for (size_t e = rowptr[r]; e < rowptr[r + 1]; ++e)
+        {
+          sum += val[e] * fP[d + (size_t) dof * colind[e]];
+        }
+        fG[ds * d + ps * r] = sum;
+      }
+    }
+  }
+}
+
+void SpreadOperator::interpolate(const double* fG, double* fP) const
+{
+  const size_t ds = planar ? (size_t) Nx * Ny * Nz : 1, ps = planar ? 1 : dof;
+  for (unsigned int g = 0; g < ngroups; ++g)
+  {
+    const size_t *rowptr = J_rowptr[g], *colind = J_colind[g];
+    const double* val = J_val[g];
+    #pragma omp parallel for
+    for (unsigned int p = 0; p < nP; ++p)
+    {
+      for (unsigned int d = 0; d < dof; ++d)
+      {
+        if (dof_group[d] != g) continue;
+        double sum = 0;
+        for (size_t e = rowptr[p]; e < rowptr[p + 1]; ++e)
+        {
+          sum += val[e] * fG[ds * d + ps * colind[e]];
+        }
+        fP[d + (size_t) dof * p] = sum;
+      }
+    }
+  }
+}
+
+size_t SpreadOperator::nnzS(const unsigned int g) const {return S_rowptr[g][(size_t) Nx * Ny * Nz];}
+size_t SpreadOperator::nnzJ(const unsigned int g) const {return J_rowptr[g][nP];}
+
+void SpreadOperator::cleanup()
+{
+  for (unsigned int g = 0; g < ngroups; ++g)
+  {
+    alignedFree(S_rowptr[g]); alignedFree(S_colind[g]); alignedFree(S_val[g]);
+    alignedFree(J_rowptr[g]); alignedFree(J_colind[g]); alignedFree(J_val[g]);
+  }
+  if (S_rowptr) {alignedFree(S_rowptr); S_rowptr = 0;}
+  if (S_colind) {alignedFree(S_colind); S_colind = 0;}
+  if (S_val) {alignedFree(S_val); S_val = 0;}
+  if (J_rowptr) {alignedFree(J_rowptr); J_rowptr = 0;}
+  if (J_colind) {alignedFree(J_colind); J_colind = 0;}
+  if (J_val) {alignedFree(J_val); J_val = 0;}
+  if (dof_group) {alignedFree(dof_group); dof_group = 0;}
+  ngroups = 0;
+}
@@ -0,0 +1,125 @@
+#include "TPStokes.h"
+#include "exceptions.h"
+#include<omp.h>
+#include<math.h>
+
+template<typename Real>
+TPStokesT<Real>::TPStokesT() : kx(0), ky(0), kz(0), ksqinv(0), Nx(0), Ny(0), Nz(0), Nxs(0),
+                               nrhs(0), eta(0), planar(false), real(false) {}
+
+template<typename Real>
+TPStokesT<Real>::TPStokesT(const unsigned int _Nx, const unsigned int _Ny, const unsigned int _Nz,
+                           const double Lx, const double Ly, const double Lz, const double _eta,
+                           const unsigned int _nrhs, const bool _planar, const bool _real)
+  : TPStokesT()
+{
+  setup(_Nx, _Ny, _Nz, Lx, Ly, Lz, _eta, _nrhs, _planar, _real);
+}
+
+namespace
+{
+  // wave numbers 2 pi n / L of an axis of N points, in the order of the DFT:
+  // n = 0, ..., ceil(N/2) - 1, then -floor(N/2), ..., -1. So the unpaired mode of 
+  // even N is -N/2, as in Solvers.py. For odd N, Solvers.py instead takes 
+  // n = 0, ..., floor(N/2) - 1, then -ceil(N/2), ..., -1, which puts -(N+1)/2 
+  // in place of (N-1)/2. It is not a frequency of the DFT, so the two differ there
+  template<typename Real>
+  void waveNumbers(Real* k, const unsigned int n, const unsigned int N, const double L)
+  {
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      k[i] = 2 * M_PI / L * (i < (N + 1) / 2 ? (double) i : (double) i - N);
+    }
+  }
+}
+
+template<typename Real>
+void TPStokesT<Real>::setup(const unsigned int _Nx, const unsigned int _Ny, const unsigned int _Nz,
+                            const double Lx, const double Ly, const double Lz, const double _eta,
+                            const unsigned int _nrhs, const bool _planar, const bool _real)
+{
+  if (not _nrhs) {exitErr("TPStokes needs at least one right-hand side.");}
+  cleanup();
+  Nx = _Nx; Ny = _Ny; Nz = _Nz; nrhs = _nrhs; eta = _eta; planar = _planar; real = _real;
+  Nxs = real ? Nx / 2 + 1 : Nx;
+  kx = (Real*) alignedMalloc(Nxs * sizeof(Real));
+  ky = (Real*) alignedMalloc(Ny * sizeof(Real));
+  kz = (Real*) alignedMalloc(Nz * sizeof(Real));
+  ksqinv = (Real*) alignedMalloc((size_t) Nz * Ny * Nxs * sizeof(Real));
+  if (not (kx && ky && kz && ksqinv)) {exitErr("Could not allocate the TPStokes multipliers.");}
+  waveNumbers(kx, Nxs, Nx, Lx); waveNumbers(ky, Ny, Ny, Ly); waveNumbers(kz, Nz, Nz, Lz);
+  // same partition as solve(), so the pages of ksqinv are placed by first touch
+  #pragma omp parallel for collapse(2) schedule(static)
+  for (unsigned int k = 0; k < Nz; ++k)
+  {
+    for (unsigned int j = 0; j < Ny; ++j)
+    {
+      Real* w = ksqinv + ((size_t) k * Ny + j) * Nxs;
+      const double kyz = (double) ky[j] * ky[j] + (double) kz[k] * kz[k];
+      for (unsigned int i = 0; i < Nxs; ++i)
+      {
+        const double ksq = kyz + (double) kx[i] * kx[i];
+        w[i] = ksq ? 1 / ksq : 0;
+      }
+    }
+  }
+}
+
+template<typename Real>
+void TPStokesT<Real>::solve(const Real* f_hat_r, const Real* f_hat_i,
+                            Real* u_hat_r, Real* u_hat_i) const
+{
+  // offsets of a wave number (sp) and of a component (sc) in the spectrum
+  const size_t sp = planar ? 1 : 3 * nrhs, sc = planar ? (size_t) Nz * Ny * Nxs : 1;
+  const Real etainv = 1 / eta;
+  #pragma omp parallel for collapse(2) schedule(static)
+  for (unsigned int k = 0; k < Nz; ++k)
+  {
+    for (unsigned int j = 0; j < Ny; ++j)
+    {
+      const size_t row = ((size_t) k * Ny + j) * Nxs;
+      const Real kyj = ky[j], kzk = kz[k];
+      const Real* w = ksqinv + row;
+      for (unsigned int r = 0; r < nrhs; ++r)
+      {
+        // x component of field r at the first wave number of the row
+        const size_t offset = row * sp + 3 * r * sc;
+        #pragma omp simd
+        for (unsigned int i = 0; i < Nxs; ++i)
+        {
+          const size_t ix = offset + i * sp, iy = ix + sc, iz = iy + sc;
+          const Real fxr = f_hat_r[ix], fyr = f_hat_r[iy], fzr = f_hat_r[iz];
+          const Real fxi = f_hat_i[ix], fyi = f_hat_i[iy], fzi = f_hat_i[iz];
+          const Real kxi = kx[i], wi = w[i], s = etainv * wi;
+          // (k . f) / |k|^2
+          const Real pr = wi * (kxi * fxr + kyj * fyr + kzk * fzr);
+          const Real pi = wi * (kxi * fxi + kyj * fyi + kzk * fzi);
+          u_hat_r[ix] = s * (fxr - kxi * pr); u_hat_i[ix] = s * (fxi - kxi * pi);
+          u_hat_r[iy] = s * (fyr - kyj * pr); u_hat_i[iy] = s * (fyi - kyj * pi);
+          u_hat_r[iz] = s * (fzr - kzk * pr); u_hat_i[iz] = s * (fzi - kzk * pi);
+        }
+      }
+    }
+  }
+}
+
+template<typename Real>
+MemoryReport TPStokesT<Real>::memoryReport() const
+{
+  MemoryReport report;
+  addBuffer(report, "tpstokes.kx", kx);
+  addBuffer(report, "tpstokes.ky", ky);
+  addBuffer(report, "tpstokes.kz", kz);
+  addBuffer(report, "tpstokes.ksqinv", ksqinv);
+  return report;
+}
+
+template<typename Real>
+void TPStokesT<Real>::cleanup()
+{
+  alignedFree(kx); alignedFree(ky); alignedFree(kz); alignedFree(ksqinv);
+  kx = ky = kz = ksqinv = 0;
+}
+
+template struct TPStokesT<double>;
+template struct TPStokesT<float>;
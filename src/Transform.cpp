@@ -1,122 +1,462 @@
 #include "Transform.h"
+#include "Memory.h"
 #include<omp.h>
 #include<iostream>
+#include<fstream>
+#include<string>
 
-Transform::Transform() : in_real(0),in_complex(0),out_real(0),out_complex(0),
-                         Nx(0),Ny(0),Nz(0),dof(0),rank(0) {}
+namespace
+{
+  // file the wisdom of persistent plans is exported to (see setWisdomFile())
+  std::string wisdom_file;
+
+  // wisdom file of the plans of each precision (fftw keeps separate wisdom for each)
+  template<typename Real> std::string wisdomFile() {return wisdom_file;}
+  template<> std::string wisdomFile<float>() {return wisdom_file + ".single";}
+
+  // import the wisdom of precision Real, if its file exists
+  template<typename Real> bool importWisdom()
+  {
+    const std::string fname = wisdomFile<Real>();
+    // fftw prints an error for a file that does not exist yet, so check first
+    if (not std::ifstream(fname).good()) return false;
+    return FFTW<Real>::import_wisdom(fname.c_str());
+  }
+}
+
+template<typename Real>
+TransformT<Real>::TransformT() : in_real(0),in_complex(0),out_real(0),out_complex(0),
+                         dims(0),howmany_dims(0),Nx(0),Ny(0),Nz(0),dof(0),rank(0),
+                         planar(false),mode(0),real(false),cheb(false),kmajor(false),bound(false) {}
 
 
 // Constructs forward plan and executes - assumes input has 0 complex part
-Transform::Transform(const double* _in_real, const unsigned int _Nx, 
+template<typename Real>
+TransformT<Real>::TransformT(const Real* _in_real, const unsigned int _Nx, 
                      const unsigned int _Ny, const unsigned int _Nz, 
-                     const unsigned int _dof)
+                     const unsigned int _dof, const bool _planar, const bool _real,
+                     const bool _cheb, const bool _kmajor)
 {
-  Nx = _Nx; Ny = _Ny; Nz = _Nz; dof = _dof;
+  Nx = _Nx; Ny = _Ny; Nz = _Nz; dof = _dof; planar = _planar; real = _real; cheb = _cheb;
+  kmajor = _kmajor;
+  bound = false;
   // dimension of the problem TODO: generalize this
   rank = 3;
 
   // sign for forward transform
   mode = FFTW_FORWARD;
-
-  // set num threads to w/e used by openmp
-  fftw_plan_with_nthreads(omp_get_max_threads());
-  // configure memory layout
-  configDims();
-  // allocate input arrays
-  in_real = (double*) fftw_malloc(Nz * Ny * Nx * dof * sizeof(double));
-  if (!in_real) {exitErr("alloc failed in Transform");}
-  in_complex = (double*) fftw_malloc(Nz * Ny * Nx * dof * sizeof(double));  
-  if (!in_complex) {exitErr("alloc failed in Transform");}
-  // alias out to in for in-place transform
-  out_real = in_real; out_complex = in_complex;
-  // create plans for forward transform
-  // we do this before populating input arrays (but only need to if not using FFTW_ESTIMATE)
-  pF = fftw_plan_guru_split_dft(rank, dims, 1, howmany_dims, in_real, in_complex, out_real, out_complex, FFTW_ESTIMATE);
-  if (!pF) {exitErr("FFTW forward planning failed");}
-  // populate input by copy
-  for (unsigned int i = 0; i < Nz * Ny * Nx * dof; ++i)
-  {
-    in_real[i] = _in_real[i];
-    in_complex[i] = 0;
-  }
-  fftw_execute(pF);
+  // allocate and plan before populating input arrays
+  plan(FFTW_ESTIMATE);
+  execute(_in_real, 0, 0, 0);
 }
 
 // Constructs backward plan and executes 
-Transform::Transform(const double* _out_real, const double* _out_complex,
+template<typename Real>
+TransformT<Real>::TransformT(const Real* _out_real, const Real* _out_complex,
                      const unsigned int _Nx, const unsigned int _Ny, 
-                     const unsigned int _Nz, const unsigned int _dof)
+                     const unsigned int _Nz, const unsigned int _dof,
+                     const bool _planar, const bool _real, const bool _cheb, 
+                     const bool _kmajor)
 {
-  Nx = _Nx; Ny = _Ny; Nz = _Nz; dof = _dof;
+  Nx = _Nx; Ny = _Ny; Nz = _Nz; dof = _dof; planar = _planar; real = _real; cheb = _cheb;
+  kmajor = _kmajor;
+  bound = false;
   // dimension of the problem TODO: generalize this
   rank = 3;
   // sign for backward transform
   mode = FFTW_BACKWARD;
+  // allocate and plan before populating input arrays
+  plan(FFTW_ESTIMATE);
+  execute(_out_real, _out_complex, 0, 0);
+}
 
+// Constructs a persistent plan, without executing
+template<typename Real>
+TransformT<Real>::TransformT(const unsigned int _Nx, const unsigned int _Ny, const unsigned int _Nz,
+                     const unsigned int _dof, const int _mode, const bool _planar,
+                     const bool _real, const bool _cheb, const bool _kmajor,
+                     const unsigned int flags)
+{
+  Nx = _Nx; Ny = _Ny; Nz = _Nz; dof = _dof; planar = _planar; real = _real; cheb = _cheb;
+  kmajor = _kmajor;
+  bound = false;
+  rank = 3;
+  if (_mode != FFTW_FORWARD && _mode != FFTW_BACKWARD) {exitErr("Invalid direction for Transform");}
+  mode = _mode;
+  plan(flags);
+  // save what was learned for the next run
+  if (not wisdom_file.empty() && not (flags & FFTW_ESTIMATE)) 
+  {
+    FFTW<Real>::export_wisdom(wisdomFile<Real>().c_str());
+  }
+}
+
+// Constructs a persistent plan on the buffers of a grid, without executing
+template<typename Real>
+TransformT<Real>::TransformT(Real* fG, Real* fG_hat_r, Real* fG_hat_i,
+                     const unsigned int _Nx, const unsigned int _Ny, const unsigned int _Nz,
+                     const unsigned int _dof, const int _mode, const bool _planar,
+                     const bool _real, const bool _cheb, const bool _kmajor,
+                     const unsigned int flags)
+{
+  Nx = _Nx; Ny = _Ny; Nz = _Nz; dof = _dof; planar = _planar; real = _real; cheb = _cheb;
+  kmajor = _kmajor;
+  rank = 3;
+  if (_mode != FFTW_FORWARD && _mode != FFTW_BACKWARD) {exitErr("Invalid direction for Transform");}
+  mode = _mode;
+  // the grid has no room for the complex part of the data of an out of place complex transform
+  if (kmajor && !real) {exitErr("A wavenumber-major Transform bound to a grid must be real");}
+  if (!fG || !fG_hat_i || (!real && fG_hat_r != fG) || (real && !fG_hat_r)) 
+  {
+    exitErr("Invalid grid buffers for Transform (see Grid::setupSpectral())");
+  }
+  bound = true;
+  if (not real)
+  {
+    in_real = out_real = fG; in_complex = out_complex = fG_hat_i;
+  }
+  else if (mode == FFTW_FORWARD)
+  {
+    in_real = fG; in_complex = 0; out_real = fG_hat_r; out_complex = fG_hat_i;
+  }
+  else
+  {
+    in_real = fG_hat_r; in_complex = fG_hat_i; out_real = fG; out_complex = 0;
+  }
+  plan(flags);
+  if (not wisdom_file.empty() && not (flags & FFTW_ESTIMATE)) 
+  {
+    FFTW<Real>::export_wisdom(wisdomFile<Real>().c_str());
+  }
+}
+
+template<typename Real>
+void TransformT<Real>::plan(const unsigned int flags)
+{
+  if (cheb && Nz < 2) {exitErr("Chebyshev transform needs at least 2 points in z");}
   // set num threads to w/e used by openmp
-  fftw_plan_with_nthreads(omp_get_max_threads());
+  FFTW<Real>::plan_with_nthreads(omp_get_max_threads());
   // configure memory layout
   configDims();
-  // allocate input arrays
-  out_real = (double*) fftw_malloc(Nz * Ny * Nx * dof * sizeof(double));
-  if (!out_real) {exitErr("alloc failed in Transform");}
-  out_complex = (double*) fftw_malloc(Nz * Ny * Nx * dof * sizeof(double));  
-  if (!out_complex) {exitErr("alloc failed in Transform");}
-  // alias out to in for in-place transform
-  in_real = out_real; in_complex = out_complex;
-  // create plans for backward transform
-  // MUST do this before populating in arrays
-  pB = fftw_plan_guru_split_dft(rank, dims, 1, howmany_dims, out_complex, out_real, in_complex, in_real, FFTW_ESTIMATE);
-  if (!pB) {exitErr("FFTW backward planning failed");}
+  // the buffers of a bound transform are those of the grid
+  if (not bound) {allocate();}
+  // the Fourier axes, and the axes looped over (z is one of these if cheb)
+  const int frank = cheb ? rank - 1 : rank, hrank = cheb ? 2 : 1;
+  const fftw_iodim64* fdims = cheb ? dims + 1 : dims;
+  // create plans. This MUST be done before populating the arrays, since
+  // any flags but FFTW_ESTIMATE overwrite them. The backward transform 
+  // is the forward one with the real and complex parts swapped
+  if (mode == FFTW_FORWARD)
+  {
+    pF = real ? FFTW<Real>::plan_split_dft_r2c(frank, fdims, hrank, howmany_dims, in_real, out_real, out_complex, flags) :
+                FFTW<Real>::plan_split_dft(frank, fdims, hrank, howmany_dims, in_real, in_complex, out_real, out_complex, flags);
+    if (!pF) {exitErr("FFTW forward planning failed");}
+  }
+  else
+  {
+    pB = real ? FFTW<Real>::plan_split_dft_c2r(frank, fdims, hrank, howmany_dims, in_real, in_complex, out_real, flags) :
+                FFTW<Real>::plan_split_dft(frank, fdims, hrank, howmany_dims, out_complex, out_real, in_complex, in_real, flags);
+    if (!pB) {exitErr("FFTW backward planning failed");}
+  }
+  if (cheb)
+  {
+    // DCT-I along z of each (y,x) column and component of the input, in place
+    // (the input of the backward real transform is the half spectrum in x)
+    const ptrdiff_t nxi = (mode == FFTW_FORWARD) ? Nx : spectralNx();
+    const fftw_iodim64 zdim = {dims[0].n, dims[0].is, dims[0].is};
+    const fftw_iodim64 cols[3] = {{dims[1].n, dims[1].is, dims[1].is}, {nxi, dims[2].is, dims[2].is},
+                                  {howmany_dims[0].n, howmany_dims[0].is, howmany_dims[0].is}};
+    const fftw_r2r_kind kind = FFTW_REDFT00;
+    pZ = FFTW<Real>::plan_r2r(1, &zdim, 3, cols, in_real, in_real, &kind, flags);
+    if (!pZ) {exitErr("FFTW Chebyshev planning failed");}
+  }
+}
+
+template<typename Real>
+void TransformT<Real>::allocate()
+{
+  // sizes of the data in real space and of the spectrum
+  const size_t N = (size_t) Nz * Ny * Nx * dof, Nh = (size_t) Nz * Ny * spectralNx() * dof;
+  if (not real && not kmajor)
+  {
+    // allocate input arrays
+    in_real = (Real*) alignedMalloc(N * sizeof(Real));
+    in_complex = (Real*) alignedMalloc(N * sizeof(Real));  
+    if (!in_real || !in_complex) {exitErr("alloc failed in Transform");}
+    // alias out to in for in-place transform
+    out_real = in_real; out_complex = in_complex;
+  }
+  else if (mode == FFTW_FORWARD)
+  {
+    // real (or complex) input, split complex output
+    in_real = (Real*) alignedMalloc(N * sizeof(Real));
+    in_complex = real ? 0 : (Real*) alignedMalloc(N * sizeof(Real));
+    out_real = (Real*) alignedMalloc(Nh * sizeof(Real));
+    out_complex = (Real*) alignedMalloc(Nh * sizeof(Real));
+    if (!in_real || (!real && !in_complex) || !out_real || !out_complex) 
+    {
+      exitErr("alloc failed in Transform");
+    }
+  }
+  else
+  {
+    // split complex input, real (or complex) output
+    in_real = (Real*) alignedMalloc(Nh * sizeof(Real));
+    in_complex = (Real*) alignedMalloc(Nh * sizeof(Real));
+    out_real = (Real*) alignedMalloc(N * sizeof(Real));
+    out_complex = real ? 0 : (Real*) alignedMalloc(N * sizeof(Real));
+    if (!in_real || !in_complex || !out_real || (!real && !out_complex)) 
+    {
+      exitErr("alloc failed in Transform");
+    }
+  }
+}
+
+template<typename Real>
+void TransformT<Real>::execute()
+{
+  // the data of a bound complex forward transform is real, so zero the imaginary part
+  const bool zero_im = not in_complex || (bound && mode == FFTW_FORWARD);
+  if (in_complex && zero_im) 
+  {
+    const size_t N = (size_t) Nz * Ny * Nx * dof;
+    #pragma omp parallel for
+    for (size_t i = 0; i < N; ++i) {in_complex[i] = 0;}
+  }
+  transform(in_real, in_complex, out_real, out_complex, zero_im);
+}
+
+template<typename Real>
+void TransformT<Real>::execute(const Real* _in_real, const Real* _in_complex, 
+                        Real* _out_real, Real* _out_complex)
+{
+  if (real || kmajor)
+  {
+    executeOutOfPlace(_in_real, _in_complex, _out_real, _out_complex);
+    return;
+  }
+  const size_t N = (size_t) Nz * Ny * Nx * dof;
+  // transform on the output arrays if the plan can be applied to them
+  const bool direct = _out_real && _out_complex && 
+                      FFTW<Real>::alignment_of(_out_real) == FFTW<Real>::alignment_of(in_real) &&
+                      FFTW<Real>::alignment_of(_out_complex) == FFTW<Real>::alignment_of(in_complex);
+  Real* re = direct ? _out_real : in_real;
+  Real* im = direct ? _out_complex : in_complex;
   // populate input by copy
-  for (unsigned int i = 0; i < Nz * Ny * Nx * dof; ++i)
+  if (_in_real != re || _in_complex != im)
+  {
+    #pragma omp parallel for
+    for (size_t i = 0; i < N; ++i)
+    {
+      if (_in_real != re) {re[i] = _in_real[i];}
+      if (_in_complex != im) {im[i] = _in_complex ? _in_complex[i] : 0;}
+    }
+  }
+  transform(re, im, re, im, not _in_complex);
+  if (not direct && (_out_real || _out_complex))
+  {
+    #pragma omp parallel for
+    for (size_t i = 0; i < N; ++i)
+    {
+      if (_out_real) {_out_real[i] = re[i];}
+      if (_out_complex) {_out_complex[i] = im[i];}
+    }
+  }
+}
+
+template<typename Real>
+void TransformT<Real>::executeOutOfPlace(const Real* _in_real, const Real* _in_complex, 
+                                  Real* _out_real, Real* _out_complex)
+{
+  // sizes of the input and output (the half spectrum is the output if forward)
+  const size_t N = (size_t) Nz * Ny * Nx * dof, Nh = (size_t) Nz * Ny * spectralNx() * dof;
+  const size_t Nin = (mode == FFTW_FORWARD) ? N : Nh, Nout = (mode == FFTW_FORWARD) ? Nh : N;
+  // the transform is out of place, so only the output can be used directly. The input 
+  // is always copied, since the backward transforms overwrite it
+  const bool direct = _out_real && FFTW<Real>::alignment_of(_out_real) == FFTW<Real>::alignment_of(out_real) &&
+                      (not out_complex || (_out_complex && 
+                       FFTW<Real>::alignment_of(_out_complex) == FFTW<Real>::alignment_of(out_complex)));
+  Real* re = direct ? _out_real : out_real;
+  Real* im = direct ? _out_complex : out_complex;
+  #pragma omp parallel for
+  for (size_t i = 0; i < Nin; ++i)
+  {
+    in_real[i] = _in_real[i];
+    if (in_complex) {in_complex[i] = _in_complex ? _in_complex[i] : 0;}
+  }
+  transform(in_real, in_complex, re, im, not in_complex || not _in_complex);
+  if (not direct && (_out_real || _out_complex))
+  {
+    #pragma omp parallel for
+    for (size_t i = 0; i < Nout; ++i)
+    {
+      if (_out_real) {_out_real[i] = re[i];}
+      if (_out_complex && im) {_out_complex[i] = im[i];}
+    }
+  }
+}
+
+template<typename Real>
+void TransformT<Real>::transform(Real* re, Real* im, Real* ore, Real* oim, const bool zero_im)
+{
+  // the backward input is divided by the weights of the Chebyshev coefficients (see 
+  // chebWeight()), and by the size of the Fourier axes if bound
+  if (mode == FFTW_BACKWARD && (cheb || bound))
+  {
+    const size_t Nin = (size_t) Nz * Ny * spectralNx() * dof;
+    const double norm = bound ? 1.0 / ((double) Nx * Ny * (cheb ? 1 : Nz)) : 1.0;
+    #pragma omp parallel for
+    for (size_t i = 0; i < Nin; ++i)
+    {
+      const double s = cheb ? norm / chebWeight(i) : norm;
+      re[i] *= s;
+      if (not zero_im) {im[i] *= s;}
+    }
+  }
+  if (cheb) 
   {
-    out_real[i] = _out_real[i];
-    out_complex[i] = _out_complex[i];
+    FFTW<Real>::execute_r2r(pZ, re, re);
+    if (not zero_im) {FFTW<Real>::execute_r2r(pZ, im, im);}
   }
-  fftw_execute(pB);
+  if (mode == FFTW_FORWARD)
+  {
+    if (real) {FFTW<Real>::execute_split_dft_r2c(pF, re, ore, oim);}
+    else {FFTW<Real>::execute_split_dft(pF, re, im, ore, oim);}
+    if (cheb) {scaleCheb(ore, oim);}
+  }
+  else if (real) {FFTW<Real>::execute_split_dft_c2r(pB, re, im, ore);}
+  else {FFTW<Real>::execute_split_dft(pB, im, re, oim, ore);}
 }
 
-void Transform::configDims()
+template<typename Real>
+double TransformT<Real>::chebWeight(const size_t i) const
 {
-  // set up iodims - we store as (k,j,i,l), l = 0:dof 
-  dims = (fftw_iodim*) fftw_malloc(rank * sizeof(fftw_iodim));    
+  // index in z of element i, stored as (k,j,i,l) or (l,k,j,i) if planar,
+  // or z fastest if kmajor
+  const size_t nx = spectralNx();
+  const size_t k = kmajor ? i % Nz : 
+                   planar ? (i / (nx * Ny)) % Nz : i / (nx * Ny * dof);
+  return (k == 0 || k == Nz - 1) ? 1.0 : 2.0;
+}
+
+template<typename Real>
+void TransformT<Real>::scaleCheb(Real* re, Real* im)
+{
+  const size_t Nh = (size_t) Nz * Ny * spectralNx() * dof;
+  const double norm = 1.0 / (2 * Nz - 2);
+  #pragma omp parallel for
+  for (size_t i = 0; i < Nh; ++i)
+  {
+    const double s = norm * chebWeight(i);
+    re[i] *= s; im[i] *= s;
+  }
+}
+
+template<typename Real>
+void TransformT<Real>::configDims()
+{
+  // set up iodims - we store as (k,j,i,l), l = 0:dof, or as (l,k,j,i) if planar
+  // (the 64-bit interface is used so strides can exceed 2^31)
+  // stride between points, and between components
+  const ptrdiff_t ps = planar ? 1 : dof; 
+  // points in x of the input and output (these differ if real, as the
+  // spectrum only has Nx / 2 + 1 points in x)
+  const ptrdiff_t Nxi = (mode == FFTW_FORWARD) ? Nx : spectralNx();
+  const ptrdiff_t Nxo = (mode == FFTW_FORWARD) ? spectralNx() : Nx;
+  dims = (fftw_iodim64*) alignedMalloc(rank * sizeof(fftw_iodim64));    
   if (!dims) {exitErr("alloc failed in configDims for Transform");}
-  // we want to do 1 fft for the entire dof x 3D array     
-  howmany_dims = (fftw_iodim*) fftw_malloc(1 * sizeof(fftw_iodim));
+  // we want to do 1 fft for the entire dof x 3D array (or one 2D fft 
+  // for each component and z-plane if cheb)
+  howmany_dims = (fftw_iodim64*) alignedMalloc((cheb ? 2 : 1) * sizeof(fftw_iodim64));
   if (!howmany_dims) {exitErr("alloc failed in configDims for Transform");}
   // size of k
   dims[0].n = Nz;
   // stride for k
-  dims[0].is = dof * Nx * Ny;
-  dims[0].os = dof * Nx * Ny;
+  dims[0].is = ps * Nxi * Ny;
+  dims[0].os = ps * Nxo * Ny;
   // size of j
   dims[1].n = Ny;
   // stride for j
-  dims[1].is = dof * Nx;
-  dims[1].os = dof * Nx;
+  dims[1].is = ps * Nxi;
+  dims[1].os = ps * Nxo;
   // size of i
   dims[2].n = Nx;
   // stride for i
-  dims[2].is = dof;
-  dims[2].os = dof;
+  dims[2].is = ps;
+  dims[2].os = ps;
   
   // dof component vec field
   howmany_dims[0].n = dof;
-  // stride of 1 b/w each component (interleaved)
-  howmany_dims[0].is = 1;
-  howmany_dims[0].os = 1;
+  // stride of 1 b/w each component (interleaved), or Nx * Ny * Nz (planar)
+  howmany_dims[0].is = planar ? Nxi * Ny * Nz : 1;
+  howmany_dims[0].os = planar ? Nxo * Ny * Nz : 1;
+  // the spectrum is stored as (j,i,l,k), or (l,j,i,k) if planar
+  if (kmajor) {setKMajorStrides(mode == FFTW_FORWARD);}
+  // z-planes (the Fourier transform is over dims[1:], see plan())
+  if (cheb) {howmany_dims[1] = dims[0];}
+}
+
+template<typename Real>
+void TransformT<Real>::setKMajorStrides(const bool out)
+{
+  // strides of k, j, i and l in the spectrum (Nxs points in x)
+  const ptrdiff_t Nxs = spectralNx();
+  const ptrdiff_t sl = planar ? (ptrdiff_t) Nz * Nxs * Ny : Nz;
+  const ptrdiff_t si = planar ? Nz : (ptrdiff_t) Nz * dof;
+  const ptrdiff_t strides[4] = {1, si * Nxs, si, sl};
+  fftw_iodim64* iodims[4] = {dims, dims + 1, dims + 2, howmany_dims};
+  for (unsigned int a = 0; a < 4; ++a) 
+  {
+    if (out) {iodims[a]->os = strides[a];}
+    else {iodims[a]->is = strides[a];}
+  }
+}
+
+template<typename Real>
+MemoryReport TransformT<Real>::memoryReport() const
+{
+  // the output is aliased to the input (in-place transform), unless real or kmajor
+  // (the buffers of a bound transform are in the report of the grid)
+  MemoryReport report;
+  if (not bound)
+  {
+    addBuffer(report, "transform.real", in_real);
+    addBuffer(report, "transform.complex", in_complex);
+    // separate outputs of the out of place transforms
+    if (out_real != in_real) {addBuffer(report, "transform.out_real", out_real);}
+    if (out_complex != in_complex) {addBuffer(report, "transform.out_complex", out_complex);}
+  }
+  addBuffer(report, "transform.dims", dims);
+  addBuffer(report, "transform.howmany_dims", howmany_dims);
+  return report;
 }
 
-void Transform::cleanup()
+template<typename Real>
+void TransformT<Real>::cleanup()
 {
   // destroy plans
-  if (mode == FFTW_FORWARD) fftw_destroy_plan(pF);
-  else if (mode == FFTW_BACKWARD) fftw_destroy_plan(pB);
+  if (mode == FFTW_FORWARD) FFTW<Real>::destroy_plan(pF);
+  else if (mode == FFTW_BACKWARD) FFTW<Real>::destroy_plan(pB);
+  if (cheb) FFTW<Real>::destroy_plan(pZ);
 
-  // free memory
-  fftw_free(in_real);
-  fftw_free(in_complex);
-  fftw_free(dims);
-  fftw_free(howmany_dims);
+  // free memory (the buffers of a bound transform belong to the grid)
+  if (not bound)
+  {
+    alignedFree(in_real);
+    alignedFree(in_complex);
+    if (out_real != in_real) {alignedFree(out_real);}
+    if (out_complex != in_complex) {alignedFree(out_complex);}
+  }
+  alignedFree(dims);
+  alignedFree(howmany_dims);
+}
+
+bool setWisdomFile(const char* fname)
+{
+  wisdom_file = fname;
+  const bool imported = importWisdom<double>();
+  return importWisdom<float>() || imported;
 }
+
+template struct TransformT<double>;
+template struct TransformT<float>;
@@ -0,0 +1,142 @@
+#include<iostream>
+#include<iomanip>
+#include<vector>
+#include<cstdlib>
+#include<math.h>
+#include<omp.h>
+#include<lapacke.h>
+#include"DPStokes.h"
+#include"LinearSolvers.h"
+
+/* Benchmark of the pentadiagonal solves of the DP Stokes solver (see pentaSolveT() in
+   LinearSolvers.h), against the pivoted LAPACK band solves they replace.
+   For each Nz, we set up the operators of DPStokes(F) on an N x N grid, and time the
+   A^{-1} of the 6 right-hand sides (u, v, w) of every wave number, with one gbtrs call
+   per wave number, and with the no pivoting factors interleaved across groups of W wave
+   numbers (copying the right-hand sides in and out of the interleaved layout included),
+   and then the same with the Schur complement correction and the integral matrices
+   (bandedSchurSolveK() vs. pentaSolveT() + schurCorrectK()), ie. the whole velocity
+   solve. We report the max difference between the two solutions, relative to the max of
+   the LAPACK one, and the number of wave numbers that fall back to LAPACK.
+
+   usage: ./bench_banded_solve [N] [reps]
+*/
+
+inline void gbtrs(int n, int nrhs, const double* ab, const int* ipiv, double* b)
+{
+  LAPACKE_dgbtrs_work(LAPACK_COL_MAJOR, 'N', n, 2, 2, nrhs, ab, 7, ipiv, b, n);
+}
+inline void gbtrs(int n, int nrhs, const float* ab, const int* ipiv, float* b)
+{
+  LAPACKE_sgbtrs_work(LAPACK_COL_MAJOR, 'N', n, 2, 2, nrhs, ab, 7, ipiv, b, n);
+}
+
+template<typename Real>
+void bench(const unsigned int N, const unsigned int Nz, const unsigned int reps)
+{
+  const int W = PentaLanes<Real>::W, nrhs = 6, ldab = 7;
+  DPStokesT<Real> s(N, N, Nz, 2.0, 2.0, 1.0, 1.0, false, true, true);
+  const unsigned int Nyx = s.Nyx, ngroups = (Nyx + W - 1) / W;
+  const size_t n = (size_t) Nz * nrhs * Nyx;
+  std::vector<Real> rhs(n), bc((size_t) 2 * nrhs * Nyx), u0(n), u1(n);
+  for (size_t i = 0; i < n; ++i) {rhs[i] = 2 * drand48() - 1;}
+  for (size_t i = 0; i < bc.size(); ++i) {bc[i] = 2 * drand48() - 1;}
+  unsigned int fallback = 0;
+  for (unsigned int g = 0; g < ngroups; ++g) {fallback += __builtin_popcount(s.PLUmask[g]);}
+  // times in ms, averaged over reps after a warm up, and max differences
+  double t[4] = {0, 0, 0, 0}, diff[2] = {0, 0};
+  for (unsigned int schur = 0; schur < 2; ++schur)
+  {
+    for (unsigned int r = 0; r <= reps; ++r)
+    {
+      double t0 = omp_get_wtime();
+      #pragma omp parallel
+      {
+        std::vector<Real> b((size_t) Nz * nrhs), x((size_t) (Nz + 2) * nrhs);
+        #pragma omp for schedule(static)
+        for (unsigned int p = 1; p < Nyx; ++p)
+        {
+          const size_t o = (size_t) Nz * nrhs * p;
+          for (unsigned int k = 0; k < Nz * nrhs; ++k) {b[k] = rhs[o + k];}
+          const Real* lu = s.LU + (size_t) ldab * Nz * p;
+          if (schur)
+          {
+            bandedSchurSolveK<Real>(lu, b.data(), &bc[2 * nrhs * p], s.PIV + (size_t) Nz * p,
+                                    s.C + (size_t) 2 * Nz * p, s.Ginv + 4 * (size_t) p,
+                                    s.Ainv_B + (size_t) 2 * Nz * p, s.SIMat, 0, x.data(),
+                                    &u0[o], 0, 2, 2, Nz, nrhs);
+          }
+          else
+          {
+            gbtrs(Nz, nrhs, lu, s.PIV + (size_t) Nz * p, b.data());
+            for (unsigned int k = 0; k < Nz * nrhs; ++k) {u0[o + k] = b[k];}
+          }
+        }
+      }
+      double t1 = omp_get_wtime();
+      #pragma omp parallel
+      {
+        std::vector<Real> X((size_t) Nz * nrhs * W), b((size_t) Nz * nrhs), x((size_t) (Nz + 2) * nrhs);
+        #pragma omp for schedule(static)
+        for (unsigned int g = 0; g < ngroups; ++g)
+        {
+          const unsigned int p0 = g * W, nl = Nyx - p0 < W ? Nyx - p0 : W;
+          const unsigned int mask = s.PLUmask[g] | (p0 == 0);
+          for (unsigned int k = 0; k < Nz * nrhs; ++k)
+          {
+            for (unsigned int l = 0; l < W; ++l) {X[W * k + l] = l < nl ? rhs[(size_t) Nz * nrhs * (p0 + l) + k] : 0;}
+          }
+          pentaSolveT<Real>(s.PLU + (size_t) 5 * W * Nz * g, X.data(), Nz, nrhs);
+          for (unsigned int l = 0; l < nl; ++l)
+          {
+            const unsigned int p = p0 + l;
+            const size_t o = (size_t) Nz * nrhs * p;
+            if (p == 0) {continue;}
+            if (mask >> l & 1)
+            {
+              for (unsigned int k = 0; k < Nz * nrhs; ++k) {b[k] = rhs[o + k];}
+              gbtrs(Nz, nrhs, s.LU + (size_t) ldab * Nz * p, s.PIV + (size_t) Nz * p, b.data());
+            }
+            else {for (unsigned int k = 0; k < Nz * nrhs; ++k) {b[k] = X[W * k + l];}}
+            if (schur)
+            {
+              schurCorrectK<Real>(b.data(), &bc[2 * nrhs * p], s.C + (size_t) 2 * Nz * p,
+                                  s.Ginv + 4 * (size_t) p, s.Ainv_B + (size_t) 2 * Nz * p,
+                                  s.SIMat, 0, x.data(), &u1[o], 0, Nz, nrhs);
+            }
+            else {for (unsigned int k = 0; k < Nz * nrhs; ++k) {u1[o + k] = b[k];}}
+          }
+        }
+      }
+      double t2 = omp_get_wtime();
+      if (r) {t[2 * schur] += t1 - t0; t[2 * schur + 1] += t2 - t1;}
+    }
+    double d = 0, norm = 0;
+    for (size_t i = (size_t) Nz * nrhs; i < n; ++i) {d = fmax(d, fabs(u1[i] - u0[i])); norm = fmax(norm, fabs(u0[i]));}
+    diff[schur] = d / norm;
+  }
+  std::cout << std::setw(8) << (sizeof(Real) == 8 ? "double" : "float") << std::setw(6) << Nz
+            << std::fixed << std::setprecision(3);
+  for (unsigned int i = 0; i < 4; ++i) {std::cout << std::setw(10) << 1e3 * t[i] / reps;}
+  std::cout << std::setw(9) << t[0] / t[1] << std::setw(9) << t[2] / t[3] << std::scientific
+            << std::setprecision(2) << std::setw(11) << diff[0] << std::setw(11) << diff[1]
+            << std::setw(10) << fallback << "\n";
+  s.cleanup();
+}
+
+int main(int argc, char* argv[])
+{
+  const unsigned int N = argc > 1 ? atoi(argv[1]) : 64;
+  const unsigned int reps = argc > 2 ? atoi(argv[2]) : 20;
+  const unsigned int Nzs[] = {30, 48, 64, 100};
+  srand48(1);
+  std::cout << "threads = " << omp_get_max_threads() << ", wave numbers = " << N * (N / 2 + 1)
+            << ", 6 right-hand sides each, times in ms\n";
+  std::cout << std::setw(8) << "prec" << std::setw(6) << "Nz" << std::setw(10) << "gbtrs"
+            << std::setw(10) << "penta" << std::setw(10) << "+schur" << std::setw(10) << "+schur"
+            << std::setw(9) << "speedup" << std::setw(9) << "+schur" << std::setw(11) << "diff"
+            << std::setw(11) << "+schur" << std::setw(10) << "fallback" << "\n";
+  for (unsigned int i = 0; i < 4; ++i) {bench<double>(N, Nzs[i], reps);}
+  for (unsigned int i = 0; i < 4; ++i) {bench<float>(N, Nzs[i], reps);}
+  return 0;
+}
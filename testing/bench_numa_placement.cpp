@@ -0,0 +1,186 @@
+#include<iostream>
+#include<iomanip>
+#include<vector>
+#include<cstdlib>
+#include<omp.h>
+#include<unistd.h>
+#include<sys/syscall.h>
+#include"SpreadInterp.h"
+#include"BoundaryConditions.h"
+#include"ParticleList.h"
+#include"Grid.h"
+#include"Memory.h"
+
+/* Benchmark of the page placement policies (see Memory.h).
+   For each policy, we set up a triply periodic grid and random particles,
+   and time zeroing, spreading, fold, copy and interpolation, with the fold and copy
+   broken down into the ghost transfers along each axis and the interior copy. To show the
+   cross-socket traffic each policy causes, we also report the fraction of the
+   pages a thread works on that live on a remote NUMA node, for the column
+   blocks of the extended grid (spreading/interpolation) and the z-slabs
+   of fG (fold/copy).
+
+   The threads must be pinned for the placement to mean anything, eg.
+
+     OMP_PROC_BIND=close OMP_PLACES=cores ./bench_numa_placement nP Nx Ny Nz reps
+
+   On a single socket machine, all the pages are local and the policies
+   should time the same. The remote traffic itself can be watched with
+   eg. numastat -p <pid> or perf stat -e node-load-misses,node-loads.
+
+   usage: ./bench_numa_placement nP [Nx Ny Nz] [reps]
+*/
+
+// numa node of the calling thread (-1 if unknown)
+int threadNode()
+{
+  #ifdef SYS_getcpu
+  unsigned int cpu, node;
+  if (syscall(SYS_getcpu, &cpu, &node, 0) == 0) return node;
+  #endif
+  return -1;
+}
+
+// number of pages in pages that are not on node (all 0 if the nodes are unknown)
+size_t remotePages(std::vector<void*>& pages, const int node)
+{
+  size_t remote = 0;
+  #ifdef SYS_move_pages
+  if (node < 0 or pages.empty()) return 0;
+  std::vector<int> status(pages.size());
+  // with nodes = 0, move_pages only reports the node of each page
+  if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), 0, status.data(), 0)) return 0;
+  for (size_t i = 0; i < status.size(); ++i) {remote += (status[i] >= 0 and status[i] != node);}
+  #endif
+  return remote;
+}
+
+// add the page of ptr to pages, if it is not the last one added
+void addPage(std::vector<void*>& pages, const void* ptr)
+{
+  static const size_t page = sysconf(_SC_PAGESIZE);
+  void* p = (void*) ((size_t) ptr & ~(page - 1));
+  if (pages.empty() or pages.back() != p) {pages.push_back(p);}
+}
+
+// fraction of the pages of the extended grid that are remote to the thread
+// spreading to them (same static partition of the (x,y) columns)
+double remoteExt(const Grid& grid)
+{
+  size_t remote = 0, total = 0;
+  #pragma omp parallel reduction(+:remote,total)
+  {
+    std::vector<void*> pages;
+    #pragma omp for collapse(2) schedule(static)
+    for (unsigned int i = 0; i < grid.Nxeff; ++i)
+    {
+      for (unsigned int j = 0; j < grid.Nyeff; ++j)
+      {
+        for (unsigned int k = 0; k < grid.Nzeff; ++k)
+        {
+          addPage(pages, grid.fG_unwrap + grid.dof *
+                  atExt<size_t, false>(i, j, k, grid.Nxeff, grid.Nyeff, grid.Nzeff));
+        }
+      }
+    }
+    total += pages.size(); remote += remotePages(pages, threadNode());
+  }
+  return total ? (double) remote / total : 0;
+}
+
+// fraction of the pages of fG that are remote to the thread
+// folding into them (same static partition of the z-slabs)
+double remoteGrid(const Grid& grid)
+{
+  size_t remote = 0, total = 0;
+  #pragma omp parallel reduction(+:remote,total)
+  {
+    std::vector<void*> pages;
+    #pragma omp for collapse(2) schedule(static)
+    for (unsigned int k = 0; k < grid.Nz; ++k)
+    {
+      for (unsigned int j = 0; j < grid.Ny; ++j)
+      {
+        addPage(pages, grid.fG + grid.dof * (grid.Nx * (j + (size_t) grid.Ny * k)));
+      }
+    }
+    total += pages.size(); remote += remotePages(pages, threadNode());
+  }
+  return total ? (double) remote / total : 0;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc != 2 and argc != 5 and argc != 6)
+  {
+    std::cerr << "usage: ./bench_numa_placement nP [Nx Ny Nz] [reps]\n"; return 1;
+  }
+  const unsigned int nP = atoi(argv[1]);
+  const unsigned int Nx = argc > 2 ? atoi(argv[2]) : 256;
+  const unsigned int Ny = argc > 2 ? atoi(argv[3]) : 256;
+  const unsigned int Nz = argc > 2 ? atoi(argv[4]) : 64;
+  const unsigned int reps = argc > 5 ? atoi(argv[5]) : 10, dof = 3;
+  const double h = 0.5;
+
+  const char* binds[] = {"false", "true", "master", "close", "spread"};
+  std::cout << "threads = " << omp_get_max_threads() << ", places = " << omp_get_num_places()
+            << ", proc_bind = " << binds[omp_get_proc_bind()] << "\n";
+  if (omp_get_proc_bind() == omp_proc_bind_false)
+  {
+    std::cout << "warning: threads are not bound, set OMP_PROC_BIND and OMP_PLACES\n";
+  }
+
+  const Placement placements[] = {no_touch, serial_touch, first_touch};
+  const char* names[] = {"no_touch", "serial_touch", "first_touch"};
+  std::cout << std::setw(13) << "placement" << std::setw(11) << "zero" << std::setw(11)
+            << "spread" << std::setw(11) << "fold" << std::setw(11) << "copy" << std::setw(11)
+            << "interp" << std::setw(13) << "remote ext" << std::setw(13) << "remote fG" << "\n";
+  for (unsigned int p = 0; p < 3; ++p)
+  {
+    setPlacement(placements[p]);
+    Grid grid; ParticleList particles;
+    srand48(1);
+    grid.setPeriodicity(true, true, true);
+    grid.makeTP(Nx * h, Ny * h, Nz * h, h, h, h, Nx, Ny, Nz, dof);
+    particles.randInit(grid, nP);
+    const unsigned short w = particles.wfxP_max, wz = particles.wfzP_max;
+    // times in ms, averaged over reps after a warm up
+    double t[5] = {0, 0, 0, 0, 0};
+    grid.ghost.plan(w, particles.wfyP_max, wz, wz, grid.Nxeff, grid.Nyeff, grid.Nzeff, dof,
+                    grid.isperiodic, grid.BCs);
+    for (unsigned int r = 0; r <= reps; ++r)
+    {
+      double t0 = omp_get_wtime();
+      grid.zeroExtGrid();
+      double t1 = omp_get_wtime();
+      spread(particles, grid);
+      double t2 = omp_get_wtime();
+      grid.ghost.fold(grid.fG_unwrap, grid.fG);
+      double t3 = omp_get_wtime();
+      grid.ghost.copy(grid.fG_unwrap, grid.fG);
+      double t4 = omp_get_wtime();
+      interpolate(particles, grid);
+      double t5 = omp_get_wtime();
+      if (r)
+      {
+        t[0] += t1 - t0; t[1] += t2 - t1; t[2] += t3 - t2; t[3] += t4 - t3; t[4] += t5 - t4;
+      }
+      else {grid.ghost.resetTimes();}
+    }
+    std::cout << std::setw(13) << names[p] << std::fixed << std::setprecision(3);
+    for (unsigned int i = 0; i < 5; ++i) {std::cout << std::setw(11) << 1e3 * t[i] / reps;}
+    std::cout << std::setw(13) << remoteExt(grid) << std::setw(13) << remoteGrid(grid) << "\n";
+    // breakdown of the fold and copy into the axes and the interior copy
+    for (unsigned int op = 0; op < 2; ++op)
+    {
+      const double* ts = op ? grid.ghost.copy_time : grid.ghost.fold_time;
+      std::cout << std::setw(13) << (op ? "copy xyz/int" : "fold xyz/int");
+      for (unsigned int a = 0; a < 4; ++a) {std::cout << std::setw(11) << 1e3 * ts[a] / reps;}
+      std::cout << "\n";
+    }
+    particles.cleanup();
+    grid.cleanup();
+  }
+  setPlacement(first_touch);
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include "LinearSolvers.h"
+#include<lapacke.h>
+#include<iostream>
+#include<vector>
+#include<cstdlib>
+#include<math.h>
+
+/* Banded Schur complement solves of the DP solvers (see LinearSolvers.h) against a
+   dense solve of the full bordered system of each wave number,
+
+     [A B] [x]   [rhs]
+     [C D] [y] = [ bc],  with sol = SIMat (x, y) and dsol = FIMat (x, y),
+
+   for random operators (A pentadiagonal and diagonally dominant, B, C, D, the
+   integral matrices and the right-hand sides random), with bc = 0 for
+   bandedSchurSolve() and a different bc for each wave number for bandedSchurSolve_noD().
+   Both errors (max difference relative to the max of the dense solution) should
+   be at round-off.
+
+   usage: ./test_banded_schur [Nyx Nz]
+*/
+
+// sol = M x for M n x m (column major)
+void matVec(const std::vector<double>& M, const double* x, double* sol, const int n, const int m)
+{
+  for (int r = 0; r < n; ++r)
+  {
+    sol[r] = 0;
+    for (int c = 0; c < m; ++c) {sol[r] += M[r + (size_t) n * c] * x[c];}
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  const int Nyx = argc > 2 ? atoi(argv[1]) : 6;
+  const int Nz = argc > 2 ? atoi(argv[2]) : 24;
+  const int kl = 2, ku = 2, ldab = 2 * kl + ku + 1, n = Nz + 2;
+  srand48(1);
+  auto rnd = []() {return 2 * drand48() - 1;};
+
+  std::vector<double> A((size_t) Nz * Nz * Nyx), LU((size_t) ldab * Nz * Nyx, 0);
+  std::vector<double> B((size_t) Nz * 2 * Nyx), C((size_t) 2 * Nz * Nyx), D((size_t) 4 * Nyx);
+  std::vector<double> G((size_t) 4 * Nyx), Ginv((size_t) 4 * Nyx), bc((size_t) 2 * Nyx);
+  std::vector<double> rhs((size_t) Nz * Nyx), SIMat((size_t) Nz * n), FIMat((size_t) Nz * n);
+  std::vector<int> PIV((size_t) Nz * Nyx);
+  for (size_t i = 0; i < SIMat.size(); ++i) {SIMat[i] = rnd(); FIMat[i] = rnd();}
+  for (int i = 0; i < Nyx; ++i)
+  {
+    double* a = &A[(size_t) Nz * Nz * i];
+    for (int c = 0; c < Nz; ++c)
+    {
+      for (int r = 0; r < Nz; ++r)
+      {
+        a[r + Nz * c] = abs(r - c) > kl ? 0 : (r == c ? 6 + rnd() : rnd());
+        if (abs(r - c) <= kl) {LU[(size_t) ldab * Nz * i + kl + ku + r - c + ldab * c] = a[r + Nz * c];}
+      }
+    }
+    for (int j = 0; j < 2 * Nz; ++j) {B[(size_t) 2 * Nz * i + j] = rnd(); C[(size_t) 2 * Nz * i + j] = rnd();}
+    for (int j = 0; j < 4; ++j) {D[4 * i + j] = rnd();}
+    for (int j = 0; j < Nz; ++j) {rhs[(size_t) Nz * i + j] = rnd();}
+    bc[2 * i] = rnd(); bc[2 * i + 1] = rnd();
+  }
+  std::vector<double> Ainv_B(B);
+  precomputeBandedLinOps(LU.data(), Ainv_B.data(), C.data(), D.data(), G.data(), Ginv.data(),
+                         PIV.data(), kl, ku, Nyx, Nz);
+
+  const char* names[2] = {"bandedSchurSolve", "bandedSchurSolve_noD"};
+  for (int noD = 0; noD < 2; ++noD)
+  {
+    std::vector<double> RHS(rhs), Cp((size_t) Nz * Nyx), Dp((size_t) Nz * Nyx);
+    if (noD)
+    {
+      bandedSchurSolve_noD(LU.data(), RHS.data(), bc.data(), PIV.data(), C.data(), Ginv.data(),
+                           Ainv_B.data(), SIMat.data(), Cp.data(), kl, ku, Nyx, Nz);
+    }
+    else
+    {
+      bandedSchurSolve(LU.data(), RHS.data(), PIV.data(), C.data(), Ginv.data(), Ainv_B.data(),
+                       FIMat.data(), SIMat.data(), Cp.data(), Dp.data(), kl, ku, Nyx, Nz);
+    }
+    double err = 0, norm = 0;
+    for (int i = 1; i < Nyx; ++i)
+    {
+      // the full system of wave number i, and its dense solve
+      std::vector<double> M((size_t) n * n, 0), x(n), sol(Nz), dsol(Nz);
+      std::vector<int> ipiv(n);
+      for (int c = 0; c < Nz; ++c)
+      {
+        for (int r = 0; r < Nz; ++r) {M[r + n * c] = A[(size_t) Nz * Nz * i + r + Nz * c];}
+        M[Nz + n * c] = C[(size_t) 2 * Nz * i + 2 * c]; M[Nz + 1 + n * c] = C[(size_t) 2 * Nz * i + 2 * c + 1];
+      }
+      for (int c = 0; c < 2; ++c)
+      {
+        for (int r = 0; r < Nz; ++r) {M[r + n * (Nz + c)] = B[(size_t) 2 * Nz * i + r + Nz * c];}
+        M[Nz + n * (Nz + c)] = D[4 * i + 2 * c]; M[Nz + 1 + n * (Nz + c)] = D[4 * i + 2 * c + 1];
+      }
+      for (int j = 0; j < Nz; ++j) {x[j] = rhs[(size_t) Nz * i + j];}
+      x[Nz] = noD ? bc[2 * i] : 0; x[Nz + 1] = noD ? bc[2 * i + 1] : 0;
+      LAPACKE_dgesv(LAPACK_COL_MAJOR, n, 1, M.data(), n, ipiv.data(), x.data(), n);
+      matVec(SIMat, x.data(), sol.data(), Nz, n);
+      matVec(FIMat, x.data(), dsol.data(), Nz, n);
+      for (int j = 0; j < Nz; ++j)
+      {
+        err = fmax(err, fabs(Cp[(size_t) Nz * i + j] - sol[j])); norm = fmax(norm, fabs(sol[j]));
+        if (noD) {continue;}
+        err = fmax(err, fabs(Dp[(size_t) Nz * i + j] - dsol[j])); norm = fmax(norm, fabs(dsol[j]));
+      }
+    }
+    std::cout << names[noD] << ": max error vs. dense solve = " << err / norm << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,174 @@
+#include "Transform.h"
+#include "LinearSolvers.h"
+#include "DPTools.h"
+#include<iostream>
+#include<iomanip>
+#include<vector>
+#include<cstdlib>
+#include<math.h>
+
+/* Accuracy of the single precision pipeline against the double precision one
+   (the numbers quoted in the README come from this test).
+
+   For each stage, the same random data is processed in double and in float, and we report
+   the max difference of the outputs relative to the max of the double output:
+
+     - forward Fourier transforms (complex and real-to-complex) on an Nx x Ny x Nz grid,
+       and the round trip error of the float transforms (backward(forward(f)) / N - f)
+     - forward Fourier-Chebyshev transform with a Chebyshev z axis, and its round trip
+     - the banded Schur complement solves of the DP solvers (see LinearSolvers.h), on the
+       operators of the Poisson problem f'' - k^2 f = g with Dirichlet BCs in Chebyshev
+       space, for every wave number of an Nx x Ny grid
+     - the bottom wall correction of the DP solvers (see DPTools.h)
+
+   usage: ./test_single_precision [Nx Ny Nz]
+*/
+
+// max |a - b| / max |b|
+template<typename T>
+double relErr(const T* a, const double* b, const size_t n)
+{
+  double err = 0, norm = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    err = fmax(err, fabs(a[i] - b[i])); norm = fmax(norm, fabs(b[i]));
+  }
+  return norm ? err / norm : err;
+}
+
+void report(const char* stage, const double err)
+{
+  std::cout << std::left << std::setw(36) << stage << std::right
+            << std::scientific << std::setprecision(2) << err << "\n";
+}
+
+// forward transform of f in double and float, and round trip in float
+void compareTransforms(const char* name, const std::vector<double>& f, const unsigned int Nx,
+                       const unsigned int Ny, const unsigned int Nz, const unsigned int dof,
+                       const bool real, const bool cheb)
+{
+  std::vector<float> ff(f.begin(), f.end());
+  Transform fd(f.data(), Nx, Ny, Nz, dof, false, real, cheb);
+  TransformF fs(ff.data(), Nx, Ny, Nz, dof, false, real, cheb);
+  const size_t Nh = (size_t) Nz * Ny * fd.spectralNx() * dof, N = (size_t) Nx * Ny * Nz * dof;
+  const double err = fmax(relErr(fs.out_real, fd.out_real, Nh), relErr(fs.out_complex, fd.out_complex, Nh));
+  report((std::string(name) + " forward").c_str(), err);
+  TransformF bs(fs.out_real, fs.out_complex, Nx, Ny, Nz, dof, false, real, cheb);
+  // the backward transforms are unnormalized in the Fourier axes
+  const float norm = 1.0 / ((double) Nx * Ny * (cheb ? 1 : Nz));
+  for (size_t i = 0; i < N; ++i) {bs.out_real[i] *= norm;}
+  report((std::string(name) + " round trip").c_str(), relErr(bs.out_real, f.data(), N));
+  fd.cleanup(); fs.cleanup(); bs.cleanup();
+}
+
+int main(int argc, char* argv[])
+{
+  const unsigned int Nx = argc > 3 ? atoi(argv[1]) : 64;
+  const unsigned int Ny = argc > 3 ? atoi(argv[2]) : 64;
+  const unsigned int Nz = argc > 3 ? atoi(argv[3]) : 64, dof = 3;
+  fftw_init_threads(); fftwf_init_threads();
+  srand48(1);
+  std::cout << "relative error of float vs double, " << Nx << " x " << Ny << " x " << Nz << "\n";
+
+  // transforms of a random field
+  std::vector<double> f((size_t) Nx * Ny * Nz * dof);
+  for (size_t i = 0; i < f.size(); ++i) {f[i] = 2 * drand48() - 1;}
+  compareTransforms("complex DFT", f, Nx, Ny, Nz, dof, false, false);
+  compareTransforms("real DFT", f, Nx, Ny, Nz, dof, true, false);
+  compareTransforms("real DFT + Chebyshev", f, Nx, Ny, Nz, dof, true, true);
+
+  /* banded Schur solves for the Chebyshev coefficients a of f'' on [-1, 1] with
+     f = SI (a, c0, d0), where SI is the second integral matrix (Nz x Nz + 2),
+     so the system is (I - k^2 SI) (a, c0, d0) = g with f(1) = f(-1) = 0 */
+  const unsigned int Nyx = Nx * Ny, kl = 2, ku = 2, ldab = 2 * kl + ku + 1;
+  std::vector<double> SI((size_t) Nz * (Nz + 2), 0), FI((size_t) Nz * (Nz + 2), 0);
+  auto si = [&](unsigned int i, unsigned int j) -> double& {return SI[i + (size_t) Nz * j];};
+  auto fi = [&](unsigned int i, unsigned int j) -> double& {return FI[i + (size_t) Nz * j];};
+  // the diagonals of SI and FI by row (see Chebyshev.py)
+  for (unsigned int m = 0; m < Nz; ++m)
+  {
+    if (m >= 2) si(m, m - 2) = m == 2 ? 0.25 : 1.0 / (2 * m * (2 * m - 2));
+    if (m >= 1) si(m, m) = m == 1 ? -0.125 : m == 2 ? -1.0 / 8 - 1.0 / 24 :
+                           -1.0 / (2 * m * (2 * m - 2)) - (m < Nz - 1 ? 1.0 / (2 * m * (2 * m + 2)) : 0);
+    si(m, m + 2) = m == 0 ? 0 : m == 1 ? 0.125 : m == 2 ? 1.0 / 24 :
+                   (m < Nz - 2 ? 1.0 / (2 * m * (2 * m + 2)) : 0);
+    if (m >= 1) fi(m, m - 1) = m == 1 ? 1 : 1.0 / (2 * m);
+    fi(m, m + 1) = m == 0 ? 0 : m == 1 ? -0.5 : (m < Nz - 1 ? -1.0 / (2 * m) : 0);
+  }
+  si(0, Nz) = 1; si(1, Nz + 1) = 1; fi(0, Nz + 1) = 1;
+  std::vector<double> A((size_t) ldab * Nz * Nyx, 0), B((size_t) Nz * 2 * Nyx), C((size_t) 2 * Nz * Nyx);
+  std::vector<double> D((size_t) 4 * Nyx), RHS((size_t) Nz * Nyx);
+  for (unsigned int i = 0; i < Nyx; ++i)
+  {
+    const double kx = (double) (i % Nx), ky = (double) (i / Nx), k2 = kx * kx + ky * ky;
+    double* ab = &A[(size_t) ldab * Nz * i];
+    for (unsigned int j = 0; j < Nz; ++j)
+    {
+      for (unsigned int r = (j > ku ? j - ku : 0); r < Nz && r <= j + kl; ++r)
+      {
+        ab[kl + ku + r - j + (size_t) ldab * j] = (r == j) - k2 * si(r, j);
+      }
+      RHS[j + (size_t) Nz * i] = 2 * drand48() - 1;
+    }
+    for (unsigned int c = 0; c < 2; ++c)
+    {
+      for (unsigned int r = 0; r < Nz; ++r) {B[r + (size_t) Nz * (c + 2 * i)] = -k2 * si(r, Nz + c);}
+    }
+    // f(1) = sum_k f_k and f(-1) = sum_k (-1)^k f_k, split into the a and (c0, d0) parts
+    for (unsigned int b = 0; b < 2; ++b)
+    {
+      for (unsigned int j = 0; j < Nz + 2; ++j)
+      {
+        double row = 0;
+        for (unsigned int r = 0; r < Nz; ++r) {row += (b && (r % 2) ? -1 : 1) * si(r, j);}
+        if (j < Nz) {C[b + 2 * (j + (size_t) Nz * i)] = row;}
+        else {D[b + 2 * (j - Nz + 2 * i)] = row;}
+      }
+    }
+  }
+  // single precision copies of the operators
+  auto toFloat = [](const std::vector<double>& v) {return std::vector<float>(v.begin(), v.end());};
+  std::vector<float> As = toFloat(A), Bs = toFloat(B), Cs = toFloat(C), Ds = toFloat(D);
+  std::vector<float> SIs = toFloat(SI), FIs = toFloat(FI), RHSs = toFloat(RHS);
+  std::vector<double> G(4 * Nyx), Ginv(4 * Nyx), Cp((size_t) Nz * Nyx), Dp((size_t) Nz * Nyx);
+  std::vector<float> Gs(4 * Nyx), Ginvs(4 * Nyx), Cps((size_t) Nz * Nyx), Dps((size_t) Nz * Nyx);
+  std::vector<int> PIV((size_t) Nz * Nyx), PIVs((size_t) Nz * Nyx);
+  precomputeBandedLinOps(A.data(), B.data(), C.data(), D.data(), G.data(), Ginv.data(),
+                         PIV.data(), kl, ku, Nyx, Nz);
+  precomputeBandedLinOpsF(As.data(), Bs.data(), Cs.data(), Ds.data(), Gs.data(), Ginvs.data(),
+                          PIVs.data(), kl, ku, Nyx, Nz);
+  bandedSchurSolve(A.data(), RHS.data(), PIV.data(), C.data(), Ginv.data(), B.data(),
+                   FI.data(), SI.data(), Cp.data(), Dp.data(), kl, ku, Nyx, Nz);
+  bandedSchurSolveF(As.data(), RHSs.data(), PIVs.data(), Cs.data(), Ginvs.data(), Bs.data(),
+                    FIs.data(), SIs.data(), Cps.data(), Dps.data(), kl, ku, Nyx, Nz);
+  // the k = 0 mode is not solved for
+  const size_t n = (size_t) Nz * (Nyx - 1);
+  report("banded Schur solve", relErr(Cps.data() + Nz, Cp.data() + Nz, n));
+  report("banded Schur solve (derivative)", relErr(Dps.data() + Nz, Dp.data() + Nz, n));
+
+  // bottom wall correction for random velocities at the wall, on [0, 2]
+  std::vector<double> fhat_r((size_t) Nyx * dof), fhat_i((size_t) Nyx * dof), Kx(Nyx), Ky(Nyx), z(Nz);
+  for (size_t i = 0; i < fhat_r.size(); ++i) {fhat_r[i] = 2 * drand48() - 1; fhat_i[i] = 2 * drand48() - 1;}
+  for (unsigned int i = 0; i < Nyx; ++i)
+  {
+    Kx[i] = 2 * M_PI / Nx * ((i % Nx) < Nx / 2 ? (double) (i % Nx) : (double) (i % Nx) - Nx);
+    Ky[i] = 2 * M_PI / Ny * ((i / Nx) < Ny / 2 ? (double) (i / Nx) : (double) (i / Nx) - Ny);
+  }
+  for (unsigned int j = 0; j < Nz; ++j) {z[j] = 1 + cos(M_PI * j / (Nz - 1));}
+  std::vector<float> fhat_rs = toFloat(fhat_r), fhat_is = toFloat(fhat_i), Kxs = toFloat(Kx);
+  std::vector<float> Kys = toFloat(Ky), zs = toFloat(z);
+  std::vector<std::vector<double>> corr(8, std::vector<double>((size_t) Nyx * Nz, 0));
+  std::vector<std::vector<float>> corrs(8, std::vector<float>((size_t) Nyx * Nz, 0));
+  evalCorrectionSol_bottomWall(corr[0].data(), corr[1].data(), corr[2].data(), corr[3].data(),
+                               corr[4].data(), corr[5].data(), corr[6].data(), corr[7].data(),
+                               fhat_r.data(), fhat_i.data(), Kx.data(), Ky.data(), z.data(),
+                               1.0, Nyx, Nz, dof);
+  evalCorrectionSol_bottomWallF(corrs[0].data(), corrs[1].data(), corrs[2].data(), corrs[3].data(),
+                                corrs[4].data(), corrs[5].data(), corrs[6].data(), corrs[7].data(),
+                                fhat_rs.data(), fhat_is.data(), Kxs.data(), Kys.data(), zs.data(),
+                                1.0f, Nyx, Nz, dof);
+  double err = 0;
+  for (unsigned int c = 0; c < 8; ++c) {err = fmax(err, relErr(corrs[c].data(), corr[c].data(), corr[c].size()));}
+  report("bottom wall correction", err);
+  return 0;
+}
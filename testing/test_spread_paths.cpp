@@ -0,0 +1,160 @@
+#include<iostream>
+#include<iomanip>
+#include<vector>
+#include<cmath>
+#include<cstdlib>
+#include<fftw3.h>
+#include"SpreadInterp.h"
+#include"BoundaryConditions.h"
+#include"ParticleList.h"
+#include"Grid.h"
+
+/* Checks of the optional spread/interp paths against the default one.
+   For the same particles, we spread, fold, copy and interpolate with the
+   default path and with each option, on a triply periodic (uniform z) and a
+   doubly periodic (Chebyshev z) grid, and report the max abs difference of the
+   grid (after fold) and of the particle data (after interpolation) relative to
+   the max of the default result. All should be at round-off.
+
+     - layers: the particles lie on 3 z-layers, so the layered separable path
+       is taken (see ParticleList::findLayers()), vs. setMaxLayers(0)
+     - weights: random particles, with the kernel weights cached on the spread
+       and reused by the interpolation (see ParticleList::setWeightCache())
+     - reorder: random particles, stored in Morton order on the grid (see
+       ParticleList::setReordering()). The interpolated data is compared in the 
+       caller's order, as returned by getForces()
+
+   usage: ./test_spread_paths [nP]
+*/
+
+// particle data in the caller's order
+struct Particles
+{
+  std::vector<double> xP, fP, radP, betafP, cwfP;
+  std::vector<unsigned short> wfP;
+};
+
+// options of the spread/interp path
+struct Options
+{
+  unsigned int max_layers;
+  bool cache_weights;
+  bool reorder;
+};
+
+// random particles with the kernels of ParticleList::randInit(), on nlayers z-layers
+// (one kernel per layer) if nlayers > 0
+Particles randParticles(const unsigned int nP, const unsigned int dof, const double Lx,
+                        const double Ly, const double Lz, const unsigned int nlayers)
+{
+  const unsigned short ws[3] = {4, 5, 6};
+  const double betas[3] = {1.785, 1.886, 1.714}, Rhs[3] = {1.2047, 1.3437, 1.5539};
+  Particles p;
+  p.xP.resize(3 * nP); p.fP.resize(dof * nP); p.radP.resize(nP); p.betafP.resize(nP);
+  p.cwfP.resize(nP); p.wfP.resize(nP);
+  for (unsigned int i = 0; i < nP; ++i)
+  {
+    const unsigned int k = nlayers ? i % nlayers : lrand48() % 3;
+    p.xP[3 * i] = drand48() * Lx; p.xP[3 * i + 1] = drand48() * Ly;
+    p.xP[3 * i + 2] = nlayers ? (k + 0.37) * Lz / (nlayers + 0.5) : drand48() * Lz;
+    for (unsigned int d = 0; d < dof; ++d) {p.fP[d + dof * i] = 2 * drand48() - 1;}
+    p.radP[i] = p.cwfP[i] = Rhs[k % 3]; p.wfP[i] = ws[k % 3]; p.betafP[i] = betas[k % 3];
+  }
+  return p;
+}
+
+// spread and interpolate the particles with options opt, storing the folded grid
+// in fG and the interpolated data (in the caller's order) in fP
+void spreadInterp(const Particles& p, const bool dp, const Options& opt,
+                  std::vector<double>& fG, std::vector<double>& fP, unsigned int& nlayers)
+{
+  const unsigned int Nx = 32, Ny = 32, Nz = 25, dof = 3, nP = p.radP.size();
+  const double h = 0.5, Lx = Nx * h, Ly = Ny * h, Lz = Nz * h;
+  Grid grid;
+  grid.setPeriodicity(true, true, !dp);
+  if (dp) {grid.makeDP(Lx, Ly, Lz, h, h, Nx, Ny, Nz, dof);}
+  else {grid.makeTP(Lx, Ly, Lz, h, h, h, Nx, Ny, Nz, dof);}
+  ParticleList particles(p.xP.data(), p.fP.data(), p.radP.data(), p.betafP.data(),
+                         p.cwfP.data(), p.wfP.data(), nP, dof);
+  particles.setMaxLayers(opt.max_layers);
+  particles.setWeightCache(opt.cache_weights);
+  particles.setReordering(opt.reorder);
+  particles.setup(grid);
+  if (opt.reorder)
+  {
+    unsigned int moved = 0;
+    for (unsigned int i = 0; particles.perm && i < nP; ++i) {moved += (particles.perm[i] != i);}
+    if (not moved) {std::cout << "reorder: the particles were not reordered\n";}
+  }
+  nlayers = particles.nlayers;
+  const unsigned short ext_up = dp ? particles.ext_up : particles.wfzP_max;
+  const unsigned short ext_down = dp ? particles.ext_down : particles.wfzP_max;
+
+  grid.zeroExtGrid();
+  spread(particles, grid);
+  fold(grid.fG_unwrap, grid.fG, particles.wfxP_max, particles.wfyP_max, ext_up,
+       ext_down, grid.Nxeff, grid.Nyeff, grid.Nzeff, dof, grid.isperiodic, grid.BCs);
+  fG.assign(grid.fG, grid.fG + (size_t) Nx * Ny * Nz * dof);
+
+  particles.zeroForces();
+  copy(grid.fG_unwrap, grid.fG, particles.wfxP_max, particles.wfyP_max, ext_up,
+       ext_down, grid.Nxeff, grid.Nyeff, grid.Nzeff, dof, grid.isperiodic, grid.BCs);
+  interpolate(particles, grid);
+  if (opt.cache_weights && not particles.kxP) {std::cout << "weights: the kernel weights were not cached\n";}
+  const double* f = particles.getForces();
+  fP.assign(f, f + (size_t) nP * dof);
+
+  particles.cleanup();
+  grid.cleanup();
+}
+
+// max |a - b| / max |b|
+double relErr(const std::vector<double>& a, const std::vector<double>& b)
+{
+  double err = 0, norm = 0;
+  for (size_t i = 0; i < b.size(); ++i)
+  {
+    err = std::max(err, std::fabs(a[i] - b[i])); norm = std::max(norm, std::fabs(b[i]));
+  }
+  return norm ? err / norm : err;
+}
+
+void report(const char* name, const char* geom, const std::vector<double>& fG,
+            const std::vector<double>& fGref, const std::vector<double>& fP,
+            const std::vector<double>& fPref)
+{
+  std::cout << std::setw(8) << name << std::setw(4) << geom << std::scientific
+            << std::setprecision(3) << "  spread err = " << relErr(fG, fGref)
+            << "  interp err = " << relErr(fP, fPref) << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  fftw_init_threads();
+  const unsigned int nP = argc > 1 ? atoi(argv[1]) : 2000, dof = 3;
+  const double L = 16, Lz = 12.5;
+  const char* geoms[2] = {"TP", "DP"};
+  const Options defaults = {0, false, false};
+  for (unsigned int dp = 0; dp < 2; ++dp)
+  {
+    std::vector<double> fGref, fPref, fG, fP;
+    unsigned int nlayers;
+    srand48(1);
+    const Particles layered = randParticles(nP, dof, L, L, Lz, 3);
+    spreadInterp(layered, dp, defaults, fGref, fPref, nlayers);
+    Options opt = defaults; opt.max_layers = 16;
+    spreadInterp(layered, dp, opt, fG, fP, nlayers);
+    if (nlayers != 3) {std::cout << "layers: found " << nlayers << " z-layers instead of 3\n";}
+    report("layers", geoms[dp], fG, fGref, fP, fPref);
+
+    const Particles random = randParticles(nP, dof, L, L, Lz, 0);
+    spreadInterp(random, dp, defaults, fGref, fPref, nlayers);
+    opt = defaults; opt.cache_weights = true;
+    spreadInterp(random, dp, opt, fG, fP, nlayers);
+    report("weights", geoms[dp], fG, fGref, fP, fPref);
+    opt = defaults; opt.reorder = true;
+    spreadInterp(random, dp, opt, fG, fP, nlayers);
+    report("reorder", geoms[dp], fG, fGref, fP, fPref);
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+#include<iostream>
+#include<iomanip>
+#include<cmath>
+#include<fftw3.h>
+#include"SpreadInterp.h"
+#include"BoundaryConditions.h"
+#include"ParticleList.h"
+#include"Grid.h"
+
+/* Accuracy report for single precision spreading/interpolation.
+   For the same random configuration, we spread, fold, copy and interpolate
+   with a double and a single precision extended grid, and report the
+   max abs error and relative l2 error of the single precision result on
+   the grid (after fold) and on the particles (after interpolation).
+
+   usage: ./test_spread_single [nP]
+*/
+
+// spread random forces and interpolate back, storing the results in fG_out and fP_out
+void spreadInterp(const unsigned int nP, const bool dp, const bool single,
+                  double* fG_out, double* fP_out)
+{
+  const unsigned int Nx = 64, Ny = 64, Nz = 25, dof = 3;
+  const double hx = 0.5, hy = 0.5, hz = 0.5, Lx = Nx * hx, Ly = Ny * hy, Lz = Nz * hz;
+  Grid grid; ParticleList particles;
+  // same configuration for each precision
+  srand48(1);
+  grid.setPeriodicity(true, true, !dp);
+  grid.setSinglePrecision(single);
+  if (dp) {grid.makeDP(Lx, Ly, Lz, hx, hy, Nx, Ny, Nz, dof);}
+  else {grid.makeTP(Lx, Ly, Lz, hx, hy, hz, Nx, Ny, Nz, dof);}
+  particles.randInit(grid, nP);
+  for (unsigned int i = 0; i < nP * dof; ++i) {particles.fP[i] = drand48() - 0.5;}
+  const unsigned short ext_up = dp ? particles.ext_up : particles.wfzP_max;
+  const unsigned short ext_down = dp ? particles.ext_down : particles.wfzP_max;
+
+  grid.zeroExtGrid();
+  spread(particles, grid);
+  if (single)
+  {
+    fold(grid.fG_unwrap_f, grid.fG, particles.wfxP_max, particles.wfyP_max, ext_up,
+         ext_down, grid.Nxeff, grid.Nyeff, grid.Nzeff, dof, grid.isperiodic, grid.BCs);
+  }
+  else
+  {
+    fold(grid.fG_unwrap, grid.fG, particles.wfxP_max, particles.wfyP_max, ext_up,
+         ext_down, grid.Nxeff, grid.Nyeff, grid.Nzeff, dof, grid.isperiodic, grid.BCs);
+  }
+  for (unsigned int i = 0; i < Nx * Ny * Nz * dof; ++i) {fG_out[i] = grid.fG[i];}
+
+  particles.zeroForces();
+  if (single)
+  {
+    copy(grid.fG_unwrap_f, grid.fG, particles.wfxP_max, particles.wfyP_max, ext_up,
+         ext_down, grid.Nxeff, grid.Nyeff, grid.Nzeff, dof, grid.isperiodic, grid.BCs);
+  }
+  else
+  {
+    copy(grid.fG_unwrap, grid.fG, particles.wfxP_max, particles.wfyP_max, ext_up,
+         ext_down, grid.Nxeff, grid.Nyeff, grid.Nzeff, dof, grid.isperiodic, grid.BCs);
+  }
+  interpolate(particles, grid);
+  for (unsigned int i = 0; i < nP * dof; ++i) {fP_out[i] = particles.fP[i];}
+
+  particles.cleanup();
+  grid.cleanup();
+}
+
+// print max abs error and relative l2 error of approx wrt ref
+void report(const char* name, const double* ref, const double* approx, const unsigned int N)
+{
+  double maxerr = 0, err2 = 0, ref2 = 0;
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    const double e = std::fabs(ref[i] - approx[i]);
+    maxerr = std::max(maxerr, e);
+    err2 += e * e; ref2 += ref[i] * ref[i];
+  }
+  std::cout << std::setw(10) << name << std::scientific << std::setprecision(3)
+            << "  max abs err = " << maxerr << "  rel l2 err = "
+            << std::sqrt(err2 / ref2) << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  fftw_init_threads();
+  const unsigned int nP = argc > 1 ? atoi(argv[1]) : 2000, NG = 64 * 64 * 25 * 3;
+  double* fG_d = (double*) fftw_malloc(NG * sizeof(double));
+  double* fG_s = (double*) fftw_malloc(NG * sizeof(double));
+  double* fP_d = (double*) fftw_malloc(nP * 3 * sizeof(double));
+  double* fP_s = (double*) fftw_malloc(nP * 3 * sizeof(double));
+  const char* names[2] = {"TP", "DP"};
+  for (unsigned int dp = 0; dp < 2; ++dp)
+  {
+    spreadInterp(nP, dp, false, fG_d, fP_d);
+    spreadInterp(nP, dp, true, fG_s, fP_s);
+    std::cout << names[dp] << " single vs. double precision, nP = " << nP << std::endl;
+    report("spread", fG_d, fG_s, NG);
+    report("interp", fP_d, fP_s, nP * 3);
+  }
+  fftw_free(fG_d); fftw_free(fG_s); fftw_free(fP_d); fftw_free(fP_s);
+  return 0;
+}
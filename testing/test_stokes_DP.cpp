@@ -0,0 +1,202 @@
+#include "DPStokes.h"
+#include "Transform.h"
+#include<iostream>
+#include<complex>
+#include<vector>
+#include<cstdlib>
+#include<math.h>
+
+/* Doubly periodic Stokes solver (see DPStokes.h)
+
+   - for a smooth random force spectrum, the solution of each geometry is checked
+     against the equations, in the space of the Chebyshev coefficients: the residuals of
+     -eta lap(u) + grad(p) = f and div(u) = 0 (but for the last 2 coefficients, which the
+     integral formulation leaves out), and the velocity at the walls, which must be 0.
+     The k = 0 mode of the no wall solve is 0 (k0 = 0), so it is left out of its residual.
+   - the solves of the four layouts of the spectrum (interleaved or planar, and
+     wavenumber-major or not) are compared with each other.
+   - for the slit channel, the velocity on the grid is compared with an exact solution
+     after a forward transform, an in place solve and the backward transform. The velocity
+     is u = curl of (0, cos(a x) sin^3(pi z / Lz), 0) plus the shear (sin(pi z / Lz), 0, 0),
+     with the pressure cos(a x) cos(pi z / Lz), so it is 0 at both walls, and so is the z
+     component of the force.
+
+   usage: ./test_stokes_DP [Nx Ny Nz]
+*/
+
+typedef std::complex<double> cplx;
+
+// Chebyshev coefficients of the z derivative on [0, 2H] (chebCoeffDiff() in Chebyshev.py)
+std::vector<cplx> diff(const std::vector<cplx>& f, const double H)
+{
+  const unsigned int Nz = f.size();
+  std::vector<cplx> df(Nz, 0);
+  df[Nz - 2] = 2 / H * (Nz - 1.0) * f[Nz - 1];
+  for (unsigned int j = 2; j < Nz; ++j) {df[Nz - j - 1] = df[Nz - j + 1] + 2 / H * (Nz - j * 1.0) * f[Nz - j];}
+  df[0] /= 2;
+  return df;
+}
+
+struct Layout
+{
+  unsigned int Nz, Nyx; bool planar, kmajor;
+  // index of coefficient k of wave number p of component d (d = 3 for the pressure)
+  size_t at(const unsigned int d, const size_t p, const unsigned int k) const
+  {
+    if (d == 3) {return kmajor ? p * Nz + k : k * Nyx + p;}
+    if (kmajor) {return planar ? (d * Nyx + p) * Nz + k : (3 * p + d) * Nz + k;}
+    return planar ? (d * Nz + k) * (size_t) Nyx + p : 3 * (k * (size_t) Nyx + p) + d;
+  }
+};
+
+int main(int argc, char* argv[])
+{
+  const unsigned int Nx = argc > 3 ? atoi(argv[1]) : 16;
+  const unsigned int Ny = argc > 3 ? atoi(argv[2]) : 12;
+  const unsigned int Nz = argc > 3 ? atoi(argv[3]) : 32, dof = 3;
+  const double Lx = 2.0, Ly = 3.0, H = 0.75, eta = 0.7;
+  const char* names[3] = {"no wall", "bottom wall", "slit channel"};
+  fftw_init_threads();
+  srand48(1);
+
+  // smooth random force on the half spectrum, 0 for the unpaired modes
+  DPStokes solver(Nx, Ny, Nz, Lx, Ly, H, eta, false, true, true);
+  const unsigned int Nxs = solver.Nxs, Nyx = solver.Nyx;
+  const size_t n = solver.spectralSize();
+  std::vector<double> f_r(n, 0), f_i(n, 0);
+  Layout ref = {Nz, Nyx, false, true};
+  for (size_t p = 0; p < Nyx; ++p)
+  {
+    const unsigned int i = p % Nxs, j = p / Nxs;
+    if (2 * i >= Nx - 1 || (j >= Ny / 2 && j <= (Ny + 1) / 2)) {continue;}
+    for (unsigned int d = 0; d < dof; ++d)
+    {
+      for (unsigned int k = 0; k < Nz; ++k)
+      {
+        const double decay = exp(-0.5 * k - 0.3 * (i + (j < Ny / 2 ? j : Ny - j)));
+        f_r[ref.at(d, p, k)] = decay * (2 * drand48() - 1);
+        f_i[ref.at(d, p, k)] = decay * (2 * drand48() - 1);
+      }
+      if (d < 2) {continue;}
+      // the z component vanishes at both ends of the z axis (see DPStokes.h)
+      cplx top = 0, bottom = 0;
+      for (unsigned int k = 0; k < Nz; ++k)
+      {
+        const cplx c(f_r[ref.at(d, p, k)], f_i[ref.at(d, p, k)]);
+        top += c; bottom += (k % 2 ? -1.0 : 1.0) * c;
+      }
+      f_r[ref.at(d, p, 0)] -= 0.5 * real(top + bottom); f_i[ref.at(d, p, 0)] -= 0.5 * imag(top + bottom);
+      f_r[ref.at(d, p, 1)] -= 0.5 * real(top - bottom); f_i[ref.at(d, p, 1)] -= 0.5 * imag(top - bottom);
+    }
+  }
+
+  for (unsigned int g = 0; g < 3; ++g)
+  {
+    const DPGeometry geom = (DPGeometry) g;
+    std::vector<double> u_r(f_r), u_i(f_i), p_r(n / dof), p_i(n / dof);
+    solver.solve(u_r.data(), u_i.data(), geom, 0, p_r.data(), p_i.data());
+    double res = 0, div = 0, wall = 0, norm = 0;
+    for (size_t p = (geom == no_wall); p < Nyx; ++p)
+    {
+      const double kx = solver.kx[p % Nxs], ky = solver.ky[p / Nxs];
+      std::vector<cplx> U[3], F[3], P(Nz);
+      for (unsigned int k = 0; k < Nz; ++k) {P[k] = cplx(p_r[ref.at(3, p, k)], p_i[ref.at(3, p, k)]);}
+      for (unsigned int d = 0; d < dof; ++d)
+      {
+        U[d].resize(Nz); F[d].resize(Nz);
+        for (unsigned int k = 0; k < Nz; ++k)
+        {
+          U[d][k] = cplx(u_r[ref.at(d, p, k)], u_i[ref.at(d, p, k)]);
+          F[d][k] = cplx(f_r[ref.at(d, p, k)], f_i[ref.at(d, p, k)]);
+          norm = fmax(norm, abs(F[d][k]));
+        }
+      }
+      const std::vector<cplx> Pz = diff(P, H), Wz = diff(U[2], H);
+      for (unsigned int d = 0; d < dof; ++d)
+      {
+        const std::vector<cplx> Uzz = diff(diff(U[d], H), H);
+        cplx top = 0, bottom = 0;
+        for (unsigned int k = 0; k < Nz; ++k)
+        {
+          top += U[d][k]; bottom += (k % 2 ? -1.0 : 1.0) * U[d][k];
+          if (k >= Nz - 2) {continue;}
+          const cplx grad = d == 0 ? cplx(0, kx) * P[k] : d == 1 ? cplx(0, ky) * P[k] : Pz[k];
+          res = fmax(res, abs(-eta * (Uzz[k] - (kx * kx + ky * ky) * U[d][k]) + grad - F[d][k]));
+          if (d == 0) {div = fmax(div, abs(cplx(0, kx) * U[0][k] + cplx(0, ky) * U[1][k] + Wz[k]));}
+        }
+        if (geom != no_wall) {wall = fmax(wall, abs(bottom));}
+        if (geom == slit_channel) {wall = fmax(wall, abs(top));}
+      }
+    }
+    std::cout << names[g] << ": max residual of the momentum eq. = " << res / norm
+              << ", of the continuity eq. = " << div / norm << ", max velocity at the walls = "
+              << wall / norm << std::endl;
+
+    // the other layouts
+    double maxdiff = 0;
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+      const Layout other = {Nz, Nyx, c != 1, c != 0};
+      DPStokes s(Nx, Ny, Nz, Lx, Ly, H, eta, other.planar, true, other.kmajor);
+      std::vector<double> v_r(n), v_i(n);
+      for (size_t p = 0; p < Nyx; ++p)
+      {
+        for (unsigned int d = 0; d < dof; ++d)
+        {
+          for (unsigned int k = 0; k < Nz; ++k)
+          {
+            v_r[other.at(d, p, k)] = f_r[ref.at(d, p, k)]; v_i[other.at(d, p, k)] = f_i[ref.at(d, p, k)];
+          }
+        }
+      }
+      s.solve(v_r.data(), v_i.data(), geom);
+      for (size_t p = 0; p < Nyx; ++p)
+      {
+        for (unsigned int d = 0; d < dof; ++d)
+        {
+          for (unsigned int k = 0; k < Nz; ++k)
+          {
+            maxdiff = fmax(maxdiff, fabs(v_r[other.at(d, p, k)] - u_r[ref.at(d, p, k)]));
+            maxdiff = fmax(maxdiff, fabs(v_i[other.at(d, p, k)] - u_i[ref.at(d, p, k)]));
+          }
+        }
+      }
+      s.cleanup();
+    }
+    std::cout << names[g] << ": max difference between layouts = " << maxdiff << std::endl;
+  }
+  solver.cleanup();
+
+  // exact solution of the slit channel, in place on the output of the forward transform
+  const size_t N = (size_t) Nx * Ny * Nz;
+  const double Lz = 2 * H, a = 2 * M_PI / Lx, b = M_PI / Lz;
+  std::vector<double> fG(N * dof), uG(N * dof);
+  for (unsigned int k = 0; k < Nz; ++k)
+  {
+    for (unsigned int j = 0; j < Ny; ++j)
+    {
+      for (unsigned int i = 0; i < Nx; ++i)
+      {
+        const double x = Lx * i / Nx, z = H * cos(M_PI * k / (Nz - 1)) + H;
+        const double s = sin(b * z), c = cos(b * z), g = s * s * s, g1 = 3 * b * s * s * c;
+        const double g2 = 3 * b * b * s * (2 - 3 * s * s), g3 = 3 * b * b * b * c * (2 - 9 * s * s);
+        const double q = c, q1 = -b * s;
+        const size_t p = dof * (i + Nx * ((size_t) j + Ny * k));
+        fG[p] = -eta * cos(a * x) * (g3 - a * a * g1) - a * sin(a * x) * q + eta * b * b * sin(b * z);
+        fG[p + 1] = 0;
+        fG[p + 2] = -eta * a * sin(a * x) * (g2 - a * a * g) + cos(a * x) * q1;
+        uG[p] = cos(a * x) * g1 + sin(b * z); uG[p + 1] = 0; uG[p + 2] = a * sin(a * x) * g;
+      }
+    }
+  }
+  DPStokes channel(Nx, Ny, Nz, Lx, Ly, H, eta, false, true, true);
+  Transform forward(fG.data(), Nx, Ny, Nz, dof, false, true, true, true);
+  channel.solve(forward.out_real, forward.out_complex, slit_channel);
+  Transform backward(forward.out_real, forward.out_complex, Nx, Ny, Nz, dof, false, true, true, true);
+  double maxerr = 0;
+  for (size_t i = 0; i < N * dof; ++i) {maxerr = fmax(maxerr, fabs(backward.out_real[i] / (Nx * Ny) - uG[i]));}
+  std::cout << "slit channel: max error vs. exact solution = " << maxerr << std::endl;
+
+  forward.cleanup(); backward.cleanup(); channel.cleanup();
+  return 0;
+}
@@ -0,0 +1,106 @@
+#include "TPStokes.h"
+#include "Transform.h"
+#include<iostream>
+#include<complex>
+#include<vector>
+#include<cstdlib>
+#include<math.h>
+
+/* Triply periodic Stokes solver (see TPStokes.h)
+
+   - for a random spectrum, the solver is compared with the complex form of the
+     operator in TriplyPeriodicStokes() (Solvers.py), for the interleaved and planar
+     layouts, the full and half spectrum, and two right-hand sides.
+   - for a force with an exact solution, the velocity on the grid is compared with
+     it after a real forward transform, an in place solve and the backward transform.
+     The force is a shear f = (sin(2 pi z / Lz), 0, 0), with u = f / (eta (2 pi / Lz)^2),
+     plus the gradient of cos(2 pi x / Lx) cos(4 pi y / Ly), which only drives pressure.
+
+   usage: ./test_stokes_TP [Nx Ny Nz]
+*/
+
+typedef std::complex<double> cplx;
+
+// max error of the solver for a random spectrum vs. the complex form of the operator
+double compareReference(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+                        const double L[3], const double eta, const unsigned int nrhs,
+                        const bool planar, const bool real)
+{
+  TPStokes solver(Nx, Ny, Nz, L[0], L[1], L[2], eta, nrhs, planar, real);
+  const size_t n = solver.spectralSize(), N = n / (3 * nrhs);
+  std::vector<double> f_r(n), f_i(n), u_r(n), u_i(n);
+  for (size_t i = 0; i < n; ++i) {f_r[i] = 2 * drand48() - 1; f_i[i] = 2 * drand48() - 1;}
+  solver.solve(f_r.data(), f_i.data(), u_r.data(), u_i.data());
+  double maxerr = 0;
+  for (size_t p = 0; p < N; ++p)
+  {
+    const size_t i = p % solver.Nxs, j = (p / solver.Nxs) % Ny, k = p / (solver.Nxs * Ny);
+    const double K[3] = {solver.kx[i], solver.ky[j], solver.kz[k]};
+    const double ksq = K[0] * K[0] + K[1] * K[1] + K[2] * K[2];
+    for (unsigned int r = 0; r < nrhs; ++r)
+    {
+      size_t idx[3]; cplx f[3], rhs = 0;
+      for (unsigned int d = 0; d < 3; ++d)
+      {
+        idx[d] = planar ? (3 * r + d) * N + p : 3 * (nrhs * p + r) + d;
+        f[d] = cplx(f_r[idx[d]], f_i[idx[d]]);
+        rhs += cplx(0, K[d]) * f[d];
+      }
+      for (unsigned int d = 0; d < 3; ++d)
+      {
+        const cplx u = ksq ? (f[d] + cplx(0, K[d]) * rhs / ksq) / (eta * ksq) : 0;
+        maxerr = fmax(maxerr, abs(u - cplx(u_r[idx[d]], u_i[idx[d]])));
+      }
+    }
+  }
+  solver.cleanup();
+  return maxerr;
+}
+
+int main(int argc, char* argv[])
+{
+  const unsigned int Nx = argc > 3 ? atoi(argv[1]) : 32;
+  const unsigned int Ny = argc > 3 ? atoi(argv[2]) : 24;
+  const unsigned int Nz = argc > 3 ? atoi(argv[3]) : 16, dof = 3;
+  const double L[3] = {2.0, 3.0, 1.5}, eta = 0.7;
+  fftw_init_threads();
+  srand48(1);
+
+  for (unsigned int c = 0; c < 8; ++c)
+  {
+    const unsigned int nrhs = 1 + c % 2; const bool planar = c & 2, real = c & 4;
+    std::cout << "Max error vs. reference (nrhs = " << nrhs << ", planar = " << planar
+              << ", real = " << real << ") = " << compareReference(Nx, Ny, Nz, L, eta, nrhs, planar, real)
+              << std::endl;
+  }
+
+  // exact solution, in place on the half spectrum
+  const size_t N = (size_t) Nx * Ny * Nz;
+  std::vector<double> fG(N * dof), uG(N * dof);
+  const double kx = 2 * M_PI / L[0], ky = 4 * M_PI / L[1], kz = 2 * M_PI / L[2];
+  for (unsigned int k = 0; k < Nz; ++k)
+  {
+    for (unsigned int j = 0; j < Ny; ++j)
+    {
+      for (unsigned int i = 0; i < Nx; ++i)
+      {
+        const double x = L[0] * i / Nx, y = L[1] * j / Ny, z = L[2] * k / Nz;
+        const size_t p = dof * (i + Nx * ((size_t) j + Ny * k));
+        fG[p] = sin(kz * z) - kx * sin(kx * x) * cos(ky * y);
+        fG[p + 1] = -ky * cos(kx * x) * sin(ky * y);
+        fG[p + 2] = 0;
+        uG[p] = sin(kz * z) / (eta * kz * kz); uG[p + 1] = 0; uG[p + 2] = 0;
+      }
+    }
+  }
+  TPStokes solver(Nx, Ny, Nz, L[0], L[1], L[2], eta, 1, false, true);
+  Transform forward(fG.data(), Nx, Ny, Nz, dof, false, true);
+  solver.solve(forward.out_real, forward.out_complex, forward.out_real, forward.out_complex);
+  Transform backward(forward.out_real, forward.out_complex, Nx, Ny, Nz, dof, false, true);
+  double maxerr = 0;
+  for (size_t i = 0; i < N * dof; ++i) {maxerr = fmax(maxerr, fabs(backward.out_real[i] / N - uG[i]));}
+  std::cout << "Max error vs. exact solution = " << maxerr << std::endl;
+
+  forward.cleanup(); backward.cleanup(); solver.cleanup();
+  return 0;
+}
@@ -4,10 +4,14 @@
 #include "Grid.h"
 #include<iostream>
 #include<math.h>
+#include<vector>
 
 // testing complex to complex forward and backward in-place transforms
 // for 3D vector field stored row-major as (k,j,i,l), l = 0:2
-// We also check OpenMP integration
+// We also check OpenMP integration, and a real round trip on the grid buffers
+// (see Grid::setupSpectral())
+//
+// usage: ./test_transform_TP [nP]
 int main(int argc, char* argv[])
 {
   // initialize threads for fftw
@@ -16,10 +20,15 @@ int main(int argc, char* argv[])
   const unsigned int Nx = 64, Ny = 64, Nz = 64, dof = 3; 
   const double hx = 0.5, hy = 0.5, hz = 0.5, Lx = Nx * hx, Ly = Ny * hy, Lz = Nz * hz; 
 
+  const unsigned int nP = argc > 1 ? atoi(argv[1]) : 2000;
+
   Grid grid; ParticleList particles;
+  grid.setPeriodicity(true, true, true);
   grid.makeTP(Lx, Ly, Lz, hx, hy, hz, Nx, Ny, Nz, dof);
-  particles.randInit(grid, atoi(argv[1]));
+  particles.randInit(grid, nP);
   spread(particles, grid); 
+  fold(grid.fG_unwrap, grid.fG, particles.wfxP_max, particles.wfyP_max, particles.wfzP_max,
+       particles.wfzP_max, grid.Nxeff, grid.Nyeff, grid.Nzeff, dof, grid.isperiodic, grid.BCs);
 
   Transform forward(grid.fG,Nx,Ny,Nz,dof);
   Transform backward(forward.out_real,forward.out_complex,Nx,Ny,Nz,dof); 
@@ -34,9 +43,28 @@ int main(int argc, char* argv[])
     maxerr = (maxerr >= err ? maxerr : err);
   }
   std::cout << "Max error = " << maxerr << std::endl;
+
+  // real transforms bound to the grid (planned without touching the data), 
+  // the backward one is normalized
+  grid.setupSpectral(true);
+  Transform fbound(grid.fG, grid.fG_hat_r, grid.fG_hat_i, Nx, Ny, Nz, dof, FFTW_FORWARD,
+                   false, true, false, false, FFTW_ESTIMATE);
+  Transform bbound(grid.fG, grid.fG_hat_r, grid.fG_hat_i, Nx, Ny, Nz, dof, FFTW_BACKWARD,
+                   false, true, false, false, FFTW_ESTIMATE);
+  std::vector<double> fG(grid.fG, grid.fG + N * dof);
+  fbound.execute(); bbound.execute();
+  maxerr = 0;
+  for (unsigned int i = 0; i < N * dof; ++i)
+  {
+    err = fabs(grid.fG[i] - fG[i]);
+    maxerr = (maxerr >= err ? maxerr : err);
+  }
+  std::cout << "Max error (bound) = " << maxerr << std::endl;
  
   forward.cleanup();
   backward.cleanup();
+  fbound.cleanup();
+  bbound.cleanup();
   particles.cleanup();
   grid.cleanup(); 
   return 0;
@@ -0,0 +1,232 @@
+#include<iostream>
+#include<iomanip>
+#include<vector>
+#include<string>
+#include<cmath>
+#include<cstdlib>
+#include<fftw3.h>
+#include"Transform.h"
+
+/* Checks of the transform modes (see Transform.h) against direct evaluations.
+   The data is random, on a small Nx x Ny x Nz grid with dof components stored as
+   (k,j,i,l) (Ny is odd). For each mode, we report the max abs difference of the
+   forward transform from a direct evaluation, and of the round trip (forward then
+   backward, normalized) from the input, relative to the max of the reference.
+   All should be at round-off.
+
+     - persistent: persistent complex transforms (see the sized constructor), executed
+       with execute(in, out) on buffers with the alignment of the plans (aligned) and
+       offset by one element, so the internal buffers are used (unaligned). Each
+       case runs on new data with the same plans
+     - real: real-to-complex and complex-to-real transforms, whose spectrum is 
+       the half (i < Nx / 2 + 1) of the one of the complex transform
+     - cheb: Fourier-Chebyshev transforms, with z at the Chebyshev extrema 
+       z_n = cos(pi * n / (Nz - 1)). The coefficients c_k of each wave number are
+       evaluated at the z_n by the Chebyshev recurrence, which should give the 
+       direct 2D DFT of each z-plane
+     - kmajor: wavenumber-major Fourier-Chebyshev transforms, complex and real (r), 
+       with interleaved and planar (p) components. The spectrum is compared with 
+       the one of the default layout, and the round trip with the input
+
+   usage: ./test_transform_modes
+*/
+
+const unsigned int Nx = 6, Ny = 5, Nz = 5, dof = 2;
+const size_t N = (size_t) Nx * Ny * Nz * dof;
+
+// index of component l of point (i,j,k)
+inline size_t idx(const size_t i, const size_t j, const size_t k, const size_t l)
+{
+  return l + dof * (i + Nx * (j + Ny * k));
+}
+
+// random data in [-1, 1]
+std::vector<double> randData(const size_t n)
+{
+  std::vector<double> v(n);
+  for (size_t i = 0; i < n; ++i) {v[i] = 2 * drand48() - 1;}
+  return v;
+}
+
+// direct (unnormalized) forward DFT of (re, im) in x and y, and in z if zdft
+void dft(const double* re, const double* im, std::vector<double>& ore,
+         std::vector<double>& oim, const bool zdft)
+{
+  ore.assign(N, 0); oim.assign(N, 0);
+  for (unsigned int kk = 0; kk < Nz; ++kk)
+  for (unsigned int jj = 0; jj < Ny; ++jj)
+  for (unsigned int ii = 0; ii < Nx; ++ii)
+  {
+    for (unsigned int k = (zdft ? 0 : kk); k < (zdft ? Nz : kk + 1); ++k)
+    for (unsigned int j = 0; j < Ny; ++j)
+    for (unsigned int i = 0; i < Nx; ++i)
+    {
+      const double phase = -2 * M_PI * ((double) ii * i / Nx + (double) jj * j / Ny +
+                                        (zdft ? (double) kk * k / Nz : 0));
+      const double c = cos(phase), s = sin(phase);
+      for (unsigned int l = 0; l < dof; ++l)
+      {
+        const double a = re[idx(i, j, k, l)], b = im ? im[idx(i, j, k, l)] : 0;
+        ore[idx(ii, jj, kk, l)] += a * c - b * s;
+        oim[idx(ii, jj, kk, l)] += a * s + b * c;
+      }
+    }
+  }
+}
+
+// max |a - b| / max |b| over the first n entries
+double relErr(const double* a, const double* b, const size_t n)
+{
+  double err = 0, norm = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    err = std::max(err, std::fabs(a[i] - b[i])); norm = std::max(norm, std::fabs(b[i]));
+  }
+  return norm ? err / norm : err;
+}
+
+void report(const char* name, const double fwd_err, const double trip_err)
+{
+  std::cout << std::setw(12) << name << std::scientific << std::setprecision(3)
+            << "  forward err = " << fwd_err << "  round trip err = " << trip_err << std::endl;
+}
+
+// persistent complex transforms on aligned and unaligned buffers
+void checkPersistent()
+{
+  Transform forward(Nx, Ny, Nz, dof, FFTW_FORWARD);
+  Transform backward(Nx, Ny, Nz, dof, FFTW_BACKWARD);
+  const char* names[2] = {"aligned", "unaligned"};
+  for (unsigned int offset = 0; offset < 2; ++offset)
+  {
+    std::vector<double> in_re(N + 1), in_im(N + 1), hat_re(N + 1), hat_im(N + 1);
+    std::vector<double> out_re(N + 1), out_im(N + 1), ref_re, ref_im;
+    const std::vector<double> re = randData(N), im = randData(N);
+    std::copy(re.begin(), re.end(), in_re.begin() + offset);
+    std::copy(im.begin(), im.end(), in_im.begin() + offset);
+    forward.execute(&in_re[offset], &in_im[offset], &hat_re[offset], &hat_im[offset]);
+    backward.execute(&hat_re[offset], &hat_im[offset], &out_re[offset], &out_im[offset]);
+    dft(re.data(), im.data(), ref_re, ref_im, true);
+    for (size_t i = 0; i < N; ++i) {out_re[i + offset] /= Nx * Ny * Nz; out_im[i + offset] /= Nx * Ny * Nz;}
+    report(names[offset], std::max(relErr(&hat_re[offset], ref_re.data(), N),
+                                   relErr(&hat_im[offset], ref_im.data(), N)),
+           std::max(relErr(&out_re[offset], re.data(), N), relErr(&out_im[offset], im.data(), N)));
+  }
+  forward.cleanup(); backward.cleanup();
+}
+
+// real-to-complex and complex-to-real transforms
+void checkReal()
+{
+  const unsigned int nx = Nx / 2 + 1;
+  const size_t Nh = (size_t) nx * Ny * Nz * dof;
+  Transform forward(Nx, Ny, Nz, dof, FFTW_FORWARD, false, true);
+  Transform backward(Nx, Ny, Nz, dof, FFTW_BACKWARD, false, true);
+  const std::vector<double> re = randData(N);
+  std::vector<double> hat_re(Nh), hat_im(Nh), out(N), ref_re, ref_im;
+  forward.execute(re.data(), 0, hat_re.data(), hat_im.data());
+  backward.execute(hat_re.data(), hat_im.data(), out.data(), 0);
+  dft(re.data(), 0, ref_re, ref_im, true);
+  // the half of the direct spectrum, stored as (k,j,i,l) with nx points in x
+  std::vector<double> half_re(Nh), half_im(Nh);
+  for (unsigned int k = 0; k < Nz; ++k)
+  for (unsigned int j = 0; j < Ny; ++j)
+  for (unsigned int i = 0; i < nx; ++i)
+  for (unsigned int l = 0; l < dof; ++l)
+  {
+    half_re[l + dof * (i + nx * (j + Ny * k))] = ref_re[idx(i, j, k, l)];
+    half_im[l + dof * (i + nx * (j + Ny * k))] = ref_im[idx(i, j, k, l)];
+  }
+  for (size_t i = 0; i < N; ++i) {out[i] /= Nx * Ny * Nz;}
+  report("real", std::max(relErr(hat_re.data(), half_re.data(), Nh), 
+                          relErr(hat_im.data(), half_im.data(), Nh)),
+         relErr(out.data(), re.data(), N));
+  forward.cleanup(); backward.cleanup();
+}
+
+// Fourier-Chebyshev transforms
+void checkCheb()
+{
+  Transform forward(Nx, Ny, Nz, dof, FFTW_FORWARD, false, false, true);
+  Transform backward(Nx, Ny, Nz, dof, FFTW_BACKWARD, false, false, true);
+  const std::vector<double> re = randData(N), im = randData(N);
+  std::vector<double> hat_re(N), hat_im(N), out_re(N), out_im(N), ref_re, ref_im;
+  forward.execute(re.data(), im.data(), hat_re.data(), hat_im.data());
+  backward.execute(hat_re.data(), hat_im.data(), out_re.data(), out_im.data());
+  dft(re.data(), im.data(), ref_re, ref_im, false);
+  // sum_k c_k T_k(z_n) for each wave number, with T_k from the recurrence
+  std::vector<double> eval_re(N, 0), eval_im(N, 0);
+  for (unsigned int n = 0; n < Nz; ++n)
+  {
+    const double z = cos(M_PI * n / (Nz - 1));
+    double Tkm1 = 0, Tk = 1;
+    for (unsigned int k = 0; k < Nz; ++k)
+    {
+      for (unsigned int j = 0; j < Ny; ++j)
+      for (unsigned int i = 0; i < Nx; ++i)
+      for (unsigned int l = 0; l < dof; ++l)
+      {
+        eval_re[idx(i, j, n, l)] += hat_re[idx(i, j, k, l)] * Tk;
+        eval_im[idx(i, j, n, l)] += hat_im[idx(i, j, k, l)] * Tk;
+      }
+      const double Tkp1 = (k == 0 ? z : 2 * z * Tk - Tkm1);
+      Tkm1 = Tk; Tk = Tkp1;
+    }
+  }
+  for (size_t i = 0; i < N; ++i) {out_re[i] /= Nx * Ny; out_im[i] /= Nx * Ny;}
+  report("cheb", std::max(relErr(eval_re.data(), ref_re.data(), N),
+                          relErr(eval_im.data(), ref_im.data(), N)),
+         std::max(relErr(out_re.data(), re.data(), N), relErr(out_im.data(), im.data(), N)));
+  forward.cleanup(); backward.cleanup();
+}
+
+// wavenumber-major Fourier-Chebyshev transforms against the default layout
+void checkKMajor()
+{
+  for (unsigned int planar = 0; planar < 2; ++planar)
+  for (unsigned int real = 0; real < 2; ++real)
+  {
+    const unsigned int nx = real ? Nx / 2 + 1 : Nx;
+    const size_t Nh = (size_t) nx * Ny * Nz * dof;
+    Transform forward(Nx, Ny, Nz, dof, FFTW_FORWARD, planar, real, true);
+    Transform forward_k(Nx, Ny, Nz, dof, FFTW_FORWARD, planar, real, true, true);
+    Transform backward_k(Nx, Ny, Nz, dof, FFTW_BACKWARD, planar, real, true, true);
+    const std::vector<double> re = randData(N), im = randData(N);
+    const double* in_im = real ? 0 : im.data();
+    std::vector<double> hat_re(Nh), hat_im(Nh), hatk_re(Nh), hatk_im(Nh);
+    std::vector<double> out_re(N), out_im(N);
+    forward.execute(re.data(), in_im, hat_re.data(), hat_im.data());
+    forward_k.execute(re.data(), in_im, hatk_re.data(), hatk_im.data());
+    backward_k.execute(hatk_re.data(), hatk_im.data(), out_re.data(), out_im.data());
+    // the default spectrum in the kmajor layout, (j,i,l,k) or (l,j,i,k) if planar
+    std::vector<double> ref_re(Nh), ref_im(Nh);
+    for (unsigned int k = 0; k < Nz; ++k)
+    for (unsigned int j = 0; j < Ny; ++j)
+    for (unsigned int i = 0; i < nx; ++i)
+    for (unsigned int l = 0; l < dof; ++l)
+    {
+      const size_t d = planar ? i + nx * (j + Ny * (k + Nz * l)) : l + dof * (i + nx * (j + Ny * k));
+      const size_t m = planar ? k + Nz * (i + nx * (j + Ny * l)) : k + Nz * (l + dof * (i + nx * j));
+      ref_re[m] = hat_re[d]; ref_im[m] = hat_im[d];
+    }
+    for (size_t i = 0; i < N; ++i) {out_re[i] /= Nx * Ny; out_im[i] /= Nx * Ny;}
+    const std::string name = std::string("kmajor") + (real || planar ? " " : "") + 
+                             (real ? "r" : "") + (planar ? "p" : "");
+    report(name.c_str(), std::max(relErr(hatk_re.data(), ref_re.data(), Nh),
+                                  relErr(hatk_im.data(), ref_im.data(), Nh)),
+           std::max(relErr(out_re.data(), re.data(), N), 
+                    real ? 0 : relErr(out_im.data(), im.data(), N)));
+    forward.cleanup(); forward_k.cleanup(); backward_k.cleanup();
+  }
+}
+
+int main()
+{
+  fftw_init_threads();
+  srand48(1);
+  checkPersistent();
+  checkReal();
+  checkCheb();
+  checkKMajor();
+  return 0;
+}
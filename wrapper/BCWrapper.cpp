@@ -2,6 +2,32 @@
 #include"Grid.h"
 #include"ParticleList.h"
 
+/* plan the fold/copy for the ghost widths of the particles */
+void planGhost(Grid* grid, ParticleList* particles)
+{
+  const unsigned short ext_up = grid->unifZ ? particles->wfzP_max : particles->ext_up;
+  const unsigned short ext_down = grid->unifZ ? particles->wfzP_max : particles->ext_down;
+  grid->ghost.plan(particles->wfxP_max, particles->wfyP_max, ext_up, ext_down, 
+                   grid->Nxeff, grid->Nyeff, grid->Nzeff, grid->dof, grid->isperiodic, 
+                   grid->BCs, grid->pencil, grid->planar);
+}
+
+/* fold or copy with the extended grid Fe in the precision of the grid, using
+   the plan stored in the grid (it is rebuilt if the grid or particles changed) */
+template<typename Real>
+void deGhostify(Real* Fe, Grid* grid, ParticleList* particles)
+{
+  planGhost(grid, particles);
+  grid->ghost.fold(Fe, grid->fG);
+}
+
+template<typename Real>
+void ghostify(Real* Fe, Grid* grid, ParticleList* particles)
+{
+  planGhost(grid, particles);
+  grid->ghost.copy(Fe, grid->fG);
+}
+
 /* C wrapper for calling BoundaryConditions methods from Python. Any functions
    defined here should also have their prototypes 
    and wrappers defined in ParticleList.py */
@@ -12,36 +38,27 @@ extern "C"
   // according to periodicity or boundary condition for each data component
   void DeGhostify(Grid* grid, ParticleList* particles)
   {
-    if (grid->unifZ)
-    {
-      fold(grid->fG_unwrap, grid->fG, particles->wfxP_max, particles->wfyP_max, 
-           particles->wfzP_max, particles->wfzP_max, grid->Nxeff, grid->Nyeff, 
-           grid->Nzeff, grid->dof, grid->isperiodic, grid->BCs);
-    }
-    else
-    {
-      fold(grid->fG_unwrap, grid->fG, particles->wfxP_max, particles->wfyP_max, 
-           particles->ext_up, particles->ext_down, grid->Nxeff, grid->Nyeff, 
-           grid->Nzeff, grid->dof, grid->isperiodic, grid->BCs);
-    }
+    if (grid->single) {deGhostify(grid->fG_unwrap_f, grid, particles);}
+    else {deGhostify(grid->fG_unwrap, grid, particles);}
   }
 
   // copy spread data from interior grid to ghost region of extended grid
   // according to periodicity or boundary condition for each data component
   void Ghostify(Grid* grid, ParticleList* particles)
   {
-    if (grid->unifZ)
-    {
-      copy(grid->fG_unwrap, grid->fG, particles->wfxP_max, particles->wfyP_max, 
-           particles->wfzP_max, particles->wfzP_max, grid->Nxeff, grid->Nyeff, 
-           grid->Nzeff, grid->dof, grid->isperiodic, grid->BCs);
-    }
-    else
+    if (grid->single) {ghostify(grid->fG_unwrap_f, grid, particles);}
+    else {ghostify(grid->fG_unwrap, grid, particles);}
+  }
+
+  // seconds spent in the fold/copy along x, y and z and in the copy between the 
+  // extended and interior grid, since the plan was built or the times were reset
+  void GhostTimes(Grid* grid, double* fold_time, double* copy_time)
+  {
+    for (unsigned int a = 0; a < 4; ++a)
     {
-      copy(grid->fG_unwrap, grid->fG, particles->wfxP_max, particles->wfyP_max, 
-           particles->ext_up, particles->ext_down, grid->Nxeff, grid->Nyeff, 
-           grid->Nzeff, grid->dof, grid->isperiodic, grid->BCs);
-    
+      fold_time[a] = grid->ghost.fold_time[a]; copy_time[a] = grid->ghost.copy_time[a];
     }
   }
+
+  void ResetGhostTimes(Grid* grid) {grid->ghost.resetTimes();}
 }
@@ -0,0 +1,57 @@
+#include "DPStokes.h"
+
+/* C wrapper for calling from Python. Any functions
+   defined here should also have their prototypes
+   and wrappers defined in Solvers.py */
+extern "C"
+{
+  // precompute the operators of the DP Stokes solvers on an Nx x Ny x Nz grid
+  DPStokes* MakeDPStokes(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+                         const double Lx, const double Ly, const double H, const double eta,
+                         const bool planar, const bool real, const bool kmajor)
+  {
+    return new DPStokes(Nx, Ny, Nz, Lx, Ly, H, eta, planar, real, kmajor);
+  }
+
+  /* velocity spectrum for a force spectrum, in place, in geometry geom (0 = no wall,
+     1 = bottom wall, 2 = slit channel). The pressure is written to p_hat_r, p_hat_i
+     unless they are null */
+  void SolveDPStokes(DPStokes* s, double* f_hat_r, double* f_hat_i, const int geom,
+                     const int k0, double* p_hat_r, double* p_hat_i)
+  {
+    s->solve(f_hat_r, f_hat_i, (DPGeometry) geom, k0, p_hat_r, p_hat_i);
+  }
+
+  /* bytes of each buffer of the solver, returned as in GridMemoryReport() */
+  unsigned int DPStokesMemoryReport(DPStokes* s, const char** names, size_t* bytes,
+                                    const unsigned int n)
+  {
+    return copyReport(s->memoryReport(), names, bytes, n);
+  }
+
+  void CleanDPStokes(DPStokes* s) {s->cleanup();}
+  void DeleteDPStokes(DPStokes* s) {if (s) {delete s; s = 0;}}
+
+  // single precision solver (see DPStokesF in DPStokes.h), as above with float data
+  DPStokesF* MakeDPStokesF(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+                           const double Lx, const double Ly, const double H, const double eta,
+                           const bool planar, const bool real, const bool kmajor)
+  {
+    return new DPStokesF(Nx, Ny, Nz, Lx, Ly, H, eta, planar, real, kmajor);
+  }
+
+  void SolveDPStokesF(DPStokesF* s, float* f_hat_r, float* f_hat_i, const int geom,
+                      const int k0, float* p_hat_r, float* p_hat_i)
+  {
+    s->solve(f_hat_r, f_hat_i, (DPGeometry) geom, k0, p_hat_r, p_hat_i);
+  }
+
+  unsigned int DPStokesMemoryReportF(DPStokesF* s, const char** names, size_t* bytes,
+                                     const unsigned int n)
+  {
+    return copyReport(s->memoryReport(), names, bytes, n);
+  }
+
+  void CleanDPStokesF(DPStokesF* s) {s->cleanup();}
+  void DeleteDPStokesF(DPStokesF* s) {if (s) {delete s; s = 0;}}
+}
@@ -12,6 +12,7 @@ extern "C"
   }
   
   void SetupGrid(Grid* grid) {grid->setup();}
+  void ResetGrid(Grid* grid) {grid->reset();}
   //void SetL(Grid* grid, const double* Ls) {grid->setL(Ls);}
   void SetL(Grid* grid, const double Lx, const double Ly, const double Lz) 
   {
@@ -30,7 +31,14 @@ extern "C"
   void SetPeriodicity(Grid* grid, bool x, bool y, bool z) {grid->setPeriodicity(x,y,z);}
   void SetBCs(Grid* grid, unsigned int* BCs) {grid->setBCs(reinterpret_cast<BC*>(BCs));}
   void Setdof(Grid* grid, const unsigned int dof) {grid->dof = dof;}
+  void SetSinglePrecision(Grid* grid, bool single) {grid->setSinglePrecision(single);}
+  void SetPencilLayout(Grid* grid, bool pencil) {grid->setPencilLayout(pencil);}
+  void SetPlanarLayout(Grid* grid, bool planar) {grid->setPlanarLayout(planar);}
+  void SetNumRHS(Grid* grid, const unsigned int nrhs) {grid->setNumRHS(nrhs);}
   void ZeroExtGrid(Grid* grid){grid->zeroExtGrid();}
+  // placement policy of the pages of grid and particle buffers (see Memory.h)
+  void SetPlacement(unsigned int placement) {setPlacement(static_cast<Placement>(placement));}
+  unsigned int GetPlacement() {return getPlacement();}
 
   void CleanGrid(Grid* g) {g->cleanup();}
   void DeleteGrid(Grid* g) {if(g) {delete g; g = 0;}} 
@@ -43,7 +51,29 @@ extern "C"
       g->fG[i] = f[i];
     }   
   } 
+  // spectrum of fG for transforms bound to the grid (see Grid::setupSpectral())
+  void SetupSpectral(Grid* g, const bool real) {g->setupSpectral(real);}
+  double* GetSpectralReal(Grid* g) {return g->fG_hat_r;}
+  double* GetSpectralComplex(Grid* g) {return g->fG_hat_i;}
   void WriteGrid(Grid* g, const char* fname) {g->writeGrid(fname);}
+  /* bytes of each buffer of the grid. The first n are copied to names and bytes,
+     and the number of buffers is returned (call with n = 0 to size the arrays) */
+  unsigned int GridMemoryReport(Grid* g, const char** names, size_t* bytes, const unsigned int n)
+  {
+    return copyReport(g->memoryReport(), names, bytes, n);
+  }
+  /* dry-run estimate of the buffers for a problem size (see estimateMemory() in Memory.h),
+     returned as in GridMemoryReport() */
+  unsigned int EstimateMemory(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+                              const unsigned int dof, const unsigned int nP, 
+                              const unsigned short wx, const unsigned short wy, 
+                              const unsigned short wz, const bool dp, const bool single, 
+                              const bool cache_weights, const unsigned int nthreads,
+                              const char** names, size_t* bytes, const unsigned int n)
+  {
+    return copyReport(estimateMemory(Nx, Ny, Nz, dof, nP, wx, wy, wz, dp, single, 
+                                     cache_weights, nthreads), names, bytes, n);
+  }
   void WriteCoords(Grid* g, const char* fname) {g->writeCoords(fname);}  
 }
 
@@ -19,7 +19,40 @@ extern "C"
   {
     particles->setup(*grid);  
   }
+
+  /* locate the particles on the grid again, reusing the grid and locator buffers */
+  void Reset(ParticleList* particles, Grid* grid)
+  {
+    particles->reset(*grid);
+  }
   
+  /* set the max number of z layers for the layered spread/interp path (0 disables it).
+     This must be called before Setup() */
+  void SetMaxLayers(ParticleList* particles, const unsigned int max_layers)
+  {
+    particles->setMaxLayers(max_layers);
+  }
+
+  /* turn caching of the kernel weights across spread/interp calls on or off */
+  void SetWeightCache(ParticleList* particles, bool cache_weights)
+  {
+    particles->setWeightCache(cache_weights);
+  }
+
+  /* turn reordering of the particles along a space-filling curve on or off, 
+     with the fraction of out-of-order particles that triggers a new reordering in Update().
+     This must be called before Setup() */
+  void SetReordering(ParticleList* particles, bool reorder, double tol)
+  {
+    particles->setReordering(reorder, tol);
+  }
+
+  /* set the number of data vectors (right-hand sides) on the particles */
+  void SetNumRHS(ParticleList* particles, const unsigned int nrhs)
+  {
+    particles->setNumRHS(nrhs);
+  }
+
   /* set or get data on the particles */
   void SetForces(ParticleList* particles, const double* _fP, unsigned int dof)
   {
@@ -28,7 +61,7 @@ extern "C"
   
   /* zero the data on particles */
   void ZeroForces(ParticleList* particles) {particles->zeroForces();}
-  double* GetForces(ParticleList* particles) {return particles->fP;}
+  double* GetForces(ParticleList* particles) {return const_cast<double*>(particles->getForces());}
   
   /* create random configuration given the grid and number of particles 
      NOTE: this calls Setup() internaly */
@@ -57,4 +90,10 @@ extern "C"
   void CleanParticles(ParticleList* s) {s->cleanup();}
   void DeleteParticles(ParticleList* s) {if(s) {delete s; s = 0;}}
   void WriteParticles(ParticleList* s, const char* fname) {s->writeParticles(fname);}
+  /* bytes of each buffer of the particles, returned as in GridMemoryReport() */
+  unsigned int ParticlesMemoryReport(ParticleList* s, const char** names, size_t* bytes, 
+                                     const unsigned int n)
+  {
+    return copyReport(s->memoryReport(), names, bytes, n);
+  }
 }
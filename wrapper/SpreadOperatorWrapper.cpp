@@ -0,0 +1,38 @@
+#include"SpreadOperator.h"
+#include"Grid.h"
+#include"ParticleList.h"
+
+/* C wrapper for calling from Python. Any functions
+   defined here should also have their prototypes
+   and wrappers defined in SpreadOperator.py */
+extern "C"
+{
+  // assemble the spread/interp operators for the particles on the grid
+  SpreadOperator* MakeSpreadOperator(ParticleList* s, Grid* g)
+  {
+    SpreadOperator* op = new SpreadOperator();
+    op->build(*s, *g);
+    return op;
+  }
+
+  // rebuild the operators after the particles move
+  void RebuildSpreadOperator(SpreadOperator* op, ParticleList* s, Grid* g)
+  {
+    op->build(*s, *g);
+  }
+
+  // g.fG = S * s.fP
+  void SpreadOp(SpreadOperator* op, ParticleList* s, Grid* g)
+  {
+    op->spread(s->fP, g->fG);
+  }
+
+  // s.fP = J * g.fG
+  void InterpolateOp(SpreadOperator* op, ParticleList* s, Grid* g)
+  {
+    op->interpolate(g->fG, s->fP);
+  }
+
+  void CleanSpreadOperator(SpreadOperator* op) {op->cleanup();}
+  void DeleteSpreadOperator(SpreadOperator* op) {if (op) {delete op; op = 0;}}
+}
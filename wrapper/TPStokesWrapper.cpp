@@ -0,0 +1,55 @@
+#include "TPStokes.h"
+
+/* C wrapper for calling from Python. Any functions
+   defined here should also have their prototypes
+   and wrappers defined in Solvers.py */
+extern "C"
+{
+  // precompute the multipliers of the TP Stokes operator on an Nx x Ny x Nz grid
+  TPStokes* MakeTPStokes(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+                         const double Lx, const double Ly, const double Lz, const double eta,
+                         const unsigned int nrhs, const bool planar, const bool real)
+  {
+    return new TPStokes(Nx, Ny, Nz, Lx, Ly, Lz, eta, nrhs, planar, real);
+  }
+
+  // velocity spectrum for a force spectrum (the outputs may be the inputs)
+  void SolveTPStokes(const TPStokes* s, const double* f_hat_r, const double* f_hat_i,
+                     double* u_hat_r, double* u_hat_i)
+  {
+    s->solve(f_hat_r, f_hat_i, u_hat_r, u_hat_i);
+  }
+
+  /* bytes of each buffer of the solver, returned as in GridMemoryReport() */
+  unsigned int TPStokesMemoryReport(TPStokes* s, const char** names, size_t* bytes,
+                                    const unsigned int n)
+  {
+    return copyReport(s->memoryReport(), names, bytes, n);
+  }
+
+  void CleanTPStokes(TPStokes* s) {s->cleanup();}
+  void DeleteTPStokes(TPStokes* s) {if (s) {delete s; s = 0;}}
+
+  // single precision solver (see TPStokesF in TPStokes.h), as above with float data
+  TPStokesF* MakeTPStokesF(const unsigned int Nx, const unsigned int Ny, const unsigned int Nz,
+                           const double Lx, const double Ly, const double Lz, const double eta,
+                           const unsigned int nrhs, const bool planar, const bool real)
+  {
+    return new TPStokesF(Nx, Ny, Nz, Lx, Ly, Lz, eta, nrhs, planar, real);
+  }
+
+  void SolveTPStokesF(const TPStokesF* s, const float* f_hat_r, const float* f_hat_i,
+                      float* u_hat_r, float* u_hat_i)
+  {
+    s->solve(f_hat_r, f_hat_i, u_hat_r, u_hat_i);
+  }
+
+  unsigned int TPStokesMemoryReportF(TPStokesF* s, const char** names, size_t* bytes,
+                                     const unsigned int n)
+  {
+    return copyReport(s->memoryReport(), names, bytes, n);
+  }
+
+  void CleanTPStokesF(TPStokesF* s) {s->cleanup();}
+  void DeleteTPStokesF(TPStokesF* s) {if (s) {delete s; s = 0;}}
+}
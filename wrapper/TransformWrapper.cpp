@@ -7,30 +7,137 @@ extern "C"
 {
   Transform* Ftransform(const double* in_real, const unsigned int Nx,
                         const unsigned int Ny, const unsigned int Nz,
-                        const unsigned int dof) 
+                        const unsigned int dof, const bool planar, const bool real,
+                        const bool cheb, const bool kmajor) 
   {
     if (not fftw_init_threads())
     {
       exitErr("Could not initialize threads for FFTW");
     }
-    return new Transform(in_real, Nx, Ny, Nz, dof);
+    return new Transform(in_real, Nx, Ny, Nz, dof, planar, real, cheb, kmajor);
   }
   
   Transform* Btransform(const double* out_real, const double* out_complex,
                         const unsigned int Nx, const unsigned int Ny, 
-                        const unsigned int Nz, const unsigned int dof)
+                        const unsigned int Nz, const unsigned int dof,
+                        const bool planar, const bool real, const bool cheb,
+                        const bool kmajor)
   {
     if (not fftw_init_threads())
     {
       exitErr("Could not initialize threads for FFTW");
     }
-    return new Transform(out_real, out_complex, Nx, Ny, Nz, dof);
+    return new Transform(out_real, out_complex, Nx, Ny, Nz, dof, planar, real, cheb, kmajor);
   }
 
+  // persistent transform (see Transform.h), with direction = FFTW_FORWARD (-1) 
+  // or FFTW_BACKWARD (1) and flags eg. FFTW_MEASURE or FFTW_PATIENT
+  Transform* MakeTransform(const unsigned int Nx, const unsigned int Ny, 
+                           const unsigned int Nz, const unsigned int dof,
+                           const int direction, const bool planar, const bool real,
+                           const bool cheb, const bool kmajor, const unsigned int flags)
+  {
+    if (not fftw_init_threads())
+    {
+      exitErr("Could not initialize threads for FFTW");
+    }
+    return new Transform(Nx, Ny, Nz, dof, direction, planar, real, cheb, kmajor, flags);
+  }
+
+  // persistent transform bound to the buffers of a grid (see Grid::setupSpectral())
+  Transform* BindTransform(double* fG, double* fG_hat_r, double* fG_hat_i,
+                           const unsigned int Nx, const unsigned int Ny, 
+                           const unsigned int Nz, const unsigned int dof,
+                           const int direction, const bool planar, const bool real,
+                           const bool cheb, const bool kmajor, const unsigned int flags)
+  {
+    if (not fftw_init_threads())
+    {
+      exitErr("Could not initialize threads for FFTW");
+    }
+    return new Transform(fG, fG_hat_r, fG_hat_i, Nx, Ny, Nz, dof, direction, 
+                         planar, real, cheb, kmajor, flags);
+  }
+
+  // execute a persistent transform (in_complex and the outputs may be null)
+  void ExecuteTransform(Transform* t, const double* in_real, const double* in_complex,
+                        double* out_real, double* out_complex)
+  {
+    t->execute(in_real, in_complex, out_real, out_complex);
+  }
+
+  // execute a transform on its own buffers (the grid buffers if bound)
+  void ExecuteBound(Transform* t) {t->execute();}
+
+  bool SetWisdomFile(const char* fname) {return setWisdomFile(fname);}
+
   double* getRealOut(Transform* t) {return t->out_real;}
   double* getComplexOut(Transform* t) {return t->out_complex;}  
 
+  /* bytes of each buffer of the transform, returned as in GridMemoryReport() */
+  unsigned int TransformMemoryReport(Transform* t, const char** names, size_t* bytes, 
+                                     const unsigned int n)
+  {
+    return copyReport(t->memoryReport(), names, bytes, n);
+  }
+
   void CleanTransform(Transform* t) {t->cleanup();}
   void DeleteTransform(Transform* t) {if(t) {delete t; t = 0;}}
-}
 
+  /* single precision transforms (see TransformF in Transform.h), as above
+     with float data. These are not bound to grids, whose buffers are double */
+  TransformF* FtransformF(const float* in_real, const unsigned int Nx,
+                          const unsigned int Ny, const unsigned int Nz,
+                          const unsigned int dof, const bool planar, const bool real,
+                          const bool cheb, const bool kmajor) 
+  {
+    if (not fftwf_init_threads())
+    {
+      exitErr("Could not initialize threads for FFTW");
+    }
+    return new TransformF(in_real, Nx, Ny, Nz, dof, planar, real, cheb, kmajor);
+  }
+  
+  TransformF* BtransformF(const float* out_real, const float* out_complex,
+                          const unsigned int Nx, const unsigned int Ny, 
+                          const unsigned int Nz, const unsigned int dof,
+                          const bool planar, const bool real, const bool cheb,
+                          const bool kmajor)
+  {
+    if (not fftwf_init_threads())
+    {
+      exitErr("Could not initialize threads for FFTW");
+    }
+    return new TransformF(out_real, out_complex, Nx, Ny, Nz, dof, planar, real, cheb, kmajor);
+  }
+
+  TransformF* MakeTransformF(const unsigned int Nx, const unsigned int Ny, 
+                             const unsigned int Nz, const unsigned int dof,
+                             const int direction, const bool planar, const bool real,
+                             const bool cheb, const bool kmajor, const unsigned int flags)
+  {
+    if (not fftwf_init_threads())
+    {
+      exitErr("Could not initialize threads for FFTW");
+    }
+    return new TransformF(Nx, Ny, Nz, dof, direction, planar, real, cheb, kmajor, flags);
+  }
+
+  void ExecuteTransformF(TransformF* t, const float* in_real, const float* in_complex,
+                         float* out_real, float* out_complex)
+  {
+    t->execute(in_real, in_complex, out_real, out_complex);
+  }
+
+  float* getRealOutF(TransformF* t) {return t->out_real;}
+  float* getComplexOutF(TransformF* t) {return t->out_complex;}  
+
+  unsigned int TransformMemoryReportF(TransformF* t, const char** names, size_t* bytes, 
+                                      const unsigned int n)
+  {
+    return copyReport(t->memoryReport(), names, bytes, n);
+  }
+
+  void CleanTransformF(TransformF* t) {t->cleanup();}
+  void DeleteTransformF(TransformF* t) {if(t) {delete t; t = 0;}}
+}